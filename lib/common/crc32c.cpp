@@ -0,0 +1,149 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// crc32c.cpp
+//
+// Identification: src/common/crc32c.cpp
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#endif
+
+#include "common/crc32c.h"
+
+namespace peloton {
+
+namespace {
+
+// Castagnoli polynomial, bit reversed
+#define CRC32C_POLYNOMIAL 0x82F63B78u
+
+typedef uint32_t (*ExtendFunction)(uint32_t crc, const char *data,
+                                   size_t length);
+
+struct Crc32cTables {
+  Crc32cTables() {
+    for (uint32_t byte = 0; byte < 256; byte++) {
+      uint32_t crc = byte;
+      for (int bit = 0; bit < 8; bit++) {
+        crc = (crc & 1) ? (crc >> 1) ^ CRC32C_POLYNOMIAL : (crc >> 1);
+      }
+      table[0][byte] = crc;
+    }
+
+    // table[k] advances a byte over k following zero bytes
+    for (int slice = 1; slice < 8; slice++) {
+      for (uint32_t byte = 0; byte < 256; byte++) {
+        uint32_t crc = table[slice - 1][byte];
+        table[slice][byte] = (crc >> 8) ^ table[0][crc & 0xff];
+      }
+    }
+  }
+
+  uint32_t table[8][256];
+};
+
+uint32_t ExtendSlicingBy8(uint32_t crc, const char *data, size_t length) {
+  static const Crc32cTables tables;
+  auto &table = tables.table;
+  const uint8_t *itr = reinterpret_cast<const uint8_t *>(data);
+  uint32_t value = ~crc;
+
+  while (length > 0 && (reinterpret_cast<uintptr_t>(itr) & 7) != 0) {
+    value = table[0][(value ^ *itr++) & 0xff] ^ (value >> 8);
+    length--;
+  }
+
+  // Eight bytes per step, the log is only written on little endian machines
+  while (length >= 8) {
+    uint64_t word;
+    memcpy(&word, itr, sizeof(word));
+    uint32_t low = value ^ static_cast<uint32_t>(word);
+    uint32_t high = static_cast<uint32_t>(word >> 32);
+    value = table[7][low & 0xff] ^ table[6][(low >> 8) & 0xff] ^
+            table[5][(low >> 16) & 0xff] ^ table[4][low >> 24] ^
+            table[3][high & 0xff] ^ table[2][(high >> 8) & 0xff] ^
+            table[1][(high >> 16) & 0xff] ^ table[0][high >> 24];
+    itr += 8;
+    length -= 8;
+  }
+
+  while (length > 0) {
+    value = table[0][(value ^ *itr++) & 0xff] ^ (value >> 8);
+    length--;
+  }
+
+  return ~value;
+}
+
+#if defined(__x86_64__)
+
+__attribute__((target("sse4.2"))) uint32_t ExtendHardware(uint32_t crc,
+                                                          const char *data,
+                                                          size_t length) {
+  const uint8_t *itr = reinterpret_cast<const uint8_t *>(data);
+  uint64_t value = ~crc & 0xffffffffu;
+
+  while (length > 0 && (reinterpret_cast<uintptr_t>(itr) & 7) != 0) {
+    value = _mm_crc32_u8(static_cast<uint32_t>(value), *itr++);
+    length--;
+  }
+
+  while (length >= 8) {
+    uint64_t word;
+    memcpy(&word, itr, sizeof(word));
+    value = _mm_crc32_u64(value, word);
+    itr += 8;
+    length -= 8;
+  }
+
+  while (length > 0) {
+    value = _mm_crc32_u8(static_cast<uint32_t>(value), *itr++);
+    length--;
+  }
+
+  return ~static_cast<uint32_t>(value);
+}
+
+ExtendFunction ChooseExtendFunction() {
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("sse4.2")) {
+    return ExtendHardware;
+  }
+  return ExtendSlicingBy8;
+}
+
+#else
+
+ExtendFunction ChooseExtendFunction() { return ExtendSlicingBy8; }
+
+#endif
+
+ExtendFunction GetExtendFunction() {
+  static const ExtendFunction extend_function = ChooseExtendFunction();
+  return extend_function;
+}
+
+}  // namespace
+
+uint32_t Crc32c::Extend(uint32_t crc, const char *data, size_t length) {
+  return GetExtendFunction()(crc, data, length);
+}
+
+bool Crc32c::IsHardwareAccelerated() {
+  return GetExtendFunction() != ExtendSlicingBy8;
+}
+
+uint32_t Crc32c::ExtendSoftware(uint32_t crc, const char *data,
+                               size_t length) {
+  return ExtendSlicingBy8(crc, data, length);
+}
+
+}  // End peloton namespace
@@ -0,0 +1,135 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// numa_util.cpp
+//
+// Identification: src/common/numa_util.cpp
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <dirent.h>
+#include <linux/mempolicy.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "common/numa_util.h"
+
+#include "common/logger.h"
+
+namespace peloton {
+
+namespace {
+
+#define NUMA_SYSFS_NODE_DIR "/sys/devices/system/node/"
+#define NUMA_SYSFS_CPU_DIR "/sys/devices/system/cpu/"
+
+// Largest node id we are able to bind to
+#define NUMA_MAX_NODE_COUNT (sizeof(unsigned long) * 8)
+
+struct NumaTopology {
+  NumaTopology() : node_count(1) {
+    // Online nodes are listed as ranges, e.g. "0-1,3"
+    std::ifstream online_file(NUMA_SYSFS_NODE_DIR "online");
+    std::string online_nodes;
+    if (online_file.good() && std::getline(online_file, online_nodes)) {
+      size_t max_node = 0;
+      const char *itr = online_nodes.c_str();
+      while (*itr != '\0') {
+        char *end = nullptr;
+        size_t node = strtoul(itr, &end, 10);
+        if (end == itr) break;
+        if (node > max_node) max_node = node;
+        itr = (*end == '-' || *end == ',') ? end + 1 : end;
+      }
+      node_count = std::min<size_t>(max_node + 1, NUMA_MAX_NODE_COUNT);
+    }
+
+    // Each cpu directory holds a "node<id>" link to its node
+    long cpu_count = sysconf(_SC_NPROCESSORS_CONF);
+    if (cpu_count < 1) cpu_count = 1;
+    cpu_to_node.assign(cpu_count, 0);
+
+    if (node_count == 1) {
+      return;
+    }
+
+    for (long cpu = 0; cpu < cpu_count; cpu++) {
+      std::string cpu_dir =
+          std::string(NUMA_SYSFS_CPU_DIR) + "cpu" + std::to_string(cpu);
+      DIR *dir = opendir(cpu_dir.c_str());
+      if (dir == nullptr) continue;
+
+      struct dirent *entry;
+      while ((entry = readdir(dir)) != nullptr) {
+        if (strncmp(entry->d_name, "node", 4) == 0 &&
+            entry->d_name[4] >= '0' && entry->d_name[4] <= '9') {
+          int node = atoi(entry->d_name + 4);
+          if (node >= 0 && static_cast<size_t>(node) < node_count) {
+            cpu_to_node[cpu] = node;
+          }
+          break;
+        }
+      }
+      closedir(dir);
+    }
+  }
+
+  size_t node_count;
+
+  std::vector<int> cpu_to_node;
+};
+
+const NumaTopology &GetTopology() {
+  static NumaTopology topology;
+  return topology;
+}
+
+}  // namespace
+
+size_t NumaUtil::GetNodeCount() { return GetTopology().node_count; }
+
+int NumaUtil::GetNodeOfCpu(const int cpu) {
+  auto &topology = GetTopology();
+  if (cpu < 0 || static_cast<size_t>(cpu) >= topology.cpu_to_node.size()) {
+    return 0;
+  }
+  return topology.cpu_to_node[cpu];
+}
+
+int NumaUtil::GetCurrentNode() {
+  if (GetNodeCount() == 1) {
+    return 0;
+  }
+  return GetNodeOfCpu(sched_getcpu());
+}
+
+bool NumaUtil::BindToNode(void *address, const size_t length,
+                          const int node) {
+  if (node < 0 || static_cast<size_t>(node) >= GetNodeCount()) {
+    return false;
+  }
+
+  unsigned long node_mask = 1UL << node;
+  long ret = syscall(SYS_mbind, address, length, MPOL_PREFERRED, &node_mask,
+                     NUMA_MAX_NODE_COUNT, MPOL_MF_MOVE);
+  if (ret != 0) {
+    LOG_TRACE("mbind to node %d failed : %s", node, strerror(errno));
+    return false;
+  }
+
+  return true;
+}
+
+}  // End peloton namespace
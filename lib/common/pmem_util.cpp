@@ -0,0 +1,229 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// pmem_util.cpp
+//
+// Identification: src/common/pmem_util.cpp
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <emmintrin.h>
+#define PMEM_X86
+#endif
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+#include "common/pmem_util.h"
+
+#include "common/logger.h"
+
+namespace peloton {
+
+namespace {
+
+// 64B cache line size
+#define PMEM_FLUSH_ALIGN ((uintptr_t)64)
+
+// Shorter copies are not worth streaming
+#define PMEM_NONTEMPORAL_MIN_LENGTH 256
+
+//===--------------------------------------------------------------------===//
+// INSTRUCTIONS
+//===--------------------------------------------------------------------===//
+
+// Source : https://github.com/pmem/nvml/blob/master/src/libpmem/pmem.c
+
+#ifdef PMEM_X86
+
+#ifndef bit_CLFLUSH
+#define bit_CLFLUSH (1 << 19)
+#endif
+
+#ifndef bit_CLFLUSHOPT
+#define bit_CLFLUSHOPT (1 << 23)
+#endif
+
+#ifndef bit_CLWB
+#define bit_CLWB (1 << 24)
+#endif
+
+// CLFLUSHOPT is clflush (0F AE /7) and CLWB is xsaveopt (0F AE /6) with a
+// 0x66 prefix. Spelled this way so that older assemblers accept them.
+#define PMEM_CLFLUSHOPT(addr) \
+  asm volatile(".byte 0x66; clflush %0" : "+m"(*(volatile char *)(addr)));
+#define PMEM_CLWB(addr) \
+  asm volatile(".byte 0x66; xsaveopt %0" : "+m"(*(volatile char *)(addr)));
+
+void FlushClflush(const void *address, size_t length) {
+  // Loop through the cache lines covering the range
+  for (uintptr_t uptr = (uintptr_t)address & ~(PMEM_FLUSH_ALIGN - 1);
+       uptr < (uintptr_t)address + length; uptr += PMEM_FLUSH_ALIGN) {
+    _mm_clflush((char *)uptr);
+  }
+}
+
+void FlushClflushopt(const void *address, size_t length) {
+  for (uintptr_t uptr = (uintptr_t)address & ~(PMEM_FLUSH_ALIGN - 1);
+       uptr < (uintptr_t)address + length; uptr += PMEM_FLUSH_ALIGN) {
+    PMEM_CLFLUSHOPT((char *)uptr);
+  }
+}
+
+void FlushClwb(const void *address, size_t length) {
+  for (uintptr_t uptr = (uintptr_t)address & ~(PMEM_FLUSH_ALIGN - 1);
+       uptr < (uintptr_t)address + length; uptr += PMEM_FLUSH_ALIGN) {
+    PMEM_CLWB((char *)uptr);
+  }
+}
+
+#endif
+
+void FlushEmulated(const void *, size_t) {
+  std::atomic_signal_fence(std::memory_order_seq_cst);
+}
+
+//===--------------------------------------------------------------------===//
+// CPU CHECK
+//===--------------------------------------------------------------------===//
+
+struct PmemFunctions {
+  PmemFunctions()
+      : flush(FlushEmulated),
+        flush_instruction_name("emulated"),
+        emulated(true) {
+#ifdef PMEM_X86
+    unsigned eax = 0, ebx = 0, ecx = 0, edx = 0;
+
+    if (__get_cpuid(0x1, &eax, &ebx, &ecx, &edx) != 0 &&
+        (edx & bit_CLFLUSH) != 0) {
+      flush = FlushClflush;
+      flush_instruction_name = "clflush";
+      emulated = false;
+    }
+
+    if (emulated == false && __get_cpuid_max(0x0, nullptr) >= 0x7) {
+      __cpuid_count(0x7, 0x0, eax, ebx, ecx, edx);
+      if ((ebx & bit_CLWB) != 0) {
+        flush = FlushClwb;
+        flush_instruction_name = "clwb";
+      } else if ((ebx & bit_CLFLUSHOPT) != 0) {
+        flush = FlushClflushopt;
+        flush_instruction_name = "clflushopt";
+      }
+    }
+#endif
+
+    LOG_TRACE("Flushing with %s", flush_instruction_name);
+  }
+
+  void (*flush)(const void *, size_t);
+
+  const char *flush_instruction_name;
+
+  bool emulated;
+};
+
+const PmemFunctions &GetFunctions() {
+  static PmemFunctions functions;
+  return functions;
+}
+
+}  // namespace
+
+//===--------------------------------------------------------------------===//
+// FLUSH AND FENCE
+//===--------------------------------------------------------------------===//
+
+void PmemUtil::Flush(const void *address, const size_t length) {
+  GetFunctions().flush(address, length);
+}
+
+void PmemUtil::Fence() {
+#ifdef PMEM_X86
+  // Orders CLWB, CLFLUSHOPT and streaming stores, and does no harm after
+  // CLFLUSH
+  if (GetFunctions().emulated == false) {
+    _mm_sfence();
+    return;
+  }
+#endif
+
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+void PmemUtil::Persist(const void *address, const size_t length) {
+  Flush(address, length);
+  Fence();
+}
+
+//===--------------------------------------------------------------------===//
+// NON-TEMPORAL COPY
+//===--------------------------------------------------------------------===//
+
+void *PmemUtil::MemcpyNontemporal(void *destination, const void *source,
+                                  const size_t length) {
+  auto &functions = GetFunctions();
+
+#ifdef PMEM_X86
+  if (functions.emulated == false && length >= PMEM_NONTEMPORAL_MIN_LENGTH) {
+    char *dest = static_cast<char *>(destination);
+    const char *src = static_cast<const char *>(source);
+    size_t remaining = length;
+
+    // Cached copy up to the first cache line boundary
+    size_t head = (0 - (uintptr_t)dest) & (PMEM_FLUSH_ALIGN - 1);
+    if (head > 0) {
+      memcpy(dest, src, head);
+      functions.flush(dest, head);
+      dest += head;
+      src += head;
+      remaining -= head;
+    }
+
+    // Whole cache lines with streaming stores
+    while (remaining >= PMEM_FLUSH_ALIGN) {
+      __m128i xmm0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+      __m128i xmm1 =
+          _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 16));
+      __m128i xmm2 =
+          _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 32));
+      __m128i xmm3 =
+          _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 48));
+      _mm_stream_si128(reinterpret_cast<__m128i *>(dest), xmm0);
+      _mm_stream_si128(reinterpret_cast<__m128i *>(dest + 16), xmm1);
+      _mm_stream_si128(reinterpret_cast<__m128i *>(dest + 32), xmm2);
+      _mm_stream_si128(reinterpret_cast<__m128i *>(dest + 48), xmm3);
+      dest += PMEM_FLUSH_ALIGN;
+      src += PMEM_FLUSH_ALIGN;
+      remaining -= PMEM_FLUSH_ALIGN;
+    }
+
+    // Cached copy of the partial last line
+    if (remaining > 0) {
+      memcpy(dest, src, remaining);
+      functions.flush(dest, remaining);
+    }
+
+    return destination;
+  }
+#endif
+
+  memcpy(destination, source, length);
+  functions.flush(destination, length);
+  return destination;
+}
+
+const char *PmemUtil::GetFlushInstructionName() {
+  return GetFunctions().flush_instruction_name;
+}
+
+bool PmemUtil::IsEmulated() { return GetFunctions().emulated; }
+
+}  // End peloton namespace
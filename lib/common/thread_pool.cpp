@@ -0,0 +1,316 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// thread_pool.cpp
+//
+// Identification: src/common/thread_pool.cpp
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <pthread.h>
+#include <sched.h>
+
+#include "common/thread_pool.h"
+
+#include "common/logger.h"
+#include "common/platform.h"
+
+namespace peloton {
+
+// Shared task runtime, see common/init.h
+ThreadPool thread_pool;
+
+namespace {
+
+// Pool and worker id of the calling thread
+thread_local ThreadPool *current_pool = nullptr;
+thread_local int current_worker_id = -1;
+
+// Rounds of stealing attempts before an idle worker goes to sleep
+const size_t idle_spin_count = 64;
+
+// Initial capacity of the injection queue
+const size_t injection_queue_size = 1024;
+
+}  // namespace
+
+//===--------------------------------------------------------------------===//
+// Task Group
+//===--------------------------------------------------------------------===//
+
+TaskGroup::~TaskGroup() {
+  // Tasks hold a pointer to the group, never let it go away under them
+  while (pending_tasks_.load(std::memory_order_acquire) != 0) {
+    if (pool_.RunPendingTask() == false) {
+      std::this_thread::yield();
+    }
+  }
+}
+
+void TaskGroup::Wait() {
+  while (pending_tasks_.load(std::memory_order_acquire) != 0) {
+    if (pool_.RunPendingTask() == false) {
+      std::this_thread::yield();
+    }
+  }
+
+  std::exception_ptr exception;
+  {
+    std::lock_guard<std::mutex> lock(exception_mutex_);
+    std::swap(exception, exception_);
+  }
+  if (exception != nullptr) {
+    std::rethrow_exception(exception);
+  }
+}
+
+void TaskGroup::TaskDone(std::exception_ptr exception) {
+  if (exception != nullptr) {
+    std::lock_guard<std::mutex> lock(exception_mutex_);
+    if (exception_ == nullptr) {
+      exception_ = exception;
+    }
+  }
+  pending_tasks_.fetch_sub(1, std::memory_order_release);
+}
+
+//===--------------------------------------------------------------------===//
+// Thread Pool
+//===--------------------------------------------------------------------===//
+
+ThreadPool::ThreadPool()
+    : pool_size_(0),
+      dedicated_thread_count_(0),
+      pin_threads_(false),
+      started_(false),
+      shutdown_(false),
+      injection_queue_(injection_queue_size),
+      queued_task_count_(0),
+      sleeping_worker_count_(0) {}
+
+ThreadPool::~ThreadPool() { Shutdown(); }
+
+void ThreadPool::Initialize(const size_t &pool_size,
+                            const size_t &dedicated_thread_count,
+                            const bool &pin_threads) {
+  std::lock_guard<std::mutex> lock(initialize_mutex_);
+  if (started_ == true) {
+    LOG_ERROR("Thread pool is already running");
+    return;
+  }
+
+  Start(pool_size, dedicated_thread_count, pin_threads);
+}
+
+void ThreadPool::EnsureStarted() {
+  if (started_.load(std::memory_order_acquire) == true) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(initialize_mutex_);
+  if (started_ == false) {
+    Start(std::max(1u, std::thread::hardware_concurrency()), 0, false);
+  }
+}
+
+void ThreadPool::Start(const size_t &pool_size,
+                       const size_t &dedicated_thread_count,
+                       const bool &pin_threads) {
+  pool_size_ = pool_size;
+  dedicated_thread_count_ = dedicated_thread_count;
+  pin_threads_ = pin_threads;
+  shutdown_ = false;
+
+  for (size_t worker_id = 0; worker_id < pool_size_; worker_id++) {
+    workers_.emplace_back(new Worker());
+  }
+
+  // Workers may steal from each other as soon as they run, so only start
+  // them once every deque exists
+  for (size_t worker_id = 0; worker_id < pool_size_; worker_id++) {
+    auto &worker = *workers_[worker_id];
+    worker.thread = std::thread(&ThreadPool::WorkerMain, this, worker_id);
+    if (pin_threads_ == true) {
+      PinThread(worker.thread, worker_id);
+    }
+  }
+
+  dedicated_threads_.resize(dedicated_thread_count_);
+
+  started_.store(true, std::memory_order_release);
+}
+
+void ThreadPool::Shutdown() {
+  std::lock_guard<std::mutex> lock(initialize_mutex_);
+  if (started_ == false) {
+    return;
+  }
+
+  // always join lastly created threads first.
+  size_t current_thread_count = current_thread_count_;
+  for (size_t i = 0; i < current_thread_count; ++i) {
+    dedicated_threads_[(current_thread_count - 1 - i)]->join();
+  }
+  dedicated_threads_.clear();
+  current_thread_count_ = 0;
+
+  {
+    std::lock_guard<std::mutex> sleep_lock(sleep_mutex_);
+    shutdown_ = true;
+  }
+  sleep_cv_.notify_all();
+
+  for (auto &worker : workers_) {
+    worker->thread.join();
+  }
+  workers_.clear();
+
+  pool_size_ = 0;
+  started_ = false;
+}
+
+int ThreadPool::GetCurrentWorkerId() const {
+  return (current_pool == this) ? current_worker_id : -1;
+}
+
+void ThreadPool::Spawn(Task *task) {
+  EnsureStarted();
+
+  // Nothing to run it on, execute in place
+  if (pool_size_ == 0) {
+    RunTask(task);
+    return;
+  }
+
+  int worker_id = GetCurrentWorkerId();
+  if (worker_id >= 0) {
+    workers_[worker_id]->deque.Push(task);
+  } else {
+    injection_queue_.Enqueue(task);
+  }
+
+  queued_task_count_.fetch_add(1, std::memory_order_seq_cst);
+  if (sleeping_worker_count_.load(std::memory_order_seq_cst) > 0) {
+    std::lock_guard<std::mutex> lock(sleep_mutex_);
+    sleep_cv_.notify_one();
+  }
+}
+
+bool ThreadPool::FindTask(const int worker_id, Task *&task) {
+  // Own deque first
+  if (worker_id >= 0 && workers_[worker_id]->deque.Pop(task) == true) {
+    queued_task_count_.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+  }
+
+  // Then work submitted from outside the pool
+  if (injection_queue_.Dequeue(task) == true) {
+    queued_task_count_.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+  }
+
+  // Then steal, starting with the next worker over
+  size_t worker_count = workers_.size();
+  size_t start = (worker_id >= 0) ? worker_id + 1 : 0;
+  for (size_t victim_itr = 0; victim_itr < worker_count; victim_itr++) {
+    size_t victim_id = (start + victim_itr) % worker_count;
+    if (static_cast<int>(victim_id) == worker_id) {
+      continue;
+    }
+    if (workers_[victim_id]->deque.Steal(task) == true) {
+      queued_task_count_.fetch_sub(1, std::memory_order_relaxed);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool ThreadPool::RunPendingTask() {
+  if (pool_size_ == 0) {
+    return false;
+  }
+
+  Task *task = nullptr;
+  if (FindTask(GetCurrentWorkerId(), task) == false) {
+    return false;
+  }
+
+  RunTask(task);
+  return true;
+}
+
+void ThreadPool::RunTask(Task *task) {
+  std::unique_ptr<Task> task_holder(task);
+  std::exception_ptr exception;
+
+  try {
+    task->function();
+  } catch (...) {
+    exception = std::current_exception();
+  }
+
+  if (task->group != nullptr) {
+    task->group->TaskDone(exception);
+  } else if (exception != nullptr) {
+    LOG_ERROR("Uncaught exception in thread pool task");
+  }
+}
+
+void ThreadPool::WorkerMain(const size_t worker_id) {
+  current_pool = this;
+  current_worker_id = worker_id;
+
+  Task *task = nullptr;
+  size_t idle_rounds = 0;
+
+  while (true) {
+    if (FindTask(worker_id, task) == true) {
+      RunTask(task);
+      idle_rounds = 0;
+      continue;
+    }
+
+    // Queues are drained, leave if the pool is going away
+    if (shutdown_.load(std::memory_order_relaxed) == true) {
+      break;
+    }
+
+    if (++idle_rounds < idle_spin_count) {
+      _mm_pause();
+      continue;
+    }
+
+    // Nothing to steal for a while, sleep until a task is spawned
+    std::unique_lock<std::mutex> lock(sleep_mutex_);
+    sleeping_worker_count_.fetch_add(1, std::memory_order_seq_cst);
+    sleep_cv_.wait(lock, [this] {
+      return queued_task_count_.load(std::memory_order_seq_cst) > 0 ||
+             shutdown_.load(std::memory_order_relaxed) == true;
+    });
+    sleeping_worker_count_.fetch_sub(1, std::memory_order_seq_cst);
+    idle_rounds = 0;
+  }
+
+  current_pool = nullptr;
+  current_worker_id = -1;
+}
+
+void ThreadPool::PinThread(std::thread &thread, const size_t &core_id) {
+  auto core_count = std::max(1u, std::thread::hardware_concurrency());
+
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  CPU_SET(core_id % core_count, &cpu_set);
+
+  int ret = pthread_setaffinity_np(thread.native_handle(), sizeof(cpu_set_t),
+                                   &cpu_set);
+  if (ret != 0) {
+    LOG_ERROR("Failed to pin thread to core %lu", core_id % core_count);
+  }
+}
+
+}  // End peloton namespace
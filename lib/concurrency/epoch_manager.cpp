@@ -0,0 +1,146 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// epoch_manager.cpp
+//
+// Identification: src/concurrency/epoch_manager.cpp
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+
+#include "concurrency/epoch_manager.h"
+
+#include "common/exception.h"
+#include "common/logger.h"
+#include "common/macros.h"
+
+namespace peloton {
+namespace concurrency {
+
+// Slot of a thread in the epoch manager, released when the thread exits
+struct ThreadEpochRegistration {
+  ~ThreadEpochRegistration() {
+    if (slot != INVALID_SLOT) {
+      EpochManager::GetInstance().ReleaseThreadSlot(slot);
+    }
+  }
+
+  static const size_t INVALID_SLOT = static_cast<size_t>(-1);
+
+  size_t slot = INVALID_SLOT;
+};
+
+thread_local ThreadEpochRegistration thread_epoch_registration;
+
+const size_t EpochManager::max_thread_count_;
+
+const uint64_t EpochManager::max_pin_count_;
+
+namespace {
+
+const int pin_count_bits = 16;
+
+inline uint64_t GetPinnedEpoch(const uint64_t &pin) {
+  return pin >> pin_count_bits;
+}
+
+inline uint64_t GetPinCount(const uint64_t &pin) {
+  return pin & EpochManager::max_pin_count_;
+}
+
+}  // namespace
+
+EpochManager::EpochManager() : current_epoch_(1) {
+  for (size_t slot = 0; slot < max_thread_count_; slot++) {
+    thread_epochs_[slot].pin = 0;
+    thread_epochs_[slot].used = false;
+  }
+}
+
+EpochManager &EpochManager::GetInstance() {
+  static EpochManager epoch_manager;
+  return epoch_manager;
+}
+
+size_t EpochManager::GetThreadSlot() {
+  auto &registration = thread_epoch_registration;
+  if (registration.slot != ThreadEpochRegistration::INVALID_SLOT) {
+    return registration.slot;
+  }
+
+  // Start looking at the thread's own index, threads that are alive
+  // together mostly end up in distinct slots on the first try
+  size_t start_slot = GetThreadIndex() % max_thread_count_;
+  for (size_t slot_itr = 0; slot_itr < max_thread_count_; slot_itr++) {
+    size_t slot = (start_slot + slot_itr) % max_thread_count_;
+    bool used = false;
+    if (thread_epochs_[slot].used.compare_exchange_strong(used, true) ==
+        true) {
+      registration.slot = slot;
+      return slot;
+    }
+  }
+
+  LOG_ERROR("More than %lu threads pin epochs", max_thread_count_);
+  throw Exception("Epoch manager ran out of thread slots");
+}
+
+void EpochManager::ReleaseThreadSlot(const size_t &slot) {
+  // Pins the thread handed over to others stay, the next thread to take the
+  // slot adds its pins to them
+  thread_epochs_[slot].used.store(false, std::memory_order_release);
+}
+
+uint64_t EpochManager::EnterEpoch(size_t &slot) {
+  slot = GetThreadSlot();
+  auto &thread_epoch = thread_epochs_[slot];
+
+  // Publish the pin before touching anything, a reclaimer that misses it
+  // only reclaims what was retired before the pin
+  uint64_t pin = thread_epoch.pin.load(std::memory_order_relaxed);
+  uint64_t new_pin;
+  do {
+    if (GetPinCount(pin) == 0) {
+      new_pin = (GetCurrentEpoch() << pin_count_bits) | 1;
+    } else {
+      PL_ASSERT(GetPinCount(pin) < max_pin_count_);
+      new_pin = pin + 1;
+    }
+  } while (thread_epoch.pin.compare_exchange_weak(
+               pin, new_pin, std::memory_order_seq_cst) == false);
+
+  return GetPinnedEpoch(new_pin);
+}
+
+void EpochManager::ExitEpoch(const size_t &slot) {
+  PL_ASSERT(slot < max_thread_count_);
+  auto &thread_epoch = thread_epochs_[slot];
+
+  uint64_t pin = thread_epoch.pin.load(std::memory_order_relaxed);
+  uint64_t new_pin;
+  do {
+    PL_ASSERT(GetPinCount(pin) > 0);
+    new_pin = (GetPinCount(pin) == 1) ? 0 : pin - 1;
+  } while (thread_epoch.pin.compare_exchange_weak(
+               pin, new_pin, std::memory_order_release) == false);
+}
+
+uint64_t EpochManager::GetReclaimableEpoch() const {
+  uint64_t reclaimable_epoch = current_epoch_.load(std::memory_order_seq_cst);
+
+  for (size_t slot = 0; slot < max_thread_count_; slot++) {
+    uint64_t epoch = GetPinnedEpoch(
+        thread_epochs_[slot].pin.load(std::memory_order_seq_cst));
+    if (epoch != 0 && epoch < reclaimable_epoch) {
+      reclaimable_epoch = epoch;
+    }
+  }
+
+  return reclaimable_epoch;
+}
+
+}  // End concurrency namespace
+}  // End peloton namespace
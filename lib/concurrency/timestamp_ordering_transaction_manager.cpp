@@ -12,10 +12,14 @@
 
 #include "concurrency/timestamp_ordering_transaction_manager.h"
 
+#include <set>
+
 #include "catalog/manager.h"
 #include "common/exception.h"
 #include "common/logger.h"
 #include "common/platform.h"
+#include "concurrency/epoch_manager.h"
+#include "gc/gc_manager.h"
 #include "logging/log_manager.h"
 #include "logging/records/transaction_record.h"
 
@@ -39,12 +43,230 @@ void TimestampOrderingTransactionManager::InitTupleReserved(
   *(cid_t *)(reserved_area + LAST_READER_OFFSET) = 0;
 }
 
-bool TimestampOrderingTransactionManager::PerformRead(
-    const ItemPointer &location,
-    bool acquire_ownership) {
+Spinlock *TimestampOrderingTransactionManager::GetSpinlockField(
+    const storage::TileGroupHeader *const tile_group_header,
+    const oid_t &tuple_id) {
+  return (Spinlock *)(tile_group_header->GetReservedFieldRef(tuple_id) +
+                      LOCK_OFFSET);
+}
+
+cid_t TimestampOrderingTransactionManager::GetLastReaderCommitId(
+    const storage::TileGroupHeader *const tile_group_header,
+    const oid_t &tuple_id) {
+  return *(cid_t *)(tile_group_header->GetReservedFieldRef(tuple_id) +
+                    LAST_READER_OFFSET);
+}
+
+bool TimestampOrderingTransactionManager::SetLastReaderCommitId(
+    const storage::TileGroupHeader *const tile_group_header,
+    const oid_t &tuple_id, const cid_t &current_cid) {
+  // get the pointer to the last_reader_cid field.
+  cid_t *ts_ptr = (cid_t *)(tile_group_header->GetReservedFieldRef(tuple_id) +
+                            LAST_READER_OFFSET);
+
+  GetSpinlockField(tile_group_header, tuple_id)->Lock();
+
+  txn_id_t tuple_txn_id = tile_group_header->GetTransactionId(tuple_id);
+
+  if (tuple_txn_id != INITIAL_TXN_ID) {
+    // if the write lock has already been acquired by some concurrent
+    // transactions, then return without setting the last_reader_cid.
+    GetSpinlockField(tile_group_header, tuple_id)->Unlock();
+    return false;
+  } else {
+    // if current_cid is larger than the current value of last_reader_cid
+    // field, then set last_reader_cid field to current_cid.
+    if (*ts_ptr < current_cid) {
+      *ts_ptr = current_cid;
+    }
+
+    GetSpinlockField(tile_group_header, tuple_id)->Unlock();
+    return true;
+  }
+}
+
+bool TimestampOrderingTransactionManager::IsOwner(
+    Transaction *const current_txn,
+    const storage::TileGroupHeader *const tile_group_header,
+    const oid_t &tuple_id) {
+  auto tuple_txn_id = tile_group_header->GetTransactionId(tuple_id);
+
+  return tuple_txn_id == current_txn->GetTransactionId();
+}
+
+bool TimestampOrderingTransactionManager::IsWritten(
+    Transaction *const current_txn,
+    const storage::TileGroupHeader *const tile_group_header,
+    const oid_t &tuple_id) {
+  auto tuple_txn_id = tile_group_header->GetTransactionId(tuple_id);
+  auto tuple_begin_cid = tile_group_header->GetBeginCommitId(tuple_id);
+
+  return tuple_txn_id == current_txn->GetTransactionId() &&
+         tuple_begin_cid == MAX_CID;
+}
+
+// if the tuple is not owned by any transaction and is visible to current
+// transaction.
+bool TimestampOrderingTransactionManager::IsOwnable(
+    UNUSED_ATTRIBUTE Transaction *const current_txn,
+    const storage::TileGroupHeader *const tile_group_header,
+    const oid_t &tuple_id) {
+  auto tuple_txn_id = tile_group_header->GetTransactionId(tuple_id);
+  auto tuple_end_cid = tile_group_header->GetEndCommitId(tuple_id);
+
+  return tuple_txn_id == INITIAL_TXN_ID && tuple_end_cid == MAX_CID;
+}
+
+bool TimestampOrderingTransactionManager::AcquireOwnership(
+    Transaction *const current_txn,
+    const storage::TileGroupHeader *const tile_group_header,
+    const oid_t &tuple_id) {
+  auto txn_id = current_txn->GetTransactionId();
+
+  // to acquire the ownership,
+  // we must guarantee that no transaction that has read
+  // the tuple has a larger timestamp than the current transaction.
+  GetSpinlockField(tile_group_header, tuple_id)->Lock();
+
+  // change timestamp
+  cid_t last_reader_cid = GetLastReaderCommitId(tile_group_header, tuple_id);
+
+  if (last_reader_cid > current_txn->GetBeginCommitId() ||
+      tile_group_header->SetAtomicTransactionId(tuple_id, txn_id) == false) {
+    GetSpinlockField(tile_group_header, tuple_id)->Unlock();
+    return false;
+  }
+
+  GetSpinlockField(tile_group_header, tuple_id)->Unlock();
+  return true;
+}
+
+void TimestampOrderingTransactionManager::YieldOwnership(
+    UNUSED_ATTRIBUTE Transaction *const current_txn,
+    const oid_t &tile_group_id, const oid_t &tuple_id) {
+  auto &manager = catalog::Manager::GetInstance();
+  auto tile_group_header = manager.GetTileGroup(tile_group_id)->GetHeader();
+  PL_ASSERT(IsOwner(current_txn, tile_group_header, tuple_id));
+  tile_group_header->SetTransactionId(tuple_id, INITIAL_TXN_ID);
+}
+
+bool TimestampOrderingTransactionManager::IsOccupied(
+    Transaction *const current_txn, const void *position_ptr) {
+  ItemPointer &position = *((ItemPointer *)position_ptr);
+
+  auto tile_group_header = catalog::Manager::GetInstance()
+                               .GetTileGroup(position.block)
+                               ->GetHeader();
+  auto tuple_id = position.offset;
+
+  txn_id_t tuple_txn_id = tile_group_header->GetTransactionId(tuple_id);
+  cid_t tuple_begin_cid = tile_group_header->GetBeginCommitId(tuple_id);
+  cid_t tuple_end_cid = tile_group_header->GetEndCommitId(tuple_id);
+
+  if (tuple_txn_id == INVALID_TXN_ID) {
+    // the tuple is not available.
+    return false;
+  }
+
+  // the tuple has already been owned by the current transaction.
+  bool own = (current_txn->GetTransactionId() == tuple_txn_id);
+  // the tuple has already been committed.
+  bool activated = (current_txn->GetBeginCommitId() >= tuple_begin_cid);
+  // the tuple is not visible.
+  bool invalidated = (current_txn->GetBeginCommitId() >= tuple_end_cid);
+
+  // there are exactly two versions that can be owned by a transaction.
+  // unless it is an insertion/select for update.
+  if (own == true) {
+    if (tuple_begin_cid == MAX_CID && tuple_end_cid != INVALID_CID) {
+      PL_ASSERT(tuple_end_cid == MAX_CID);
+      // the only version that is visible is the newly inserted one.
+      return true;
+    } else if (current_txn->GetRWType(position) == RWType::READ_OWN) {
+      // the ownership is from a select-for-update read operation
+      return true;
+    } else {
+      // the older version is not visible.
+      return false;
+    }
+  } else {
+    if (tuple_txn_id != INITIAL_TXN_ID) {
+      // if the tuple is owned by other transactions, or claimed for one.
+      if (tuple_begin_cid == MAX_CID) {
+        // uncommitted version. a dirty delete is invisible, a dirty update
+        // or insert is visible.
+        return tuple_end_cid != INVALID_CID;
+      } else {
+        // the older version may be visible.
+        return activated && !invalidated;
+      }
+    } else {
+      // if the tuple is not owned by any transaction.
+      return activated && !invalidated;
+    }
+  }
+}
+
+VisibilityType TimestampOrderingTransactionManager::IsVisible(
+    Transaction *const current_txn,
+    const storage::TileGroupHeader *const tile_group_header,
+    const oid_t &tuple_id) {
+  txn_id_t tuple_txn_id = tile_group_header->GetTransactionId(tuple_id);
+  cid_t tuple_begin_cid = tile_group_header->GetBeginCommitId(tuple_id);
+  cid_t tuple_end_cid = tile_group_header->GetEndCommitId(tuple_id);
+
+  // the tuple has already been owned by the current transaction.
+  bool own = (current_txn->GetTransactionId() == tuple_txn_id);
+  // the tuple has already been committed.
+  bool activated = (current_txn->GetBeginCommitId() >= tuple_begin_cid);
+  // the tuple is not visible.
+  bool invalidated = (current_txn->GetBeginCommitId() >= tuple_end_cid);
+
+  if (tuple_txn_id == INVALID_TXN_ID) {
+    // the tuple is not available.
+    if (activated && !invalidated) {
+      // deleted tuple
+      return VisibilityType::DELETED;
+    } else {
+      // aborted tuple
+      return VisibilityType::INVISIBLE;
+    }
+  }
+
+  // there are exactly two versions that can be owned by a transaction,
+  // unless it is an insertion.
+  if (own == true) {
+    if (tuple_begin_cid == MAX_CID && tuple_end_cid != INVALID_CID) {
+      PL_ASSERT(tuple_end_cid == MAX_CID);
+      // the only version that is visible is the newly inserted/updated one.
+      return VisibilityType::OK;
+    } else if (tuple_end_cid == INVALID_CID) {
+      // tuple being deleted by current txn
+      return VisibilityType::DELETED;
+    } else {
+      // old version of the tuple that is being updated by current txn
+      return VisibilityType::INVISIBLE;
+    }
+  }
+
+  // uncommitted versions of other transactions, and claimed slots, are
+  // invisible. committed versions are visible in their range, whoever
+  // owns them.
+  if (tuple_txn_id != INITIAL_TXN_ID && tuple_begin_cid == MAX_CID) {
+    return VisibilityType::INVISIBLE;
+  }
 
+  if (activated && !invalidated) {
+    return VisibilityType::OK;
+  } else {
+    return VisibilityType::INVISIBLE;
+  }
+}
 
- /* oid_t tile_group_id = location.block;
+bool TimestampOrderingTransactionManager::PerformRead(
+    Transaction *const current_txn, const ItemPointer &location,
+    bool acquire_ownership) {
+  oid_t tile_group_id = location.block;
   oid_t tuple_id = location.offset;
 
   LOG_TRACE("PerformRead (%u, %u)\n", location.block, location.offset);
@@ -53,8 +275,7 @@ bool TimestampOrderingTransactionManager::PerformRead(
   auto tile_group_header = tile_group->GetHeader();
 
   // Check if it's select for update before we check the ownership and modify
-  // the
-  // last reader tid
+  // the last reader tid
   if (acquire_ownership == true &&
       IsOwner(current_txn, tile_group_header, tuple_id) == false) {
     // Acquire ownership if we haven't
@@ -70,39 +291,30 @@ bool TimestampOrderingTransactionManager::PerformRead(
     current_txn->RecordReadOwn(location);
   }
 
-  // if the current transaction has already owned this tuple, then perform read
-  // directly.
+  // if the current transaction has already owned this tuple, then perform
+  // read directly.
   if (IsOwner(current_txn, tile_group_header, tuple_id) == true) {
     PL_ASSERT(GetLastReaderCommitId(tile_group_header, tuple_id) <=
               current_txn->GetBeginCommitId());
-    // Increment table read op stats
-    if (FLAGS_stats_mode != STATS_TYPE_INVALID) {
-      stats::BackendStatsContext::GetInstance()->IncrementTableReads(
-          location.block);
-    }
     return true;
   }
-  // if the current transaction does not own this tuple, then attemp to set last
-  // reader cid.
+
+  // if the current transaction does not own this tuple, then attempt to set
+  // last reader cid.
   if (SetLastReaderCommitId(tile_group_header, tuple_id,
                             current_txn->GetBeginCommitId()) == true) {
     current_txn->RecordRead(location);
-    // Increment table read op stats
-    if (FLAGS_stats_mode != STATS_TYPE_INVALID) {
-      stats::BackendStatsContext::GetInstance()->IncrementTableReads(
-          location.block);
-    }
     return true;
   } else {
     // if the tuple has been owned by some concurrent transactions, then read
     // fails.
-    LOG_TRACE("Transaction read failed");*/
+    LOG_TRACE("Transaction read failed");
     return false;
-
+  }
 }
 
 void TimestampOrderingTransactionManager::PerformInsert(
-     const ItemPointer &location,
+    Transaction *const current_txn, const ItemPointer &location,
     ItemPointer *index_entry_ptr) {
   PL_ASSERT(current_txn->IsDeclaredReadOnly() == false);
 
@@ -111,30 +323,30 @@ void TimestampOrderingTransactionManager::PerformInsert(
 
   auto &manager = catalog::Manager::GetInstance();
   auto tile_group_header = manager.GetTileGroup(tile_group_id)->GetHeader();
+  auto transaction_id = current_txn->GetTransactionId();
 
+  // check MVCC info
+  // the tuple slot must have been claimed for the insert.
+  PL_ASSERT(tile_group_header->GetTransactionId(tuple_id) == CLAIMED_TXN_ID);
+  PL_ASSERT(tile_group_header->GetBeginCommitId(tuple_id) == MAX_CID);
+  PL_ASSERT(tile_group_header->GetEndCommitId(tuple_id) == MAX_CID);
 
-  //tile_group_header->SetTransactionId(tuple_id, transaction_id);
+  tile_group_header->SetTransactionId(tuple_id, transaction_id);
 
   // no need to set next item pointer.
 
   // Add the new tuple into the insert set
-  //current_txn->RecordInsert(location);
+  current_txn->RecordInsert(location);
 
   InitTupleReserved(tile_group_header, tuple_id);
 
   // Write down the head pointer's address in tile group header
   tile_group_header->SetIndirection(tuple_id, index_entry_ptr);
-
-  // Increment table insert op stats
-  if (FLAGS_stats_mode != STATS_TYPE_INVALID) {
-    stats::BackendStatsContext::GetInstance()->IncrementTableInserts(
-        location.block);
-  }
 }
 
 void TimestampOrderingTransactionManager::PerformUpdate(
-    const ItemPointer &old_location,
-    const ItemPointer &new_location) {/*
+    Transaction *const current_txn, const ItemPointer &old_location,
+    const ItemPointer &new_location) {
   PL_ASSERT(current_txn->IsDeclaredReadOnly() == false);
 
   LOG_TRACE("Performing Write old tuple %u %u", old_location.block,
@@ -155,7 +367,7 @@ void TimestampOrderingTransactionManager::PerformUpdate(
   PL_ASSERT(tile_group_header->GetTransactionId(old_location.offset) ==
             transaction_id);
   PL_ASSERT(new_tile_group_header->GetTransactionId(new_location.offset) ==
-            INVALID_TXN_ID);
+            CLAIMED_TXN_ID);
   PL_ASSERT(new_tile_group_header->GetBeginCommitId(new_location.offset) ==
             MAX_CID);
   PL_ASSERT(new_tile_group_header->GetEndCommitId(new_location.offset) ==
@@ -201,7 +413,6 @@ void TimestampOrderingTransactionManager::PerformUpdate(
         tile_group_header->GetIndirection(old_location.offset);
 
     if (index_entry_ptr != nullptr) {
-
       new_tile_group_header->SetIndirection(new_location.offset,
                                             index_entry_ptr);
 
@@ -220,23 +431,14 @@ void TimestampOrderingTransactionManager::PerformUpdate(
 
   // Add the old tuple into the update set
   current_txn->RecordUpdate(old_location);
-
-  // Increment table update op stats
-  if (FLAGS_stats_mode != STATS_TYPE_INVALID) {
-    stats::BackendStatsContext::GetInstance()->IncrementTableUpdates(
-        new_location.block);
-  }*/
-
-    return false;
 }
 
 void TimestampOrderingTransactionManager::PerformUpdate(
-     const ItemPointer &location) {
-    /*
+    Transaction *const current_txn, const ItemPointer &location) {
   PL_ASSERT(current_txn->IsDeclaredReadOnly() == false);
 
   oid_t tile_group_id = location.block;
-  oid_t tuple_id = location.offset;
+  UNUSED_ATTRIBUTE oid_t tuple_id = location.offset;
 
   auto &manager = catalog::Manager::GetInstance();
   auto tile_group_header = manager.GetTileGroup(tile_group_id)->GetHeader();
@@ -252,12 +454,6 @@ void TimestampOrderingTransactionManager::PerformUpdate(
     // update an inserted version
     current_txn->RecordUpdate(old_location);
   }
-
-  // Increment table update op stats
-  if (FLAGS_stats_mode != STATS_TYPE_INVALID) {
-    stats::BackendStatsContext::GetInstance()->IncrementTableUpdates(
-        location.block);
-  }
 }
 
 void TimestampOrderingTransactionManager::PerformDelete(
@@ -282,7 +478,7 @@ void TimestampOrderingTransactionManager::PerformDelete(
   PL_ASSERT(tile_group_header->GetTransactionId(old_location.offset) ==
             transaction_id);
   PL_ASSERT(new_tile_group_header->GetTransactionId(new_location.offset) ==
-            INVALID_TXN_ID);
+            CLAIMED_TXN_ID);
   PL_ASSERT(new_tile_group_header->GetBeginCommitId(new_location.offset) ==
             MAX_CID);
   PL_ASSERT(new_tile_group_header->GetEndCommitId(new_location.offset) ==
@@ -344,17 +540,10 @@ void TimestampOrderingTransactionManager::PerformDelete(
   }
 
   current_txn->RecordDelete(old_location);
-
-  // Increment table delete op stats
-  if (FLAGS_stats_mode != STATS_TYPE_INVALID) {
-    stats::BackendStatsContext::GetInstance()->IncrementTableDeletes(
-        old_location.block);
-  } */
-    return false;
 }
 
 void TimestampOrderingTransactionManager::PerformDelete(
-    const ItemPointer &location) {/*
+    Transaction *const current_txn, const ItemPointer &location) {
   PL_ASSERT(current_txn->IsDeclaredReadOnly() == false);
 
   oid_t tile_group_id = location.block;
@@ -378,12 +567,57 @@ void TimestampOrderingTransactionManager::PerformDelete(
     // if this version is newly inserted.
     current_txn->RecordDelete(location);
   }
+}
+
+Transaction *TimestampOrderingTransactionManager::BeginTransaction(
+    const size_t thread_id) {
+  // The transaction pins an epoch until it ends, neither the versions it can
+  // see nor the slots it claims are reclaimed before. The pin goes with the
+  // transaction, it may end on another thread.
+  size_t epoch_slot;
+  uint64_t epoch_id = EpochManager::GetInstance().EnterEpoch(epoch_slot);
+
+  txn_id_t txn_id = GetNextTransactionId();
+  cid_t begin_cid = GetNextCommitId();
+  Transaction *txn = new Transaction(thread_id, txn_id, begin_cid);
+  txn->SetEpoch(epoch_slot, epoch_id);
+
+  LOG_TRACE("Beginning peloton txn : %lu ", txn_id);
+  return txn;
+}
+
+Transaction *TimestampOrderingTransactionManager::BeginReadonlyTransaction(
+    const size_t thread_id) {
+  size_t epoch_slot;
+  uint64_t epoch_id = EpochManager::GetInstance().EnterEpoch(epoch_slot);
+
+  txn_id_t txn_id = GetNextTransactionId();
+  cid_t begin_cid = GetNextCommitId();
+  Transaction *txn = new Transaction(thread_id, txn_id, begin_cid, true);
+  txn->SetEpoch(epoch_slot, epoch_id);
+
+  LOG_TRACE("Beginning readonly peloton txn : %lu ", txn_id);
+  return txn;
+}
+
+void TimestampOrderingTransactionManager::EndTransaction(
+    Transaction *current_txn) {
+  size_t epoch_slot = current_txn->GetEpochSlot();
+  delete current_txn;
+
+  // Whatever the transaction made obsolete can be reclaimed once the
+  // transactions that began before it are done as well
+  EpochManager::GetInstance().ExitEpoch(epoch_slot);
+}
 
-  // Increment table delete op stats
-  if (FLAGS_stats_mode != STATS_TYPE_INVALID) {
-    stats::BackendStatsContext::GetInstance()->IncrementTableDeletes(
-        location.block);
-  }*/
+void TimestampOrderingTransactionManager::EndReadonlyTransaction(
+    Transaction *current_txn) {
+  PL_ASSERT(current_txn->IsDeclaredReadOnly() == true);
+
+  size_t epoch_slot = current_txn->GetEpochSlot();
+  delete current_txn;
+
+  EpochManager::GetInstance().ExitEpoch(epoch_slot);
 }
 
 ResultType TimestampOrderingTransactionManager::CommitTransaction(
@@ -397,6 +631,7 @@ ResultType TimestampOrderingTransactionManager::CommitTransaction(
 
   auto &manager = catalog::Manager::GetInstance();
   auto &log_manager = logging::LogManager::GetInstance();
+  auto &gc_manager = gc::GCManager::GetInstance();
 
   // generate transaction id.
   cid_t end_commit_id = current_txn->GetBeginCommitId();
@@ -406,13 +641,8 @@ ResultType TimestampOrderingTransactionManager::CommitTransaction(
 
   auto gc_set = current_txn->GetGCSetPtr();
 
-  oid_t database_id = 0;
-  if (FLAGS_stats_mode != STATS_TYPE_INVALID) {
-    if (!rw_set.empty()) {
-      database_id =
-          manager.GetTileGroup(rw_set.begin()->first)->GetDatabaseId();
-    }
-  }
+  // tile groups holding versions installed below
+  std::set<oid_t> written_tile_group_ids;
 
   // install everything.
   // 1. install a new version for update operations;
@@ -456,9 +686,15 @@ ResultType TimestampOrderingTransactionManager::CommitTransaction(
                                                 INITIAL_TXN_ID);
         tile_group_header->SetTransactionId(tuple_slot, INITIAL_TXN_ID);
 
+        written_tile_group_ids.insert(tile_group_id);
+        written_tile_group_ids.insert(new_version.block);
+
         // add to gc set.
         gc_set->operator[](tile_group_id)[tuple_slot] = false;
 
+        // the replaced version goes once no running snapshot can see it
+        gc_manager.RecycleOldVersion(ItemPointer(tile_group_id, tuple_slot));
+
         // add to log manager
         log_manager.LogUpdate(
             end_commit_id, ItemPointer(tile_group_id, tuple_slot), new_version);
@@ -486,6 +722,9 @@ ResultType TimestampOrderingTransactionManager::CommitTransaction(
                                                 INVALID_TXN_ID);
         tile_group_header->SetTransactionId(tuple_slot, INITIAL_TXN_ID);
 
+        written_tile_group_ids.insert(tile_group_id);
+        written_tile_group_ids.insert(new_version.block);
+
         // add to gc set.
         // we need to recycle both old and new versions.
         // we require the GC to delete tuple from index only once.
@@ -494,6 +733,10 @@ ResultType TimestampOrderingTransactionManager::CommitTransaction(
         // recycle new version (which is an empty version), do not delete from index
         gc_set->operator[](new_version.block)[new_version.offset] = false;
 
+        // the deleted version goes once no running snapshot can see it. The
+        // empty version heads the chain the indexes lead to, it stays.
+        gc_manager.RecycleOldVersion(ItemPointer(tile_group_id, tuple_slot));
+
         // add to log manager
         log_manager.LogDelete(end_commit_id,
                               ItemPointer(tile_group_id, tuple_slot));
@@ -510,6 +753,8 @@ ResultType TimestampOrderingTransactionManager::CommitTransaction(
 
         tile_group_header->SetTransactionId(tuple_slot, INITIAL_TXN_ID);
 
+        written_tile_group_ids.insert(tile_group_id);
+
         // nothing to be added to gc set.
 
         // add to log manager
@@ -537,16 +782,19 @@ ResultType TimestampOrderingTransactionManager::CommitTransaction(
     }
   }
 
+  // the installed versions reach persistent tile groups before the commit is
+  // reported
+  for (auto written_tile_group_id : written_tile_group_ids) {
+    auto tile_group = manager.GetTileGroup(written_tile_group_id);
+    if (tile_group != nullptr) {
+      tile_group->Sync();
+    }
+  }
+
   ResultType result = current_txn->GetResult();
 
   EndTransaction(current_txn);
 
-  // Increment # txns committed metric
-  if (FLAGS_stats_mode != STATS_TYPE_INVALID) {
-    stats::BackendStatsContext::GetInstance()->IncrementTxnCommitted(
-        database_id);
-  }
-
   return result;
 }
 
@@ -562,14 +810,6 @@ ResultType TimestampOrderingTransactionManager::AbortTransaction(
 
   auto gc_set = current_txn->GetGCSetPtr();
 
-  oid_t database_id = 0;
-  if (FLAGS_stats_mode != STATS_TYPE_INVALID) {
-    if (!rw_set.empty()) {
-      database_id =
-          manager.GetTileGroup(rw_set.begin()->first)->GetDatabaseId();
-    }
-  }
-
   for (auto &tile_group_entry : rw_set) {
     oid_t tile_group_id = tile_group_entry.first;
     auto tile_group = manager.GetTileGroup(tile_group_id);
@@ -725,11 +965,6 @@ ResultType TimestampOrderingTransactionManager::AbortTransaction(
   current_txn->SetResult(ResultType::ABORTED);
   EndTransaction(current_txn);
 
-  // Increment # txns aborted metric
-  if (FLAGS_stats_mode != STATS_TYPE_INVALID) {
-    stats::BackendStatsContext::GetInstance()->IncrementTxnAborted(database_id);
-  }
-
   return ResultType::ABORTED;
 }
 
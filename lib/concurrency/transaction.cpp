@@ -0,0 +1,152 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// transaction.cpp
+//
+// Identification: src/concurrency/transaction.cpp
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "concurrency/transaction.h"
+
+#include <iomanip>
+#include <sstream>
+
+#include "common/logger.h"
+#include "common/macros.h"
+#include "common/platform.h"
+
+namespace peloton {
+namespace concurrency {
+
+Transaction::Transaction(const size_t thread_id, const txn_id_t &txn_id,
+                         const cid_t &begin_cid, const bool readonly)
+    : txn_id_(txn_id),
+      begin_cid_(begin_cid),
+      thread_id_(thread_id),
+      gc_set_(new GCSet()),
+      declared_readonly_(readonly) {}
+
+Transaction::~Transaction() {}
+
+RWType Transaction::GetRWType(const ItemPointer &location) {
+  oid_t tile_group_id = location.block;
+  oid_t tuple_id = location.offset;
+
+  auto tile_group_itr = rw_set_.find(tile_group_id);
+  if (tile_group_itr == rw_set_.end()) {
+    return RWType::INVALID;
+  }
+
+  auto tuple_itr = tile_group_itr->second.find(tuple_id);
+  if (tuple_itr == tile_group_itr->second.end()) {
+    return RWType::INVALID;
+  }
+
+  return tuple_itr->second;
+}
+
+void Transaction::RecordRead(const ItemPointer &location) {
+  oid_t tile_group_id = location.block;
+  oid_t tuple_id = location.offset;
+
+  auto &tile_group_set = rw_set_[tile_group_id];
+  auto tuple_itr = tile_group_set.find(tuple_id);
+  if (tuple_itr != tile_group_set.end()) {
+    PL_ASSERT(tuple_itr->second != RWType::DELETE &&
+              tuple_itr->second != RWType::INS_DEL);
+    return;
+  }
+
+  tile_group_set[tuple_id] = RWType::READ;
+}
+
+void Transaction::RecordReadOwn(const ItemPointer &location) {
+  oid_t tile_group_id = location.block;
+  oid_t tuple_id = location.offset;
+
+  auto &tile_group_set = rw_set_[tile_group_id];
+  auto tuple_itr = tile_group_set.find(tuple_id);
+  if (tuple_itr != tile_group_set.end()) {
+    RWType &type = tuple_itr->second;
+    PL_ASSERT(type != RWType::DELETE && type != RWType::INS_DEL);
+    if (type == RWType::READ) {
+      type = RWType::READ_OWN;
+    }
+    return;
+  }
+
+  tile_group_set[tuple_id] = RWType::READ_OWN;
+}
+
+void Transaction::RecordUpdate(const ItemPointer &location) {
+  oid_t tile_group_id = location.block;
+  oid_t tuple_id = location.offset;
+
+  auto &tile_group_set = rw_set_[tile_group_id];
+  auto tuple_itr = tile_group_set.find(tuple_id);
+  if (tuple_itr != tile_group_set.end()) {
+    RWType &type = tuple_itr->second;
+    PL_ASSERT(type != RWType::DELETE && type != RWType::INS_DEL);
+    // Updates of the transaction's own inserts stay inserts
+    if (type == RWType::READ || type == RWType::READ_OWN) {
+      type = RWType::UPDATE;
+      is_written_ = true;
+    }
+    return;
+  }
+
+  tile_group_set[tuple_id] = RWType::UPDATE;
+  is_written_ = true;
+}
+
+void Transaction::RecordInsert(const ItemPointer &location) {
+  oid_t tile_group_id = location.block;
+  oid_t tuple_id = location.offset;
+
+  PL_ASSERT(GetRWType(location) == RWType::INVALID);
+
+  rw_set_[tile_group_id][tuple_id] = RWType::INSERT;
+  ++insert_count_;
+}
+
+bool Transaction::RecordDelete(const ItemPointer &location) {
+  oid_t tile_group_id = location.block;
+  oid_t tuple_id = location.offset;
+
+  auto &tile_group_set = rw_set_[tile_group_id];
+  auto tuple_itr = tile_group_set.find(tuple_id);
+  if (tuple_itr != tile_group_set.end()) {
+    RWType &type = tuple_itr->second;
+    PL_ASSERT(type != RWType::DELETE && type != RWType::INS_DEL);
+    if (type == RWType::INSERT) {
+      type = RWType::INS_DEL;
+      --insert_count_;
+      return true;
+    }
+    type = RWType::DELETE;
+    is_written_ = true;
+    return false;
+  }
+
+  tile_group_set[tuple_id] = RWType::DELETE;
+  is_written_ = true;
+  return false;
+}
+
+const std::string Transaction::GetInfo() const {
+  std::ostringstream os;
+
+  os << "\tTxn :: @" << this << " ID : " << std::setw(4) << txn_id_
+     << " Begin Commit ID : " << std::setw(4) << begin_cid_
+     << " Epoch : " << std::setw(4) << epoch_id_
+     << " Result : " << ResultTypeToString(result_);
+
+  return os.str();
+}
+
+}  // End concurrency namespace
+}  // End peloton namespace
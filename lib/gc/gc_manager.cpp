@@ -0,0 +1,165 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// gc_manager.cpp
+//
+// Identification: src/gc/gc_manager.cpp
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "gc/gc_manager.h"
+
+#include <chrono>
+#include <vector>
+
+#include "catalog/manager.h"
+#include "common/logger.h"
+#include "concurrency/epoch_manager.h"
+#include "storage/data_table.h"
+#include "storage/tile_group.h"
+#include "storage/tile_group_header.h"
+
+namespace peloton {
+namespace gc {
+
+const size_t GCManager::shard_count_;
+
+const size_t GCManager::cooperative_collection_threshold_;
+
+GCManager::GCManager()
+    : pending_version_count_(0),
+      collected_version_count_(0),
+      gc_stop_(false) {}
+
+GCManager::~GCManager() { StopGC(); }
+
+GCManager &GCManager::GetInstance() {
+  static GCManager gc_manager;
+  return gc_manager;
+}
+
+void GCManager::StartGC() {
+  StopGC();
+
+  gc_stop_ = false;
+  gc_thread_ = std::thread(&GCManager::Running, this);
+}
+
+void GCManager::StopGC() {
+  gc_stop_ = true;
+
+  if (gc_thread_.joinable() == true) {
+    gc_thread_.join();
+  }
+}
+
+void GCManager::Running() {
+  while (gc_stop_ == false) {
+    Collect();
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(gc_sleep_duration_));
+  }
+}
+
+void GCManager::RecycleOldVersion(const ItemPointer &location) {
+  auto epoch = concurrency::EpochManager::GetInstance().GetCurrentEpoch();
+  auto &shard = shards_[GetThreadIndex() % shard_count_];
+
+  shard.shard_lock.Lock();
+  shard.old_versions.emplace_back(epoch, location);
+  size_t old_version_count = shard.old_versions.size();
+  shard.shard_lock.Unlock();
+
+  pending_version_count_.fetch_add(1, std::memory_order_relaxed);
+
+  // Keep the queue short without a GC thread
+  if (old_version_count >= cooperative_collection_threshold_) {
+    CollectShard(shard, GetReclaimableEpoch());
+  }
+}
+
+uint64_t GCManager::GetReclaimableEpoch() {
+  auto &epoch_manager = concurrency::EpochManager::GetInstance();
+  epoch_manager.AdvanceEpoch();
+  return epoch_manager.GetReclaimableEpoch();
+}
+
+size_t GCManager::Collect() {
+  if (pending_version_count_ == 0) {
+    return 0;
+  }
+
+  uint64_t reclaimable_epoch = GetReclaimableEpoch();
+  size_t collected_count = 0;
+  for (size_t shard_itr = 0; shard_itr < shard_count_; shard_itr++) {
+    collected_count += CollectShard(shards_[shard_itr], reclaimable_epoch);
+  }
+
+  return collected_count;
+}
+
+size_t GCManager::CollectShard(Shard &shard,
+                               const uint64_t &reclaimable_epoch) {
+  // Take the versions out, the collection itself runs without the lock
+  std::vector<ItemPointer> old_versions;
+  shard.shard_lock.Lock();
+  while (shard.old_versions.empty() == false &&
+         shard.old_versions.front().first < reclaimable_epoch) {
+    old_versions.push_back(shard.old_versions.front().second);
+    shard.old_versions.pop_front();
+  }
+  shard.shard_lock.Unlock();
+
+  for (auto &location : old_versions) {
+    CollectVersion(location);
+  }
+
+  pending_version_count_.fetch_sub(old_versions.size(),
+                                   std::memory_order_relaxed);
+  collected_version_count_.fetch_add(old_versions.size(),
+                                     std::memory_order_relaxed);
+  return old_versions.size();
+}
+
+void GCManager::CollectVersion(const ItemPointer &location) {
+  auto &manager = catalog::Manager::GetInstance();
+
+  // Versions of dropped tile groups went with them
+  auto tile_group = manager.GetTileGroup(location.block);
+  if (tile_group == nullptr) {
+    return;
+  }
+  auto tile_group_header = tile_group->GetHeader();
+
+  // The version chain ends at the newer version
+  ItemPointer prev_location =
+      tile_group_header->GetPrevItemPointer(location.offset);
+  if (prev_location.IsNull() == false) {
+    auto prev_tile_group = manager.GetTileGroup(prev_location.block);
+    if (prev_tile_group != nullptr) {
+      auto prev_tile_group_header = prev_tile_group->GetHeader();
+      ItemPointer next_location =
+          prev_tile_group_header->GetNextItemPointer(prev_location.offset);
+      if (next_location.block == location.block &&
+          next_location.offset == location.offset) {
+        prev_tile_group_header->SetNextItemPointer(prev_location.offset,
+                                                   INVALID_ITEMPOINTER);
+      }
+    }
+  }
+
+  tile_group->FreeUninlinedData(location.offset);
+
+  LOG_TRACE("Collected version %u, %u", location.block, location.offset);
+
+  auto table = dynamic_cast<storage::DataTable *>(tile_group->GetAbstractTable());
+  if (table != nullptr) {
+    table->ReleaseTupleSlot(location);
+  }
+}
+
+}  // End gc namespace
+}  // End peloton namespace
@@ -0,0 +1,47 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// crc32c.h
+//
+// Identification: src/include/common/crc32c.h
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace peloton {
+
+//===--------------------------------------------------------------------===//
+// CRC32C
+//===--------------------------------------------------------------------===//
+
+/**
+ * CRC32C (Castagnoli) checksums.
+ *
+ * Uses the SSE4.2 crc32 instruction when the cpu supports it and a
+ * slicing-by-8 table lookup otherwise, both produce the same checksums.
+ */
+class Crc32c {
+ public:
+  // Checksum of data
+  static uint32_t Value(const char *data, size_t length) {
+    return Extend(0, data, length);
+  }
+
+  // Checksum of the concatenation of the data checksummed as crc and data
+  static uint32_t Extend(uint32_t crc, const char *data, size_t length);
+
+  static bool IsHardwareAccelerated();
+
+  // Extend with the table lookup even if the cpu has the crc32 instruction
+  static uint32_t ExtendSoftware(uint32_t crc, const char *data,
+                                 size_t length);
+};
+
+}  // End peloton namespace
@@ -0,0 +1,46 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// numa_util.h
+//
+// Identification: src/include/common/numa_util.h
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+
+namespace peloton {
+
+//===--------------------------------------------------------------------===//
+// NUMA Utilities
+//===--------------------------------------------------------------------===//
+
+/**
+ * Thin wrapper around the NUMA topology exported by sysfs and the mbind
+ * system call, so that we do not depend on libnuma.
+ * On machines without NUMA support everything maps to node 0.
+ */
+class NumaUtil {
+ public:
+  // Number of memory nodes, at least one
+  static size_t GetNodeCount();
+
+  // Node of the cpu the calling thread is running on
+  static int GetCurrentNode();
+
+  // Node the given cpu belongs to
+  static int GetNodeOfCpu(const int cpu);
+
+  // Prefer placing the pages of [address, address + length) on the given
+  // node, migrating pages that are already faulted in. The range must be
+  // page-aligned. Returns false if the kernel refused, in which case pages
+  // land wherever they are first touched.
+  static bool BindToNode(void *address, const size_t length, const int node);
+};
+
+}  // End peloton namespace
@@ -15,6 +15,8 @@
 
 #include <thread>
 #include <atomic>
+#include <cstdlib>
+#include <new>
 
 #include <pthread.h>
 #include <immintrin.h>
@@ -41,6 +43,34 @@ inline bool atomic_cas(T *object, T old_value, T new_value) {
 // some helpers for cacheline alignment
 #define CACHE_ALIGNED __attribute__((aligned(CACHELINE_SIZE)))
 
+// Before C++17 operator new ignores alignment beyond max_align_t. Types that
+// are CACHE_ALIGNED, or hold members that are, and get allocated with new
+// derive from this to start on a cache line of their own.
+struct CacheAlignedAllocation {
+  static void *operator new(std::size_t size) {
+    void *ptr = nullptr;
+    if (posix_memalign(&ptr, CACHELINE_SIZE, size) != 0) {
+      throw std::bad_alloc();
+    }
+    return ptr;
+  }
+
+  static void operator delete(void *ptr) { free(ptr); }
+};
+
+//===--------------------------------------------------------------------===//
+// Thread index
+//===--------------------------------------------------------------------===//
+
+// Dense number of the calling thread, handed out in the order threads first
+// ask for it. Used to spread threads over per-thread shards and lanes.
+inline size_t GetThreadIndex() {
+  static std::atomic<size_t> next_thread_index(0);
+  static thread_local size_t thread_index =
+      next_thread_index.fetch_add(1, std::memory_order_relaxed);
+  return thread_index;
+}
+
 //===--------------------------------------------------------------------===//
 // Reader/Writer lock
 //===--------------------------------------------------------------------===//
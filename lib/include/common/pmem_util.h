@@ -0,0 +1,55 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// pmem_util.h
+//
+// Identification: src/include/common/pmem_util.h
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+
+namespace peloton {
+
+//===--------------------------------------------------------------------===//
+// Persistent Memory Utilities
+//===--------------------------------------------------------------------===//
+
+/**
+ * Cache flush, fence and non-temporal copy primitives for persistent memory.
+ *
+ * The flush instruction is picked once, from what the cpu supports: CLWB,
+ * then CLFLUSHOPT, then CLFLUSH. Without any of them, or on other
+ * architectures, we run in emulation mode where flushes only keep the
+ * compiler from reordering stores and copies go through the cache.
+ */
+class PmemUtil {
+ public:
+  // Write back the cache lines covering [address, address + length).
+  // Only ordered against later stores after a Fence.
+  static void Flush(const void *address, const size_t length);
+
+  // Wait for preceding flushes and non-temporal stores
+  static void Fence();
+
+  // Flush followed by Fence
+  static void Persist(const void *address, const size_t length);
+
+  // memcpy streaming the bulk of the copy around the cache. On return the
+  // destination is written back as far as a Flush would have, so a Fence
+  // makes it durable.
+  static void *MemcpyNontemporal(void *destination, const void *source,
+                                 const size_t length);
+
+  // Flush instruction in use, "emulated" in emulation mode
+  static const char *GetFlushInstructionName();
+
+  static bool IsEmulated();
+};
+
+}  // End peloton namespace
@@ -4,7 +4,7 @@
 //
 // thread_pool.h
 //
-// Identification: src/include/common/worker_thread_pool.h
+// Identification: src/include/common/thread_pool.h
 //
 // Copyright (c) 2015-16, Carnegie Mellon University Database Group
 //
@@ -13,72 +13,196 @@
 
 #pragma once
 
-#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <thread>
-
-#include <boost/asio/io_service.hpp>
-#include <boost/thread/thread.hpp>
-#include <boost/bind.hpp>
-#include <boost/function.hpp>
+#include <vector>
 
 #include "common/macros.h"
+#include "common/platform.h"
+#include "container/lock_free_queue.h"
+#include "container/work_stealing_deque.h"
 
 namespace peloton {
-// a wrapper for boost worker thread pool.
-class ThreadPool {
+
+class ThreadPool;
+
+//===--------------------------------------------------------------------===//
+// Task Group
+//===--------------------------------------------------------------------===//
+
+/**
+ * Tracks a set of tasks spawned on a thread pool so that the spawner can join
+ * them. A thread waiting on a group keeps executing pending tasks instead of
+ * blocking, so groups can be nested inside tasks without starving the pool.
+ * The first exception thrown by a task of the group is rethrown by Wait().
+ */
+class TaskGroup {
+  friend class ThreadPool;
+
  public:
-  ThreadPool() : pool_size_(0), 
-                 dedicated_thread_count_(0),
-                 work_(io_service_) { }
+  TaskGroup(ThreadPool &pool) : pool_(pool), pending_tasks_(0) {}
 
-  ~ThreadPool() { }
+  TaskGroup(const TaskGroup &) = delete;
+  TaskGroup &operator=(const TaskGroup &) = delete;
 
-  void Initialize(const size_t &pool_size, const size_t &dedicated_thread_count) {
-    pool_size_ = pool_size;
-    // PL_ASSERT(pool_size_ != 0);
+  ~TaskGroup();
 
-    dedicated_thread_count_ = dedicated_thread_count;
+  // Spawn a task belonging to this group
+  template <typename FunctionType>
+  void Run(FunctionType &&func);
 
-    for (size_t i = 0; i < pool_size_; ++i) {
-      // add thread to thread pool.
-      thread_pool_.create_thread(
-          boost::bind(&boost::asio::io_service::run, &io_service_));
-    }
+  // Wait for all tasks of this group to finish
+  void Wait();
 
-    dedicated_threads_.resize(dedicated_thread_count_);
-  }
+ private:
+  void TaskDone(std::exception_ptr exception);
 
-  void Shutdown() {
-    // always join lastly created threads first.
-    for (size_t i = 0; i < current_thread_count_; ++i) {
-      dedicated_threads_[(current_thread_count_ - 1 - i)]->join();
-    }
-    io_service_.stop();
-    thread_pool_.join_all();
-  }
+  ThreadPool &pool_;
+
+  std::atomic<size_t> pending_tasks_;
+
+  std::mutex exception_mutex_;
+
+  std::exception_ptr exception_;
+};
+
+//===--------------------------------------------------------------------===//
+// Thread Pool
+//===--------------------------------------------------------------------===//
+
+/**
+ * Work-stealing task scheduler.
+ *
+ * Every worker owns a Chase-Lev deque. Tasks spawned by a worker go to the
+ * bottom of its own deque and are popped LIFO for locality, idle workers steal
+ * FIFO from the top of the other deques. Tasks submitted from threads outside
+ * the pool go through a shared injection queue. Workers that find no work
+ * spin briefly and then sleep until new tasks arrive.
+ *
+ * If Initialize() was not called before the first task is submitted, the pool
+ * starts one worker per hardware thread.
+ */
+class ThreadPool {
+  friend class TaskGroup;
+
+ public:
+  typedef std::function<void()> TaskType;
+
+  ThreadPool();
+
+  ~ThreadPool();
+
+  void Initialize(const size_t &pool_size,
+                  const size_t &dedicated_thread_count,
+                  const bool &pin_threads = false);
+
+  void Shutdown();
 
   // submit task to thread pool.
   // it accepts a function and a set of function parameters as parameters.
   template <typename FunctionType, typename... ParamTypes>
-  void SubmitTask(FunctionType &&func, const ParamTypes &&... params) {
-    // add task to thread pool.
-    io_service_.post(std::bind(func, params...));
+  void SubmitTask(FunctionType &&func, ParamTypes &&... params) {
+    Spawn(new Task(std::bind(std::forward<FunctionType>(func),
+                             std::forward<ParamTypes>(params)...),
+                   nullptr));
   }
 
   // submit task to a dedicated thread.
   // it accepts a function and a set of function parameters as parameters.
   template <typename FunctionType, typename... ParamTypes>
-  void SubmitDedicatedTask(FunctionType &&func, const ParamTypes &&... params) {
+  void SubmitDedicatedTask(FunctionType &&func, ParamTypes &&... params) {
     size_t thread_id =
         current_thread_count_.fetch_add(1, std::memory_order_relaxed);
+    PL_ASSERT(thread_id < dedicated_threads_.size());
     // assign task to dedicated thread.
-    dedicated_threads_[thread_id].reset(new std::thread(std::thread(func, params...)));
+    dedicated_threads_[thread_id].reset(
+        new std::thread(std::forward<FunctionType>(func),
+                        std::forward<ParamTypes>(params)...));
+    if (pin_threads_ == true) {
+      PinThread(*dedicated_threads_[thread_id], pool_size_ + thread_id);
+    }
   }
 
+  // Split [begin, end) into chunks of at most grain iterations and call
+  // func(chunk_begin, chunk_end) on each of them in parallel. Returns once
+  // all chunks are done.
+  template <typename FunctionType>
+  void ParallelFor(const size_t &begin, const size_t &end, const size_t &grain,
+                   FunctionType &&func) {
+    if (begin >= end) {
+      return;
+    }
+
+    TaskGroup group(*this);
+    ParallelForRange(group, begin, end, std::max<size_t>(grain, 1), func);
+    group.Wait();
+  }
+
+  size_t GetPoolSize() const { return pool_size_; }
+
+  // Id of the pool worker running the calling thread, -1 for other threads
+  int GetCurrentWorkerId() const;
+
  private:
   ThreadPool(const ThreadPool &);
   ThreadPool &operator=(const ThreadPool &);
 
+  struct Task {
+    Task(TaskType &&function, TaskGroup *group)
+        : function(std::move(function)), group(group) {}
+
+    TaskType function;
+
+    // group the task belongs to, if any
+    TaskGroup *group;
+  };
+
+  // The deque's ends are cache aligned
+  struct Worker : public CacheAlignedAllocation {
+    WorkStealingDeque<Task *> deque;
+
+    std::thread thread;
+  };
+
+  template <typename FunctionType>
+  void ParallelForRange(TaskGroup &group, size_t begin, size_t end,
+                        const size_t grain, FunctionType &func) {
+    // Hand the upper halves to the pool and keep the lowest chunk
+    while (end - begin > grain) {
+      size_t middle = begin + (end - begin) / 2;
+      group.Run([this, &group, middle, end, grain, &func]() {
+        ParallelForRange(group, middle, end, grain, func);
+      });
+      end = middle;
+    }
+    func(begin, end);
+  }
+
+  void Start(const size_t &pool_size, const size_t &dedicated_thread_count,
+             const bool &pin_threads);
+
+  // Start the default number of workers if nobody initialized the pool
+  void EnsureStarted();
+
+  void Spawn(Task *task);
+
+  // Run one pending task on the calling thread, returns false if none found
+  bool RunPendingTask();
+
+  bool FindTask(const int worker_id, Task *&task);
+
+  void RunTask(Task *task);
+
+  void WorkerMain(const size_t worker_id);
+
+  static void PinThread(std::thread &thread, const size_t &core_id);
+
  private:
   // number of threads in the thread pool.
   size_t pool_size_;
@@ -87,15 +211,36 @@ class ThreadPool {
   // current number of dedicated threads.
   std::atomic<size_t> current_thread_count_ = ATOMIC_VAR_INIT(0);
 
-  // real thread pool that holds a set of threads.
-  boost::thread_group thread_pool_;
-  // io_service provides IO functionality of asynchronize services.
-  boost::asio::io_service io_service_;
-  // io_service::work is responsible for starting the io_service processing
-  // loop.
-  boost::asio::io_service::work work_;
+  // pin workers and dedicated threads to cores
+  bool pin_threads_;
+
+  std::atomic<bool> started_;
+
+  std::atomic<bool> shutdown_;
+
+  std::mutex initialize_mutex_;
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+
+  // tasks submitted from threads outside the pool
+  LockFreeQueue<Task *> injection_queue_;
+
+  // tasks sitting in any queue
+  std::atomic<int64_t> queued_task_count_;
+
+  // idle workers wait here for new tasks
+  std::atomic<size_t> sleeping_worker_count_;
+  std::mutex sleep_mutex_;
+  std::condition_variable sleep_cv_;
 
   std::vector<std::unique_ptr<std::thread>> dedicated_threads_;
 };
 
+template <typename FunctionType>
+void TaskGroup::Run(FunctionType &&func) {
+  pending_tasks_.fetch_add(1, std::memory_order_relaxed);
+  pool_.Spawn(new ThreadPool::Task(
+      ThreadPool::TaskType(std::forward<FunctionType>(func)), this));
+}
+
 }  // End peloton namespace
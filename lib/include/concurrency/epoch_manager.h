@@ -0,0 +1,117 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// epoch_manager.h
+//
+// Identification: src/include/concurrency/epoch_manager.h
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "common/platform.h"
+
+namespace peloton {
+namespace concurrency {
+
+//===--------------------------------------------------------------------===//
+// Epoch Manager
+//===--------------------------------------------------------------------===//
+
+/**
+ * Decentralized epoch-based reclamation.
+ *
+ * A thread pins the current epoch while it may hold on to versions it looked
+ * up, e.g. for the duration of a scan or a transaction. Whatever is retired
+ * in an epoch can be reused once every pinned epoch is newer, as no thread
+ * can still refer to it then. Every thread pins in its own cache line, the
+ * epoch counter is only written when retired state is reclaimed.
+ *
+ * Pins are counted per slot, the oldest one holds until all of them are
+ * released. A pin may be released from another thread than the one that
+ * took it, as long as the slot it was taken in is passed along.
+ */
+class EpochManager {
+  EpochManager(EpochManager const &) = delete;
+
+ public:
+  EpochManager();
+
+  static EpochManager &GetInstance();
+
+  // Pin the current epoch for the calling thread. Pins nest, the outermost
+  // one counts.
+  uint64_t EnterEpoch() {
+    size_t slot;
+    return EnterEpoch(slot);
+  }
+
+  void ExitEpoch() { ExitEpoch(GetThreadSlot()); }
+
+  // Pin the current epoch in the calling thread's slot, which is returned so
+  // that any thread can release the pin later. Returns the pinned epoch.
+  uint64_t EnterEpoch(size_t &slot);
+
+  void ExitEpoch(const size_t &slot);
+
+  uint64_t GetCurrentEpoch() const {
+    return current_epoch_.load(std::memory_order_acquire);
+  }
+
+  // Start a new epoch, returns the new epoch
+  uint64_t AdvanceEpoch() {
+    return current_epoch_.fetch_add(1, std::memory_order_acq_rel) + 1;
+  }
+
+  // State retired in an epoch older than this one is no longer reachable
+  uint64_t GetReclaimableEpoch() const;
+
+  static const size_t max_thread_count_ = 256;
+
+  // pins held on one slot at once
+  static const uint64_t max_pin_count_ = (UINT64_C(1) << 16) - 1;
+
+ private:
+  struct CACHE_ALIGNED ThreadEpoch {
+    // pinned epoch in the high bits, number of pins in the low 16 bits. 0 if
+    // the slot is not pinned.
+    std::atomic<uint64_t> pin;
+
+    std::atomic<bool> used;
+  };
+
+  // Slot of the calling thread, registered on first use
+  size_t GetThreadSlot();
+
+  void ReleaseThreadSlot(const size_t &slot);
+
+  friend struct ThreadEpochRegistration;
+
+  std::atomic<uint64_t> current_epoch_;
+
+  ThreadEpoch thread_epochs_[max_thread_count_];
+};
+
+//===--------------------------------------------------------------------===//
+// Epoch Guard
+//===--------------------------------------------------------------------===//
+
+// Pins the current epoch for the lifetime of the guard
+class EpochGuard {
+  EpochGuard(EpochGuard const &) = delete;
+
+ public:
+  EpochGuard() { EpochManager::GetInstance().EnterEpoch(); }
+
+  ~EpochGuard() { EpochManager::GetInstance().ExitEpoch(); }
+};
+
+}  // End concurrency namespace
+}  // End peloton namespace
@@ -0,0 +1,130 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// transaction.h
+//
+// Identification: src/include/concurrency/transaction.h
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "common/item_pointer.h"
+#include "common/printable.h"
+#include "type/types.h"
+
+namespace peloton {
+namespace concurrency {
+
+//===--------------------------------------------------------------------===//
+// Transaction
+//===--------------------------------------------------------------------===//
+
+class Transaction : public Printable {
+  Transaction(Transaction const &) = delete;
+
+ public:
+  Transaction(const size_t thread_id, const txn_id_t &txn_id,
+              const cid_t &begin_cid, const bool readonly = false);
+
+  ~Transaction();
+
+  //===--------------------------------------------------------------------===//
+  // Mutators and Accessors
+  //===--------------------------------------------------------------------===//
+
+  inline txn_id_t GetTransactionId() const { return txn_id_; }
+
+  inline cid_t GetBeginCommitId() const { return begin_cid_; }
+
+  inline size_t GetThreadId() const { return thread_id_; }
+
+  // Epoch the transaction pins while it runs, and the epoch manager slot the
+  // pin was taken in
+  inline uint64_t GetEpochId() const { return epoch_id_; }
+
+  inline size_t GetEpochSlot() const { return epoch_slot_; }
+
+  inline void SetEpoch(const size_t &epoch_slot, const uint64_t &epoch_id) {
+    epoch_slot_ = epoch_slot;
+    epoch_id_ = epoch_id;
+  }
+
+  // record read set
+  void RecordRead(const ItemPointer &location);
+
+  // record read set, the ownership was acquired for a later update
+  void RecordReadOwn(const ItemPointer &location);
+
+  // record write set
+  void RecordUpdate(const ItemPointer &location);
+
+  // record insert set
+  void RecordInsert(const ItemPointer &location);
+
+  // Return true if we detect INS_DEL
+  bool RecordDelete(const ItemPointer &location);
+
+  RWType GetRWType(const ItemPointer &location);
+
+  inline const ReadWriteSet &GetReadWriteSet() { return rw_set_; }
+
+  inline std::shared_ptr<GCSet> GetGCSetPtr() { return gc_set_; }
+
+  // Get a string representation for debugging
+  const std::string GetInfo() const;
+
+  // Set result and status
+  inline void SetResult(ResultType result) { result_ = result; }
+
+  // Get result and status
+  inline ResultType GetResult() const { return result_; }
+
+  inline bool IsReadOnly() const {
+    return is_written_ == false && insert_count_ == 0;
+  }
+
+  inline bool IsDeclaredReadOnly() const { return declared_readonly_; }
+
+ private:
+  //===--------------------------------------------------------------------===//
+  // Data members
+  //===--------------------------------------------------------------------===//
+
+  // transaction id
+  txn_id_t txn_id_;
+
+  // start commit id
+  cid_t begin_cid_;
+
+  // thread id
+  size_t thread_id_;
+
+  // epoch pinned by the transaction and the slot it was pinned in
+  uint64_t epoch_id_ = 0;
+
+  size_t epoch_slot_ = 0;
+
+  ReadWriteSet rw_set_;
+
+  std::shared_ptr<GCSet> gc_set_;
+
+  // result of the transaction
+  ResultType result_ = ResultType::SUCCESS;
+
+  bool is_written_ = false;
+
+  size_t insert_count_ = 0;
+
+  bool declared_readonly_;
+};
+
+}  // End concurrency namespace
+}  // End peloton namespace
@@ -20,6 +20,8 @@
 
 #include "storage/tile_group_header.h"
 #include "common/logger.h"
+#include "common/platform.h"
+#include "concurrency/transaction.h"
 
 namespace peloton {
 
@@ -36,46 +38,111 @@ class Manager;
 
 namespace concurrency {
 
-class Transaction;
-
 class TransactionManager {
  public:
   TransactionManager() {
+    next_txn_id_ = ATOMIC_VAR_INIT(START_TXN_ID);
     next_cid_ = ATOMIC_VAR_INIT(START_CID);
     maximum_grant_cid_ = ATOMIC_VAR_INIT(MAX_CID);
   }
 
   virtual ~TransactionManager() {}
 
+  // This method is used for avoiding concurrent inserts.
+  virtual bool IsOccupied(Transaction *const current_txn,
+                          const void *position) = 0;
+
+  virtual VisibilityType IsVisible(
+      Transaction *const current_txn,
+      const storage::TileGroupHeader *const tile_group_header,
+      const oid_t &tuple_id) = 0;
+
+  // This method test whether the current transaction is the owner of a tuple.
+  virtual bool IsOwner(Transaction *const current_txn,
+                       const storage::TileGroupHeader *const tile_group_header,
+                       const oid_t &tuple_id) = 0;
+
+  // This method tests whether the current transaction has created this
+  // version of the tuple
+  virtual bool IsWritten(
+      Transaction *const current_txn,
+      const storage::TileGroupHeader *const tile_group_header,
+      const oid_t &tuple_id) = 0;
+
+  // This method tests whether it is possible to obtain the ownership.
+  virtual bool IsOwnable(
+      Transaction *const current_txn,
+      const storage::TileGroupHeader *const tile_group_header,
+      const oid_t &tuple_id) = 0;
+
+  // This method is used to acquire the ownership of a tuple for a
+  // transaction.
+  virtual bool AcquireOwnership(
+      Transaction *const current_txn,
+      const storage::TileGroupHeader *const tile_group_header,
+      const oid_t &tuple_id) = 0;
+
+  // This method is used by executor to yield ownership after the acquired
+  // ownership.
+  virtual void YieldOwnership(Transaction *const current_txn,
+                              const oid_t &tile_group_id,
+                              const oid_t &tuple_id) = 0;
 
   // The index_entry_ptr is the address of the head node of the version chain, 
   // which is directly pointed by the primary index.
-  virtual void PerformInsert(
+  virtual void PerformInsert(Transaction *const current_txn,
                              const ItemPointer &location, 
                              ItemPointer *index_entry_ptr = nullptr) = 0;
 
-  virtual bool PerformRead(
+  virtual bool PerformRead(Transaction *const current_txn,
                            const ItemPointer &location,
                            bool acquire_ownership = false) = 0;
 
-  virtual void PerformUpdate(
+  virtual void PerformUpdate(Transaction *const current_txn,
                              const ItemPointer &old_location,
                              const ItemPointer &new_location) = 0;
 
-  virtual void PerformDelete(
+  virtual void PerformDelete(Transaction *const current_txn,
                              const ItemPointer &old_location,
                              const ItemPointer &new_location) = 0;
 
-  virtual void PerformUpdate(const ItemPointer &location) = 0;
+  virtual void PerformUpdate(Transaction *const current_txn,
+                             const ItemPointer &location) = 0;
+
+  virtual void PerformDelete(Transaction *const current_txn,
+                             const ItemPointer &location) = 0;
+
+  virtual ResultType CommitTransaction(Transaction *const current_txn) = 0;
+
+  virtual ResultType AbortTransaction(Transaction *const current_txn) = 0;
+
+  virtual Transaction *BeginTransaction(const size_t thread_id = 0) = 0;
 
-  virtual void PerformDelete(const ItemPointer &location) = 0;
+  virtual Transaction *BeginReadonlyTransaction(const size_t thread_id = 0) = 0;
+
+  virtual void EndTransaction(Transaction *current_txn) = 0;
+
+  virtual void EndReadonlyTransaction(Transaction *current_txn) = 0;
+
+  txn_id_t GetNextTransactionId() { return next_txn_id_++; }
+
+  cid_t GetNextCommitId() {
+    cid_t temp_cid = next_cid_++;
+    // wait if we do not yet have a grant for this commit id
+    while (temp_cid > maximum_grant_cid_.load()) {
+      _mm_pause();
+    }
+    return temp_cid;
+  }
 
   void ResetStates() {
+    next_txn_id_ = START_TXN_ID;
     next_cid_ = START_CID;
   }
 
 
  private:
+  std::atomic<txn_id_t> next_txn_id_;
   std::atomic<cid_t> next_cid_;
   std::atomic<cid_t> maximum_grant_cid_;
 
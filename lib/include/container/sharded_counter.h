@@ -0,0 +1,74 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// sharded_counter.h
+//
+// Identification: src/include/container/sharded_counter.h
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+
+#include "common/platform.h"
+
+namespace peloton {
+
+//===--------------------------------------------------------------------===//
+// Sharded Counter
+//===--------------------------------------------------------------------===//
+
+/**
+ * Counter that threads update without sharing a cache line.
+ *
+ * Every thread adds to the shard of its thread index, reading the counter
+ * sums up all shards. Reads are thus more expensive than updates and only
+ * see a consistent value when no updates run concurrently.
+ */
+class ShardedCounter {
+  ShardedCounter(ShardedCounter const &) = delete;
+
+ public:
+  ShardedCounter() { Set(0); }
+
+  inline void Add(const int64_t amount) {
+    shards_[GetThreadIndex() % shard_count_].value.fetch_add(
+        amount, std::memory_order_relaxed);
+  }
+
+  inline void Sub(const int64_t amount) { Add(-amount); }
+
+  // Not atomic with respect to concurrent updates
+  void Set(const int64_t value) {
+    for (size_t shard_itr = 0; shard_itr < shard_count_; shard_itr++) {
+      shards_[shard_itr].value.store(0, std::memory_order_relaxed);
+    }
+    shards_[0].value.store(value, std::memory_order_relaxed);
+  }
+
+  int64_t Get() const {
+    int64_t value = 0;
+    for (size_t shard_itr = 0; shard_itr < shard_count_; shard_itr++) {
+      value += shards_[shard_itr].value.load(std::memory_order_relaxed);
+    }
+    return value;
+  }
+
+  static const size_t shard_count_ = 32;
+
+ private:
+  struct CACHE_ALIGNED Shard {
+    std::atomic<int64_t> value;
+  };
+
+  Shard shards_[shard_count_];
+};
+
+}  // End peloton namespace
@@ -0,0 +1,157 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// work_stealing_deque.h
+//
+// Identification: src/include/container/work_stealing_deque.h
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "common/macros.h"
+#include "common/platform.h"
+
+namespace peloton {
+
+//===--------------------------------------------------------------------===//
+// Work-stealing Deque -- Chase-Lev deque with a single owner that pushes and
+// pops at the bottom, and any number of thieves that steal from the top.
+//
+// Follows "Correct and Efficient Work-Stealing for Weak Memory Models"
+// (Le et al., PPoPP'13). T must be trivially copyable (e.g. a pointer).
+//===--------------------------------------------------------------------===//
+
+template <typename T>
+class WorkStealingDeque {
+ public:
+  WorkStealingDeque(const size_t &capacity = 1024)
+      : top_(0), bottom_(0), array_(new Array(capacity)) {
+    PL_ASSERT(capacity > 0 && (capacity & (capacity - 1)) == 0);
+  }
+
+  WorkStealingDeque(const WorkStealingDeque &) = delete;
+  WorkStealingDeque &operator=(const WorkStealingDeque &) = delete;
+
+  ~WorkStealingDeque() { delete array_.load(std::memory_order_relaxed); }
+
+  // Push an item at the bottom. Only the owner may call this.
+  void Push(const T &item) {
+    int64_t bottom = bottom_.load(std::memory_order_relaxed);
+    int64_t top = top_.load(std::memory_order_acquire);
+    Array *array = array_.load(std::memory_order_relaxed);
+
+    if (bottom - top > static_cast<int64_t>(array->capacity) - 1) {
+      // Thieves may still be reading the old array, keep it until we are
+      // destroyed
+      Array *new_array = array->Grow(top, bottom);
+      retired_arrays_.emplace_back(array);
+      array_.store(new_array, std::memory_order_release);
+      array = new_array;
+    }
+
+    array->Put(bottom, item);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom_.store(bottom + 1, std::memory_order_relaxed);
+  }
+
+  // Pop an item from the bottom, returning false if the deque was empty.
+  // Only the owner may call this.
+  bool Pop(T &item) {
+    int64_t bottom = bottom_.load(std::memory_order_relaxed) - 1;
+    Array *array = array_.load(std::memory_order_relaxed);
+    bottom_.store(bottom, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t top = top_.load(std::memory_order_relaxed);
+
+    if (top > bottom) {
+      // Empty
+      bottom_.store(bottom + 1, std::memory_order_relaxed);
+      return false;
+    }
+
+    item = array->Get(bottom);
+    if (top == bottom) {
+      // Last item, race against thieves for it
+      bool won = top_.compare_exchange_strong(top, top + 1,
+                                              std::memory_order_seq_cst,
+                                              std::memory_order_relaxed);
+      bottom_.store(bottom + 1, std::memory_order_relaxed);
+      return won;
+    }
+
+    return true;
+  }
+
+  // Steal an item from the top, returning false if the deque was empty or
+  // another thread won the race for the item. Any thread may call this.
+  bool Steal(T &item) {
+    int64_t top = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t bottom = bottom_.load(std::memory_order_acquire);
+
+    if (top >= bottom) {
+      return false;
+    }
+
+    Array *array = array_.load(std::memory_order_acquire);
+    item = array->Get(top);
+    return top_.compare_exchange_strong(top, top + 1,
+                                        std::memory_order_seq_cst,
+                                        std::memory_order_relaxed);
+  }
+
+  bool IsEmpty() const {
+    int64_t bottom = bottom_.load(std::memory_order_relaxed);
+    int64_t top = top_.load(std::memory_order_relaxed);
+    return top >= bottom;
+  }
+
+ private:
+  // Circular array of items, grown by doubling
+  struct Array {
+    Array(const size_t &capacity)
+        : capacity(capacity), mask(capacity - 1), items(new std::atomic<T>[capacity]) {}
+
+    T Get(const int64_t &index) const {
+      return items[index & mask].load(std::memory_order_relaxed);
+    }
+
+    void Put(const int64_t &index, const T &item) {
+      items[index & mask].store(item, std::memory_order_relaxed);
+    }
+
+    Array *Grow(const int64_t &top, const int64_t &bottom) const {
+      Array *new_array = new Array(capacity * 2);
+      for (int64_t index = top; index < bottom; index++) {
+        new_array->Put(index, Get(index));
+      }
+      return new_array;
+    }
+
+    size_t capacity;
+    size_t mask;
+    std::unique_ptr<std::atomic<T>[]> items;
+  };
+
+  // Thieves side
+  std::atomic<int64_t> top_ CACHE_ALIGNED;
+
+  // Owner side
+  std::atomic<int64_t> bottom_ CACHE_ALIGNED;
+
+  std::atomic<Array *> array_;
+
+  // Arrays replaced by a grow, only touched by the owner
+  std::vector<std::unique_ptr<Array>> retired_arrays_;
+};
+
+}  // namespace peloton
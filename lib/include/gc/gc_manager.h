@@ -0,0 +1,115 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// gc_manager.h
+//
+// Identification: src/include/gc/gc_manager.h
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <thread>
+#include <utility>
+
+#include "common/item_pointer.h"
+#include "common/platform.h"
+#include "type/types.h"
+
+namespace peloton {
+namespace gc {
+
+//===--------------------------------------------------------------------===//
+// GC Manager
+//===--------------------------------------------------------------------===//
+
+/**
+ * Epoch-based garbage collection of old versions.
+ *
+ * Worker threads pin an epoch through the concurrency::EpochManager for as
+ * long as a transaction runs. A committed transaction hands the versions it
+ * made obsolete to the queue of its thread, tagged with the current epoch.
+ * Once every pinned epoch is newer, no snapshot can reach them anymore: their
+ * uninlined values go back to the tile pools, the version chain is cut in
+ * front of them and their slots go to the free slots of their table.
+ *
+ * Threads collect their own queue when it grows long, a background thread
+ * collects all queues if started.
+ */
+class GCManager {
+  GCManager(GCManager const &) = delete;
+
+ public:
+  GCManager();
+
+  ~GCManager();
+
+  static GCManager &GetInstance();
+
+  // Start collecting in the background
+  void StartGC();
+
+  // Stop collecting in the background
+  void StopGC();
+
+  // Hand over a version a committed transaction made obsolete
+  void RecycleOldVersion(const ItemPointer &location);
+
+  // Collect the old versions no pinned epoch can see anymore. Returns the
+  // number of versions collected.
+  size_t Collect();
+
+  // versions waiting to be collected
+  size_t GetPendingVersionCount() const { return pending_version_count_; }
+
+  size_t GetCollectedVersionCount() const { return collected_version_count_; }
+
+  static const size_t shard_count_ = 16;
+
+  // queued versions at which a thread collects its own queue
+  static const size_t cooperative_collection_threshold_ = 256;
+
+ private:
+  struct CACHE_ALIGNED Shard {
+    Spinlock shard_lock;
+
+    // <epoch, version> in the order they were handed over
+    std::deque<std::pair<uint64_t, ItemPointer>> old_versions;
+  };
+
+  // Collect the versions of the shard handed over before the reclaimable
+  // epoch
+  size_t CollectShard(Shard &shard, const uint64_t &reclaimable_epoch);
+
+  void CollectVersion(const ItemPointer &location);
+
+  // Start a new epoch so that the current one can end, returns the oldest
+  // epoch that is still pinned
+  uint64_t GetReclaimableEpoch();
+
+  // GC thread
+  void Running();
+
+  Shard shards_[shard_count_];
+
+  std::atomic<size_t> pending_version_count_;
+
+  std::atomic<size_t> collected_version_count_;
+
+  // Stop signal
+  std::atomic<bool> gc_stop_;
+
+  std::thread gc_thread_;
+
+  // Sleeping period between collections (in ms)
+  oid_t gc_sleep_duration_ = 10;
+};
+
+}  // End gc namespace
+}  // End peloton namespace
@@ -12,13 +12,14 @@
 
 #pragma once
 
+#include <atomic>
 #include <condition_variable>
 #include <mutex>
 #include <vector>
 
 #include "common/item_pointer.h"
 #include "common/platform.h"
-#include "logging/circular_buffer_pool.h"
+#include "logging/lock_free_buffer_pool.h"
 #include "logging/log_buffer.h"
 #include "logging/log_record.h"
 #include "logging/logger.h"
@@ -27,6 +28,8 @@
 namespace peloton {
 namespace logging {
 
+class FrontendLogger;
+
 //===--------------------------------------------------------------------===//
 // Backend Logger
 //===--------------------------------------------------------------------===//
@@ -55,15 +58,11 @@ class BackendLogger : public Logger {
                                     ItemPointer delete_location,
                                     const void *data = nullptr) = 0;
 
+  // Only called from the thread owning this backend logger
   void SetLoggingCidLowerBound(cid_t cid) {
-    // XXX bad synchronization practice
-    log_buffer_lock.Lock();
-
     logging_cid_lower_bound = cid;
 
     highest_logged_commit_message = INVALID_CID;
-
-    log_buffer_lock.Unlock();
   }
 
   // FIXME The following methods should be exposed to FrontendLogger only
@@ -77,6 +76,8 @@ class BackendLogger : public Logger {
   // returns a pair of commit ids, the first is the lower bound for values this
   // logger may
   // commit, The second is the maximum id this worker has committed
+  // The frontend logger only collects the buffers handed over by the backend,
+  // the current buffer stays with the backend thread
   std::pair<cid_t, cid_t> PrepareLogBuffers();
 
   // Grant an empty buffer to use
@@ -95,20 +96,26 @@ class BackendLogger : public Logger {
   type::AbstractPool *GetVarlenPool() { return backend_pool.get(); }
 
  protected:
-  // the lock for the buffer being used currently
-  Spinlock log_buffer_lock;
+  // Hand the current buffer over to the frontend logger
+  void PersistLogBuffer();
 
   // temporary local_queue used by backend
   std::vector<std::unique_ptr<LogBuffer>> local_queue;
 
   // commit id of the highest value committed so far
-  cid_t highest_logged_commit_message = INVALID_CID;
+  std::atomic<cid_t> highest_logged_commit_message{INVALID_CID};
+
+  // highest commit id the frontend logger has collected, only used by it
+  cid_t collected_commit_message = INVALID_CID;
 
   // id of the corresponding frontend logger
   int frontend_logger_id = -1;  // default
 
+  // the corresponding frontend logger, notified of full buffers and commits
+  FrontendLogger *frontend_logger = nullptr;
+
   // lower bound for values this backend may commit
-  cid_t logging_cid_lower_bound = INVALID_CID;
+  std::atomic<cid_t> logging_cid_lower_bound{INVALID_CID};
 
   // max cid for the current log buffer
   cid_t max_log_id_buffer = 0;
@@ -116,7 +123,7 @@ class BackendLogger : public Logger {
   // temporary serialization buffer
   CopySerializeOutput output_buffer;
 
-  // the current buffer
+  // the current buffer, only touched by the thread owning this backend
   std::unique_ptr<LogBuffer> log_buffer_;
 
   // the pool of available buffers
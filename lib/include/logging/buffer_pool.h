@@ -28,7 +28,7 @@
 #include "logging/log_buffer.h"
 #include <memory>
 
-// Buffer Pool Size has to be 2^n
+// Number of log buffers granted to every backend logger
 #define BUFFER_POOL_SIZE 16
 
 namespace peloton {
@@ -47,6 +47,9 @@ class BufferPool {
   // get a buffer from the buffer pool
   virtual std::unique_ptr<LogBuffer> Get() = 0;
 
+  // get a buffer from the buffer pool without waiting, false if it is empty
+  virtual bool TryGet(std::unique_ptr<LogBuffer> &) = 0;
+
   virtual unsigned int GetSize() = 0;
 };
 
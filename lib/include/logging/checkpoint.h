@@ -18,6 +18,7 @@
 
 #include "common/item_pointer.h"
 #include "type/ephemeral_pool.h"
+#include "type/serializeio.h"
 #include "type/types.h"
 
 namespace peloton {
@@ -52,7 +53,7 @@ class Checkpoint {
   // Do recovery from most recent version of checkpoint
   virtual cid_t DoRecovery() = 0;
 
-  void RecoverTuple(storage::Tuple *tuple, storage::DataTable *table,
+  void RecoverTuple(SerializeInput &tuple_body, storage::DataTable *table,
                     ItemPointer target_location, cid_t commit_id);
 
   inline cid_t GetMostRecentCheckpointCid() {
@@ -15,6 +15,7 @@
 
 #include <memory>
 #include <thread>
+#include <vector>
 
 #include "logging/checkpoint.h"
 
@@ -69,6 +70,9 @@ class SimpleCheckpoint : public Checkpoint {
 
   FileHandle file_handle_ = INVALID_FILE_HANDLE;
 
+  // tuple record read during recovery
+  std::vector<char> record_buffer_;
+
   std::unique_ptr<BackendLogger> logger_;
 
   // Keep tracking max oid for setting next_oid in manager
@@ -16,6 +16,7 @@
 #include <iostream>
 #include <atomic>
 #include <condition_variable>
+#include <mutex>
 #include <vector>
 #include <unistd.h>
 #include <map>
@@ -29,6 +30,10 @@
 #include "logging/backend_logger.h"
 #include "logging/checkpoint.h"
 
+// Longest wait for a notification (in us), the frontend logger still has to
+// notice status changes and lower bounds of idle backend loggers
+#define LOG_COLLECTION_TIMEOUT 10000
+
 namespace peloton {
 namespace logging {
 //===--------------------------------------------------------------------===//
@@ -42,7 +47,8 @@ class FrontendLogger : public Logger {
   ~FrontendLogger();
 
   static FrontendLogger *GetFrontendLogger(LoggingType logging_type,
-                                           bool test_mode = false);
+                                           bool test_mode = false,
+                                           unsigned int logger_id = 0);
 
   void MainLoop(void);
 
@@ -50,6 +56,10 @@ class FrontendLogger : public Logger {
 
   void AddBackendLogger(BackendLogger *backend_logger);
 
+  // Called by backend loggers when a buffer fills up or a commit record is
+  // logged, wakes up the frontend logger if it waits for log records
+  void NotifyLogRecords(void);
+
   //===--------------------------------------------------------------------===//
   // Virtual Functions
   //===--------------------------------------------------------------------===//
@@ -78,8 +88,8 @@ class FrontendLogger : public Logger {
 
   cid_t GetMaxDelimiterForRecovery() { return max_delimiter_for_recovery; }
 
-  void SetIsDistinguishedLogger(bool flag) { is_distinguished_logger = flag; }
-
+  // Raise the global max flushed id with the one of this logger, wakes up
+  // the other frontend loggers if it grows
   void UpdateGlobalMaxFlushId();
 
   // reset the frontend logger to its original state (for testing
@@ -122,9 +132,32 @@ class FrontendLogger : public Logger {
   // To synch the status
   Spinlock backend_loggers_lock;
 
-  // period with which it collects log records from backend loggers
+  // Wait until a backend logger notifies or the collection timeout passes
+  void WaitForLogRecords(void);
+
+  // period with which it collects log records from backend loggers, an
+  // upper bound for the batching window when it is set
   int wait_timeout;
 
+  // set by backend loggers, cleared by the frontend logger when it collects
+  std::atomic<bool> log_records_pending;
+
+  // the frontend logger waits on the event
+  std::atomic<bool> log_records_waiting;
+
+  std::mutex log_event_mutex;
+
+  std::condition_variable log_event_cv;
+
+  // longest wait for a notification (in us), shortened while flushed log
+  // records wait for their group commit
+  int collection_timeout;
+
+  // how long the frontend logger lingers after a wakeup to gather a larger
+  // batch (in us). Grows while collections find several backends with log
+  // records and shrinks back to 0 at low load.
+  int collection_window = 0;
+
   // stats
   size_t fsync_count = 0;
 
@@ -140,7 +173,6 @@ class FrontendLogger : public Logger {
 
   bool test_mode_ = false;
 
-  bool is_distinguished_logger = false;
 };
 
 }  // namespace logging
@@ -0,0 +1,55 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// lock_free_buffer_pool.h
+//
+// Identification: src/include/logging/lock_free_buffer_pool.h
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "concurrentqueue/blockingconcurrentqueue.h"
+
+#include "logging/buffer_pool.h"
+
+namespace peloton {
+namespace logging {
+
+//===--------------------------------------------------------------------===//
+// Lock-free Buffer Pool
+//===--------------------------------------------------------------------===//
+
+/**
+ * Hands log buffers between a backend logger and its frontend logger.
+ *
+ * Puts and gets never take a lock, a get on an empty pool sleeps on a
+ * semaphore until a buffer arrives instead of spinning. The pool is bounded
+ * by the buffers the frontend logger grants to a backend logger, there are
+ * never more than BUFFER_POOL_SIZE of them in flight.
+ */
+class LockFreeBufferPool : public BufferPool {
+ public:
+  LockFreeBufferPool() : buffers_(BUFFER_POOL_SIZE) {}
+
+  // put a buffer to the buffer pool
+  bool Put(std::unique_ptr<LogBuffer>);
+
+  // get a buffer from the buffer pool. blocks if none available
+  std::unique_ptr<LogBuffer> Get();
+
+  // get a buffer if one is available
+  bool TryGet(std::unique_ptr<LogBuffer> &);
+
+  // get the approximate number of buffers available
+  unsigned int GetSize();
+
+ private:
+  moodycamel::BlockingConcurrentQueue<std::unique_ptr<LogBuffer>> buffers_;
+};
+
+}  // namespace logging
+}  // namespace peloton
@@ -0,0 +1,87 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// log_compressor.h
+//
+// Identification: src/include/logging/log_compressor.h
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace peloton {
+namespace logging {
+
+//===--------------------------------------------------------------------===//
+// Log Compressor
+//===--------------------------------------------------------------------===//
+
+/**
+ * Compresses a run of log data into a single block record.
+ *
+ * The codec is a byte-oriented LZ77 variant: a sequence is a token holding
+ * the literal length and the match length in four bits each, the literals
+ * and the two-byte offset of the match, longer lengths continue in extra
+ * bytes. It only looks up the last position of every four-byte prefix, so
+ * it runs at memory speed and catches what makes log data redundant: tuple
+ * images of the same table that repeat most of their columns.
+ *
+ * A block record is framed like any other log record:
+ *   - LogRecordType           : LOGRECORD_TYPE_WAL_COMPRESSED_BLOCK
+ *   - Frame length            : int
+ *   - Size of the log data    : uint32_t
+ *   - Compressed log data
+ *   - Checksum                : uint32_t
+ */
+class LogCompressor {
+  LogCompressor(LogCompressor const &) = delete;
+
+ public:
+  LogCompressor() {}
+
+  // Compress the log data into a block record, false if it does not shrink.
+  // Higher levels search longer before they skip incompressible data
+  bool CompressBlock(const char *data, size_t size, int level);
+
+  const char *GetBlock() const { return block_.data(); }
+
+  size_t GetBlockSize() const { return block_size_; }
+
+  // Decompress the log data of a block record frame, the frame includes its
+  // length. Returns false if the frame is corrupt
+  static bool DecompressFrame(const char *frame, size_t frame_size,
+                              std::vector<char> &data);
+
+  // no compression, the log data is written as is
+  static const int min_level_ = 0;
+
+  static const int max_level_ = 4;
+
+  // log data smaller than this is not worth a block
+  static const size_t min_block_data_size_ = 256;
+
+ private:
+  // Compressed size, 0 if the result would not fit into capacity
+  size_t Compress(const uint8_t *data, size_t size, uint8_t *output,
+                  size_t capacity, int level);
+
+  static bool Decompress(const uint8_t *input, size_t input_size,
+                         uint8_t *output, size_t output_size);
+
+  // last position of every hashed four-byte prefix, plus one
+  std::vector<uint32_t> hash_table_;
+
+  std::vector<char> block_;
+
+  size_t block_size_ = 0;
+};
+
+}  // namespace logging
+}  // namespace peloton
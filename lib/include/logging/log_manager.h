@@ -12,6 +12,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <map>
 #include <mutex>
 #include <vector>
@@ -102,7 +103,8 @@ class LogManager {
   // method for frontend to inform waiting backends of a flush to disk
   void FrontendLoggerFlushed();
 
-  // wait for the flush of a frontend logger (for worker thread)
+  // wait for the flush of a frontend logger (for worker thread), the
+  // worker is woken up once its commit id is persistent
   void WaitForFlush(cid_t cid);
 
   // get the current persistent flushed commit
@@ -143,6 +145,14 @@ class LogManager {
 
   std::string GetLogDirectoryName(void);
 
+  // set the directory of the log stream of a frontend logger, e.g. to put the
+  // streams on different devices
+  void SetLogStreamDirectoryName(unsigned int logger_id, std::string log_dir);
+
+  // the directory of the log stream of a frontend logger, the log directory
+  // unless set otherwise
+  std::string GetLogStreamDirectoryName(unsigned int logger_id);
+
   bool HasPelotonFrontendLogger() const {
     return (false);
   }
@@ -202,12 +212,17 @@ class LogManager {
     global_max_flushed_id_for_recovery = new_max;
   }
 
+  // replay the transactions recovered from all log streams in commit id order
+  void ReplayRecoveredTransactions();
+
   // updates the catalog and transaction managers to the correct oid and cid
   // after recovery
   void UpdateCatalogAndTxnManagers(oid_t new_oid, cid_t new_cid);
 
   // set the maximum commit id which has been persisted to disk
-  void SetGlobalMaxFlushedCommitId(cid_t);
+  // raise the max flushed commit id of all frontend loggers, returns whether
+  // it grew
+  bool RaiseGlobalMaxFlushedCommitId(cid_t);
 
   // set the maximum commit id which has been persisted to disk
   cid_t GetGlobalMaxFlushedCommitId();
@@ -236,8 +251,31 @@ class LogManager {
 
   inline void SetNoWrite(bool no_write) { no_write_ = no_write; }
 
+  // get the amount of log data (in bytes) that forces a group commit
+  inline size_t GetGroupCommitSize() const { return group_commit_size_; }
+
+  // set the amount of log data (in bytes) that forces a group commit
+  inline void SetGroupCommitSize(size_t group_commit_size) {
+    group_commit_size_ = group_commit_size;
+  }
+
+  // get the longest time (in us) a commit may wait for its group commit
+  inline int64_t GetGroupCommitLatency() const { return group_commit_latency_; }
+
+  // set the longest time (in us) a commit may wait for its group commit
+  inline void SetGroupCommitLatency(int64_t group_commit_latency) {
+    group_commit_latency_ = group_commit_latency;
+  }
+
   inline bool GetNoWrite() const { return no_write_; }
 
+  // whether frontend loggers compress the log buffers they write
+  inline bool GetLogCompression() const { return log_compression_; }
+
+  inline void SetLogCompression(bool log_compression) {
+    log_compression_ = log_compression;
+  }
+
  private:
   LogManager();
   ~LogManager();
@@ -277,9 +315,15 @@ class LogManager {
   std::mutex logging_status_mutex;
   std::condition_variable logging_status_cv;
 
-  // To wait for flush
+  // A worker thread waiting for the flush of its commit
+  struct FlushWaiter {
+    std::condition_variable flush_cv;
+    bool flushed = false;
+  };
+
+  // To wait for flush, waiters are kept ordered by the cid they wait for
   std::mutex flush_notify_mutex;
-  std::condition_variable flush_notify_cv;
+  std::multimap<cid_t, FlushWaiter *> flush_waiters;
 
   // To update catalog and txn managers
   std::mutex update_managers_mutex;
@@ -298,12 +342,15 @@ class LogManager {
 
   std::string log_directory_name;
 
+  // directories of the log streams placed elsewhere
+  std::map<unsigned int, std::string> log_stream_directory_names;
+
   // round robin counter for frontend logger assignment
   int frontend_logger_assign_counter;
 
   cid_t global_max_flushed_id_for_recovery = UINT64_MAX;
 
-  cid_t global_max_flushed_commit_id = 0;
+  std::atomic<cid_t> global_max_flushed_commit_id;
 
   // number the fronted loggers who have updated the manager of their max oid
   // and cid
@@ -313,6 +360,13 @@ class LogManager {
 
   bool no_write_ = false;
 
+  // group commit policy of the frontend loggers
+  size_t group_commit_size_ = 64 * 1024;
+
+  int64_t group_commit_latency_ = 10000;
+
+  bool log_compression_ = false;
+
   // max oid after recovery
   oid_t max_oid = 0;
 
@@ -20,6 +20,7 @@
  *     - HEADER
  *       - Header length         : int
  *       - Transaction Id        : txn_id_t
+ *     - Checksum                : uint32_t
  *
  *     Tuple Record :
  *       - LogRecordType         : enum
@@ -33,10 +34,15 @@
  *     -BODY
  *       - Body length           : int
  *       - Data                  : void*
+ *     - Checksum                : uint32_t
+ *
+ * The checksum is the CRC32C of all bytes of the record in front of it,
+ * starting with the LogRecordType.
 */
 
 #pragma once
 
+#include "common/crc32c.h"
 #include "type/types.h"
 #include "type/serializer.h"
 #include "type/serializeio.h"
@@ -68,6 +74,12 @@ class LogRecord {
   size_t GetMessageLength(void) const { return message_length; }
 
  protected:
+  // Close the serialized record with its checksum
+  static void WriteChecksum(CopySerializeOutput &output) {
+    output.WriteInt(
+        static_cast<int32_t>(Crc32c::Value(output.Data(), output.Size())));
+  }
+
   LogRecordType log_record_type = LOGRECORD_TYPE_INVALID;
 
   cid_t cid;
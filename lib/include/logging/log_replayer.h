@@ -0,0 +1,150 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// log_replayer.h
+//
+// Identification: src/include/logging/log_replayer.h
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "common/item_pointer.h"
+#include "type/types.h"
+
+namespace peloton {
+
+namespace storage {
+class DataTable;
+class TileGroup;
+}
+
+namespace logging {
+
+class TupleRecord;
+
+//===--------------------------------------------------------------------===//
+// Log Replayer
+//===--------------------------------------------------------------------===//
+
+/**
+ * Applies the committed transactions read during recovery with a pool of
+ * worker threads.
+ *
+ * Every tuple version is applied by the worker owning its tile group, so a
+ * tile group is created and written by a single thread only and its header
+ * lock is never contended. Transactions are handed over in commit id order
+ * and each worker applies its versions in the order they arrive, so all
+ * changes of a tuple slot are applied in commit order. An update is split
+ * into the new version, applied by the owner of its tile group, and the end
+ * of the old version, applied by the owner of the old tile group.
+ */
+class LogReplayer {
+  LogReplayer(LogReplayer const &) = delete;
+
+ public:
+  LogReplayer(size_t worker_count);
+
+  ~LogReplayer();
+
+  // Hand over the tuple records of a committed transaction, takes ownership
+  // of the records. Their tuple bodies have to stay mapped until Finish()
+  void ReplayTransaction(cid_t commit_id,
+                         std::vector<TupleRecord *> &tuple_records);
+
+  // Wait until all transactions are applied, returns the max tile group id
+  // created during the replay
+  oid_t Finish();
+
+  size_t GetWorkerCount() const { return workers_.size(); }
+
+  // versions handed to a worker at once
+  static const size_t batch_size_ = 1024;
+
+ private:
+  enum ReplayOperationType {
+    REPLAY_OPERATION_TYPE_INSERT = 1,
+    // new version of an update, not counted as a new tuple
+    REPLAY_OPERATION_TYPE_INSERT_NEW_VERSION = 2,
+    REPLAY_OPERATION_TYPE_DELETE = 3,
+    // old version of an update
+    REPLAY_OPERATION_TYPE_UPDATE_OLD_VERSION = 4
+  };
+
+  struct ReplayOperation {
+    ReplayOperationType type;
+    cid_t commit_id;
+    oid_t database_oid;
+    oid_t table_oid;
+    // slot written by the operation
+    ItemPointer location;
+    // new version of an updated tuple
+    ItemPointer new_location;
+    // serialized tuple in the mapped log, only set for inserts
+    const char *tuple_body;
+
+    size_t tuple_body_size;
+  };
+
+  // Table and tile group of the last operation applied by a worker
+  struct ReplayTarget {
+    oid_t database_oid = INVALID_OID;
+
+    oid_t table_oid = INVALID_OID;
+
+    storage::DataTable *table = nullptr;
+
+    oid_t tile_group_id = INVALID_OID;
+
+    std::shared_ptr<storage::TileGroup> tile_group;
+  };
+
+  struct ReplayWorker {
+    std::mutex worker_mutex;
+
+    std::condition_variable worker_cv;
+
+    // batches handed over, applied in order
+    std::deque<std::vector<ReplayOperation>> batches;
+
+    // batch filled by the dispatching thread
+    std::vector<ReplayOperation> pending_batch;
+
+    bool done = false;
+
+    oid_t max_tile_group_id = 0;
+
+    std::thread worker_thread;
+  };
+
+  void Dispatch(const ReplayOperation &operation);
+
+  void SubmitBatch(ReplayWorker &worker);
+
+  void RunWorker(ReplayWorker *worker);
+
+  void ApplyOperation(ReplayOperation &operation, ReplayTarget &target,
+                      oid_t &max_tile_group_id);
+
+  // Create the tile group of a slot if recovery did not see it yet
+  std::shared_ptr<storage::TileGroup> GetTileGroup(storage::DataTable *table,
+                                                   oid_t tile_group_id,
+                                                   oid_t &max_tile_group_id);
+
+  std::vector<std::unique_ptr<ReplayWorker>> workers_;
+
+  bool finished_ = false;
+};
+
+}  // namespace logging
+}  // namespace peloton
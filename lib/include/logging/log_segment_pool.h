@@ -0,0 +1,94 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// log_segment_pool.h
+//
+// Identification: src/include/logging/log_segment_pool.h
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace peloton {
+namespace logging {
+
+//===--------------------------------------------------------------------===//
+// Log Segment Pool
+//===--------------------------------------------------------------------===//
+
+/**
+ * Keeps preallocated, zeroed log segments ready for the next log file.
+ *
+ * Writing into a segment whose blocks are already allocated and written
+ * needs no file size or extent updates, so fdatasync only has to flush the
+ * log data. A background thread zeroes the spare segments: log files handed
+ * back after a truncation are recycled, new ones are created as needed.
+ * Recovery reads the zeros behind the log data as the end of the file.
+ */
+class LogSegmentPool {
+  LogSegmentPool(LogSegmentPool const &) = delete;
+
+ public:
+  LogSegmentPool(const std::string &directory, size_t segment_size);
+
+  ~LogSegmentPool();
+
+  // Turn a spare segment into the given log file, creates an empty log file
+  // if no spare is ready. The directory entry is durable once it returns
+  // true.
+  bool AcquireSegment(const std::string &file_name);
+
+  // Take back the file of a truncated log
+  void RecycleSegment(const std::string &file_name);
+
+  // zeroed segments ready to be used
+  size_t GetSpareSegmentCount();
+
+  // segments kept ready
+  static const size_t spare_segment_count_ = 2;
+
+ private:
+  // Background thread zeroing the spare segments
+  void PrepareSegments();
+
+  bool ZeroSegment(const std::string &file_name);
+
+  // Make renames and new files in the directory durable
+  bool SyncDirectory();
+
+  std::string GetSpareFileName(size_t spare_id) const;
+
+  std::string directory_;
+
+  size_t segment_size_;
+
+  std::mutex pool_mutex_;
+
+  std::condition_variable pool_cv_;
+
+  // zeroed spares
+  std::vector<std::string> ready_segments_;
+
+  // spares to be zeroed
+  std::deque<std::string> recycled_segments_;
+
+  size_t next_spare_id_ = 0;
+
+  std::atomic<bool> pool_stop_;
+
+  std::thread pool_thread_;
+};
+
+}  // namespace logging
+}  // namespace peloton
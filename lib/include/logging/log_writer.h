@@ -0,0 +1,159 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// log_writer.h
+//
+// Identification: src/include/logging/log_writer.h
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace peloton {
+namespace logging {
+
+class IoRing;
+
+//===--------------------------------------------------------------------===//
+// Log Writer
+//===--------------------------------------------------------------------===//
+
+/**
+ * Appends log data to a log file with direct, asynchronous writes.
+ *
+ * The data is staged in block-aligned buffers and written with O_DIRECT,
+ * bypassing stdio and the page cache. A buffer is submitted as soon as it is
+ * full while the frontend logger keeps on collecting; Sync() submits the
+ * partial tail, padded with zeros, waits for all writes and makes them
+ * durable with fdatasync. The padded block is written again by the next
+ * Sync() once more data follows it.
+ *
+ * Writes are submitted through io_uring where the kernel supports it and
+ * handed to a pool of I/O threads otherwise.
+ */
+class LogWriter {
+  LogWriter(LogWriter const &) = delete;
+
+ public:
+  LogWriter();
+
+  ~LogWriter();
+
+  // Open the file for appending at its beginning
+  bool Open(const std::string &file_name);
+
+  // Sync and close the file
+  void Close();
+
+  bool IsOpen() const { return fd_ != -1; }
+
+  // Stage data at the end of the file
+  void Append(const char *data, size_t size);
+
+  // Write everything appended so far and make it durable
+  bool Sync();
+
+  // Bytes appended since the file was opened
+  size_t GetSize() const { return buffer_file_offset_ + buffer_fill_; }
+
+  int GetFD() const { return fd_; }
+
+  // whether writes go through io_uring
+  bool IsUsingIoRing() const { return io_ring_ != nullptr; }
+
+  // alignment of direct writes
+  static const size_t block_size_ = 4096;
+
+  // size of a staging buffer
+  static const size_t buffer_size_ = 256 * 1024;
+
+  static const size_t buffer_count_ = 4;
+
+  static const size_t io_thread_count_ = 2;
+
+ private:
+  struct WriteRequest {
+    size_t buffer_id;
+    const char *data;
+    size_t size;
+    off_t file_offset;
+  };
+
+  // Write the staged data of the current buffer from the last submitted block
+  // up to the next block boundary
+  void SubmitCurrentBuffer(size_t end);
+
+  void SubmitWrite(const WriteRequest &request);
+
+  // Write synchronously, also picks up short asynchronous writes
+  bool WriteFully(const char *data, size_t size, off_t file_offset);
+
+  void CompleteWrite(size_t buffer_id, bool success);
+
+  // Wait until the buffer has no writes in flight
+  void WaitForBuffer(size_t buffer_id);
+
+  void WaitForAllWrites();
+
+  // Reap completed io_uring writes, blocks for one if wait is set
+  void ReapCompletions(bool wait);
+
+  // I/O thread of the fallback
+  void RunIoThread();
+
+  void StartIoThreads();
+
+  void StopIoThreads();
+
+  int fd_ = -1;
+
+  // aligned staging buffers
+  std::vector<char *> buffers_;
+
+  // writes in flight per buffer
+  std::vector<size_t> pending_writes_;
+
+  // buffer data is appended to
+  size_t current_buffer_ = 0;
+
+  // file offset of the beginning of the current buffer
+  size_t buffer_file_offset_ = 0;
+
+  // bytes staged in the current buffer
+  size_t buffer_fill_ = 0;
+
+  // bytes of the current buffer already submitted
+  size_t buffer_submitted_ = 0;
+
+  // a write failed since the last sync
+  bool write_failed_ = false;
+
+  std::unique_ptr<IoRing> io_ring_;
+
+  // Fallback: requests are handed to I/O threads
+  std::mutex io_mutex_;
+
+  std::condition_variable io_request_cv_;
+
+  std::condition_variable io_completion_cv_;
+
+  std::deque<WriteRequest> io_requests_;
+
+  std::vector<std::thread> io_threads_;
+
+  bool io_stop_ = false;
+};
+
+}  // namespace logging
+}  // namespace peloton
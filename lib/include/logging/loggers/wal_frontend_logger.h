@@ -16,12 +16,23 @@
 #include "logging/frontend_logger.h"
 #include "logging/records/tuple_record.h"
 #include "logging/log_file.h"
+#include "logging/mapped_log_file.h"
+#include "logging/log_compressor.h"
+#include "logging/log_replayer.h"
+#include "logging/log_segment_pool.h"
+#include "logging/log_writer.h"
 
 #include <dirent.h>
 #include <vector>
 #include <set>
 #include <chrono>
 
+// Amount of log data (in bytes) the compression level is adapted after
+#define LOG_COMPRESSION_WINDOW_SIZE (4 * 1024 * 1024)
+
+// Largest amount of log data (in bytes) compressed into a single block
+#define LOG_COMPRESSION_BLOCK_SIZE (1024 * 1024)
+
 namespace peloton {
 
 namespace concurrency {
@@ -43,7 +54,7 @@ class WriteAheadFrontendLogger : public FrontendLogger {
  public:
   WriteAheadFrontendLogger(void);
 
-  WriteAheadFrontendLogger(bool for_testing);
+  WriteAheadFrontendLogger(bool for_testing, unsigned int logger_id = 0);
 
   WriteAheadFrontendLogger(std::string log_dir);
 
@@ -51,6 +62,12 @@ class WriteAheadFrontendLogger : public FrontendLogger {
 
   void FlushLogRecords(void);
 
+  // whether the collected commits should be flushed now
+  bool GroupCommitIsDue(size_t collected_buffer_count);
+
+  // compression level of the log buffers written next
+  int GetLogCompressionLevel() const { return log_compression_level; }
+
   //===--------------------------------------------------------------------===//
   // Recovery
   //===--------------------------------------------------------------------===//
@@ -63,11 +80,22 @@ class WriteAheadFrontendLogger : public FrontendLogger {
 
   void CommitTransactionRecovery(cid_t commit_id);
 
-  void InsertTuple(TupleRecord *recovery_txn);
+  // Read the log up to the next iteration delimiter, returns false at the
+  // end of the log
+  bool ReadRecoveredTransactions();
 
-  void DeleteTuple(TupleRecord *recovery_txn);
+  // the committed transactions of this stream up to this commit id have
+  // been read, MAX_CID at the end of the log
+  cid_t GetRecoveredDelimiter() const { return recovered_delimiter; }
 
-  void UpdateTuple(TupleRecord *recovery_txn);
+  // lowest commit id of the committed transactions not replayed yet, MAX_CID
+  // if there is none
+  cid_t GetNextRecoveredCommitId();
+
+  void ReplayNextRecoveredTransaction(LogReplayer &log_replayer);
+
+  // report the max oid and cid seen once all transactions are replayed
+  void DoneReplay(oid_t max_tile_group_id);
 
   void AbortActiveTransactions();
 
@@ -87,7 +115,8 @@ class WriteAheadFrontendLogger : public FrontendLogger {
 
   std::string GetFileNameFromVersion(int);
 
-  std::pair<cid_t, cid_t> ExtractMaxLogIdAndMaxDelimFromLogFileRecords(FILE *);
+  std::pair<cid_t, cid_t> ExtractMaxLogIdAndMaxDelimFromLogFileRecords(
+      const std::string &file_name);
 
   void SetLoggerID(int);
 
@@ -104,6 +133,22 @@ class WriteAheadFrontendLogger : public FrontendLogger {
  private:
   std::string GetLogFileName(void);
 
+  bool IsCompressingLogData();
+
+  void WriteLogData(const char *data, size_t size);
+
+  // Write the staged log data as a compressed block if it shrinks
+  void AppendStagedLogData();
+
+  void AdaptLogCompressionLevel();
+
+  bool ExtractMaxLogIdAndMaxDelimFromLogRecords(MappedLogFile &log_data,
+                                                cid_t &max_log_id_so_far,
+                                                cid_t &max_delim_so_far);
+
+  // Abort the transactions without a commit record at the end of the log
+  bool EndRecoveredTransactions();
+
   bool RecoverTableIndexHelper(storage::DataTable *target_table,
                                cid_t start_cid);
 
@@ -117,17 +162,41 @@ class WriteAheadFrontendLogger : public FrontendLogger {
   // File pointer and descriptor
   FileHandle cur_file_handle;
 
+  // Appends to the current log file
+  std::unique_ptr<LogWriter> log_writer;
+
+  // Preallocated log files
+  std::unique_ptr<LogSegmentPool> log_segment_pool;
+
   // Txn table during recovery
   std::map<txn_id_t, std::vector<TupleRecord *>> recovery_txn_table;
 
+  // Committed transactions waiting to be replayed, ordered by commit id
+  std::map<cid_t, std::vector<TupleRecord *>> recovered_txn_table;
+
+  // commit ids replayed from the log, (start, max]
+  cid_t recovery_start_commit_id = INVALID_CID;
+
+  cid_t recovery_max_commit_id = INVALID_CID;
+
+  // latest iteration delimiter read
+  cid_t recovered_delimiter = INVALID_CID;
+
   // Keep tracking max oid for setting next_oid in manager
   // For active processing after recovery
   oid_t max_oid = 0;
 
   cid_t max_cid = 0;
 
-  // pool for allocating non-inlined values
-  type::AbstractPool *recovery_pool;
+  // log files mapped during recovery
+  std::vector<std::unique_ptr<MappedLogFile>> recovery_mapped_files;
+
+  // file or compressed block the records are read from, null at the end of
+  // the log
+  MappedLogFile *cur_mapped_file = nullptr;
+
+  // log file the records are read from
+  MappedLogFile *cur_log_file = nullptr;
 
   // abj1 adding code here!
   std::vector<LogFile *> log_files_;
@@ -149,15 +218,38 @@ class WriteAheadFrontendLogger : public FrontendLogger {
 
   CopySerializeOutput output_buffer;
 
-  int logger_id;
+  int logger_id = 0;
 
   cid_t max_delimiter_file = 0;
 
   bool should_create_new_file = false;
 
-  TimePoint last_flush = Clock::now();
+  // log data written since the last fsync (in bytes)
+  size_t unflushed_log_size = 0;
+
+  // whether collected commits wait for their group commit
+  bool waiting_for_group_commit = false;
+
+  // when the oldest waiting commit was collected
+  TimePoint group_commit_start = Clock::now();
+
+  LogCompressor log_compressor;
+
+  // log data written since the last sync, compressed into one block
+  std::vector<char> staged_log_data;
+
+  // LogCompressor::min_level_ writes log buffers as they are
+  int log_compression_level = 1;
+
+  // time spent compressing and writing log data (in us) and log data
+  // collected in the current compression window (in bytes)
+  int64_t compression_micros = 0;
+
+  int64_t write_micros = 0;
+
+  size_t compression_window_size = 0;
 
-  Micros flush_frequency{10000};
+  TimePoint compression_window_start = Clock::now();
 };
 
 }  // namespace logging
@@ -61,6 +61,10 @@ class LoggingUtil {
 
   static void SkipTupleRecordBody(FileHandle &file_handle);
 
+  static bool ReadRecordChecksum(FileHandle &file_handle,
+                                 LogRecordType log_record_type,
+                                 const char *frames, size_t frames_size);
+
   static int GetFileSizeFromFileName(const char *);
 
   static bool CreateDirectory(const char *dir_name, int mode);
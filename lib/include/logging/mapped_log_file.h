@@ -0,0 +1,88 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// mapped_log_file.h
+//
+// Identification: src/include/logging/mapped_log_file.h
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "type/types.h"
+
+namespace peloton {
+namespace logging {
+
+//===--------------------------------------------------------------------===//
+// Mapped Log File
+//===--------------------------------------------------------------------===//
+
+/**
+ * A log file mapped into memory for recovery.
+ *
+ * Records are parsed in place: a frame is returned as a pointer into the
+ * mapping, so tuple bodies reach the replay without being copied or
+ * deserialized by the reader. The mapping has to outlive every record
+ * pointing into it.
+ *
+ * The log data of a compressed block record is read through a MappedLogFile
+ * of its own, holding the decompressed data instead of a mapping.
+ */
+class MappedLogFile {
+  MappedLogFile(MappedLogFile const &) = delete;
+
+ public:
+  MappedLogFile() {}
+
+  ~MappedLogFile();
+
+  // Map the whole file read-only
+  bool Open(const std::string &file_name);
+
+  void Close();
+
+  const char *GetData() const { return data_; }
+
+  size_t GetSize() const { return size_; }
+
+  // Position of the next record
+  size_t GetOffset() const { return offset_; }
+
+  void Seek(size_t offset) { offset_ = offset; }
+
+  // Type of the next record, LOGRECORD_TYPE_INVALID at the end of the log
+  // data or of the file
+  LogRecordType ReadRecordType();
+
+  // Next length-prefixed frame, including its length, false if the frame is
+  // cut off
+  bool ReadFrame(const char *&frame, size_t &frame_size);
+
+  // Checksum closing the record that starts at record_offset, false if it is
+  // cut off or does not match the record
+  bool ReadChecksum(size_t record_offset);
+
+  // Decompress the block record whose type was read last into block, false
+  // if it is cut off or corrupt
+  bool ReadCompressedBlock(MappedLogFile &block);
+
+ private:
+  const char *data_ = nullptr;
+
+  size_t size_ = 0;
+
+  size_t offset_ = 0;
+
+  // decompressed log data of a block, empty for a mapped file
+  std::vector<char> block_data_;
+};
+
+}  // namespace logging
+}  // namespace peloton
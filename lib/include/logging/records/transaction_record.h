@@ -42,7 +42,7 @@ class TransactionRecord : public LogRecord, Printable {
 
   bool Serialize(CopySerializeOutput &output);
 
-  void Deserialize(CopySerializeInput &input);
+  void Deserialize(SerializeInput &input);
 
   static size_t GetTransactionRecordSize(void);
 
@@ -64,7 +64,7 @@ class TupleRecord : public LogRecord, Printable {
 
   void SerializeHeader(CopySerializeOutput &output);
 
-  void DeserializeHeader(CopySerializeInput &input);
+  void DeserializeHeader(SerializeInput &input);
 
   //===--------------------------------------------------------------------===//
   // Accessor
@@ -82,6 +82,16 @@ class TupleRecord : public LogRecord, Printable {
 
   storage::Tuple *GetTuple();
 
+  // serialized tuple read in place during recovery
+  void SetTupleBody(const char *tuple_body, size_t tuple_body_size) {
+    this->tuple_body = tuple_body;
+    this->tuple_body_size = tuple_body_size;
+  }
+
+  const char *GetTupleBody() const { return tuple_body; }
+
+  size_t GetTupleBodySize() const { return tuple_body_size; }
+
   static size_t GetTupleRecordSize(void);
 
   // Get a string representation for debugging
@@ -107,6 +117,11 @@ class TupleRecord : public LogRecord, Printable {
   // tuple (for deserialize
   storage::Tuple *tuple = nullptr;
 
+  // serialized tuple, points into the mapped log file
+  const char *tuple_body = nullptr;
+
+  size_t tuple_body_size = 0;
+
   // database id
   oid_t db_oid = DEFAULT_DB_ID;
 };
@@ -132,10 +132,15 @@ class AbstractTable : public Printable {
 
   TileGroup *GetTileGroupWithLayout(oid_t database_id, oid_t tile_group_id,
                                     const column_map_type &partitioning,
-                                    const size_t num_tuples);
+                                    const size_t num_tuples,
+                                    const int numa_node = INVALID_NUMA_NODE);
 
   column_map_type GetTileGroupLayout(LayoutType layout_type) const;
 
+  // Schemas of the tiles of a tile group with the given layout
+  std::vector<catalog::Schema> GetTileSchemas(
+      const column_map_type &partitioning) const;
+
   //===--------------------------------------------------------------------===//
   // MEMBERS
   //===--------------------------------------------------------------------===//
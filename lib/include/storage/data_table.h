@@ -12,6 +12,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <map>
 #include <memory>
 #include <mutex>
@@ -23,7 +24,9 @@
 #include "common/platform.h"
 #include "common/abstract_tuple.h"
 #include "container/lock_free_array.h"
+#include "container/sharded_counter.h"
 #include "storage/abstract_table.h"
+#include "storage/free_slot_manager.h"
 #include "storage/indirection_array.h"
 
 //===--------------------------------------------------------------------===//
@@ -34,6 +37,8 @@ extern std::vector<peloton::oid_t> sdbench_column_ids;
 
 namespace peloton {
 
+class TaskGroup;
+
 namespace brain {
 class Sample;
 }
@@ -72,8 +77,9 @@ class IndirectionArray;
  * ...
  * <Tile Group n>
  *
+ * Allocated cache aligned, as its tuple count and free slots are.
  */
-class DataTable : public AbstractTable {
+class DataTable : public AbstractTable, public CacheAlignedAllocation {
   friend class TileGroup;
   friend class TileGroupFactory;
   friend class TableFactory;
@@ -122,6 +128,19 @@ class DataTable : public AbstractTable {
   // aggregate_executor.
   ItemPointer InsertTuple(const Tuple *tuple);
 
+  // give back the slot of a deleted or obsolete version once new snapshots
+  // can no longer see it. It is reused once no pinned epoch can see it either.
+  void RetireTupleSlot(const ItemPointer &location);
+
+  // give back the slot of a version that nobody can see anymore, it is
+  // reused right away
+  void ReleaseTupleSlot(const ItemPointer &location);
+
+  // retired slots that have not been reused yet
+  size_t GetRetiredTupleSlotCount() const {
+    return free_slot_manager_.GetRetiredSlotCount();
+  }
+
   //===--------------------------------------------------------------------===//
   // TILE GROUP
   //===--------------------------------------------------------------------===//
@@ -131,6 +150,11 @@ class DataTable : public AbstractTable {
 
   void AddTileGroup(const std::shared_ptr<TileGroup> &tile_group);
 
+  // Re-attach the table's tile groups found in the persistent heap and
+  // give their live versions indirections. Returns the number of tile groups
+  // recovered.
+  size_t RecoverTileGroups();
+
   // Offset is a 0-based number local to the table
   std::shared_ptr<storage::TileGroup> GetTileGroup(
       const std::size_t &tile_group_offset) const;
@@ -141,8 +165,12 @@ class DataTable : public AbstractTable {
 
   size_t GetTileGroupCount() const;
 
+  // Snapshot of the ids of all tile groups currently in the table
+  std::vector<oid_t> GetTileGroupIds() const;
+
   // Get a tile group with given layout
-  TileGroup *GetTileGroupWithLayout(const column_map_type &partitioning);
+  TileGroup *GetTileGroupWithLayout(const column_map_type &partitioning,
+                                    const int numa_node = INVALID_NUMA_NODE);
 
   // Evict a tile group to NVS
   void EvictTileGroup(storage::TileGroup*);
@@ -157,6 +185,20 @@ class DataTable : public AbstractTable {
   storage::TileGroup *TransformTileGroup(const oid_t &tile_group_offset,
                                          const double &theta);
 
+  //===--------------------------------------------------------------------===//
+  // COMPACTION
+  //===--------------------------------------------------------------------===//
+
+  // One round of compaction. Full tile groups with fewer than
+  // liveness_threshold of their slots live are sealed, sealed ones no insert
+  // can reach anymore have their live tuples moved into densely packed tile
+  // groups, and moved-out ones no pinned epoch can see are dropped. The moved
+  // versions start at commit_id, which must be newer than every committed
+  // one, and the move holds them under COMPACTION_TXN_ID.
+  // Returns the number of tile groups moved out.
+  size_t CompactTileGroups(const double &liveness_threshold,
+                           const cid_t &commit_id);
+
   //===--------------------------------------------------------------------===//
   // STATS
   //===--------------------------------------------------------------------===//
@@ -210,6 +252,12 @@ class DataTable : public AbstractTable {
     default_active_tilegroup_count_ = active_tile_group_count;
   }
 
+  // Fraction of an active tile group that fills up before its successor is
+  // built in the background, 1 or more to build it when the group is full
+  static void SetSpareTileGroupThreshold(const double threshold) {
+    spare_tile_group_threshold_ = threshold;
+  }
+
   static void SetActiveIndirectionArrayCount(
       const size_t active_indirection_array_count) {
     default_active_indirection_array_count_ = active_indirection_array_count;
@@ -224,20 +272,68 @@ class DataTable : public AbstractTable {
 
   bool CheckConstraints(const storage::Tuple *tuple) const;
 
+  // Set the dirty flag unless it is set already
+  void SetDirty();
+
   // Claim a tuple slot in a tile group
   ItemPointer GetEmptyTupleSlot(const storage::Tuple *tuple);
 
+  // Pick the calling thread's lane among the active tile groups of its NUMA
+  // node
+  size_t GetActiveTileGroupId() const;
+
   // add a tile group to the table
   oid_t AddDefaultTileGroup();
   // add a tile group to the table. replace the active_tile_group_id-th active
   // tile group.
   oid_t AddDefaultTileGroup(const size_t &active_tile_group_id);
 
+  // Build a tile group for the active_tile_group_id-th active slot without
+  // adding it to the table
+  std::shared_ptr<TileGroup> CreateDefaultTileGroup(
+      const size_t &active_tile_group_id);
+
+  // Build the successor of the active_tile_group_id-th active tile group in
+  // the background, once per full_tile_group_id
+  void ProvisionSpareTileGroup(const size_t &active_tile_group_id,
+                               const oid_t &full_tile_group_id);
+
+  // Add the spare tile group, or a new one if it is not ready, to the table
+  // and swap it in for the full active tile group
+  void ReplaceActiveTileGroup(const size_t &active_tile_group_id,
+                              std::shared_ptr<TileGroup> full_tile_group);
+
   oid_t AddDefaultIndirectionArray(const size_t &active_indirection_array_id);
 
+  // Hand out an indirection, replacing the active indirection array it
+  // fills up
+  ItemPointer *AllocateIndirection();
+
+  // Point the live versions of a recovered tile group, and the older
+  // versions of their chains, to new indirections
+  void RecoverIndirections(TileGroup *tile_group);
+
   // Drop all tile groups of the table. Used by recovery
   void DropTileGroups();
 
+  bool IsActiveTileGroup(const TileGroup *tile_group) const;
+
+  // Move the live tuples of a sealed tile group into compaction tile groups.
+  // Returns false if a running transaction owns one of them.
+  bool MoveLiveTuples(const oid_t &tile_group_id, const cid_t &commit_id);
+
+  // Copy the tuple into a free slot of the current compaction tile group
+  ItemPointer CopyToCompactionTileGroup(TileGroup *tile_group,
+                                        const oid_t &tuple_slot_id);
+
+  // Clear the chain pointers of other tile groups that lead into the tile
+  // group
+  void UnlinkTileGroup(const oid_t &tile_group_id);
+
+  // Unlink the moved-out tile groups compacted before the reclaimable epoch,
+  // and drop the ones unlinked before it
+  void DropCompactedTileGroups(const uint64_t &reclaimable_epoch);
+
   //===--------------------------------------------------------------------===//
 
  public:
@@ -245,14 +341,20 @@ class DataTable : public AbstractTable {
 
   static size_t default_active_indirection_array_count_;
 
+  static double spare_tile_group_threshold_;
+
  private:
   //===--------------------------------------------------------------------===//
   // MEMBERS
   //===--------------------------------------------------------------------===//
 
+  // active tile groups per NUMA node
   size_t active_tilegroup_count_;
   size_t active_indirection_array_count_;
 
+  // NUMA nodes with their own set of active tile groups
+  size_t numa_node_count_;
+
   oid_t database_oid;
   std::string table_name;
 
@@ -262,10 +364,26 @@ class DataTable : public AbstractTable {
   // TILE GROUPS
   LockFreeArray<oid_t> tile_groups_;
 
+  // active tile groups of node n are at [n * active_tilegroup_count_,
+  // (n + 1) * active_tilegroup_count_)
+  // accessed with the shared_ptr atomic functions
   std::vector<std::shared_ptr<storage::TileGroup>> active_tile_groups_;
 
+  // successors of the active tile groups, built ahead of time
+  std::vector<std::shared_ptr<storage::TileGroup>> spare_tile_groups_;
+
+  // id of the active tile group whose successor was last requested, per
+  // active tile group
+  std::unique_ptr<std::atomic<oid_t>[]> spare_tile_group_requests_;
+
+  // background builds of spare tile groups
+  std::unique_ptr<TaskGroup> spare_tile_group_tasks_;
+
   std::atomic<size_t> tile_group_count_ = ATOMIC_VAR_INIT(0);
 
+  // slots of versions nobody can see anymore, reused before new ones
+  FreeSlotManager free_slot_manager_;
+
   // INDIRECTIONS
   std::vector<std::shared_ptr<storage::IndirectionArray>>
       active_indirection_arrays_;
@@ -273,13 +391,38 @@ class DataTable : public AbstractTable {
   // data table mutex
   std::mutex data_table_mutex_;
 
+  // COMPACTION
+  struct CompactedTileGroup {
+    // epoch the live tuples were moved out in, or unlinked in
+    uint64_t epoch;
+
+    oid_t tile_group_id;
+
+    // whether the moved versions no longer lead to the tile group
+    bool unlinked = false;
+  };
+
+  // serializes compaction rounds
+  std::mutex compaction_mutex_;
+
+  // sealed tile groups with the epoch they were sealed in, waiting for
+  // running inserts into them to finish
+  std::vector<std::pair<uint64_t, oid_t>> sealed_tile_groups_;
+
+  // moved-out tile groups, waiting for readers of old snapshots to finish
+  std::vector<CompactedTileGroup> compacted_tile_groups_;
+
+  // tile group the live tuples are moved into
+  std::shared_ptr<TileGroup> compaction_tile_group_;
+
 
-  // # of tuples. must be atomic as multiple transactions can perform insert
+  // # of tuples. sharded as multiple transactions can perform insert
   // concurrently.
-  std::atomic<size_t> number_of_tuples_ = ATOMIC_VAR_INIT(0);
+  ShardedCounter number_of_tuples_;
 
   // dirty flag. for detecting whether the tile group has been used.
-  bool dirty_ = false;
+  // only written when it changes, inserts on all cores read it
+  std::atomic<bool> dirty_ = ATOMIC_VAR_INIT(false);
 
   //===--------------------------------------------------------------------===//
   // TUNING MEMBERS
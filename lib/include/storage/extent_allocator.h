@@ -0,0 +1,111 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// extent_allocator.h
+//
+// Identification: src/include/storage/extent_allocator.h
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <limits>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "type/types.h"
+
+namespace peloton {
+namespace storage {
+
+//===--------------------------------------------------------------------===//
+// Extent Allocator
+//===--------------------------------------------------------------------===//
+
+/**
+ * Manages free space in a linear address range, such as the data file
+ * backing the SSD/HDD storage backends.
+ *
+ * Extents are multiples of the alignment (a page by default). Free extents
+ * are indexed by offset, so that a released extent is coalesced with its
+ * free neighbours, and by size class (power of two number of pages), so that
+ * an allocation takes the best fit from the smallest class that can hold it.
+ *
+ * Not thread-safe, callers serialize access.
+ */
+class ExtentAllocator {
+  ExtentAllocator(ExtentAllocator const &) = delete;
+
+ public:
+  ExtentAllocator(const size_t &capacity,
+                  const size_t &alignment = default_alignment_);
+
+  // Returns the offset of a new extent of at least size bytes, or
+  // INVALID_EXTENT_OFFSET if there is no free extent large enough
+  size_t Allocate(const size_t &size);
+
+  // Allocate the extent [offset, offset + size), which must be free.
+  // Used to rebuild the allocation state of a persistent range.
+  bool Reserve(const size_t &offset, const size_t &size);
+
+  // Free the extent starting at offset, returns its length or 0 if no extent
+  // starts there
+  size_t Release(const size_t &offset);
+
+  // Extend the managed range to new_capacity bytes
+  void Grow(const size_t &new_capacity);
+
+  // Length of the allocated extent starting at offset, 0 if none
+  size_t GetExtentSize(const size_t &offset) const;
+
+  size_t GetCapacity() const { return capacity_; }
+
+  size_t GetFreeBytes() const { return free_bytes_; }
+
+  size_t GetAllocatedBytes() const { return capacity_ - free_bytes_; }
+
+  size_t GetFreeExtentCount() const { return free_extents_.size(); }
+
+  // Largest allocation that would currently succeed
+  size_t GetLargestFreeExtent() const;
+
+  static const size_t INVALID_EXTENT_OFFSET =
+      std::numeric_limits<size_t>::max();
+
+  static const size_t default_alignment_ = 4096;
+
+ private:
+  size_t GetSizeClass(const size_t &length) const;
+
+  void AddFreeExtent(const size_t &offset, const size_t &length);
+
+  void RemoveFreeExtent(const size_t &offset, const size_t &length);
+
+  //===--------------------------------------------------------------------===//
+  // Members
+  //===--------------------------------------------------------------------===//
+
+  size_t capacity_;
+
+  size_t alignment_;
+
+  size_t free_bytes_;
+
+  // free extents : offset -> length
+  std::map<size_t, size_t> free_extents_;
+
+  // free extents per size class : <length, offset>
+  std::vector<std::set<std::pair<size_t, size_t>>> size_classes_;
+
+  // allocated extents : offset -> length
+  std::unordered_map<size_t, size_t> allocated_extents_;
+};
+
+}  // End storage namespace
+}  // End peloton namespace
@@ -0,0 +1,92 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// free_slot_manager.h
+//
+// Identification: src/include/storage/free_slot_manager.h
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <utility>
+#include <vector>
+
+#include "common/item_pointer.h"
+#include "common/platform.h"
+
+namespace peloton {
+namespace storage {
+
+//===--------------------------------------------------------------------===//
+// Free Slot Manager
+//===--------------------------------------------------------------------===//
+
+/**
+ * Tracks the tuple slots of a table that can be handed out again.
+ *
+ * A slot is retired once its version is unreachable for new snapshots, i.e.
+ * it has been unlinked from the version chain and the indexes and it ended
+ * before the oldest running snapshot. Threads that still look at it pin an
+ * epoch before they do so, and the slot only becomes free once every pinned
+ * epoch is newer than the one it was retired in.
+ *
+ * Slots are kept in shards picked by the thread index, so that threads
+ * mostly retire and reuse slots without contending on a lock. A thread that
+ * finds its own shard empty takes free slots of the other shards.
+ */
+class FreeSlotManager {
+  FreeSlotManager(FreeSlotManager const &) = delete;
+
+ public:
+  FreeSlotManager();
+
+  // Hand back the slot of a version that new snapshots can no longer see
+  void RetireSlot(const ItemPointer &location);
+
+  // Hand back a slot that nobody can see anymore, e.g. one the garbage
+  // collector already waited for
+  void ReleaseSlot(const ItemPointer &location);
+
+  // A slot that nobody can see anymore, INVALID_ITEMPOINTER if there is none
+  ItemPointer GetFreeSlot();
+
+  // Forget all slots, e.g. when the table drops its tile groups
+  void Clear();
+
+  // retired slots that have not been handed out again
+  size_t GetRetiredSlotCount() const { return retired_slot_count_; }
+
+  static const size_t shard_count_ = 16;
+
+  // reclaims of a thread between two epochs it starts itself, the garbage
+  // collector starts new epochs in between
+  static const size_t epoch_advance_interval_ = 64;
+
+ private:
+  struct CACHE_ALIGNED Shard {
+    Spinlock shard_lock;
+
+    // <epoch, slot> in the order the slots were retired
+    std::deque<std::pair<uint64_t, ItemPointer>> retired_slots;
+
+    // slots no pinned epoch can see anymore
+    std::vector<ItemPointer> free_slots;
+  };
+
+  // Move the slots of the shard that were retired before the reclaimable
+  // epoch to its free slots. Caller holds the shard lock.
+  void ReclaimSlots(Shard &shard, uint64_t &reclaimable_epoch);
+
+  Shard shards_[shard_count_];
+
+  std::atomic<size_t> retired_slot_count_;
+};
+
+}  // End storage namespace
+}  // End peloton namespace
@@ -0,0 +1,128 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// huge_page_pool.h
+//
+// Identification: src/include/storage/huge_page_pool.h
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "type/types.h"
+
+namespace peloton {
+namespace storage {
+
+// 2 MB huge pages
+#define HUGE_PAGE_SIZE (UINT64_C(2) * 1024 * 1024)
+
+//===--------------------------------------------------------------------===//
+// Huge Page Pool
+//===--------------------------------------------------------------------===//
+
+/**
+ * Hands out memory regions backed by 2 MB huge pages.
+ *
+ * Regions come from explicitly reserved huge pages (MAP_HUGETLB) when the
+ * system has them, and otherwise from a 2 MB aligned anonymous mapping that
+ * is marked with MADV_HUGEPAGE so that transparent huge pages back it.
+ * Released regions are kept in a pool keyed by size and NUMA node and handed
+ * out again to later tile groups, up to a bound on the cached bytes.
+ */
+class HugePagePool {
+  HugePagePool(HugePagePool const &) = delete;
+
+ public:
+  HugePagePool(const size_t &max_cached_bytes = default_max_cached_bytes_);
+
+  ~HugePagePool();
+
+  // Allocate a region of at least size bytes, rounded up to huge pages
+  void *Allocate(const size_t &size, const int &numa_node);
+
+  // Return a region to the pool. Returns false if the region was not
+  // allocated by this pool.
+  bool Release(void *address);
+
+  // Unmap all cached regions
+  void Trim();
+
+  //===--------------------------------------------------------------------===//
+  // Accounting
+  //===--------------------------------------------------------------------===//
+
+  // regions backed by reserved huge pages
+  size_t GetHugetlbRegionCount() const { return hugetlb_region_count_; }
+
+  // regions backed by transparent huge pages
+  size_t GetTransparentRegionCount() const {
+    return transparent_region_count_;
+  }
+
+  // allocations served from the pool
+  size_t GetRecycledRegionCount() const { return recycled_region_count_; }
+
+  // bytes handed out and not yet released
+  size_t GetLiveBytes() const { return live_bytes_; }
+
+  // bytes kept in the pool for reuse
+  size_t GetCachedBytes() const { return cached_bytes_; }
+
+  static const size_t default_max_cached_bytes_ = 64 * HUGE_PAGE_SIZE;
+
+  // regions mapped without reserved huge pages after the kernel ran out of
+  // them, before asking again
+  static const size_t hugetlb_retry_interval_ = 64;
+
+ private:
+  struct Region {
+    size_t size;
+    int numa_node;
+    bool hugetlb;
+  };
+
+  void *MapRegion(const size_t &size, bool &hugetlb);
+
+  void UnmapRegion(void *address, const Region &region);
+
+  // Regions in use
+  std::unordered_map<void *, Region> live_regions_;
+
+  // Released regions by <size, node>
+  std::map<std::pair<size_t, int>, std::vector<std::pair<void *, Region>>>
+      cached_regions_;
+
+  std::mutex pool_mutex_;
+
+  size_t max_cached_bytes_;
+
+  // Stop asking for reserved huge pages if the kernel does not support them
+  std::atomic<bool> hugetlb_available_;
+
+  // regions left to map before reserved huge pages are asked for again
+  std::atomic<size_t> hugetlb_retry_countdown_;
+
+  std::atomic<size_t> hugetlb_region_count_;
+
+  std::atomic<size_t> transparent_region_count_;
+
+  std::atomic<size_t> recycled_region_count_;
+
+  std::atomic<size_t> live_bytes_;
+
+  std::atomic<size_t> cached_bytes_;
+};
+
+}  // End storage namespace
+}  // End peloton namespace
@@ -0,0 +1,175 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// parallel_table_scanner.h
+//
+// Identification: src/include/storage/parallel_table_scanner.h
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "common/platform.h"
+#include "type/types.h"
+
+namespace peloton {
+
+namespace executor {
+class LogicalTile;
+}
+
+namespace storage {
+
+class DataTable;
+class TileGroup;
+
+//===--------------------------------------------------------------------===//
+// Morsel
+//===--------------------------------------------------------------------===//
+
+/**
+ * A contiguous range [begin_offset, end_offset) of the tile groups captured
+ * by a scan, all placed on the same NUMA node. A morsel is the unit of work
+ * handed out to scan workers.
+ */
+struct Morsel {
+  oid_t begin_offset;
+  oid_t end_offset;
+  int numa_node;
+};
+
+//===--------------------------------------------------------------------===//
+// Morsel Queue
+//===--------------------------------------------------------------------===//
+
+/**
+ * Work-stealing queue of morsels.
+ *
+ * Morsels are kept in one deque per NUMA node, holding the morsels whose
+ * memory lives on that node. A worker pops from the front of the deque of
+ * the node it is running on, and once that runs dry steals from the back of
+ * the other nodes' deques, so skewed morsels do not leave cores idle at the
+ * tail of a scan while most tile groups are still read node-locally.
+ */
+class MorselQueue {
+  MorselQueue() = delete;
+  MorselQueue(MorselQueue const &) = delete;
+
+ public:
+  MorselQueue(const std::vector<Morsel> &morsels, const size_t node_count);
+
+  // Get the next morsel for a worker running on the given node. Returns false
+  // when no work is left anywhere.
+  bool Next(const int numa_node, Morsel &morsel);
+
+  size_t GetNodeCount() const { return node_queues_.size(); }
+
+ private:
+  struct NodeQueue : public CacheAlignedAllocation {
+    Spinlock lock;
+    std::deque<Morsel> morsels;
+  } CACHE_ALIGNED;
+
+  bool PopFront(NodeQueue &queue, Morsel &morsel);
+
+  bool PopBack(NodeQueue &queue, Morsel &morsel);
+
+  std::vector<std::unique_ptr<NodeQueue>> node_queues_;
+};
+
+//===--------------------------------------------------------------------===//
+// Parallel Table Scanner
+//===--------------------------------------------------------------------===//
+
+/**
+ * Morsel-driven parallel scan over the tile groups of a data table.
+ *
+ * The tile groups are collected when the scanner is constructed, and again
+ * when it executes to pick up the ones compaction filled with live versions
+ * in between. Each tuple slot is checked against the begin/end commit ids of
+ * its version, so all workers observe the same snapshot of the table at
+ * snapshot_cid. The scan pins an epoch while it runs, so neither compaction
+ * nor garbage collection frees tile groups or varlen data under it; the
+ * transaction owning an older snapshot keeps its own pin in between.
+ * Morsels never span NUMA nodes and workers prefer morsels of their node.
+ * Every non-empty tile group yields one logical tile that is handed to the
+ * consumer on the worker thread that scanned it. Scan workers run as tasks on
+ * the shared thread pool.
+ */
+class ParallelTableScanner {
+  ParallelTableScanner() = delete;
+  ParallelTableScanner(ParallelTableScanner const &) = delete;
+
+ public:
+  typedef std::function<void(size_t worker_id,
+                             std::unique_ptr<executor::LogicalTile> tile)>
+      ConsumerType;
+
+  // worker_count of zero means one worker per hardware thread
+  ParallelTableScanner(const DataTable *table, const cid_t snapshot_cid,
+                       const std::vector<oid_t> &column_ids,
+                       const size_t worker_count = 0,
+                       const size_t tile_groups_per_morsel =
+                           default_tile_groups_per_morsel_);
+
+  // Scan the whole table, blocking until every morsel has been consumed
+  void Execute(const ConsumerType &consumer);
+
+  // Build the logical tile holding the versions of the given tile group that
+  // are visible at snapshot_cid. Returns nullptr when none are.
+  static executor::LogicalTile *ScanTileGroup(
+      const std::shared_ptr<TileGroup> &tile_group, const cid_t snapshot_cid,
+      const std::vector<oid_t> &column_ids);
+
+  const std::vector<Morsel> &GetMorsels() const { return morsels_; }
+
+  const std::vector<oid_t> &GetTileGroupIds() const { return tile_group_ids_; }
+
+  size_t GetWorkerCount() const { return worker_count_; }
+
+  static const size_t default_tile_groups_per_morsel_ = 4;
+
+ private:
+  void ScanMorsels(const size_t worker_id, MorselQueue &queue,
+                   const ConsumerType &consumer);
+
+  // Add morsels for the given tile groups that the scan does not cover yet
+  void AddTileGroups(const std::vector<oid_t> &tile_group_ids);
+
+  void AddMorsels(const std::vector<oid_t> &tile_group_ids,
+                  const int numa_node);
+
+  //===--------------------------------------------------------------------===//
+  // Members
+  //===--------------------------------------------------------------------===//
+
+  const DataTable *table_;
+
+  cid_t snapshot_cid_;
+
+  std::vector<oid_t> column_ids_;
+
+  size_t worker_count_;
+
+  size_t tile_groups_per_morsel_;
+
+  // tile groups covered by the scan, morsels index into this list.
+  // tile groups of the same node are adjacent.
+  std::vector<oid_t> tile_group_ids_;
+
+  size_t numa_node_count_;
+
+  std::vector<Morsel> morsels_;
+};
+
+}  // End storage namespace
+}  // End peloton namespace
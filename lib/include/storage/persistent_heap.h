@@ -0,0 +1,230 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// persistent_heap.h
+//
+// Identification: src/include/storage/persistent_heap.h
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "storage/extent_allocator.h"
+#include "type/types.h"
+
+namespace peloton {
+namespace storage {
+
+//===--------------------------------------------------------------------===//
+// Persistent layout
+//===--------------------------------------------------------------------===//
+
+// The heap file starts with the superblock, followed by the tile group
+// descriptor table and the data area. Everything in the file refers to other
+// parts of the file by offset, so the heap may be mapped at any address.
+
+struct PersistentHeapSuperblock {
+  uint64_t magic;
+  uint64_t version;
+  uint64_t heap_size;
+  uint64_t descriptor_count;
+  uint64_t descriptor_offset;
+  uint64_t data_offset;
+};
+
+// Descriptor states
+#define PERSISTENT_DESCRIPTOR_FREE 0
+#define PERSISTENT_DESCRIPTOR_VALID 1
+
+// One per persistent tile group, a cache line each
+struct PersistentTileGroupDescriptor {
+  uint64_t state;
+  oid_t database_id;
+  oid_t table_id;
+  oid_t tile_group_id;
+  oid_t tuple_count;
+  oid_t tile_count;
+  oid_t column_count;
+  uint64_t header_offset;
+  uint64_t header_size;
+  // tile_count PersistentTileExtents followed by column_count
+  // PersistentColumnMapEntries
+  uint64_t layout_offset;
+  // registration order, of two descriptors of the same tile group the
+  // later one replaced the earlier one
+  uint64_t sequence;
+};
+
+struct PersistentTileExtent {
+  uint64_t offset;
+  uint64_t size;
+};
+
+struct PersistentColumnMapEntry {
+  oid_t tile_offset;
+  oid_t tile_column_offset;
+};
+
+//===--------------------------------------------------------------------===//
+// Persistent Heap
+//===--------------------------------------------------------------------===//
+
+/**
+ * Tile storage that survives a restart, in a file on a DAX or tmpfs file
+ * system.
+ *
+ * The allocation state is not persisted. An extent is in use exactly when a
+ * valid descriptor refers to it, so opening the heap rebuilds the allocator
+ * from the descriptor table. A tile group is published by persisting its
+ * header, tiles and layout before its descriptor turns valid, and retired by
+ * invalidating the descriptor before its extents are freed. A crash at any
+ * point thus leaves every valid descriptor pointing to complete tile groups,
+ * and leaks nothing. A tile group replacing another one with the same id,
+ * such as a transformed tile group, is published once it is complete and
+ * wins over the one it replaces.
+ */
+class PersistentHeap {
+  PersistentHeap(PersistentHeap const &) = delete;
+
+ public:
+  // Open the heap file, creating a heap of heap_size bytes if there is none.
+  // An existing heap keeps its size.
+  PersistentHeap(const std::string &file_name, const size_t &heap_size);
+
+  ~PersistentHeap();
+
+  //===--------------------------------------------------------------------===//
+  // Allocation
+  //===--------------------------------------------------------------------===//
+
+  void *Allocate(const size_t &size);
+
+  void Free(void *address);
+
+  bool Contains(const void *address) const {
+    return address >= heap_address && address < heap_address + heap_size;
+  }
+
+  // Flush the range and wait for it to reach persistence
+  void Persist(const void *address, const size_t &length);
+
+  //===--------------------------------------------------------------------===//
+  // Tile group descriptors
+  //===--------------------------------------------------------------------===//
+
+  // Publish a tile group whose header and tiles live in the heap.
+  // column_map is the tile group's column_map_type. Returns the descriptor
+  // id, INVALID_OID if the descriptor table is full.
+  oid_t RegisterTileGroup(
+      const oid_t &database_id, const oid_t &table_id,
+      const oid_t &tile_group_id, const oid_t &tuple_count,
+      const void *header_data, const size_t &header_size,
+      const std::vector<std::pair<const void *, size_t>> &tile_data,
+      const std::map<oid_t, std::pair<oid_t, oid_t>> &column_map);
+
+  void UnregisterTileGroup(const oid_t &descriptor_id);
+
+  // Keep all tile groups and extents from here on
+  void Detach() { detached = true; }
+
+  // Descriptors of the table's tile groups found when the heap was opened.
+  // Each is handed out once.
+  std::vector<oid_t> TakeRecoveredTileGroups(const oid_t &database_id,
+                                             const oid_t &table_id);
+
+  const PersistentTileGroupDescriptor &GetDescriptor(
+      const oid_t &descriptor_id) const {
+    return descriptors[descriptor_id];
+  }
+
+  char *GetHeaderData(const oid_t &descriptor_id) const;
+
+  std::vector<char *> GetTileData(const oid_t &descriptor_id) const;
+
+  std::map<oid_t, std::pair<oid_t, oid_t>> GetColumnMap(
+      const oid_t &descriptor_id) const;
+
+  //===--------------------------------------------------------------------===//
+  // Accessors
+  //===--------------------------------------------------------------------===//
+
+  const std::string &GetFileName() const { return file_name; }
+
+  size_t GetHeapSize() const { return heap_size; }
+
+  size_t GetFreeBytes();
+
+  // Largest tile group id in the heap when it was opened
+  oid_t GetMaxRecoveredTileGroupId() const {
+    return max_recovered_tile_group_id;
+  }
+
+  size_t GetRecoveredTileGroupCount() const {
+    return recovered_tile_group_count;
+  }
+
+  // DAX file system if present, temp directory otherwise
+  static std::string GetDefaultFileName();
+
+ private:
+  void Format();
+
+  void Recover();
+
+  char *GetAddress(const uint64_t &offset) const {
+    return heap_address + offset;
+  }
+
+  uint64_t GetOffset(const void *address) const {
+    return reinterpret_cast<const char *>(address) - heap_address;
+  }
+
+  //===--------------------------------------------------------------------===//
+  // Members
+  //===--------------------------------------------------------------------===//
+
+  std::string file_name;
+
+  int heap_fd;
+
+  char *heap_address;
+
+  size_t heap_size;
+
+  PersistentHeapSuperblock *superblock;
+
+  PersistentTileGroupDescriptor *descriptors;
+
+  // protects the allocator and the descriptor bookkeeping
+  std::mutex heap_mutex;
+
+  // data area, offsets relative to the superblock's data offset
+  std::unique_ptr<ExtentAllocator> data_allocator;
+
+  std::vector<oid_t> free_descriptors;
+
+  // <database, table> to recovered descriptors
+  std::map<std::pair<oid_t, oid_t>, std::vector<oid_t>> recovered_tile_groups;
+
+  oid_t max_recovered_tile_group_id;
+
+  size_t recovered_tile_group_count;
+
+  uint64_t next_sequence;
+
+  std::atomic<bool> detached;
+};
+
+}  // End storage namespace
+}  // End peloton namespace
@@ -12,14 +12,26 @@
 
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
+#include <memory>
 #include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 
 #include "common/platform.h"
+#include "storage/extent_allocator.h"
+#include "storage/huge_page_pool.h"
+#include "storage/zeroed_buffer_pool.h"
 #include "type/types.h"
 
 namespace peloton {
 namespace storage {
 
+class PersistentHeap;
+
 //===--------------------------------------------------------------------===//
 // Filesystem directories
 //===--------------------------------------------------------------------===//
@@ -44,37 +56,231 @@ class StorageManager {
   StorageManager();
   ~StorageManager();
 
-  void *Allocate(BackendType type, size_t size);
+  // Allocate memory on the given backend. For in-memory backends the pages
+  // are placed on numa_node unless it is INVALID_NUMA_NODE.
+  void *Allocate(BackendType type, size_t size,
+                 int numa_node = INVALID_NUMA_NODE);
 
   void Release(BackendType type, void *address);
 
+  // Zero-filled memory for tiles and tile group headers. In buffer pool
+  // mode it comes from, and goes back to, the zeroed buffer pool, so size
+  // and numa_node must match between the two calls.
+  void *AllocateZeroed(BackendType type, size_t size,
+                       int numa_node = INVALID_NUMA_NODE);
+
+  void ReleaseZeroed(BackendType type, void *address, size_t size,
+                     int numa_node = INVALID_NUMA_NODE);
+
+  // Make [address, address + length) durable. In async sync mode SSD/HDD
+  // ranges are only queued, see WaitForSync().
   void Sync(BackendType type, void *address, size_t length);
 
+  // Batch SSD/HDD syncs on a background flusher
+  void SetAsyncSyncMode(const bool enabled);
+
+  bool GetAsyncSyncMode() const { return async_sync_mode; }
+
+  // Block until every range queued before the call is durable
+  void WaitForSync();
+
   size_t GetMsyncCount() const { return msync_count; }
 
-  size_t GetClflushCount() const { return clflush_count; }
+  size_t GetSyncedByteCount() const { return synced_byte_count; }
+
+  size_t GetSyncBatchCount() const { return sync_batch_count; }
+
+  size_t GetClflushCount() const {
+    return clflush_count.load(std::memory_order_relaxed);
+  }
+
+  size_t GetAllocationCount() const {
+    return allocation_count.load(std::memory_order_relaxed);
+  }
+
+  size_t GetNumaAllocationCount() const {
+    return numa_allocation_count.load(std::memory_order_relaxed);
+  }
+
+  size_t GetHugePageAllocationCount() const {
+    return huge_page_allocation_count.load(std::memory_order_relaxed);
+  }
+
+  // Back large in-memory allocations with 2 MB huge pages
+  void SetHugePageMode(const bool enabled) { huge_page_mode = enabled; }
+
+  bool GetHugePageMode() const { return huge_page_mode; }
+
+  const HugePagePool &GetHugePagePool() const { return huge_page_pool; }
+
+  // Recycle tile and header buffers, cleared in the background
+  void SetBufferPoolMode(const bool enabled) { buffer_pool_mode = enabled; }
+
+  bool GetBufferPoolMode() const { return buffer_pool_mode; }
+
+  const ZeroedBufferPool &GetZeroedBufferPool() const {
+    return zeroed_buffer_pool;
+  }
 
-  size_t GetAllocationCount() const { return allocation_count; }
+  // Keep NVM tiles in a persistent heap file, see PersistentHeap. Must be
+  // called before any table is created. Returns the number of tile groups
+  // found in an existing heap, which tables re-attach with
+  // DataTable::RecoverTileGroups().
+  size_t OpenPersistentHeap(const std::string &file_name, size_t heap_size);
+
+  // Stop retiring tile groups from the persistent heap, so that tearing
+  // down tables at shutdown keeps their tile groups for the next start
+  void ClosePersistentHeap();
+
+  PersistentHeap *GetPersistentHeap() const { return persistent_heap; }
+
+  // Make the NVM backend as slow as the device being benchmarked. Every page
+  // of new NVM space costs read_latency, as its first touch reads it from the
+  // device. Every NVM sync costs flush_latency per cache line, then
+  // write_latency for the writes to drain. Latencies are in nanoseconds,
+  // all zero turns emulation off. Set it before the workload starts.
+  void SetNvmLatencyEmulation(size_t read_latency, size_t write_latency,
+                              size_t flush_latency);
+
+  bool GetNvmLatencyEmulation() const { return nvm_latency_emulation; }
+
+  size_t GetNvmReadLatency() const {
+    return nvm_read_latency.load(std::memory_order_relaxed);
+  }
+
+  size_t GetNvmWriteLatency() const {
+    return nvm_write_latency.load(std::memory_order_relaxed);
+  }
+
+  size_t GetNvmFlushLatency() const {
+    return nvm_flush_latency.load(std::memory_order_relaxed);
+  }
+
+  // Total latency injected so far, in nanoseconds
+  size_t GetEmulatedLatency() const { return emulated_latency; }
+
+  // TSC ticks per microsecond, measured when latency emulation is first
+  // turned on, zero before
+  double GetTscFrequency() const { return tsc_frequency; }
+
+  // Whether data on the backend outlives the process and has to be synced
+  bool NeedsSync(BackendType type) const;
+
+  // Current size of the data file backing the SSD/HDD backends
+  size_t GetDataFileLength() const { return data_file_len; }
+
+  size_t GetDataFileFreeBytes();
+
+  size_t GetDataFileGrowthCount() const { return data_file_growth_count; }
 
  private:
+  // Write back a page aligned range of the data file
+  void SyncDataFile(size_t offset, size_t length);
+
+  // Background flusher for async sync mode
+  void FlushSyncRanges();
+
+  void StopSyncFlusher();
+
+  // Busy-wait for latency nanoseconds
+  void EmulateNvmLatency(size_t latency);
+
+  // Take an extent from the data file, INVALID_EXTENT_OFFSET if none fits
+  size_t AllocateDataFileExtent(size_t size);
+
+  // Extend the data file so that an extent of size bytes fits.
+  // Caller holds the data file growth mutex.
+  void GrowDataFile(size_t size);
+
   // data file address
   void *data_file_address;
 
-  // data file lock
+  // data file descriptor, kept open to grow the file
+  int data_file_fd;
+
+  // data file lock, guards the extent allocator
   Spinlock data_file_spinlock;
 
+  // serializes growing the data file, held across its syscalls
+  std::mutex data_file_growth_mutex;
+
   // data file len
-  size_t data_file_len;
+  std::atomic<size_t> data_file_len;
+
+  // address space reserved for the data file mapping
+  size_t data_file_reserved_len;
+
+  // free space in the data file
+  std::unique_ptr<ExtentAllocator> data_file_allocator;
+
+  std::atomic<size_t> data_file_growth_count = ATOMIC_VAR_INIT(0);
+
+  // async sync mode
+  std::atomic<bool> async_sync_mode = ATOMIC_VAR_INIT(false);
+
+  std::thread sync_flusher;
+
+  std::mutex sync_mutex;
+
+  // signals the flusher that ranges are queued
+  std::condition_variable sync_queued_cv;
+
+  // signals waiters that a batch is durable
+  std::condition_variable sync_done_cv;
+
+  // queued <offset, length> ranges of the data file
+  std::vector<std::pair<size_t, size_t>> queued_sync_ranges;
+
+  // ranges are numbered in queue order
+  size_t queued_sync_count = 0;
+
+  size_t durable_sync_count = 0;
 
-  // data offset
-  size_t data_file_offset;
+  bool sync_flusher_shutdown = false;
 
   // stats
-  size_t msync_count = 0;
+  std::atomic<size_t> msync_count = ATOMIC_VAR_INIT(0);
+
+  std::atomic<size_t> synced_byte_count = ATOMIC_VAR_INIT(0);
+
+  size_t sync_batch_count = 0;
+
+  std::atomic<size_t> clflush_count = ATOMIC_VAR_INIT(0);
+
+  std::atomic<size_t> allocation_count = ATOMIC_VAR_INIT(0);
+
+  std::atomic<size_t> numa_allocation_count = ATOMIC_VAR_INIT(0);
+
+  std::atomic<size_t> huge_page_allocation_count = ATOMIC_VAR_INIT(0);
+
+  // NVM latency emulation, latencies in nanoseconds
+  std::atomic<bool> nvm_latency_emulation = ATOMIC_VAR_INIT(false);
+
+  std::atomic<size_t> nvm_read_latency = ATOMIC_VAR_INIT(0);
+
+  std::atomic<size_t> nvm_write_latency = ATOMIC_VAR_INIT(0);
+
+  std::atomic<size_t> nvm_flush_latency = ATOMIC_VAR_INIT(0);
+
+  std::atomic<size_t> emulated_latency = ATOMIC_VAR_INIT(0);
+
+  // TSC ticks per microsecond, published by the emulation flag
+  double tsc_frequency = 0;
+
+  std::once_flag tsc_calibration_flag;
+
+  // huge pages
+  std::atomic<bool> huge_page_mode = ATOMIC_VAR_INIT(false);
+
+  HugePagePool huge_page_pool;
+
+  // zeroed tile buffers
+  std::atomic<bool> buffer_pool_mode = ATOMIC_VAR_INIT(false);
 
-  size_t clflush_count = 0;
+  ZeroedBufferPool zeroed_buffer_pool{*this};
 
-  size_t allocation_count = 0;
+  // persistent NVM tiles, mapped until the process exits
+  PersistentHeap *persistent_heap = nullptr;
 };
 
 }  // End storage namespace
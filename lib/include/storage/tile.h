@@ -59,7 +59,12 @@ class Tile : public Printable {
   // Tile creator
   Tile(BackendType backend_type, TileGroupHeader *tile_header,
        const catalog::Schema &tuple_schema, TileGroup *tile_group,
-       int tuple_count);
+       int tuple_count, int numa_node = INVALID_NUMA_NODE);
+
+  // Attach to tile data recovered from persistent memory
+  Tile(BackendType backend_type, TileGroupHeader *tile_header,
+       const catalog::Schema &tuple_schema, TileGroup *tile_group,
+       int tuple_count, char *persistent_data);
 
   virtual ~Tile();
 
@@ -110,6 +115,12 @@ class Tile : public Printable {
                     const size_t column_offset, const bool is_inlined,
                     const size_t column_length);
 
+  /**
+   * Give the uninlined values of the tuple slot back to the pool.
+   * Used when the version in the slot is garbage collected.
+   */
+  void FreeUninlinedData(const oid_t tuple_offset);
+
   // Get tuple at location
   static Tuple *GetTuple(catalog::Manager *catalog,
                          const ItemPointer *tuple_location);
@@ -177,6 +188,9 @@ class Tile : public Printable {
   // Sync the contents
   void Sync();
 
+  // Sync the tuples in slots [begin_slot, end_slot)
+  void Sync(const oid_t &begin_slot, const oid_t &end_slot);
+
  protected:
   //===--------------------------------------------------------------------===//
   // Data members
@@ -191,6 +205,9 @@ class Tile : public Printable {
   // backend type
   BackendType backend_type;
 
+  // node the tile was allocated on
+  int numa_node;
+
   // tile schema
   catalog::Schema schema;
 
@@ -282,9 +299,23 @@ class TileFactory {
                        oid_t table_id, oid_t tile_group_id, oid_t tile_id,
                        TileGroupHeader *tile_header,
                        const catalog::Schema &schema, TileGroup *tile_group,
-                       int tuple_count) {
-    Tile *tile =
-        new Tile(backend_type, tile_header, schema, tile_group, tuple_count);
+                       int tuple_count, int numa_node = INVALID_NUMA_NODE) {
+    Tile *tile = new Tile(backend_type, tile_header, schema, tile_group,
+                          tuple_count, numa_node);
+
+    TileFactory::InitCommon(tile, database_id, table_id, tile_group_id, tile_id,
+                            schema);
+
+    return tile;
+  }
+
+  static Tile *GetTile(BackendType backend_type, oid_t database_id,
+                       oid_t table_id, oid_t tile_group_id, oid_t tile_id,
+                       TileGroupHeader *tile_header,
+                       const catalog::Schema &schema, TileGroup *tile_group,
+                       int tuple_count, char *persistent_data) {
+    Tile *tile = new Tile(backend_type, tile_header, schema, tile_group,
+                          tuple_count, persistent_data);
 
     TileFactory::InitCommon(tile, database_id, table_id, tile_group_id, tile_id,
                             schema);
@@ -75,7 +75,14 @@ class TileGroup : public Printable {
   // Tile group constructor
   TileGroup(BackendType backend_type, TileGroupHeader *tile_group_header,
             AbstractTable *table, const std::vector<catalog::Schema> &schemas,
-            const column_map_type &column_map, int tuple_count);
+            const column_map_type &column_map, int tuple_count,
+            int numa_node = INVALID_NUMA_NODE);
+
+  // Tile group over tiles recovered from persistent memory
+  TileGroup(BackendType backend_type, TileGroupHeader *tile_group_header,
+            AbstractTable *table, const std::vector<catalog::Schema> &schemas,
+            const column_map_type &column_map, int tuple_count,
+            const std::vector<char *> &persistent_tile_data);
 
   ~TileGroup();
 
@@ -89,10 +96,14 @@ class TileGroup : public Printable {
   // insert tuple at next available slot in tile if a slot exists
   oid_t InsertTuple(const Tuple *tuple);
 
-  // insert tuple at specific tuple slot
+  // give the uninlined values of a garbage collected version back to the
+  // tile pools
+  void FreeUninlinedData(const oid_t &tuple_slot_id);
+
+  // insert serialized tuple at specific tuple slot
   // used by recovery mode
   oid_t InsertTupleFromRecovery(cid_t commit_id, oid_t tuple_slot_id,
-                                const Tuple *tuple);
+                                SerializeInput &tuple_body);
 
   // insert tuple at specific tuple slot
   // used by recovery mode
@@ -103,7 +114,8 @@ class TileGroup : public Printable {
   oid_t UpdateTupleFromRecovery(cid_t commit_id, oid_t tuple_slot_id,
                                 ItemPointer new_location);
 
-  oid_t InsertTupleFromCheckpoint(oid_t tuple_slot_id, const Tuple *tuple,
+  oid_t InsertTupleFromCheckpoint(oid_t tuple_slot_id,
+                                  SerializeInput &tuple_body,
                                   cid_t commit_id);
 
   //===--------------------------------------------------------------------===//
@@ -154,6 +166,12 @@ class TileGroup : public Printable {
 
   AbstractTable *GetAbstractTable() const { return table; }
 
+  // NUMA node holding the tile group's memory, or INVALID_NUMA_NODE
+  int GetNumaNode() const { return numa_node; }
+
+  // Descriptor in the persistent heap, INVALID_OID if not persistent
+  oid_t GetPersistentDescriptorId() const { return persistent_descriptor_id; }
+
   void SetTileGroupId(oid_t tile_group_id_) { tile_group_id = tile_group_id_; }
 
   std::vector<catalog::Schema> &GetTileSchemas() { return tile_schemas; }
@@ -181,10 +199,13 @@ class TileGroup : public Printable {
 
   double GetSchemaDifference(const storage::column_map_type &new_column_map);
 
-  // Sync the contents
+  // Sync the contents modified since the last sync
   void Sync();
 
  protected:
+  // Decode a serialized tuple into the tiles of the slot
+  void CopySerializedTuple(oid_t tuple_slot_id, SerializeInput &tuple_body);
+
   //===--------------------------------------------------------------------===//
   // Data members
   //===--------------------------------------------------------------------===//
@@ -215,11 +236,16 @@ class TileGroup : public Printable {
   // number of tiles
   oid_t tile_count;
 
+  // NUMA node the tiles and the header were allocated on
+  int numa_node;
+
   std::mutex tile_group_mutex;
 
   // column to tile mapping :
   // <column offset> to <tile offset, tile column offset>
   column_map_type column_map;
+
+  oid_t persistent_descriptor_id;
 };
 
 }  // End storage namespace
@@ -0,0 +1,112 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// tile_group_compactor.h
+//
+// Identification: src/include/storage/tile_group_compactor.h
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "type/types.h"
+
+namespace peloton {
+namespace storage {
+
+class DataTable;
+
+//===--------------------------------------------------------------------===//
+// Tile Group Compactor
+//===--------------------------------------------------------------------===//
+
+/**
+ * Background service that keeps the tile groups of its tables dense.
+ *
+ * Every round runs DataTable::CompactTileGroups on all tables. A tile group
+ * takes a few rounds to go away: it is sealed in one round, its live tuples
+ * are moved once running inserts are done with it, and it is dropped once
+ * readers of older snapshots are done with it.
+ */
+class TileGroupCompactor {
+ public:
+  TileGroupCompactor(const TileGroupCompactor &) = delete;
+  TileGroupCompactor &operator=(const TileGroupCompactor &) = delete;
+  TileGroupCompactor(TileGroupCompactor &&) = delete;
+  TileGroupCompactor &operator=(TileGroupCompactor &&) = delete;
+
+  // Hands out the commit id a round stamps on the tuples it moves. It must
+  // be newer than every committed transaction, e.g. the commit id of a
+  // transaction begun for the round.
+  typedef std::function<cid_t()> CommitIdProvider;
+
+  TileGroupCompactor();
+
+  ~TileGroupCompactor();
+
+  // Singleton
+  static TileGroupCompactor &GetInstance();
+
+  // Start compacting in the background
+  void Start(const CommitIdProvider &commit_id_provider);
+
+  // Stop compacting
+  void Stop();
+
+  // Run one round over all tables, returns the tile groups moved out
+  size_t Compact(const cid_t &commit_id);
+
+  // Add table to list of tables that must be compacted
+  void AddTable(DataTable *table);
+
+  // Remove table from the list, e.g. before it is dropped
+  void RemoveTable(DataTable *table);
+
+  // Clear list
+  void ClearTables();
+
+  // Tile groups with fewer live tuples than this fraction of their slots
+  // get compacted
+  void SetLivenessThreshold(const double &threshold) {
+    liveness_threshold = threshold;
+  }
+
+ private:
+  // Compactor thread
+  void CompactTables();
+
+  // Tables that must be compacted
+  std::vector<DataTable *> tables;
+
+  std::mutex compactor_mutex;
+
+  // Stop signal
+  std::atomic<bool> compaction_stop;
+
+  // Compactor thread
+  std::thread compactor_thread;
+
+  CommitIdProvider commit_id_provider;
+
+  //===--------------------------------------------------------------------===//
+  // Compactor Parameters
+  //===--------------------------------------------------------------------===//
+
+  std::atomic<double> liveness_threshold;
+
+  // Sleeping period between rounds (in ms)
+  oid_t sleep_duration = 100;
+};
+
+}  // End storage namespace
+}  // End peloton namespace
@@ -33,7 +33,18 @@ class TileGroupFactory {
                                  oid_t tile_group_id, AbstractTable *table,
                                  const std::vector<catalog::Schema> &schemas,
                                  const column_map_type &column_map,
-                                 int tuple_count);
+                                 int tuple_count,
+                                 int numa_node = INVALID_NUMA_NODE,
+                                 bool publish = true);
+
+  // Publish the tile group in the persistent heap if its tiles live there.
+  // Tile groups created with publish = false are published once filled.
+  static void PublishTileGroup(TileGroup *tile_group);
+
+  // Re-attach a tile group found in the persistent heap
+  static TileGroup *GetPersistentTileGroup(
+      AbstractTable *table, const std::vector<catalog::Schema> &schemas,
+      const oid_t &descriptor_id);
 };
 
 }  // End storage namespace
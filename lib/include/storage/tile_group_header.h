@@ -15,12 +15,15 @@
 #include <atomic>
 #include <cstring>
 #include <iostream>
+#include <memory>
 #include <queue>
+#include <utility>
 #include <vector>
 
 #include "common/item_pointer.h"
 #include "common/macros.h"
 #include "common/platform.h"
+#include "common/pmem_util.h"
 #include "common/printable.h"
 #include "type/types.h"
 
@@ -67,7 +70,12 @@ class TileGroupHeader : public Printable {
   TileGroupHeader() = delete;
 
  public:
-  TileGroupHeader(const BackendType &backend_type, const int &tuple_count);
+  TileGroupHeader(const BackendType &backend_type, const int &tuple_count,
+                  const int &numa_node = INVALID_NUMA_NODE);
+
+  // Attach to a header recovered from persistent memory
+  TileGroupHeader(const BackendType &backend_type, const int &tuple_count,
+                  char *persistent_data);
 
   TileGroupHeader &operator=(const peloton::storage::TileGroupHeader &other) {
     // check for self-assignment
@@ -75,32 +83,44 @@ class TileGroupHeader : public Printable {
 
     header_size = other.header_size;
 
-    // copy over all the data
-    PL_MEMCPY(data, other.data, header_size);
+    // copy over all the data, streaming it around the cache
+    PmemUtil::MemcpyNontemporal(data, other.data, header_size);
+    PmemUtil::Fence();
 
     num_tuple_slots = other.num_tuple_slots;
     oid_t val = other.next_tuple_slot;
     next_tuple_slot = val;
 
+    // chunks claimed before the copy are gone
+    insert_serial = next_insert_serial++;
+
+    MarkAllDirty();
+
     return *this;
   }
 
   ~TileGroupHeader();
 
   // this function is only called by DataTable::GetEmptyTupleSlot().
-  oid_t GetNextEmptyTupleSlot() {
-    if (next_tuple_slot >= num_tuple_slots) {
-      return INVALID_OID;
-    }
+  // Threads claim slots in chunks of insert_chunk_slot_count and hand them
+  // out from a thread-local cache, so that concurrent inserters do not
+  // contend on next_tuple_slot for every tuple.
+  oid_t GetNextEmptyTupleSlot();
 
-    oid_t tuple_slot_id =
-        next_tuple_slot.fetch_add(1, std::memory_order_relaxed);
+  uint64_t GetInsertSerial() const { return insert_serial; }
 
-    if (tuple_slot_id >= num_tuple_slots) {
-      return INVALID_OID;
-    } else {
-      return tuple_slot_id;
-    }
+  // Stop handing out slots, e.g. before the tile group is compacted. Slots
+  // that were already handed out stay with their inserters.
+  void Seal() { sealed.store(true, std::memory_order_seq_cst); }
+
+  bool IsSealed() const { return sealed.load(std::memory_order_acquire); }
+
+  // Make a slot whose version nobody can see anymore empty again, so that it
+  // can be handed out a second time
+  void ReclaimTupleSlot(const oid_t &tuple_slot_id) {
+    InitTupleSlot(tuple_slot_id);
+    SetIndirection(tuple_slot_id, nullptr);
+    MarkDirty(tuple_slot_id);
   }
 
   /**
@@ -111,6 +131,10 @@ class TileGroupHeader : public Printable {
     tile_header_lock.Lock();
     if (tuple_slot_id < num_tuple_slots) {
       if (next_tuple_slot <= tuple_slot_id) {
+        for (oid_t slot_itr = next_tuple_slot; slot_itr <= tuple_slot_id;
+             slot_itr++) {
+          InitTupleSlot(slot_itr);
+        }
         next_tuple_slot = tuple_slot_id + 1;
       }
       tile_header_lock.Unlock();
@@ -183,46 +207,59 @@ class TileGroupHeader : public Printable {
   inline void SetTransactionId(const oid_t &tuple_slot_id,
                                const txn_id_t &transaction_id) const {
     *((txn_id_t *)(TUPLE_HEADER_LOCATION)) = transaction_id;
+    MarkDirty(tuple_slot_id);
   }
 
   inline void SetBeginCommitId(const oid_t &tuple_slot_id,
                                const cid_t &begin_cid) {
     *((cid_t *)(TUPLE_HEADER_LOCATION + begin_cid_offset)) = begin_cid;
+    MarkDirty(tuple_slot_id);
   }
 
   inline void SetEndCommitId(const oid_t &tuple_slot_id,
                              const cid_t &end_cid) const {
     *((cid_t *)(TUPLE_HEADER_LOCATION + end_cid_offset)) = end_cid;
+    MarkDirty(tuple_slot_id);
   }
 
   inline void SetNextItemPointer(const oid_t &tuple_slot_id,
                                  const ItemPointer &item) const {
     *((ItemPointer *)(TUPLE_HEADER_LOCATION + next_pointer_offset)) = item;
+    MarkDirty(tuple_slot_id);
   }
 
   inline void SetPrevItemPointer(const oid_t &tuple_slot_id,
                                  const ItemPointer &item) const {
     *((ItemPointer *)(TUPLE_HEADER_LOCATION + prev_pointer_offset)) = item;
+    MarkDirty(tuple_slot_id);
   }
 
   inline void SetIndirection(const oid_t &tuple_slot_id,
                              const ItemPointer *indirection) const {
     *((const ItemPointer **)(TUPLE_HEADER_LOCATION + indirection_offset)) =
         indirection;
+    MarkDirty(tuple_slot_id);
   }
 
   inline txn_id_t SetAtomicTransactionId(const oid_t &tuple_slot_id,
                                          const txn_id_t &old_txn_id,
                                          const txn_id_t &new_txn_id) const {
     txn_id_t *txn_id_ptr = (txn_id_t *)(TUPLE_HEADER_LOCATION);
-    return __sync_val_compare_and_swap(txn_id_ptr, old_txn_id, new_txn_id);
+    txn_id_t txn_id =
+        __sync_val_compare_and_swap(txn_id_ptr, old_txn_id, new_txn_id);
+    MarkDirty(tuple_slot_id);
+    return txn_id;
   }
 
   inline bool SetAtomicTransactionId(const oid_t &tuple_slot_id,
                                      const txn_id_t &transaction_id) const {
     txn_id_t *txn_id_ptr = (txn_id_t *)(TUPLE_HEADER_LOCATION);
-    return __sync_bool_compare_and_swap(txn_id_ptr, INITIAL_TXN_ID,
-                                        transaction_id);
+    bool swapped = __sync_bool_compare_and_swap(txn_id_ptr, INITIAL_TXN_ID,
+                                                transaction_id);
+    if (swapped == true) {
+      MarkDirty(tuple_slot_id);
+    }
+    return swapped;
   }
 
   void PrintVisibility(txn_id_t txn_id, cid_t at_cid);
@@ -234,6 +271,35 @@ class TileGroupHeader : public Printable {
   // Sync the contents
   void Sync();
 
+  // Sync the entries of slots [begin_slot, end_slot)
+  void Sync(const oid_t &begin_slot, const oid_t &end_slot);
+
+  //===--------------------------------------------------------------------===//
+  // Dirty tracking
+  //===--------------------------------------------------------------------===//
+
+  // Slots a thread claims at once for inserts. Never covers the last slot,
+  // which goes to the inserter that fills the tile group on its own.
+  static const oid_t insert_chunk_slot_count = 8;
+
+  // Slots are tracked in chunks, a chunk of header entries fills a page
+  static const oid_t dirty_chunk_slot_count = 64;
+
+  // Record a modification of the slot's header entry or tuple data. Only
+  // backends that need to be synced track modifications.
+  inline void MarkDirty(const oid_t &tuple_slot_id) const {
+    if (dirty_chunks == nullptr) return;
+
+    oid_t chunk_id = tuple_slot_id / dirty_chunk_slot_count;
+    dirty_chunks[chunk_id / 64].fetch_or(UINT64_C(1) << (chunk_id % 64),
+                                         std::memory_order_release);
+  }
+
+  void MarkAllDirty();
+
+  // Clear the dirty set and return it as coalesced [begin, end) slot ranges
+  std::vector<std::pair<oid_t, oid_t>> TakeDirtyRanges();
+
   //===--------------------------------------------------------------------===//
   // Utilities
   //===--------------------------------------------------------------------===//
@@ -243,6 +309,10 @@ class TileGroupHeader : public Printable {
 
   static inline size_t GetReservedSize() { return reserved_size; }
 
+  char *GetData() const { return data; }
+
+  size_t GetHeaderSize() const { return header_size; }
+
   // header entry size is the size of the layout described above
   static const size_t reserved_size = 16;
   static const size_t header_entry_size = sizeof(txn_id_t) + 2 * sizeof(cid_t) +
@@ -260,6 +330,17 @@ class TileGroupHeader : public Printable {
       indirection_offset + sizeof(ItemPointer);
 
  private:
+  // Set the MVCC initial values of a slot that is handed out for the first
+  // time. Slots past the high-water mark are still zero, which reads as an
+  // invalid transaction and thus as an empty slot.
+  void InitTupleSlot(const oid_t &tuple_slot_id) {
+    SetTransactionId(tuple_slot_id, INVALID_TXN_ID);
+    SetBeginCommitId(tuple_slot_id, MAX_CID);
+    SetEndCommitId(tuple_slot_id, MAX_CID);
+    SetNextItemPointer(tuple_slot_id, INVALID_ITEMPOINTER);
+    SetPrevItemPointer(tuple_slot_id, INVALID_ITEMPOINTER);
+  }
+
   //===--------------------------------------------------------------------===//
   // Data members
   //===--------------------------------------------------------------------===//
@@ -267,6 +348,9 @@ class TileGroupHeader : public Printable {
   // Backend
   BackendType backend_type;
 
+  // node the header was allocated on
+  int numa_node;
+
   // Associated tile_group
   TileGroup *tile_group;
 
@@ -283,7 +367,22 @@ class TileGroupHeader : public Printable {
   // IT MAY OUT OF BOUNDARY! ALWAYS CHECK IF IT EXCEEDS num_tuple_slots
   std::atomic<oid_t> next_tuple_slot;
 
+  // identifies the header in the thread-local caches of claimed slots,
+  // unlike the address it is never reused
+  uint64_t insert_serial;
+
+  static std::atomic<uint64_t> next_insert_serial;
+
+  // no more slots are handed out
+  std::atomic<bool> sealed;
+
   Spinlock tile_header_lock;
+
+  // one bit per chunk of slots modified since the last sync,
+  // nullptr if the backend does not need syncing
+  std::unique_ptr<std::atomic<uint64_t>[]> dirty_chunks;
+
+  size_t dirty_word_count;
 };
 
 }  // End storage namespace
@@ -31,6 +31,7 @@ class TileGroup;
 /**
  * Iterator for table which goes over all active tiles.
  * FIXME: This is not thread-safe or transactional!
+ * Use ParallelTableScanner for snapshot scans across worker threads.
  **/
 class TileGroupIterator : public Iterator<std::shared_ptr<TileGroup>> {
   TileGroupIterator() = delete;
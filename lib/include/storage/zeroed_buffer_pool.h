@@ -0,0 +1,124 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// zeroed_buffer_pool.h
+//
+// Identification: src/include/storage/zeroed_buffer_pool.h
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include "type/types.h"
+
+namespace peloton {
+namespace storage {
+
+class StorageManager;
+
+//===--------------------------------------------------------------------===//
+// Zeroed Buffer Pool
+//===--------------------------------------------------------------------===//
+
+/**
+ * Recycles the zero-filled buffers backing tiles and tile group headers.
+ *
+ * Buffers are pooled by backend, size and NUMA node. A background thread
+ * zeroes released buffers and keeps a few zeroed, faulted-in buffers ready
+ * for every shape that was asked for, so that creating a tile group on the
+ * insert path neither allocates nor clears memory. The number kept ready for
+ * a shape grows each time it runs dry, up to max_ready_count_, and all pooled
+ * buffers together stay within max_cached_bytes.
+ */
+class ZeroedBufferPool {
+  ZeroedBufferPool(ZeroedBufferPool const &) = delete;
+
+ public:
+  ZeroedBufferPool(StorageManager &storage_manager,
+                   const size_t &max_cached_bytes = default_max_cached_bytes_);
+
+  ~ZeroedBufferPool();
+
+  // Zero-filled buffer of size bytes on the backend
+  void *Allocate(const BackendType &backend_type, const size_t &size,
+                 const int &numa_node);
+
+  // Return a buffer allocated from the backend with the same size and node
+  void Release(const BackendType &backend_type, void *address,
+               const size_t &size, const int &numa_node);
+
+  // Stop the refill thread and hand all pooled buffers back to the backends
+  void Shutdown();
+
+  //===--------------------------------------------------------------------===//
+  // Accounting
+  //===--------------------------------------------------------------------===//
+
+  // allocations served with a ready buffer
+  size_t GetHitCount() const { return hit_count_; }
+
+  // allocations that had to allocate and clear a buffer
+  size_t GetMissCount() const { return miss_count_; }
+
+  // bytes in pooled buffers, ready or waiting to be zeroed
+  size_t GetCachedBytes() const { return cached_bytes_; }
+
+  static const size_t default_max_cached_bytes_ = 256 * 1024 * 1024;
+
+  static const size_t max_ready_count_ = 8;
+
+ private:
+  // <backend, size, node>
+  typedef std::tuple<BackendType, size_t, int> Shape;
+
+  struct ShapeBuffers {
+    // zeroed and ready to hand out
+    std::vector<void *> ready;
+
+    // released, still to be zeroed
+    std::vector<void *> dirty;
+
+    // ready buffers to keep around
+    size_t ready_target = 1;
+  };
+
+  // Refill thread
+  void RefillBuffers();
+
+  void StartRefiller();
+
+  StorageManager &storage_manager_;
+
+  size_t max_cached_bytes_;
+
+  std::map<Shape, ShapeBuffers> shapes_;
+
+  std::mutex pool_mutex_;
+
+  // signals the refill thread that a shape needs work
+  std::condition_variable refill_cv_;
+
+  std::thread refiller_;
+
+  bool shutdown_;
+
+  std::atomic<size_t> hit_count_;
+
+  std::atomic<size_t> miss_count_;
+
+  std::atomic<size_t> cached_bytes_;
+};
+
+}  // End storage namespace
+}  // End peloton namespace
@@ -878,6 +878,8 @@ enum LogRecordType {
   LOGRECORD_TYPE_WAL_TUPLE_INSERT = 21,
   LOGRECORD_TYPE_WAL_TUPLE_DELETE = 22,
   LOGRECORD_TYPE_WAL_TUPLE_UPDATE = 23,
+  // Compressed log data of a log buffer
+  LOGRECORD_TYPE_WAL_COMPRESSED_BLOCK = 24,
 
   // DML records for Write behind logging
   LOGRECORD_TYPE_WBL_TUPLE_INSERT = 31,
@@ -942,6 +944,9 @@ enum MetricType {
 
 static const int INVALID_FILE_DESCRIPTOR = -1;
 
+// No NUMA node preference, memory is placed by the OS
+static const int INVALID_NUMA_NODE = -1;
+
 // ------------------------------------------------------------------
 // Tuple serialization formats
 // ------------------------------------------------------------------
@@ -997,7 +1002,13 @@ static const txn_id_t INITIAL_TXN_ID = 1;
 
 static const txn_id_t READONLY_TXN_ID = 2;
 
-static const txn_id_t START_TXN_ID = 3;
+// owns the versions compaction moves out of a tile group
+static const txn_id_t COMPACTION_TXN_ID = 3;
+
+// owns a slot handed out for a new version until its transaction takes over
+static const txn_id_t CLAIMED_TXN_ID = 4;
+
+static const txn_id_t START_TXN_ID = 5;
 
 static const txn_id_t MAX_TXN_ID = std::numeric_limits<txn_id_t>::max();
 
@@ -12,6 +12,7 @@
 
 #include "logging/backend_logger.h"
 #include "common/logger.h"
+#include "logging/frontend_logger.h"
 #include "logging/log_manager.h"
 #include "logging/log_record.h"
 #include "logging/loggers/wal_backend_logger.h"
@@ -25,9 +26,9 @@ namespace logging {
 BackendLogger::BackendLogger()
     : log_buffer_(std::unique_ptr<LogBuffer>(nullptr)),
       available_buffer_pool_(
-          std::unique_ptr<BufferPool>(new CircularBufferPool())),
+          std::unique_ptr<BufferPool>(new LockFreeBufferPool())),
       persist_buffer_pool_(
-          std::unique_ptr<BufferPool>(new CircularBufferPool())) {
+          std::unique_ptr<BufferPool>(new LockFreeBufferPool())) {
   logger_type = LoggerType::BACKEND;
   backend_pool.reset(new type::EphemeralPool());
   frontend_logger_id = -1;
@@ -69,21 +70,10 @@ void BackendLogger::Log(LogRecord *record) {
   // Enqueue the serialized log record into the queue
   record->Serialize(output_buffer);
 
-  this->log_buffer_lock.Lock();
+  // The current buffer belongs to this thread, appending takes no lock
   if (!log_buffer_) {
-    LOG_TRACE("Acquire the first log buffer in backend logger");
-    this->log_buffer_lock.Unlock();
-    std::unique_ptr<LogBuffer> new_buff =
-        std::move(available_buffer_pool_->Get());
-    this->log_buffer_lock.Lock();
-    log_buffer_ = std::move(new_buff);
-  }
-  // update max logged commit id
-  if (record->GetType() == LOGRECORD_TYPE_TRANSACTION_COMMIT) {
-    auto new_log_commit_id = record->GetTransactionId();
-    PL_ASSERT(new_log_commit_id > highest_logged_commit_message);
-    highest_logged_commit_message = new_log_commit_id;
-    logging_cid_lower_bound = INVALID_CID;
+    LOG_TRACE("Acquire a log buffer in backend logger");
+    log_buffer_ = available_buffer_pool_->Get();
   }
 
   // update the max logged id for the current buffer
@@ -97,27 +87,40 @@ void BackendLogger::Log(LogRecord *record) {
 
   if (!log_buffer_->WriteRecord(record)) {
     LOG_TRACE("Log buffer is full - Attempt to acquire a new one");
-    // put back a buffer
-    max_log_id_buffer = 0;  // reset
-    persist_buffer_pool_->Put(std::move(log_buffer_));
-    this->log_buffer_lock.Unlock();
+    PersistLogBuffer();
 
-    // get a new one
-    std::unique_ptr<LogBuffer> new_buff =
-        std::move(available_buffer_pool_->Get());
-    this->log_buffer_lock.Lock();
-    log_buffer_ = std::move(new_buff);
+    // get a new one, waits until the frontend logger grants a flushed buffer
+    log_buffer_ = available_buffer_pool_->Get();
+    log_buffer_->SetMaxLogId(cur_log_id);
+    max_log_id_buffer = cur_log_id;
 
     // write to the new log buffer
     auto success = log_buffer_->WriteRecord(record);
     if (!success) {
       LOG_ERROR("Write record to log buffer failed");
-      this->log_buffer_lock.Unlock();
       return;
     }
   }
 
-  this->log_buffer_lock.Unlock();
+  // update max logged commit id
+  if (record->GetType() == LOGRECORD_TYPE_TRANSACTION_COMMIT) {
+    auto new_log_commit_id = record->GetTransactionId();
+    PL_ASSERT(new_log_commit_id > highest_logged_commit_message);
+
+    // The commit waits for the flush, its records are handed over before the
+    // commit id is published
+    PersistLogBuffer();
+    highest_logged_commit_message = new_log_commit_id;
+    logging_cid_lower_bound = INVALID_CID;
+  }
+}
+
+void BackendLogger::PersistLogBuffer() {
+  max_log_id_buffer = 0;  // reset
+  persist_buffer_pool_->Put(std::move(log_buffer_));
+  if (frontend_logger != nullptr) {
+    frontend_logger->NotifyLogRecords();
+  }
 }
 
 // used by the frontend logger to collect data on the current state of the
@@ -126,30 +129,31 @@ void BackendLogger::Log(LogRecord *record) {
 // logger may
 // commit, The second is the maximum id this worker has committed
 std::pair<cid_t, cid_t> BackendLogger::PrepareLogBuffers() {
-  this->log_buffer_lock.Lock();
   std::pair<cid_t, cid_t> ret(INVALID_CID, INVALID_CID);
-  // prepare the cid's seen so far
-  if (logging_cid_lower_bound != INVALID_CID ||
-      (log_buffer_ && log_buffer_->GetSize() > 0)) {
-    ret.second = highest_logged_commit_message;
-    if (logging_cid_lower_bound > highest_logged_commit_message) {
-      ret.first = logging_cid_lower_bound;
-    }
-  }
-  if (log_buffer_ && log_buffer_->GetSize() > 0) {
-    // put back a buffer
-    LOG_TRACE(
-        "Move the current log buffer to buffer pool, "
-        "highest_logged_commit_message: %d, logging_cid_lower_bound: %d",
-        (int)highest_logged_commit_message, (int)logging_cid_lower_bound);
-    persist_buffer_pool_->Put(std::move(log_buffer_));
+
+  // Read the commit ids before collecting the buffers, a commit id is only
+  // published after the buffer holding the commit was handed over
+  cid_t lower_bound = logging_cid_lower_bound;
+  cid_t committed = highest_logged_commit_message;
+
+  std::unique_ptr<LogBuffer> log_buffer;
+  while (persist_buffer_pool_->TryGet(log_buffer) == true) {
+    local_queue.push_back(std::move(log_buffer));
   }
-  this->log_buffer_lock.Unlock();
 
-  auto num_log_buffer = persist_buffer_pool_->GetSize();
-  while (num_log_buffer > 0) {
-    local_queue.push_back(persist_buffer_pool_->Get());
-    num_log_buffer--;
+  // prepare the cid's seen so far, a commit is reported even if its buffer
+  // went out with an earlier collection
+  if (lower_bound != INVALID_CID || local_queue.empty() == false ||
+      committed != collected_commit_message) {
+    LOG_TRACE(
+        "Collect %lu log buffers, highest_logged_commit_message: %d, "
+        "logging_cid_lower_bound: %d",
+        local_queue.size(), (int)committed, (int)lower_bound);
+    ret.second = committed;
+    if (lower_bound > committed) {
+      ret.first = lower_bound;
+    }
+    collected_commit_message = committed;
   }
   return ret;
 }
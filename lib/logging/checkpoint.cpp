@@ -106,7 +106,8 @@ std::unique_ptr<Checkpoint> Checkpoint::GetCheckpoint(
   return std::move(std::unique_ptr<Checkpoint>(nullptr));
 }
 
-void Checkpoint::RecoverTuple(storage::Tuple *tuple, storage::DataTable *table,
+void Checkpoint::RecoverTuple(SerializeInput &tuple_body,
+                              storage::DataTable *table,
                               ItemPointer target_location, cid_t commit_id) {
   auto tile_group_id = target_location.block;
   auto tuple_slot = target_location.offset;
@@ -125,7 +126,7 @@ void Checkpoint::RecoverTuple(storage::Tuple *tuple, storage::DataTable *table,
 
   // Do the insert!
   auto inserted_tuple_slot =
-      tile_group->InsertTupleFromCheckpoint(tuple_slot, tuple, commit_id);
+      tile_group->InsertTupleFromCheckpoint(tuple_slot, tuple_body, commit_id);
 
   if (inserted_tuple_slot == INVALID_OID) {
     // TODO: We need to abort on failure!
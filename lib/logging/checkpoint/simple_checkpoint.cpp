@@ -65,30 +65,56 @@ cid_t SimpleCheckpoint::DoRecovery() {
 void SimpleCheckpoint::InsertTuple(cid_t commit_id) {
   TupleRecord tuple_record(LOGRECORD_TYPE_WAL_TUPLE_INSERT);
 
+  // Read off the header and the serialized tuple, the tuple is decoded
+  // straight into the tile group
+  size_t header_size = LoggingUtil::GetNextFrameSize(file_handle_);
   // Check for torn log write
-  if (LoggingUtil::ReadTupleRecordHeader(tuple_record, file_handle_) == false) {
+  if (header_size == 0) {
     LOG_ERROR("Could not read tuple record header.");
     return;
   }
-
-  auto table = LoggingUtil::GetTable(tuple_record);
-  if (!table) {
-    // the table was deleted
-    LoggingUtil::SkipTupleRecordBody(file_handle_);
+  record_buffer_.resize(header_size);
+  if (fread(record_buffer_.data(), 1, header_size, file_handle_.file) !=
+      header_size) {
+    LOG_ERROR("Error occured in fread ");
     return;
   }
 
-  // Read off the tuple record body from the log
-  std::unique_ptr<storage::Tuple> tuple(LoggingUtil::ReadTupleRecordBody(
-      table->GetSchema(), pool.get(), file_handle_));
+  size_t body_size = LoggingUtil::GetNextFrameSize(file_handle_);
   // Check for torn log write
-  if (tuple == nullptr) {
+  if (body_size == 0) {
     LOG_ERROR("Torn checkpoint write.");
     return;
   }
+  record_buffer_.resize(header_size + body_size);
+  if (fread(record_buffer_.data() + header_size, 1, body_size,
+            file_handle_.file) != body_size) {
+    LOG_ERROR("Error occured in fread ");
+    return;
+  }
+
+  if (LoggingUtil::ReadRecordChecksum(file_handle_, tuple_record.GetType(),
+                                      record_buffer_.data(),
+                                      record_buffer_.size()) == false) {
+    LOG_ERROR("Checksum mismatch in checkpoint tuple record.");
+    return;
+  }
+
+  ReferenceSerializeInput tuple_header(record_buffer_.data(), header_size);
+  tuple_record.DeserializeHeader(tuple_header);
+
+  auto table = LoggingUtil::GetTable(tuple_record);
+  if (!table) {
+    // the table was deleted
+    return;
+  }
+
+  ReferenceSerializeInput tuple_body(record_buffer_.data() + header_size,
+                                     body_size);
+
   auto target_location = tuple_record.GetInsertLocation();
   auto tile_group_id = target_location.block;
-  RecoverTuple(tuple.get(), table, target_location, commit_id);
+  RecoverTuple(tuple_body, table, target_location, commit_id);
   if (max_oid_ < target_location.block) {
     max_oid_ = tile_group_id;
   }
@@ -10,6 +10,8 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+#include <chrono>
 #include <thread>
 
 #include "common/logger.h"
@@ -25,10 +27,16 @@
 // configuration for testing
 int64_t peloton_wait_timeout = 0;
 
+// Default upper bound of the batching window (in us)
+#define LOG_COLLECTION_MAX_WINDOW 200
+
 namespace peloton {
 namespace logging {
 
-FrontendLogger::FrontendLogger() {
+FrontendLogger::FrontendLogger()
+    : log_records_pending(false),
+      log_records_waiting(false),
+      collection_timeout(LOG_COLLECTION_TIMEOUT) {
   logger_type = LoggerType::FRONTEND;
 
   // Set wait timeout
@@ -49,12 +57,13 @@ FrontendLogger::~FrontendLogger() {
  * @param logging type can be write ahead logging or write behind logging
  */
 FrontendLogger *FrontendLogger::GetFrontendLogger(LoggingType logging_type,
-                                                  bool test_mode) {
+                                                  bool test_mode,
+                                                  unsigned int logger_id) {
   FrontendLogger *frontend_logger = nullptr;
 
   LOG_TRACE("Logging_type is %d", (int)logging_type);
   if (LoggingUtil::IsBasedOnWriteAheadLogging(logging_type) == true) {
-    frontend_logger = new WriteAheadFrontendLogger(test_mode);
+    frontend_logger = new WriteAheadFrontendLogger(test_mode, logger_id);
   } else if (LoggingUtil::IsBasedOnWriteBehindLogging(logging_type) == true) {
     frontend_logger = new WriteBehindFrontendLogger();
   } else {
@@ -64,24 +73,23 @@ FrontendLogger *FrontendLogger::GetFrontendLogger(LoggingType logging_type,
   return frontend_logger;
 }
 
-// only the distinguished logger does this
 void FrontendLogger::UpdateGlobalMaxFlushId() {
-  if (is_distinguished_logger) {
-    cid_t global_max_flushed_commit_id = INVALID_CID;
-
-    auto &log_manager = LogManager::GetInstance();
-    std::vector<std::unique_ptr<FrontendLogger>> &frontend_loggers =
-        log_manager.GetFrontendLoggersList();
-    int num_loggers = frontend_loggers.size();
-
-    for (int i = 0; i < num_loggers; i++) {
-      cid_t logger_max_commit_id;
-      logger_max_commit_id = frontend_loggers[i].get()->GetMaxFlushedCommitId();
-      global_max_flushed_commit_id =
-          std::max(global_max_flushed_commit_id, logger_max_commit_id);
-    }
+  auto &log_manager = LogManager::GetInstance();
 
-    log_manager.SetGlobalMaxFlushedCommitId(global_max_flushed_commit_id);
+  if (log_manager.RaiseGlobalMaxFlushedCommitId(max_flushed_commit_id) ==
+      false) {
+    return;
+  }
+
+  // A commit is durable once every stream has flushed past it. Idle streams
+  // catch up by flushing a delimiter with the global max, wake them up
+  // instead of letting the commits wait for their collection timeout.
+  std::vector<std::unique_ptr<FrontendLogger>> &frontend_loggers =
+      log_manager.GetFrontendLoggersList();
+  for (auto &frontend_logger : frontend_loggers) {
+    if (frontend_logger.get() != this) {
+      frontend_logger->NotifyLogRecords();
+    }
   }
 }
 
@@ -147,7 +155,7 @@ void FrontendLogger::MainLoop(void) {
     // LOG_TRACE("Log manager: Invoking FlushLogRecords");
     FlushLogRecords();
 
-    // update the global max flushed ID (only distinguished logger does this)
+    // update the global max flushed ID
     UpdateGlobalMaxFlushId();
   }
 
@@ -169,12 +177,47 @@ void FrontendLogger::MainLoop(void) {
   log_manager.SetLoggingStatus(LoggingStatusType::SLEEP);
 }
 
+/**
+ * @brief Wake up the frontend logger, a backend logger has records to collect
+ */
+void FrontendLogger::NotifyLogRecords() {
+  // Only the first notification after a collection has to wake anybody up
+  if (log_records_pending.exchange(true) == true) {
+    return;
+  }
+
+  if (log_records_waiting.load() == true) {
+    std::lock_guard<std::mutex> wait_lock(log_event_mutex);
+    log_event_cv.notify_one();
+  }
+}
+
+/**
+ * @brief Wait until a backend logger has records or the collection timeout
+ * expires
+ */
+void FrontendLogger::WaitForLogRecords() {
+  if (log_records_pending.exchange(false) == false) {
+    std::unique_lock<std::mutex> wait_lock(log_event_mutex);
+    log_records_waiting = true;
+    log_event_cv.wait_for(wait_lock,
+                          std::chrono::microseconds(collection_timeout),
+                          [this] { return log_records_pending.load(); });
+    log_records_waiting = false;
+    log_records_pending = false;
+  }
+
+  // Under load, linger to collect the records of concurrent commits together
+  if (collection_window > 0) {
+    std::this_thread::sleep_for(std::chrono::microseconds(collection_window));
+  }
+}
+
 /**
  * @brief Collect the log records from BackendLoggers
  */
 void FrontendLogger::CollectLogRecordsFromBackendLoggers() {
-  auto sleep_period = std::chrono::microseconds(wait_timeout);
-  std::this_thread::sleep_for(sleep_period);
+  WaitForLogRecords();
   int debug_flag = 0;
 
   auto &log_manager = LogManager::GetInstance();
@@ -188,6 +231,7 @@ void FrontendLogger::CollectLogRecordsFromBackendLoggers() {
     // LOG_TRACE("Collect log buffers from %lu backend loggers",
     //           backend_loggers.size());
     int i = 0;
+    size_t active_backend_logger_count = 0;
     for (auto backend_logger : backend_loggers) {
       auto cid_pair = backend_logger->PrepareLogBuffers();
       auto &log_buffers = backend_logger->GetLogBuffers();
@@ -208,6 +252,7 @@ void FrontendLogger::CollectLogRecordsFromBackendLoggers() {
         i++;
         continue;
       }
+      active_backend_logger_count++;
 
       // Move the log record from backend_logger to here
       for (oid_t log_record_itr = 0; log_record_itr < log_buffer_size;
@@ -258,6 +303,17 @@ void FrontendLogger::CollectLogRecordsFromBackendLoggers() {
     // LOG_TRACE("max_collected_commit_id: %d, max_possible_commit_id: %d",
     // (int)max_collected_commit_id, (int)max_possible_commit_id);
     backend_loggers_lock.Unlock();
+
+    // Batch for longer while several backends log at once, a lone commit
+    // is flushed right away
+    int max_collection_window =
+        (wait_timeout > 0) ? wait_timeout : LOG_COLLECTION_MAX_WINDOW;
+    if (active_backend_logger_count > 1) {
+      collection_window =
+          std::min(std::max(collection_window * 2, 1), max_collection_window);
+    } else {
+      collection_window /= 2;
+    }
   }
 }
 
@@ -286,6 +342,7 @@ void FrontendLogger::AddBackendLogger(BackendLogger *backend_logger) {
   // Add backend logger to the list of backend loggers
   backend_loggers_lock.Lock();
   backend_logger->SetLoggingCidLowerBound(max_collected_commit_id);
+  backend_logger->frontend_logger = this;
   backend_loggers.push_back(backend_logger);
   backend_loggers_lock.Unlock();
 }
@@ -0,0 +1,46 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// lock_free_buffer_pool.cpp
+//
+// Identification: src/logging/lock_free_buffer_pool.cpp
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "logging/lock_free_buffer_pool.h"
+#include "common/logger.h"
+
+namespace peloton {
+namespace logging {
+
+//===--------------------------------------------------------------------===//
+// Lock-free Buffer Pool
+//===--------------------------------------------------------------------===//
+
+bool LockFreeBufferPool::Put(std::unique_ptr<LogBuffer> buffer) {
+  if (buffers_.enqueue(std::move(buffer)) == false) {
+    LOG_ERROR("Failed to put a log buffer into the buffer pool");
+    return false;
+  }
+  return true;
+}
+
+std::unique_ptr<LogBuffer> LockFreeBufferPool::Get() {
+  std::unique_ptr<LogBuffer> buffer;
+  buffers_.wait_dequeue(buffer);
+  return buffer;
+}
+
+bool LockFreeBufferPool::TryGet(std::unique_ptr<LogBuffer> &buffer) {
+  return buffers_.try_dequeue(buffer);
+}
+
+unsigned int LockFreeBufferPool::GetSize() {
+  return static_cast<unsigned int>(buffers_.size_approx());
+}
+
+}  // namespace logging
+}  // namespace peloton
@@ -0,0 +1,295 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// log_compressor.cpp
+//
+// Identification: src/logging/log_compressor.cpp
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "logging/log_compressor.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#include "common/crc32c.h"
+#include "common/macros.h"
+#include "type/types.h"
+
+namespace peloton {
+namespace logging {
+
+const int LogCompressor::min_level_;
+const int LogCompressor::max_level_;
+const size_t LogCompressor::min_block_data_size_;
+
+namespace {
+
+// Shortest match worth a sequence
+#define LZ_MIN_MATCH 4
+
+// Longest distance a two-byte offset can reach
+#define LZ_MAX_OFFSET 65535
+
+// Lengths of 15 and more continue in extra bytes
+#define LZ_LENGTH_MASK 15
+
+inline uint32_t Load32(const uint8_t *location) {
+  uint32_t value;
+  PL_MEMCPY(&value, location, sizeof(value));
+  return value;
+}
+
+inline uint32_t HashPrefix(uint32_t prefix, int hash_bits) {
+  return (prefix * 2654435761u) >> (32 - hash_bits);
+}
+
+inline size_t GetLengthBytes(size_t length) {
+  return (length < LZ_LENGTH_MASK) ? 0 : (length - LZ_LENGTH_MASK) / 255 + 1;
+}
+
+uint8_t *WriteLength(uint8_t *output, size_t length) {
+  length -= LZ_LENGTH_MASK;
+  while (length >= 255) {
+    *output++ = 255;
+    length -= 255;
+  }
+  *output++ = static_cast<uint8_t>(length);
+  return output;
+}
+
+bool ReadLength(const uint8_t *&input, const uint8_t *input_end,
+                size_t &length) {
+  uint8_t byte;
+  do {
+    if (input == input_end) {
+      return false;
+    }
+    byte = *input++;
+    length += byte;
+  } while (byte == 255);
+  return true;
+}
+
+// Emit a sequence, false if it does not fit into the output
+bool WriteSequence(uint8_t *&output, const uint8_t *output_end,
+                   const uint8_t *literals, size_t literal_length,
+                   size_t offset, size_t match_length) {
+  size_t sequence_size = 1 + GetLengthBytes(literal_length) + literal_length;
+  if (match_length > 0) {
+    sequence_size += 2 + GetLengthBytes(match_length - LZ_MIN_MATCH);
+  }
+  if ((size_t)(output_end - output) < sequence_size) {
+    return false;
+  }
+
+  uint8_t *token = output++;
+  *token = static_cast<uint8_t>(
+      std::min<size_t>(literal_length, LZ_LENGTH_MASK) << 4);
+  if (literal_length >= LZ_LENGTH_MASK) {
+    output = WriteLength(output, literal_length);
+  }
+  PL_MEMCPY(output, literals, literal_length);
+  output += literal_length;
+
+  // The last sequence has no match
+  if (match_length > 0) {
+    *token |= static_cast<uint8_t>(
+        std::min<size_t>(match_length - LZ_MIN_MATCH, LZ_LENGTH_MASK));
+    *output++ = static_cast<uint8_t>(offset & 0xff);
+    *output++ = static_cast<uint8_t>(offset >> 8);
+    if (match_length - LZ_MIN_MATCH >= LZ_LENGTH_MASK) {
+      output = WriteLength(output, match_length - LZ_MIN_MATCH);
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+bool LogCompressor::CompressBlock(const char *data, size_t size, int level) {
+  block_size_ = 0;
+  if (level <= min_level_ || size < min_block_data_size_ ||
+      size > (size_t)std::numeric_limits<int32_t>::max()) {
+    return false;
+  }
+  level = std::min(level, max_level_);
+
+  const size_t header_size =
+      sizeof(char) + sizeof(int32_t) + sizeof(uint32_t);
+  const size_t checksum_size = sizeof(uint32_t);
+
+  // The block has to be smaller than the log data it replaces
+  if (size <= header_size + checksum_size + 1) {
+    return false;
+  }
+  if (block_.size() < size) {
+    block_.resize(size);
+  }
+
+  size_t compressed_size =
+      Compress(reinterpret_cast<const uint8_t *>(data), size,
+               reinterpret_cast<uint8_t *>(block_.data() + header_size),
+               size - header_size - checksum_size - 1, level);
+  if (compressed_size == 0) {
+    return false;
+  }
+
+  block_[0] = static_cast<char>(LOGRECORD_TYPE_WAL_COMPRESSED_BLOCK);
+  int32_t frame_length =
+      static_cast<int32_t>(sizeof(uint32_t) + compressed_size);
+  PL_MEMCPY(block_.data() + sizeof(char), &frame_length, sizeof(frame_length));
+  uint32_t data_size = static_cast<uint32_t>(size);
+  PL_MEMCPY(block_.data() + sizeof(char) + sizeof(int32_t), &data_size,
+            sizeof(data_size));
+
+  uint32_t checksum = Crc32c::Value(block_.data(), header_size + compressed_size);
+  PL_MEMCPY(block_.data() + header_size + compressed_size, &checksum,
+            sizeof(checksum));
+
+  block_size_ = header_size + compressed_size + checksum_size;
+  return true;
+}
+
+bool LogCompressor::DecompressFrame(const char *frame, size_t frame_size,
+                                    std::vector<char> &data) {
+  uint32_t data_size;
+  if (frame_size < sizeof(int32_t) + sizeof(data_size)) {
+    return false;
+  }
+  PL_MEMCPY(&data_size, frame + sizeof(int32_t), sizeof(data_size));
+
+  const size_t prefix_size = sizeof(int32_t) + sizeof(data_size);
+  data.resize(data_size);
+  return Decompress(reinterpret_cast<const uint8_t *>(frame + prefix_size),
+                    frame_size - prefix_size,
+                    reinterpret_cast<uint8_t *>(data.data()), data_size);
+}
+
+size_t LogCompressor::Compress(const uint8_t *data, size_t size,
+                               uint8_t *output, size_t capacity, int level) {
+  // Higher levels use a larger window of prefixes and speed up slower over
+  // data without matches
+  const int hash_bits = 11 + level;
+  const int skip_shift = 2 + level;
+  hash_table_.assign(size_t(1) << hash_bits, 0);
+
+  const uint8_t *input = data;
+  const uint8_t *input_end = data + size;
+  const uint8_t *anchor = data;
+  uint8_t *output_itr = output;
+  const uint8_t *output_end = output + capacity;
+  size_t misses = 0;
+
+  while (input_end - input >= LZ_MIN_MATCH) {
+    uint32_t prefix = Load32(input);
+    uint32_t &entry = hash_table_[HashPrefix(prefix, hash_bits)];
+    size_t position = input - data;
+    size_t candidate = entry;
+    entry = static_cast<uint32_t>(position + 1);
+
+    if (candidate == 0 || position + 1 - candidate > LZ_MAX_OFFSET ||
+        Load32(data + candidate - 1) != prefix) {
+      input += 1 + (misses++ >> skip_shift);
+      continue;
+    }
+
+    const uint8_t *match = data + candidate - 1;
+    size_t match_length = LZ_MIN_MATCH;
+    while (input + match_length < input_end &&
+           match[match_length] == input[match_length]) {
+      match_length++;
+    }
+
+    // Take the literals in front of the match into it as well
+    while (input > anchor && match > data && input[-1] == match[-1]) {
+      input--;
+      match--;
+      match_length++;
+    }
+
+    if (WriteSequence(output_itr, output_end, anchor, input - anchor,
+                      input - match, match_length) == false) {
+      return 0;
+    }
+
+    input += match_length;
+    anchor = input;
+    misses = 0;
+  }
+
+  if (anchor < input_end &&
+      WriteSequence(output_itr, output_end, anchor, input_end - anchor, 0,
+                    0) == false) {
+    return 0;
+  }
+
+  return output_itr - output;
+}
+
+bool LogCompressor::Decompress(const uint8_t *input, size_t input_size,
+                               uint8_t *output, size_t output_size) {
+  const uint8_t *input_end = input + input_size;
+  uint8_t *output_itr = output;
+  uint8_t *output_end = output + output_size;
+
+  while (input < input_end) {
+    uint8_t token = *input++;
+
+    size_t literal_length = token >> 4;
+    if (literal_length == LZ_LENGTH_MASK &&
+        ReadLength(input, input_end, literal_length) == false) {
+      return false;
+    }
+    if ((size_t)(input_end - input) < literal_length ||
+        (size_t)(output_end - output_itr) < literal_length) {
+      return false;
+    }
+    PL_MEMCPY(output_itr, input, literal_length);
+    input += literal_length;
+    output_itr += literal_length;
+
+    // The last sequence has no match
+    if (input == input_end) {
+      break;
+    }
+
+    if (input_end - input < 2) {
+      return false;
+    }
+    size_t offset = input[0] | (input[1] << 8);
+    input += 2;
+
+    size_t match_length = token & LZ_LENGTH_MASK;
+    if (match_length == LZ_LENGTH_MASK &&
+        ReadLength(input, input_end, match_length) == false) {
+      return false;
+    }
+    match_length += LZ_MIN_MATCH;
+
+    if (offset == 0 || offset > (size_t)(output_itr - output) ||
+        (size_t)(output_end - output_itr) < match_length) {
+      return false;
+    }
+
+    // Matches may overlap the bytes they produce
+    const uint8_t *match = output_itr - offset;
+    if (offset >= match_length) {
+      PL_MEMCPY(output_itr, match, match_length);
+      output_itr += match_length;
+    } else {
+      for (size_t byte_itr = 0; byte_itr < match_length; byte_itr++) {
+        *output_itr++ = *match++;
+      }
+    }
+  }
+
+  return output_itr == output_end;
+}
+
+}  // namespace logging
+}  // namespace peloton
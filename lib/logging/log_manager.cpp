@@ -10,14 +10,18 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <sched.h>
+#include <algorithm>
 #include <condition_variable>
 #include <memory>
+#include <thread>
 
 #include "catalog/catalog.h"
 #include "catalog/manager.h"
 #include "common/logger.h"
 #include "common/macros.h"
 #include "logging/log_manager.h"
+#include "logging/log_replayer.h"
 #include "logging/logging_util.h"
 #include "logging/records/transaction_record.h"
 #include "storage/data_table.h"
@@ -31,9 +35,7 @@ namespace logging {
 // Each thread gets a backend logger
 thread_local static BackendLogger *backend_logger = nullptr;
 
-LogManager::LogManager() {
-
-}
+LogManager::LogManager() : global_max_flushed_commit_id(0) {}
 
 LogManager::~LogManager() {}
 
@@ -61,10 +63,6 @@ void LogManager::StartStandbyMode() {
     return;
   }
 
-  // assign a distinguished logger thread only if we have more than 1 loggers
-  if (num_frontend_loggers_ > 1)
-    frontend_loggers[0].get()->SetIsDistinguishedLogger(true);
-
   // Toggle status in log manager map
   SetLoggingStatus(LoggingStatusType::STANDBY);
 
@@ -301,6 +299,21 @@ BackendLogger *LogManager::GetBackendLogger(unsigned int hint_idx) {
           backend_logger);
       backend_logger->SetFrontendLoggerID(i % num_frontend_loggers_);
 
+    } else if (logger_mapping_strategy_ ==
+               LoggerMappingStrategyType::AFFINITY) {
+      // neighbouring cores share a log stream
+      unsigned int logger_idx = i % num_frontend_loggers_;
+      int cpu = sched_getcpu();
+      unsigned int core_count =
+          std::max(std::thread::hardware_concurrency(), 1u);
+      if (cpu >= 0) {
+        logger_idx =
+            ((unsigned int)cpu % core_count) * num_frontend_loggers_ /
+            core_count;
+      }
+      frontend_loggers[logger_idx].get()->AddBackendLogger(backend_logger);
+      backend_logger->SetFrontendLoggerID(logger_idx);
+
     } else if (logger_mapping_strategy_ == LoggerMappingStrategyType::MANUAL) {
       // manual mapping with hint
       PL_ASSERT(hint_idx < frontend_loggers.size());
@@ -320,7 +333,7 @@ void LogManager::InitFrontendLoggers() {
   if (frontend_loggers.size() == 0) {
     for (unsigned int i = 0; i < num_frontend_loggers_; i++) {
       std::unique_ptr<FrontendLogger> frontend_logger(
-          FrontendLogger::GetFrontendLogger(logging_type_, test_mode_));
+          FrontendLogger::GetFrontendLogger(logging_type_, test_mode_, i));
       frontend_logger->SetNoWrite(no_write_);
 
       if (frontend_logger.get() != nullptr) {
@@ -381,6 +394,19 @@ void LogManager::SetLogDirectoryName(std::string log_directory) {
 // XXX change to read configuration file
 std::string LogManager::GetLogDirectoryName(void) { return log_directory_name; }
 
+void LogManager::SetLogStreamDirectoryName(unsigned int logger_id,
+                                           std::string log_directory) {
+  log_stream_directory_names[logger_id] = log_directory;
+}
+
+std::string LogManager::GetLogStreamDirectoryName(unsigned int logger_id) {
+  auto log_stream_directory = log_stream_directory_names.find(logger_id);
+  if (log_stream_directory == log_stream_directory_names.end()) {
+    return log_directory_name;
+  }
+  return log_stream_directory->second;
+}
+
 void LogManager::PrepareRecovery() {
   if (prepared_recovery_) {
     return;
@@ -440,11 +466,16 @@ cid_t LogManager::GetGlobalMaxFlushedCommitId() {
   return global_max_flushed_commit_id;
 }
 
-void LogManager::SetGlobalMaxFlushedCommitId(cid_t new_max) {
-  if (new_max != global_max_flushed_commit_id) {
-    LOG_TRACE("Setting global_max_flushed_commit_id to %d", (int)new_max);
+bool LogManager::RaiseGlobalMaxFlushedCommitId(cid_t new_max) {
+  cid_t current_max = global_max_flushed_commit_id.load();
+  while (current_max < new_max) {
+    if (global_max_flushed_commit_id.compare_exchange_weak(current_max,
+                                                           new_max)) {
+      LOG_TRACE("Setting global_max_flushed_commit_id to %d", (int)new_max);
+      return true;
+    }
   }
-  global_max_flushed_commit_id = new_max;
+  return false;
 }
 
 cid_t LogManager::GetPersistentFlushedCommitId() {
@@ -473,7 +504,16 @@ cid_t LogManager::GetPersistentFlushedCommitId() {
 void LogManager::FrontendLoggerFlushed() {
   {
     std::unique_lock<std::mutex> wait_lock(flush_notify_mutex);
-    flush_notify_cv.notify_all();
+    cid_t persistent_flushed_commit_id = this->GetPersistentFlushedCommitId();
+
+    // Only wake up the workers whose commits are persistent now
+    auto waiter_itr = flush_waiters.begin();
+    while (waiter_itr != flush_waiters.end() &&
+           waiter_itr->first <= persistent_flushed_commit_id) {
+      waiter_itr->second->flushed = true;
+      waiter_itr->second->flush_cv.notify_one();
+      waiter_itr = flush_waiters.erase(waiter_itr);
+    }
   }
 }
 
@@ -482,11 +522,16 @@ void LogManager::WaitForFlush(cid_t cid) {
   {
     std::unique_lock<std::mutex> wait_lock(flush_notify_mutex);
 
-    while (this->GetPersistentFlushedCommitId() < cid) {
+    if (this->GetPersistentFlushedCommitId() < cid) {
       LOG_TRACE(
           "Logs up to %lu cid is flushed. %lu cid is not flushed yet. Wait...",
           this->GetPersistentFlushedCommitId(), cid);
-      flush_notify_cv.wait(wait_lock);
+
+      FlushWaiter flush_waiter;
+      flush_waiters.emplace(cid, &flush_waiter);
+      while (flush_waiter.flushed == false) {
+        flush_waiter.flush_cv.wait(wait_lock);
+      }
     }
     LOG_TRACE(
         "Flushes done! Can return! Got persistent flushed commit id as %d",
@@ -503,11 +548,80 @@ void LogManager::NotifyRecoveryDone() {
   if (i == num_frontend_loggers_) {
     LOG_TRACE(
         "This was the last one! Recover Index and change to LOGGING mode.");
+    if (LoggingUtil::IsBasedOnWriteAheadLogging(logging_type_) == true) {
+      ReplayRecoveredTransactions();
+    }
     frontend_loggers[0].get()->RecoverIndex();
     SetLoggingStatus(LoggingStatusType::LOGGING);
   }
 }
 
+/**
+ * @brief Replay the committed transactions of all log streams in commit id
+ * order. A transaction may change tuples written by a transaction of another
+ * stream. The streams are read one iteration delimiter at a time, so only
+ * the transactions between two delimiters are held in memory.
+ */
+void LogManager::ReplayRecoveredTransactions() {
+  std::vector<WriteAheadFrontendLogger *> log_streams;
+  for (auto &frontend_logger : frontend_loggers) {
+    auto log_stream =
+        dynamic_cast<WriteAheadFrontendLogger *>(frontend_logger.get());
+    if (log_stream == nullptr) {
+      LOG_ERROR("Frontend logger is not a write ahead logger, not replaying");
+      continue;
+    }
+    log_streams.push_back(log_stream);
+  }
+
+  // Tuple versions are applied in parallel, partitioned by tile group
+  LogReplayer log_replayer(std::thread::hardware_concurrency());
+
+  size_t replayed_count = 0;
+  cid_t replayed_commit_id = INVALID_CID;
+  while (replayed_commit_id != MAX_CID) {
+    // Every stream is read past the commits replayed so far. Up to the
+    // lowest delimiter, no stream holds back a committed transaction.
+    cid_t complete_commit_id = MAX_CID;
+    for (auto log_stream : log_streams) {
+      while (log_stream->GetRecoveredDelimiter() <= replayed_commit_id &&
+             log_stream->ReadRecoveredTransactions() == true) {
+      }
+      complete_commit_id =
+          std::min(complete_commit_id, log_stream->GetRecoveredDelimiter());
+    }
+
+    while (true) {
+      // Few streams, a linear scan picks the next transaction
+      WriteAheadFrontendLogger *next_log_stream = nullptr;
+      cid_t next_commit_id = MAX_CID;
+      for (auto log_stream : log_streams) {
+        cid_t commit_id = log_stream->GetNextRecoveredCommitId();
+        if (commit_id < next_commit_id) {
+          next_commit_id = commit_id;
+          next_log_stream = log_stream;
+        }
+      }
+
+      if (next_log_stream == nullptr || next_commit_id > complete_commit_id) {
+        break;
+      }
+      next_log_stream->ReplayNextRecoveredTransaction(log_replayer);
+      replayed_count++;
+    }
+
+    replayed_commit_id = complete_commit_id;
+  }
+
+  oid_t max_tile_group_id = log_replayer.Finish();
+  for (auto log_stream : log_streams) {
+    log_stream->DoneReplay(max_tile_group_id);
+  }
+
+  LOG_TRACE("Replayed %lu transactions from %lu log streams with %lu workers",
+            replayed_count, log_streams.size(), log_replayer.GetWorkerCount());
+}
+
 void LogManager::UpdateCatalogAndTxnManagers(oid_t new_oid, cid_t new_cid) {
   {
     std::unique_lock<std::mutex> wait_lock(update_managers_mutex);
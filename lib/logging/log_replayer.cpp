@@ -0,0 +1,251 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// log_replayer.cpp
+//
+// Identification: src/logging/log_replayer.cpp
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "logging/log_replayer.h"
+
+#include <algorithm>
+
+#include "catalog/catalog.h"
+#include "catalog/manager.h"
+#include "common/logger.h"
+#include "common/macros.h"
+#include "logging/records/tuple_record.h"
+#include "storage/data_table.h"
+#include "storage/database.h"
+#include "storage/tile_group.h"
+#include "type/serializeio.h"
+
+namespace peloton {
+namespace logging {
+
+const size_t LogReplayer::batch_size_;
+
+LogReplayer::LogReplayer(size_t worker_count) {
+  worker_count = std::max(worker_count, (size_t)1);
+  for (size_t worker_itr = 0; worker_itr < worker_count; worker_itr++) {
+    workers_.emplace_back(new ReplayWorker());
+    workers_.back()->pending_batch.reserve(batch_size_);
+  }
+  for (auto &worker : workers_) {
+    worker->worker_thread =
+        std::thread(&LogReplayer::RunWorker, this, worker.get());
+  }
+}
+
+LogReplayer::~LogReplayer() {
+  if (finished_ == false) {
+    Finish();
+  }
+}
+
+void LogReplayer::ReplayTransaction(cid_t commit_id,
+                                    std::vector<TupleRecord *> &tuple_records) {
+  PL_ASSERT(finished_ == false);
+
+  for (auto tuple_record : tuple_records) {
+    ReplayOperation operation;
+    operation.commit_id = commit_id;
+    operation.database_oid = tuple_record->GetDatabaseOid();
+    operation.table_oid = tuple_record->GetTableId();
+    operation.tuple_body = nullptr;
+    operation.tuple_body_size = 0;
+
+    switch (tuple_record->GetType()) {
+      case LOGRECORD_TYPE_WAL_TUPLE_INSERT:
+        operation.type = REPLAY_OPERATION_TYPE_INSERT;
+        operation.location = tuple_record->GetInsertLocation();
+        operation.tuple_body = tuple_record->GetTupleBody();
+        operation.tuple_body_size = tuple_record->GetTupleBodySize();
+        Dispatch(operation);
+        break;
+
+      case LOGRECORD_TYPE_WAL_TUPLE_UPDATE:
+        // The two versions may live in tile groups of different workers
+        operation.type = REPLAY_OPERATION_TYPE_INSERT_NEW_VERSION;
+        operation.location = tuple_record->GetInsertLocation();
+        operation.tuple_body = tuple_record->GetTupleBody();
+        operation.tuple_body_size = tuple_record->GetTupleBodySize();
+        Dispatch(operation);
+
+        operation.type = REPLAY_OPERATION_TYPE_UPDATE_OLD_VERSION;
+        operation.location = tuple_record->GetDeleteLocation();
+        operation.new_location = tuple_record->GetInsertLocation();
+        operation.tuple_body = nullptr;
+        operation.tuple_body_size = 0;
+        Dispatch(operation);
+        break;
+
+      case LOGRECORD_TYPE_WAL_TUPLE_DELETE:
+        operation.type = REPLAY_OPERATION_TYPE_DELETE;
+        operation.location = tuple_record->GetDeleteLocation();
+        Dispatch(operation);
+        break;
+
+      default:
+        LOG_ERROR("Unexpected record type %d in recovered transaction %lu",
+                  (int)tuple_record->GetType(), (unsigned long)commit_id);
+        break;
+    }
+
+    // The tuple body stays in the mapped log
+    delete tuple_record;
+  }
+  tuple_records.clear();
+}
+
+oid_t LogReplayer::Finish() {
+  for (auto &worker : workers_) {
+    SubmitBatch(*worker);
+    {
+      std::lock_guard<std::mutex> worker_lock(worker->worker_mutex);
+      worker->done = true;
+    }
+    worker->worker_cv.notify_one();
+  }
+
+  oid_t max_tile_group_id = 0;
+  for (auto &worker : workers_) {
+    if (worker->worker_thread.joinable() == true) {
+      worker->worker_thread.join();
+    }
+    max_tile_group_id = std::max(max_tile_group_id, worker->max_tile_group_id);
+  }
+
+  finished_ = true;
+  return max_tile_group_id;
+}
+
+void LogReplayer::Dispatch(const ReplayOperation &operation) {
+  auto &worker = *workers_[operation.location.block % workers_.size()];
+  worker.pending_batch.push_back(operation);
+  if (worker.pending_batch.size() >= batch_size_) {
+    SubmitBatch(worker);
+  }
+}
+
+void LogReplayer::SubmitBatch(ReplayWorker &worker) {
+  if (worker.pending_batch.empty() == true) {
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> worker_lock(worker.worker_mutex);
+    worker.batches.push_back(std::move(worker.pending_batch));
+  }
+  worker.worker_cv.notify_one();
+
+  worker.pending_batch = std::vector<ReplayOperation>();
+  worker.pending_batch.reserve(batch_size_);
+}
+
+void LogReplayer::RunWorker(ReplayWorker *worker) {
+  oid_t max_tile_group_id = 0;
+  ReplayTarget target;
+
+  while (true) {
+    std::vector<ReplayOperation> batch;
+    {
+      std::unique_lock<std::mutex> worker_lock(worker->worker_mutex);
+      worker->worker_cv.wait(worker_lock, [worker] {
+        return worker->done || worker->batches.empty() == false;
+      });
+      if (worker->batches.empty() == true) {
+        break;
+      }
+      batch = std::move(worker->batches.front());
+      worker->batches.pop_front();
+    }
+
+    for (auto &operation : batch) {
+      ApplyOperation(operation, target, max_tile_group_id);
+    }
+  }
+
+  worker->max_tile_group_id = max_tile_group_id;
+}
+
+void LogReplayer::ApplyOperation(ReplayOperation &operation,
+                                 ReplayTarget &target,
+                                 oid_t &max_tile_group_id) {
+  // Runs of versions go to the same table and tile group, they are looked up
+  // once per run
+  if (operation.database_oid != target.database_oid ||
+      operation.table_oid != target.table_oid) {
+    auto catalog = catalog::Catalog::GetInstance();
+    storage::Database *db =
+        catalog->GetDatabaseWithOid(operation.database_oid);
+    PL_ASSERT(db);
+
+    target.database_oid = operation.database_oid;
+    target.table_oid = operation.table_oid;
+    target.table = db->GetTableWithOid(operation.table_oid);
+    target.tile_group_id = INVALID_OID;
+    target.tile_group.reset();
+  }
+
+  auto table = target.table;
+  if (table == nullptr) {
+    return;
+  }
+
+  if (operation.location.block != target.tile_group_id) {
+    target.tile_group =
+        GetTileGroup(table, operation.location.block, max_tile_group_id);
+    target.tile_group_id = operation.location.block;
+  }
+
+  auto &tile_group = target.tile_group;
+  cid_t commit_id = operation.commit_id;
+  oid_t tuple_slot_id = operation.location.offset;
+
+  switch (operation.type) {
+    case REPLAY_OPERATION_TYPE_INSERT:
+    case REPLAY_OPERATION_TYPE_INSERT_NEW_VERSION: {
+      ReferenceSerializeInput tuple_body(operation.tuple_body,
+                                         operation.tuple_body_size);
+      tile_group->InsertTupleFromRecovery(commit_id, tuple_slot_id,
+                                          tuple_body);
+      if (operation.type == REPLAY_OPERATION_TYPE_INSERT) {
+        table->IncreaseTupleCount(1);
+      }
+    } break;
+
+    case REPLAY_OPERATION_TYPE_DELETE:
+      // FIXME we always decrease the number of tuples by one
+      table->DecreaseTupleCount(1);
+      tile_group->DeleteTupleFromRecovery(commit_id, tuple_slot_id);
+      break;
+
+    case REPLAY_OPERATION_TYPE_UPDATE_OLD_VERSION:
+      tile_group->UpdateTupleFromRecovery(commit_id, tuple_slot_id,
+                                          operation.new_location);
+      break;
+  }
+}
+
+std::shared_ptr<storage::TileGroup> LogReplayer::GetTileGroup(
+    storage::DataTable *table, oid_t tile_group_id, oid_t &max_tile_group_id) {
+  auto &manager = catalog::Manager::GetInstance();
+  auto tile_group = manager.GetTileGroup(tile_group_id);
+
+  // Only this worker creates tile groups with this id
+  if (tile_group == nullptr) {
+    table->AddTileGroupWithOidForRecovery(tile_group_id);
+    tile_group = manager.GetTileGroup(tile_group_id);
+    max_tile_group_id = std::max(max_tile_group_id, tile_group_id);
+  }
+
+  return tile_group;
+}
+
+}  // namespace logging
+}  // namespace peloton
@@ -0,0 +1,238 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// log_segment_pool.cpp
+//
+// Identification: src/logging/log_segment_pool.cpp
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "logging/log_segment_pool.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#include "common/logger.h"
+#include "logging/logging_util.h"
+
+namespace peloton {
+namespace logging {
+
+// Spares must not look like log files to recovery
+static const std::string spare_file_prefix = "peloton_spare_";
+
+static const std::string spare_file_suffix = ".log";
+
+// Zeroes are written in chunks of this size (in bytes)
+#define LOG_SEGMENT_ZERO_CHUNK_SIZE (1024 * 1024)
+
+const size_t LogSegmentPool::spare_segment_count_;
+
+LogSegmentPool::LogSegmentPool(const std::string &directory,
+                               size_t segment_size)
+    : directory_(directory), segment_size_(segment_size), pool_stop_(false) {
+  // Spares left behind might not be zeroed completely
+  DIR *dirp = opendir(directory_.c_str());
+  if (dirp != nullptr) {
+    struct dirent *file;
+    while ((file = readdir(dirp)) != nullptr) {
+      if (strncmp(file->d_name, spare_file_prefix.c_str(),
+                  spare_file_prefix.length()) == 0) {
+        size_t spare_id = LoggingUtil::ExtractNumberFromFileName(file->d_name);
+        next_spare_id_ = std::max(next_spare_id_, spare_id + 1);
+        recycled_segments_.push_back(directory_ + "/" + file->d_name);
+      }
+    }
+    closedir(dirp);
+  }
+
+  pool_thread_ = std::thread(&LogSegmentPool::PrepareSegments, this);
+}
+
+LogSegmentPool::~LogSegmentPool() {
+  {
+    std::lock_guard<std::mutex> pool_lock(pool_mutex_);
+    pool_stop_ = true;
+  }
+  pool_cv_.notify_all();
+
+  pool_thread_.join();
+}
+
+bool LogSegmentPool::AcquireSegment(const std::string &file_name) {
+  std::string spare_file_name;
+  {
+    std::lock_guard<std::mutex> pool_lock(pool_mutex_);
+    if (ready_segments_.empty() == false) {
+      spare_file_name = ready_segments_.back();
+      ready_segments_.pop_back();
+    }
+  }
+  pool_cv_.notify_one();
+
+  if (spare_file_name.empty() == false) {
+    if (rename(spare_file_name.c_str(), file_name.c_str()) == 0) {
+      LOG_TRACE("Reusing log segment %s for %s", spare_file_name.c_str(),
+                file_name.c_str());
+      return SyncDirectory();
+    }
+    LOG_ERROR("Could not rename log segment %s: %s", spare_file_name.c_str(),
+              strerror(errno));
+  }
+
+  // No spare ready, the file grows as it is written
+  int fd = open(file_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+  if (fd == -1) {
+    LOG_ERROR("Could not create log file %s: %s", file_name.c_str(),
+              strerror(errno));
+    return false;
+  }
+  close(fd);
+
+  return SyncDirectory();
+}
+
+void LogSegmentPool::RecycleSegment(const std::string &file_name) {
+  std::string spare_file_name;
+  {
+    std::lock_guard<std::mutex> pool_lock(pool_mutex_);
+    if (ready_segments_.size() + recycled_segments_.size() <
+        spare_segment_count_) {
+      spare_file_name = GetSpareFileName(next_spare_id_++);
+    }
+  }
+
+  if (spare_file_name.empty() == false &&
+      rename(file_name.c_str(), spare_file_name.c_str()) == 0) {
+    // The log file must not come back at the next start
+    SyncDirectory();
+    {
+      std::lock_guard<std::mutex> pool_lock(pool_mutex_);
+      recycled_segments_.push_back(spare_file_name);
+    }
+    pool_cv_.notify_one();
+    return;
+  }
+
+  // Enough spares around
+  if (remove(file_name.c_str()) != 0) {
+    LOG_ERROR("Couldn't delete log file: %s error: %s", file_name.c_str(),
+              strerror(errno));
+  }
+}
+
+bool LogSegmentPool::SyncDirectory() {
+  int fd = open(directory_.c_str(), O_RDONLY | O_DIRECTORY);
+  if (fd == -1) {
+    LOG_ERROR("Could not open log directory %s: %s", directory_.c_str(),
+              strerror(errno));
+    return false;
+  }
+
+  bool success = (fsync(fd) == 0);
+  if (success == false) {
+    LOG_ERROR("Could not sync log directory %s: %s", directory_.c_str(),
+              strerror(errno));
+  }
+  close(fd);
+
+  return success;
+}
+
+size_t LogSegmentPool::GetSpareSegmentCount() {
+  std::lock_guard<std::mutex> pool_lock(pool_mutex_);
+  return ready_segments_.size();
+}
+
+void LogSegmentPool::PrepareSegments() {
+  while (true) {
+    std::string spare_file_name;
+    {
+      std::unique_lock<std::mutex> pool_lock(pool_mutex_);
+      pool_cv_.wait(pool_lock, [this] {
+        return pool_stop_ || recycled_segments_.empty() == false ||
+               ready_segments_.size() < spare_segment_count_;
+      });
+      if (pool_stop_ == true) {
+        return;
+      }
+
+      if (recycled_segments_.empty() == false) {
+        spare_file_name = recycled_segments_.front();
+        recycled_segments_.pop_front();
+      } else {
+        spare_file_name = GetSpareFileName(next_spare_id_++);
+      }
+    }
+
+    if (ZeroSegment(spare_file_name) == false) {
+      // Zeroed again on the next start if it was cut short by shutdown
+      if (pool_stop_ == false) {
+        remove(spare_file_name.c_str());
+      }
+      continue;
+    }
+
+    std::lock_guard<std::mutex> pool_lock(pool_mutex_);
+    if (ready_segments_.size() < spare_segment_count_) {
+      ready_segments_.push_back(spare_file_name);
+    } else {
+      remove(spare_file_name.c_str());
+    }
+  }
+}
+
+bool LogSegmentPool::ZeroSegment(const std::string &file_name) {
+  int fd = open(file_name.c_str(), O_WRONLY | O_CREAT, 0600);
+  if (fd == -1) {
+    LOG_ERROR("Could not open log segment %s: %s", file_name.c_str(),
+              strerror(errno));
+    return false;
+  }
+
+  // Segments that outgrew the limit are cut back
+  bool success = (ftruncate(fd, segment_size_) == 0);
+
+  std::vector<char> zeros(LOG_SEGMENT_ZERO_CHUNK_SIZE, 0);
+  size_t offset = 0;
+  while (success == true && offset < segment_size_ && pool_stop_ == false) {
+    size_t chunk_size =
+        std::min(segment_size_ - offset, (size_t)LOG_SEGMENT_ZERO_CHUNK_SIZE);
+    ssize_t written = pwrite(fd, zeros.data(), chunk_size, offset);
+    if (written < 0 && errno != EINTR) {
+      success = false;
+    } else if (written > 0) {
+      offset += written;
+    }
+  }
+
+  if (success == true && offset == segment_size_) {
+    success = (fdatasync(fd) == 0);
+  } else {
+    success = false;
+  }
+
+  if (success == false && pool_stop_ == false) {
+    LOG_ERROR("Could not zero log segment %s: %s", file_name.c_str(),
+              strerror(errno));
+  }
+
+  close(fd);
+  return success;
+}
+
+std::string LogSegmentPool::GetSpareFileName(size_t spare_id) const {
+  return directory_ + "/" + spare_file_prefix + std::to_string(spare_id) +
+         spare_file_suffix;
+}
+
+}  // namespace logging
+}  // namespace peloton
@@ -0,0 +1,546 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// log_writer.cpp
+//
+// Identification: src/logging/log_writer.cpp
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "logging/log_writer.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__linux__) && defined(__NR_io_uring_setup)
+#include <linux/io_uring.h>
+#define LOG_WRITER_IO_URING
+#endif
+
+#include "common/logger.h"
+#include "common/macros.h"
+
+namespace peloton {
+namespace logging {
+
+//===--------------------------------------------------------------------===//
+// io_uring
+//===--------------------------------------------------------------------===//
+
+#ifdef LOG_WRITER_IO_URING
+
+/**
+ * Minimal io_uring submission and completion ring for positioned writes,
+ * driven by a single thread through the raw system calls.
+ */
+class IoRing {
+  IoRing(IoRing const &) = delete;
+
+ public:
+  // nullptr if the kernel does not support io_uring with IORING_OP_WRITE
+  static IoRing *Create(unsigned entries) {
+    std::unique_ptr<IoRing> io_ring(new IoRing());
+    if (io_ring->Init(entries) == false) {
+      return nullptr;
+    }
+    return io_ring.release();
+  }
+
+  ~IoRing() {
+    if (sqes_ != nullptr) {
+      munmap(sqes_, sqes_size_);
+    }
+    if (cq_ptr_ != MAP_FAILED && cq_ptr_ != sq_ptr_) {
+      munmap(cq_ptr_, cq_ring_size_);
+    }
+    if (sq_ptr_ != MAP_FAILED) {
+      munmap(sq_ptr_, sq_ring_size_);
+    }
+    if (ring_fd_ != -1) {
+      close(ring_fd_);
+    }
+  }
+
+  bool IsFull() const {
+    return *sq_tail_ - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) >=
+           sq_entries_;
+  }
+
+  // Returns false if the write was not submitted, i.e. the submission queue
+  // is full or the kernel did not take it
+  bool SubmitWrite(int fd, const char *data, size_t size, off_t file_offset,
+                   uint64_t user_data) {
+    if (IsFull() == true) {
+      return false;
+    }
+
+    unsigned tail = *sq_tail_;
+    unsigned index = tail & *sq_mask_;
+    struct io_uring_sqe *sqe = &sqes_[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_WRITE;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(data);
+    sqe->len = size;
+    sqe->off = file_offset;
+    sqe->user_data = user_data;
+    sq_array_[index] = index;
+
+    __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+
+    int ret;
+    do {
+      ret = syscall(__NR_io_uring_enter, ring_fd_, 1, 0, 0, nullptr, 0);
+    } while (ret < 0 && errno == EINTR);
+    if (ret < 1) {
+      // Nothing was consumed, take the entry back
+      LOG_ERROR("io_uring_enter failed: %s",
+                (ret < 0) ? strerror(errno) : "no entry submitted");
+      __atomic_store_n(sq_tail_, tail, __ATOMIC_RELEASE);
+      return false;
+    }
+    return true;
+  }
+
+  // Hand the completed writes to the handler, blocks for one if wait is set
+  template <typename CompletionHandler>
+  size_t ReapCompletions(bool wait, CompletionHandler handler) {
+    unsigned head = *cq_head_;
+    if (wait == true && head == __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) {
+      int ret;
+      do {
+        ret = syscall(__NR_io_uring_enter, ring_fd_, 0, 1,
+                      IORING_ENTER_GETEVENTS, nullptr, 0);
+      } while (ret < 0 && errno == EINTR);
+    }
+
+    size_t reaped_count = 0;
+    while (head != __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) {
+      struct io_uring_cqe *cqe = &cqes_[head & *cq_mask_];
+      handler(cqe->user_data, cqe->res);
+      head++;
+      reaped_count++;
+    }
+    __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+
+    return reaped_count;
+  }
+
+ private:
+  IoRing() {}
+
+  bool Init(unsigned entries) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+
+    ring_fd_ = syscall(__NR_io_uring_setup, entries, &params);
+    if (ring_fd_ < 0) {
+      ring_fd_ = -1;
+      return false;
+    }
+
+    // IORING_OP_WRITE came with the same kernel release as this feature
+    if ((params.features & IORING_FEAT_RW_CUR_POS) == 0) {
+      return false;
+    }
+
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size_ =
+        params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap == true) {
+      sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+    }
+
+    sq_ptr_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+    if (sq_ptr_ == MAP_FAILED) {
+      return false;
+    }
+    if (single_mmap == true) {
+      cq_ptr_ = sq_ptr_;
+    } else {
+      cq_ptr_ = mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_CQ_RING);
+      if (cq_ptr_ == MAP_FAILED) {
+        return false;
+      }
+    }
+
+    sqes_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+    void *sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+      return false;
+    }
+    sqes_ = static_cast<struct io_uring_sqe *>(sqes);
+
+    char *sq_ptr = static_cast<char *>(sq_ptr_);
+    sq_head_ = reinterpret_cast<unsigned *>(sq_ptr + params.sq_off.head);
+    sq_tail_ = reinterpret_cast<unsigned *>(sq_ptr + params.sq_off.tail);
+    sq_mask_ = reinterpret_cast<unsigned *>(sq_ptr + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned *>(sq_ptr + params.sq_off.array);
+    sq_entries_ = params.sq_entries;
+
+    char *cq_ptr = static_cast<char *>(cq_ptr_);
+    cq_head_ = reinterpret_cast<unsigned *>(cq_ptr + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned *>(cq_ptr + params.cq_off.tail);
+    cq_mask_ = reinterpret_cast<unsigned *>(cq_ptr + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<struct io_uring_cqe *>(cq_ptr +
+                                                    params.cq_off.cqes);
+
+    return true;
+  }
+
+  int ring_fd_ = -1;
+
+  void *sq_ptr_ = MAP_FAILED;
+
+  void *cq_ptr_ = MAP_FAILED;
+
+  struct io_uring_sqe *sqes_ = nullptr;
+
+  size_t sq_ring_size_ = 0;
+
+  size_t cq_ring_size_ = 0;
+
+  size_t sqes_size_ = 0;
+
+  unsigned *sq_head_ = nullptr;
+
+  unsigned *sq_tail_ = nullptr;
+
+  unsigned *sq_mask_ = nullptr;
+
+  unsigned *sq_array_ = nullptr;
+
+  unsigned sq_entries_ = 0;
+
+  unsigned *cq_head_ = nullptr;
+
+  unsigned *cq_tail_ = nullptr;
+
+  unsigned *cq_mask_ = nullptr;
+
+  struct io_uring_cqe *cqes_ = nullptr;
+};
+
+#else
+
+class IoRing {
+ public:
+  static IoRing *Create(unsigned) { return nullptr; }
+
+  bool IsFull() const { return false; }
+
+  bool SubmitWrite(int, const char *, size_t, off_t, uint64_t) {
+    return false;
+  }
+
+  template <typename CompletionHandler>
+  size_t ReapCompletions(bool, CompletionHandler) {
+    return 0;
+  }
+};
+
+#endif
+
+//===--------------------------------------------------------------------===//
+// Log Writer
+//===--------------------------------------------------------------------===//
+
+const size_t LogWriter::block_size_;
+
+const size_t LogWriter::buffer_size_;
+
+const size_t LogWriter::buffer_count_;
+
+const size_t LogWriter::io_thread_count_;
+
+LogWriter::LogWriter() : pending_writes_(buffer_count_, 0) {
+  for (size_t buffer_itr = 0; buffer_itr < buffer_count_; buffer_itr++) {
+    void *buffer = nullptr;
+    if (posix_memalign(&buffer, block_size_, buffer_size_) != 0) {
+      LOG_ERROR("Could not allocate log writer buffer");
+      buffer = nullptr;
+    }
+    buffers_.push_back(static_cast<char *>(buffer));
+  }
+
+  io_ring_.reset(IoRing::Create(2 * buffer_count_));
+  if (io_ring_ == nullptr) {
+    LOG_TRACE("io_uring is not available, writing with I/O threads");
+    StartIoThreads();
+  }
+}
+
+LogWriter::~LogWriter() {
+  Close();
+  StopIoThreads();
+
+  for (auto buffer : buffers_) {
+    free(buffer);
+  }
+}
+
+bool LogWriter::Open(const std::string &file_name) {
+  Close();
+
+  // Nothing can be staged without the buffers
+  for (auto buffer : buffers_) {
+    if (buffer == nullptr) {
+      LOG_ERROR("Log writer has no buffers, not opening %s",
+                file_name.c_str());
+      return false;
+    }
+  }
+
+  fd_ = open(file_name.c_str(), O_WRONLY | O_CREAT | O_DIRECT, 0600);
+
+  // Not every file system supports direct I/O
+  if (fd_ == -1 && errno == EINVAL) {
+    LOG_TRACE("Direct I/O is not supported for %s", file_name.c_str());
+    fd_ = open(file_name.c_str(), O_WRONLY | O_CREAT, 0600);
+  }
+
+  if (fd_ == -1) {
+    LOG_ERROR("Could not open log file %s: %s", file_name.c_str(),
+              strerror(errno));
+    return false;
+  }
+
+  current_buffer_ = 0;
+  buffer_file_offset_ = 0;
+  buffer_fill_ = 0;
+  buffer_submitted_ = 0;
+  write_failed_ = false;
+  memset(buffers_[current_buffer_], 0, buffer_size_);
+
+  return true;
+}
+
+void LogWriter::Close() {
+  if (fd_ == -1) {
+    return;
+  }
+
+  Sync();
+
+  if (close(fd_) != 0) {
+    LOG_ERROR("Error occured in close(%s)", strerror(errno));
+  }
+  fd_ = -1;
+}
+
+void LogWriter::Append(const char *data, size_t size) {
+  PL_ASSERT(fd_ != -1);
+
+  while (size > 0) {
+    size_t copy_size = std::min(size, buffer_size_ - buffer_fill_);
+    memcpy(buffers_[current_buffer_] + buffer_fill_, data, copy_size);
+    buffer_fill_ += copy_size;
+    data += copy_size;
+    size -= copy_size;
+
+    // Write the full buffer while staging continues in the next one
+    if (buffer_fill_ == buffer_size_) {
+      SubmitCurrentBuffer(buffer_size_);
+
+      current_buffer_ = (current_buffer_ + 1) % buffer_count_;
+      WaitForBuffer(current_buffer_);
+      memset(buffers_[current_buffer_], 0, buffer_size_);
+
+      buffer_file_offset_ += buffer_size_;
+      buffer_fill_ = 0;
+      buffer_submitted_ = 0;
+    }
+  }
+}
+
+bool LogWriter::Sync() {
+  if (fd_ == -1) {
+    return false;
+  }
+
+  if (buffer_fill_ > buffer_submitted_) {
+    SubmitCurrentBuffer(buffer_fill_);
+  }
+  WaitForAllWrites();
+
+  if (fdatasync(fd_) != 0) {
+    LOG_ERROR("Error occured in fdatasync(%s)", strerror(errno));
+    write_failed_ = true;
+  }
+
+  bool success = (write_failed_ == false);
+  write_failed_ = false;
+  return success;
+}
+
+void LogWriter::SubmitCurrentBuffer(size_t end) {
+  // The last block may have been written partially, write it again
+  size_t begin = buffer_submitted_ - buffer_submitted_ % block_size_;
+  size_t aligned_end = (end + block_size_ - 1) / block_size_ * block_size_;
+
+  if (aligned_end > begin) {
+    WriteRequest request;
+    request.buffer_id = current_buffer_;
+    request.data = buffers_[current_buffer_] + begin;
+    request.size = aligned_end - begin;
+    request.file_offset = buffer_file_offset_ + begin;
+    SubmitWrite(request);
+  }
+
+  buffer_submitted_ = end;
+}
+
+void LogWriter::SubmitWrite(const WriteRequest &request) {
+  if (io_ring_ != nullptr) {
+    pending_writes_[request.buffer_id]++;
+
+    while (io_ring_->IsFull() == true) {
+      ReapCompletions(true);
+    }
+
+    // The request travels as user data and comes back with its completion
+    auto ring_request = new WriteRequest(request);
+    if (io_ring_->SubmitWrite(fd_, request.data, request.size,
+                              request.file_offset,
+                              reinterpret_cast<uint64_t>(ring_request)) ==
+        false) {
+      // No completion will come, write it synchronously instead
+      delete ring_request;
+      bool success =
+          WriteFully(request.data, request.size, request.file_offset);
+      CompleteWrite(request.buffer_id, success);
+    }
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> io_lock(io_mutex_);
+    pending_writes_[request.buffer_id]++;
+    io_requests_.push_back(request);
+  }
+  io_request_cv_.notify_one();
+}
+
+bool LogWriter::WriteFully(const char *data, size_t size, off_t file_offset) {
+  while (size > 0) {
+    ssize_t written = pwrite(fd_, data, size, file_offset);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      LOG_ERROR("Error occured in pwrite(%s)", strerror(errno));
+      return false;
+    }
+    data += written;
+    size -= written;
+    file_offset += written;
+  }
+  return true;
+}
+
+void LogWriter::CompleteWrite(size_t buffer_id, bool success) {
+  PL_ASSERT(pending_writes_[buffer_id] > 0);
+  pending_writes_[buffer_id]--;
+
+  if (success == false) {
+    write_failed_ = true;
+  }
+}
+
+void LogWriter::ReapCompletions(bool wait) {
+  io_ring_->ReapCompletions(wait, [this](uint64_t user_data, int result) {
+    auto request = reinterpret_cast<WriteRequest *>(user_data);
+    bool success = true;
+
+    if (result < 0) {
+      LOG_ERROR("Asynchronous log write failed: %s", strerror(-result));
+      success = false;
+    } else if (static_cast<size_t>(result) < request->size) {
+      // Finish a short write synchronously
+      success = WriteFully(request->data + result, request->size - result,
+                           request->file_offset + result);
+    }
+
+    CompleteWrite(request->buffer_id, success);
+    delete request;
+  });
+}
+
+void LogWriter::WaitForBuffer(size_t buffer_id) {
+  if (io_ring_ != nullptr) {
+    while (pending_writes_[buffer_id] > 0) {
+      ReapCompletions(true);
+    }
+    return;
+  }
+
+  std::unique_lock<std::mutex> io_lock(io_mutex_);
+  io_completion_cv_.wait(io_lock,
+                         [&] { return pending_writes_[buffer_id] == 0; });
+}
+
+void LogWriter::WaitForAllWrites() {
+  for (size_t buffer_itr = 0; buffer_itr < buffer_count_; buffer_itr++) {
+    WaitForBuffer(buffer_itr);
+  }
+}
+
+void LogWriter::RunIoThread() {
+  while (true) {
+    WriteRequest request;
+    {
+      std::unique_lock<std::mutex> io_lock(io_mutex_);
+      io_request_cv_.wait(
+          io_lock, [this] { return io_stop_ || io_requests_.empty() == false; });
+      if (io_requests_.empty() == true) {
+        return;
+      }
+      request = io_requests_.front();
+      io_requests_.pop_front();
+    }
+
+    bool success = WriteFully(request.data, request.size, request.file_offset);
+
+    {
+      std::lock_guard<std::mutex> io_lock(io_mutex_);
+      CompleteWrite(request.buffer_id, success);
+    }
+    io_completion_cv_.notify_all();
+  }
+}
+
+void LogWriter::StartIoThreads() {
+  io_stop_ = false;
+  for (size_t thread_itr = 0; thread_itr < io_thread_count_; thread_itr++) {
+    io_threads_.emplace_back(&LogWriter::RunIoThread, this);
+  }
+}
+
+void LogWriter::StopIoThreads() {
+  {
+    std::lock_guard<std::mutex> io_lock(io_mutex_);
+    io_stop_ = true;
+  }
+  io_request_cv_.notify_all();
+
+  for (auto &io_thread : io_threads_) {
+    io_thread.join();
+  }
+  io_threads_.clear();
+}
+
+}  // namespace logging
+}  // namespace peloton
@@ -15,12 +15,13 @@
 #include <sys/mman.h>
 #include <algorithm>
 #include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <numeric>
 
 #include "catalog/catalog.h"
 #include "catalog/manager.h"
 #include "catalog/schema.h"
-#include "type/ephemeral_pool.h"
 
 #include "logging/log_manager.h"
 #include "logging/records/transaction_record.h"
@@ -37,8 +38,6 @@
 #include "storage/tuple.h"
 #include "common/logger.h"
 
-int logger_id_counter = 0;
-
 //#define LOG_FILE_SWITCH_LIMIT (1024)
 
 namespace peloton {
@@ -54,11 +53,11 @@ WriteAheadFrontendLogger::WriteAheadFrontendLogger()
 /**
  * @brief Open logfile and file descriptor
  */
-WriteAheadFrontendLogger::WriteAheadFrontendLogger(bool for_testing) {
+WriteAheadFrontendLogger::WriteAheadFrontendLogger(bool for_testing,
+                                                   unsigned int logger_id) {
   test_mode_ = for_testing;
+  SetLoggerID(logger_id);
 
-  // allocate pool
-  recovery_pool = new type::EphemeralPool();
   if (test_mode_) {
     cur_file_handle.file = nullptr;
   } else {
@@ -69,15 +68,11 @@ WriteAheadFrontendLogger::WriteAheadFrontendLogger(bool for_testing) {
 WriteAheadFrontendLogger::WriteAheadFrontendLogger(std::string log_dir)
     : peloton_log_directory(log_dir) {
   LOG_TRACE("Instantiating wal_fel with log directory: %s", log_dir.c_str());
-  
-  // allocate pool
-  recovery_pool = new type::EphemeralPool();
 
   InitSelf();
 }
 
 void WriteAheadFrontendLogger::InitSelf() {
-  SetLoggerID(__sync_fetch_and_add(&logger_id_counter, 1));
   InitLogDirectory();
   InitLogFilesList();
   UpdateMaxDelimiterForRecovery();
@@ -85,12 +80,22 @@ void WriteAheadFrontendLogger::InitSelf() {
             (int)max_delimiter_for_recovery);
   cur_file_handle.fd = -1;  // this is a restart or a new start
   max_log_id_file = 0;      // 0 is unused
+
+  log_writer.reset(new LogWriter());
+  log_segment_pool.reset(new LogSegmentPool(
+      peloton_log_directory,
+      LogManager::GetInstance().GetLogFileSizeLimit() * 1024));
 }
 
 /**
  * @brief close logfile
  */
 WriteAheadFrontendLogger::~WriteAheadFrontendLogger() {
+  // The log writer syncs the staged log data when it is closed
+  if (log_writer != nullptr && log_writer->IsOpen()) {
+    AppendStagedLogData();
+  }
+
   // close the log file
   if (cur_file_handle.file != nullptr) {
     int ret = fclose(cur_file_handle.file);
@@ -100,8 +105,6 @@ WriteAheadFrontendLogger::~WriteAheadFrontendLogger() {
   }
 
   for (auto log_file : log_files_) delete log_file;
-  // clean up pool
-  delete recovery_pool;
 }
 
 /**
@@ -134,10 +137,8 @@ void WriteAheadFrontendLogger::FlushLogRecords(void) {
        global_queue_itr++) {
     auto &log_buffer = global_queue[global_queue_itr];
 
-    if (!test_mode_ && !no_write_) {
-      fwrite(log_buffer->GetData(), sizeof(char), log_buffer->GetSize(),
-             cur_file_handle.file);
-    }
+    WriteLogData(log_buffer->GetData(), log_buffer->GetSize());
+    unflushed_log_size += log_buffer->GetSize();
 
     LOG_TRACE("Log buffer get max log id returned %d",
               (int)log_buffer->GetMaxLogId());
@@ -156,23 +157,32 @@ void WriteAheadFrontendLogger::FlushLogRecords(void) {
   bool flushed = false;
 
   if (max_collected_commit_id != max_flushed_commit_id) {
+    // The group commit of the oldest waiting commit starts now
+    if (waiting_for_group_commit == false) {
+      waiting_for_group_commit = true;
+      group_commit_start = Clock::now();
+    }
+
     if (!test_mode_) {
       PL_ASSERT(cur_file_handle.fd != -1);
       if (cur_file_handle.fd != -1) {
-        if (!no_write_) {
-          fwrite(delimiter_rec.GetMessage(), sizeof(char),
-                 delimiter_rec.GetMessageLength(), cur_file_handle.file);
-        }
+        WriteLogData(delimiter_rec.GetMessage(),
+                     delimiter_rec.GetMessageLength());
         LOG_TRACE("Wrote delimiter to log file with commit_id %ld",
                   this->max_collected_commit_id);
+        unflushed_log_size += delimiter_rec.GetMessageLength();
 
         // by moving the fflush and sync here, we ensure that this file will
         // have at least 1 delimiter
-        if (Clock::now() > last_flush + flush_frequency) {
-          if (!no_write_) {
-            LoggingUtil::FFlushFsync(cur_file_handle);
+        if (GroupCommitIsDue(global_queue_size)) {
+          AppendStagedLogData();
+          auto sync_start = Clock::now();
+          if (!no_write_ && log_writer->Sync() == false) {
+            LOG_ERROR("Could not sync log file");
           }
-          last_flush = Clock::now();
+          write_micros +=
+              std::chrono::duration_cast<Micros>(Clock::now() - sync_start)
+                  .count();
           if (this->max_collected_commit_id > max_flushed_commit_id) {
             max_flushed_commit_id = this->max_collected_commit_id;
           }
@@ -189,8 +199,7 @@ void WriteAheadFrontendLogger::FlushLogRecords(void) {
         if (FileSwitchCondIsTrue()) should_create_new_file = true;
       }
     } else {
-      if (Clock::now() > last_flush + flush_frequency) {
-        last_flush = Clock::now();
+      if (GroupCommitIsDue(global_queue_size)) {
         if (this->max_collected_commit_id > max_flushed_commit_id) {
           max_flushed_commit_id = this->max_collected_commit_id;
         }
@@ -204,45 +213,195 @@ void WriteAheadFrontendLogger::FlushLogRecords(void) {
   // Clean up the frontend logger's queue
   global_queue.clear();
 
+  if (flushed) {
+    unflushed_log_size = 0;
+    waiting_for_group_commit = false;
+    AdaptLogCompressionLevel();
+  }
+
+  // Waiting commits are flushed once a collection window passes without new
+  // log data, and at the latest at their latency bound
+  collection_timeout = LOG_COLLECTION_TIMEOUT;
+  if (waiting_for_group_commit == true) {
+    auto group_commit_end =
+        group_commit_start +
+        Micros(LogManager::GetInstance().GetGroupCommitLatency());
+    auto remaining_time =
+        std::chrono::duration_cast<Micros>(group_commit_end - Clock::now());
+    collection_timeout = std::max<int64_t>(
+        std::min<int64_t>(remaining_time.count(),
+                          std::max(collection_window, 1)),
+        0);
+  }
+
   if (flushed) {
     // signal that we have flushed
     LogManager::GetInstance().FrontendLoggerFlushed();
   }
 }
 
+/**
+ * @brief Group commit policy: flush once a batch is large enough, the oldest
+ * waiting commit reaches the latency bound or there is nothing left to batch
+ * the commits with
+ */
+bool WriteAheadFrontendLogger::GroupCommitIsDue(size_t collected_buffer_count) {
+  auto &log_manager = LogManager::GetInstance();
+
+  if (unflushed_log_size >= log_manager.GetGroupCommitSize()) {
+    return true;
+  }
+
+  if (Clock::now() >=
+      group_commit_start + Micros(log_manager.GetGroupCommitLatency())) {
+    return true;
+  }
+
+  // The log device idles: no log data arrived in this round, or a single
+  // backend commits at a time and nobody else would join the group
+  return collected_buffer_count == 0 || collection_window == 0;
+}
+
+bool WriteAheadFrontendLogger::IsCompressingLogData() {
+  return log_compression_level > LogCompressor::min_level_ &&
+         LogManager::GetInstance().GetLogCompression() == true;
+}
+
+/**
+ * @brief Write log data to the current log file. With compression, the log
+ * data is staged until the next sync and written as one block
+ */
+void WriteAheadFrontendLogger::WriteLogData(const char *data, size_t size) {
+  if (test_mode_ || no_write_) {
+    return;
+  }
+  compression_window_size += size;
+
+  if (IsCompressingLogData()) {
+    staged_log_data.insert(staged_log_data.end(), data, data + size);
+    if (staged_log_data.size() >= LOG_COMPRESSION_BLOCK_SIZE) {
+      AppendStagedLogData();
+    }
+    return;
+  }
+
+  // Keep the log in order if compression was just switched off
+  AppendStagedLogData();
+
+  auto write_start = Clock::now();
+  log_writer->Append(data, size);
+  write_micros +=
+      std::chrono::duration_cast<Micros>(Clock::now() - write_start).count();
+}
+
+void WriteAheadFrontendLogger::AppendStagedLogData() {
+  if (staged_log_data.empty() == true) {
+    return;
+  }
+
+  // Log data that does not shrink is written as is
+  const char *data = staged_log_data.data();
+  size_t size = staged_log_data.size();
+  auto compression_start = Clock::now();
+  if (log_compressor.CompressBlock(data, size,
+                                   std::max(log_compression_level, 1))) {
+    data = log_compressor.GetBlock();
+    size = log_compressor.GetBlockSize();
+  }
+  compression_micros += std::chrono::duration_cast<Micros>(
+                            Clock::now() - compression_start).count();
+
+  auto write_start = Clock::now();
+  log_writer->Append(data, size);
+  write_micros +=
+      std::chrono::duration_cast<Micros>(Clock::now() - write_start).count();
+
+  staged_log_data.clear();
+}
+
+/**
+ * @brief Compression policy: compress harder while the log device is busy
+ * for most of a window, back off once compressing takes longer than writing
+ * the compressed data
+ */
+void WriteAheadFrontendLogger::AdaptLogCompressionLevel() {
+  if (compression_window_size < LOG_COMPRESSION_WINDOW_SIZE) {
+    return;
+  }
+
+  auto now = Clock::now();
+  if (LogManager::GetInstance().GetLogCompression() == false) {
+    compression_micros = 0;
+    write_micros = 0;
+    compression_window_size = 0;
+    compression_window_start = now;
+    return;
+  }
+
+  auto window_micros =
+      std::chrono::duration_cast<Micros>(now - compression_window_start)
+          .count();
+
+  if (compression_micros > write_micros) {
+    log_compression_level =
+        std::max(log_compression_level - 1, LogCompressor::min_level_);
+  } else if (write_micros * 2 >= window_micros) {
+    log_compression_level =
+        std::min(log_compression_level + 1, LogCompressor::max_level_);
+  }
+  LOG_TRACE("Log compression level is now %d", log_compression_level);
+
+  compression_micros = 0;
+  write_micros = 0;
+  compression_window_size = 0;
+  compression_window_start = now;
+}
+
 //===--------------------------------------------------------------------===//
 // Recovery
 //===--------------------------------------------------------------------===//
 
 /**
- * @brief Recovery system based on log file
+ * @brief Recovery system based on log file. Only opens the log, the log
+ * manager reads it while replaying, see ReadRecoveredTransactions().
  */
 void WriteAheadFrontendLogger::DoRecovery() {
   // FIXME GetNextCommitId() increments next_cid!!!
-  cid_t start_commit_id = CheckpointManager::GetInstance().GetRecoveredCid();
+  recovery_start_commit_id = CheckpointManager::GetInstance().GetRecoveredCid();
   auto &log_manager = logging::LogManager::GetInstance();
-  int num_inserts = 0;
-  cid_t global_max_flushed_id_for_recovery;
   log_file_cursor_ = 0;
 
-  global_max_flushed_id_for_recovery =
-      log_manager.GetGlobalMaxFlushedIdForRecovery();
+  recovery_max_commit_id = log_manager.GetGlobalMaxFlushedIdForRecovery();
   LOG_TRACE("Got start_commit_id as %d, global max flushed as %d",
-            (int)start_commit_id, (int)global_max_flushed_id_for_recovery);
+            (int)recovery_start_commit_id, (int)recovery_max_commit_id);
+
+  recovered_delimiter = INVALID_CID;
 
   // open first file
   OpenNextLogFile();
+}
 
-  // Go over the log file if needed
-  bool reached_end_of_log = false;
-
+/**
+ * @brief Read the log up to the next iteration delimiter. Every transaction
+ * of this stream that committed up to the delimiter has been read then.
+ * @return false once the end of the log is reached
+ */
+bool WriteAheadFrontendLogger::ReadRecoveredTransactions() {
   // Go over each log record in the log file
-  while (reached_end_of_log == false) {
+  while (true) {
     // Read the first byte to identify log record type
     // If that is not possible, then wrap up recovery
     auto record_type = GetNextLogRecordTypeForRecovery();
     cid_t log_id = INVALID_CID;
     TupleRecord *tuple_record;
+    const char *frame;
+    size_t frame_size;
+    const char *body_frame = nullptr;
+    size_t body_frame_size = 0;
+    size_t record_offset = 0;
+    if (cur_mapped_file != nullptr) {
+      record_offset = cur_mapped_file->GetOffset() - 1;
+    }
 
     switch (record_type) {
       case LOGRECORD_TYPE_TRANSACTION_BEGIN:
@@ -250,36 +409,67 @@ void WriteAheadFrontendLogger::DoRecovery() {
       case LOGRECORD_TYPE_ITERATION_DELIMITER: {
         // Check for torn log write
         TransactionRecord txn_rec(record_type);
-        if (LoggingUtil::ReadTransactionRecordHeader(
-                txn_rec, cur_file_handle) == false) {
-          cur_file_handle = INVALID_FILE_HANDLE;
-          return;
+        if (cur_mapped_file->ReadFrame(frame, frame_size) == false ||
+            cur_mapped_file->ReadChecksum(record_offset) == false) {
+          LOG_TRACE("Log ends at a torn transaction record");
+          return EndRecoveredTransactions();
         }
+        ReferenceSerializeInput txn_header(frame, frame_size);
+        txn_rec.Deserialize(txn_header);
         log_id = txn_rec.GetTransactionId();
-        if (log_id <= start_commit_id ||
-            log_id > global_max_flushed_id_for_recovery) {
+
+        // The delimiters tell how far the stream is complete
+        if (record_type == LOGRECORD_TYPE_ITERATION_DELIMITER) {
+          if (log_id > recovered_delimiter) {
+            recovered_delimiter = log_id;
+            return true;
+          }
+          continue;
+        }
+
+        if (log_id <= recovery_start_commit_id ||
+            log_id > recovery_max_commit_id) {
           LOG_TRACE("SKIP");
           continue;
         }
+
+        if (record_type == LOGRECORD_TYPE_TRANSACTION_BEGIN) {
+          StartTransactionRecovery(log_id);
+        } else {
+          // Now directly commit this transaction. This is safe because we
+          // reject commit ids that appear after the persistent commit id
+          // above.
+          CommitTransactionRecovery(log_id);
+        }
         break;
       }
       case LOGRECORD_TYPE_WAL_TUPLE_INSERT:
       case LOGRECORD_TYPE_WAL_TUPLE_UPDATE: {
-        tuple_record = new TupleRecord(record_type);
         // Check for torn log write
-        if (LoggingUtil::ReadTupleRecordHeader(*tuple_record,
-                                               cur_file_handle) == false) {
+        if (cur_mapped_file->ReadFrame(frame, frame_size) == false) {
           LOG_ERROR("Could not read tuple record header.");
-          cur_file_handle = INVALID_FILE_HANDLE;
-          return;
+          return EndRecoveredTransactions();
+        }
+
+        // The body is replayed in place from the mapped log file
+        if (cur_mapped_file->ReadFrame(body_frame, body_frame_size) == false) {
+          LOG_ERROR("Could not read tuple record body.");
+          return EndRecoveredTransactions();
+        }
+        if (cur_mapped_file->ReadChecksum(record_offset) == false) {
+          LOG_ERROR("Checksum mismatch in tuple record, log ends here.");
+          return EndRecoveredTransactions();
         }
 
+        tuple_record = new TupleRecord(record_type);
+        ReferenceSerializeInput tuple_header(frame, frame_size);
+        tuple_record->DeserializeHeader(tuple_header);
+
         log_id = tuple_record->GetTransactionId();
         auto table = LoggingUtil::GetTable(*tuple_record);
 
-        if (!table || log_id <= start_commit_id ||
-            log_id > global_max_flushed_id_for_recovery) {
-          LoggingUtil::SkipTupleRecordBody(cur_file_handle);
+        if (!table || log_id <= recovery_start_commit_id ||
+            log_id > recovery_max_commit_id) {
           LOG_TRACE("Skip a tuple, log id is %d", (int)log_id);
           delete tuple_record;
           continue;
@@ -288,90 +478,55 @@ void WriteAheadFrontendLogger::DoRecovery() {
         if (recovery_txn_table.find(log_id) == recovery_txn_table.end()) {
           LOG_ERROR("Insert txd id %d not found in recovery txn table",
                     (int)log_id);
-          cur_file_handle = INVALID_FILE_HANDLE;
-          return;
+          delete tuple_record;
+          return EndRecoveredTransactions();
         }
 
-        // Read off the tuple record body from the log
-        tuple_record->SetTuple(LoggingUtil::ReadTupleRecordBody(
-            table->GetSchema(), recovery_pool, cur_file_handle));
-        num_inserts++;
+        tuple_record->SetTupleBody(body_frame, body_frame_size);
+        recovery_txn_table[log_id].push_back(tuple_record);
         break;
       }
       case LOGRECORD_TYPE_WAL_TUPLE_DELETE: {
-        tuple_record = new TupleRecord(record_type);
         // Check for torn log write
-        if (LoggingUtil::ReadTupleRecordHeader(*tuple_record,
-                                               cur_file_handle) == false) {
-          cur_file_handle = INVALID_FILE_HANDLE;
-          return;
+        if (cur_mapped_file->ReadFrame(frame, frame_size) == false ||
+            cur_mapped_file->ReadChecksum(record_offset) == false) {
+          LOG_TRACE("Log ends at a torn delete record");
+          return EndRecoveredTransactions();
         }
+        tuple_record = new TupleRecord(record_type);
+        ReferenceSerializeInput tuple_header(frame, frame_size);
+        tuple_record->DeserializeHeader(tuple_header);
 
         log_id = tuple_record->GetTransactionId();
-        if (log_id <= start_commit_id ||
-            log_id > global_max_flushed_id_for_recovery) {
+        if (log_id <= recovery_start_commit_id ||
+            log_id > recovery_max_commit_id) {
           delete tuple_record;
           continue;
         }
         if (recovery_txn_table.find(log_id) == recovery_txn_table.end()) {
           LOG_TRACE("Delete txd id %d not found in recovery txn table",
                     (int)log_id);
-          cur_file_handle = INVALID_FILE_HANDLE;
-          return;
+          delete tuple_record;
+          return EndRecoveredTransactions();
         }
+        recovery_txn_table[log_id].push_back(tuple_record);
         break;
       }
       default:
-        reached_end_of_log = true;
-        break;
-    }
-    if (!reached_end_of_log) {
-      switch (record_type) {
-        case LOGRECORD_TYPE_TRANSACTION_BEGIN:
-          PL_ASSERT(log_id != INVALID_CID);
-          StartTransactionRecovery(log_id);
-          break;
-
-        case LOGRECORD_TYPE_TRANSACTION_COMMIT:
-          PL_ASSERT(log_id != INVALID_CID);
-
-          // Now directly commit this transaction. This is safe because we
-          // reject commit ids that appear
-          // after the persistent commit id before coming here (in the switch
-          // case above).
-          CommitTransactionRecovery(log_id);
-          break;
-
-        case LOGRECORD_TYPE_WAL_TUPLE_INSERT:
-        case LOGRECORD_TYPE_WAL_TUPLE_DELETE:
-        case LOGRECORD_TYPE_WAL_TUPLE_UPDATE:
-          recovery_txn_table[tuple_record->GetTransactionId()]
-              .push_back(tuple_record);
-          break;
-        case LOGRECORD_TYPE_ITERATION_DELIMITER: {
-          // Do nothing if we hit the delimiter, because the delimiters help
-          // us only to find
-          // the max persistent commit id, and should be ignored during actual
-          // recovery
-          break;
-        }
-
-        default:
-          reached_end_of_log = true;
-          break;
-      }
+        return EndRecoveredTransactions();
     }
   }
+}
 
+bool WriteAheadFrontendLogger::EndRecoveredTransactions() {
   // Finally, abort ACTIVE transactions in recovery_txn_table
   AbortActiveTransactions();
 
-  // After finishing recovery, set the next oid with maximum oid
-  // observed during the recovery
-  log_manager.UpdateCatalogAndTxnManagers(max_oid, max_cid);
-
-  LOG_TRACE("This thread did %d inserts", (int)num_inserts);
-  cur_file_handle = INVALID_FILE_HANDLE;
+  // Every committed transaction left has been read
+  recovered_delimiter = MAX_CID;
+  cur_mapped_file = nullptr;
+  cur_log_file = nullptr;
+  return false;
 }
 
 void WriteAheadFrontendLogger::RecoverIndex() {
@@ -418,159 +573,43 @@ void WriteAheadFrontendLogger::StartTransactionRecovery(cid_t commit_id) {
  * @param recovery txn
  */
 void WriteAheadFrontendLogger::CommitTransactionRecovery(cid_t commit_id) {
-  std::vector<TupleRecord *> &tuple_records = recovery_txn_table[commit_id];
-  for (auto it = tuple_records.begin(); it != tuple_records.end(); it++) {
-    TupleRecord *curr = *it;
-    switch (curr->GetType()) {
-      case LOGRECORD_TYPE_WAL_TUPLE_INSERT:
-        InsertTuple(curr);
-        break;
-      case LOGRECORD_TYPE_WAL_TUPLE_UPDATE:
-        UpdateTuple(curr);
-        break;
-      case LOGRECORD_TYPE_WAL_TUPLE_DELETE:
-        DeleteTuple(curr);
-        break;
-      default:
-        continue;
-    }
-    delete curr;
-  }
-  max_cid = commit_id + 1;
+  // The log manager replays the committed transactions of all streams in
+  // commit id order once every stream has been read
+  recovered_txn_table[commit_id] = std::move(recovery_txn_table[commit_id]);
   recovery_txn_table.erase(commit_id);
 }
 
-void InsertTupleHelper(oid_t &max_tg, cid_t commit_id, oid_t db_id,
-                       oid_t table_id, const ItemPointer &insert_loc,
-                       storage::Tuple *tuple,
-                       bool should_increase_tuple_count = true) {
-  LOG_TRACE("Insert tuple helper.");
-  auto &manager = catalog::Manager::GetInstance();
-  auto catalog = catalog::Catalog::GetInstance();
-  storage::Database *db = catalog->GetDatabaseWithOid(db_id);
-  PL_ASSERT(db);
-
-  auto table = db->GetTableWithOid(table_id);
-  if (!table) {
-    delete tuple;
-    return;
-  }
-  PL_ASSERT(table);
-
-  // FIXME Handle the case when tile_group is not created yet.
-  // table->GetTileGroupLock().WriteLock();
-  auto tile_group = manager.GetTileGroup(insert_loc.block);
-
-  if (tile_group == nullptr) {
-    table->AddTileGroupWithOidForRecovery(insert_loc.block);
-    tile_group = manager.GetTileGroup(insert_loc.block);
-    if (max_tg < insert_loc.block) {
-      max_tg = insert_loc.block;
-    }
-  }
-  // table->GetTileGroupLock().Unlock();
-  // unlock table here
-
-  tile_group->InsertTupleFromRecovery(commit_id, insert_loc.offset, tuple);
-  if (should_increase_tuple_count) {
-    table->IncreaseTupleCount(1);
-  }
-  delete tuple;
-}
-
-void DeleteTupleHelper(oid_t &max_tg, cid_t commit_id, oid_t db_id,
-                       oid_t table_id, const ItemPointer &delete_loc) {
-  auto &manager = catalog::Manager::GetInstance();
-  auto catalog = catalog::Catalog::GetInstance();
-  storage::Database *db = catalog->GetDatabaseWithOid(db_id);
-  PL_ASSERT(db);
-
-  auto table = db->GetTableWithOid(table_id);
-  if (!table) {
-    return;
-  }
-  PL_ASSERT(table);
-
-  // FIXME Handle the case when tile_group is not created yet.
-  // acquiring the write lock will lead to deadlock
-  // table->GetTileGroupLock().WriteLock();
-  auto tile_group = manager.GetTileGroup(delete_loc.block);
-  if (tile_group == nullptr) {
-    table->AddTileGroupWithOidForRecovery(delete_loc.block);
-    tile_group = manager.GetTileGroup(delete_loc.block);
-    if (max_tg < delete_loc.block) {
-      max_tg = delete_loc.block;
-    }
-  }
-  // FIXME we always decrease the number of tuples by one
-  table->DecreaseTupleCount(1);
-  // table->GetTileGroupLock().Unlock();
-
-  tile_group->DeleteTupleFromRecovery(commit_id, delete_loc.offset);
-}
-
-void UpdateTupleHelper(oid_t &max_tg, cid_t commit_id, oid_t db_id,
-                       oid_t table_id, const ItemPointer &remove_loc,
-                       const ItemPointer &insert_loc, storage::Tuple *tuple) {
-  auto &manager = catalog::Manager::GetInstance();
-  auto catalog = catalog::Catalog::GetInstance();
-  storage::Database *db = catalog->GetDatabaseWithOid(db_id);
-  PL_ASSERT(db);
-
-  auto table = db->GetTableWithOid(table_id);
-  if (!table) {
-    delete tuple;
-    return;
+cid_t WriteAheadFrontendLogger::GetNextRecoveredCommitId() {
+  if (recovered_txn_table.empty() == true) {
+    return MAX_CID;
   }
-  PL_ASSERT(table);
-
-  // FIXME Handle the case when tile_group is not created yet.
-  // table->GetTileGroupLock().WriteLock();
-  auto tile_group = manager.GetTileGroup(remove_loc.block);
-  if (tile_group == nullptr) {
-    table->AddTileGroupWithOidForRecovery(remove_loc.block);
-    tile_group = manager.GetTileGroup(remove_loc.block);
-    if (max_tg < remove_loc.block) {
-      max_tg = remove_loc.block;
-    }
-  }
-  // table->GetTileGroupLock().Unlock();
-  InsertTupleHelper(max_tg, commit_id, db_id, table_id, insert_loc, tuple,
-                    false);
-
-  tile_group->UpdateTupleFromRecovery(commit_id, remove_loc.offset, insert_loc);
+  return recovered_txn_table.begin()->first;
 }
 
 /**
- * @brief read tuple record from log file and add them tuples to recovery txn
- * @param recovery txn
+ * @brief hand the committed transaction with the lowest commit id to the
+ * replayer
  */
-void WriteAheadFrontendLogger::InsertTuple(TupleRecord *record) {
-  InsertTupleHelper(max_oid, record->GetTransactionId(),
-                    record->GetDatabaseOid(), record->GetTableId(),
-                    record->GetInsertLocation(), record->GetTuple());
+void WriteAheadFrontendLogger::ReplayNextRecoveredTransaction(
+    LogReplayer &log_replayer) {
+  PL_ASSERT(recovered_txn_table.empty() == false);
+  auto recovered_txn = recovered_txn_table.begin();
+  cid_t commit_id = recovered_txn->first;
+  log_replayer.ReplayTransaction(commit_id, recovered_txn->second);
+  max_cid = std::max(max_cid, commit_id + 1);
+  recovered_txn_table.erase(recovered_txn);
 }
 
-/**
- * @brief read tuple record from log file and add them tuples to recovery txn
- * @param recovery txn
- */
-void WriteAheadFrontendLogger::DeleteTuple(TupleRecord *record) {
-  DeleteTupleHelper(max_oid, record->GetTransactionId(),
-                    record->GetDatabaseOid(), record->GetTableId(),
-                    record->GetDeleteLocation());
-}
+void WriteAheadFrontendLogger::DoneReplay(oid_t max_tile_group_id) {
+  // After finishing recovery, set the next oid with maximum oid
+  // observed during the recovery
+  max_oid = std::max(max_oid, max_tile_group_id);
 
-/**
- * @brief read tuple record from log file and add them tuples to recovery txn
- * @param recovery txn
- */
+  // No record points into the log files anymore
+  recovery_mapped_files.clear();
 
-void WriteAheadFrontendLogger::UpdateTuple(TupleRecord *record) {
-  UpdateTupleHelper(max_oid, record->GetTransactionId(),
-                    record->GetDatabaseOid(), record->GetTableId(),
-                    record->GetDeleteLocation(), record->GetInsertLocation(),
-                    record->GetTuple());
+  auto &log_manager = logging::LogManager::GetInstance();
+  log_manager.UpdateCatalogAndTxnManagers(max_oid, max_cid);
 }
 
 //===--------------------------------------------------------------------===//
@@ -578,57 +617,46 @@ void WriteAheadFrontendLogger::UpdateTuple(TupleRecord *record) {
 //===--------------------------------------------------------------------===//
 
 LogRecordType WriteAheadFrontendLogger::GetNextLogRecordTypeForRecovery() {
-  char buffer;
-  bool is_truncated = false;
-  int ret;
-
-  if (cur_file_handle.file == nullptr || cur_file_handle.fd == -1)
-    return LOGRECORD_TYPE_INVALID;
-
   LOG_TRACE("Inside GetNextLogRecordForRecovery");
 
-  LOG_TRACE("File is at position %d", (int)ftell(cur_file_handle.file));
-
-  // Check if the log record type is broken
-  if (LoggingUtil::IsFileTruncated(cur_file_handle, 1)) {
-    LOG_TRACE("Log file is truncated, should open next log file");
-    is_truncated = true;
-  }
+  while (true) {
+    if (cur_mapped_file == nullptr) return LOGRECORD_TYPE_INVALID;
 
-  // Otherwise, read the log record type
-  if (!is_truncated) {
-    ret = fread((void *)&buffer, 1, sizeof(char), cur_file_handle.file);
-    if (ret <= 0) {
-      LOG_TRACE("Failed an fread");
-    }
-  }
-  if (is_truncated || ret <= 0) {
-    LOG_TRACE("Call OpenNextLogFile");
-    OpenNextLogFile();
-    if (cur_file_handle.fd == -1) return LOGRECORD_TYPE_INVALID;
+    LOG_TRACE("File is at position %lu", cur_mapped_file->GetOffset());
 
-    LOG_TRACE("Open succeeded. log_file_fd is %d", (int)cur_file_handle.fd);
+    // Invalid at the end of the file and behind the log data of a
+    // preallocated log file
+    LogRecordType log_record_type = cur_mapped_file->ReadRecordType();
 
-    if (LoggingUtil::IsFileTruncated(cur_file_handle, 1)) {
-      LOG_ERROR("Log file is truncated");
-      return LOGRECORD_TYPE_INVALID;
+    // The records of a compressed block are read from its decompressed log
+    // data, which stays around until they are replayed
+    if (log_record_type == LOGRECORD_TYPE_WAL_COMPRESSED_BLOCK) {
+      std::unique_ptr<MappedLogFile> block(new MappedLogFile());
+      if (cur_mapped_file != cur_log_file ||
+          cur_mapped_file->ReadCompressedBlock(*block) == false) {
+        LOG_ERROR("Log ends at a corrupt compressed block");
+        cur_mapped_file = nullptr;
+        return LOGRECORD_TYPE_INVALID;
+      }
+      cur_mapped_file = block.get();
+      recovery_mapped_files.push_back(std::move(block));
+      continue;
     }
 
-    LOG_TRACE("File is not truncated.");
-    ret = fread((void *)&buffer, 1, sizeof(char), cur_file_handle.file);
-    if (ret <= 0) {
-      LOG_ERROR("Could not read from log file");
-      return LOGRECORD_TYPE_INVALID;
+    if (log_record_type != LOGRECORD_TYPE_INVALID) {
+      return log_record_type;
     }
-    LOG_TRACE("fread succeeded.");
-  } else {
-    LOG_TRACE("fread succeeded.");
-  }
 
-  CopySerializeInput input(&buffer, sizeof(char));
-  LogRecordType log_record_type = (LogRecordType)(input.ReadByte());
+    // Continue behind the block in the log file
+    if (cur_mapped_file != cur_log_file) {
+      cur_mapped_file = cur_log_file;
+      continue;
+    }
+    LOG_TRACE("Reached the end of the log data in this file");
 
-  return log_record_type;
+    LOG_TRACE("Call OpenNextLogFile");
+    OpenNextLogFile();
+  }
 }
 
 std::string WriteAheadFrontendLogger::GetLogFileName(void) {
@@ -694,7 +722,8 @@ void WriteAheadFrontendLogger::InitLogFilesList() {
 
       if (temp_max_log_id_file == 0 || temp_max_log_id_file == UINT64_MAX ||
           temp_max_delimiter_file == 0) {
-        extracted_values = ExtractMaxLogIdAndMaxDelimFromLogFileRecords(fp);
+        extracted_values =
+            ExtractMaxLogIdAndMaxDelimFromLogFileRecords(file_name_with_dir);
 
         temp_max_log_id_file = extracted_values.first;
         temp_max_delimiter_file = extracted_values.second;
@@ -775,7 +804,6 @@ void WriteAheadFrontendLogger::CreateNewLogFile(bool close_old_file) {
   int new_file_num;
   std::string new_file_name;
   cid_t default_commit_id = INVALID_CID, default_delimiter = INVALID_CID;
-  struct stat log_stats;
 
   new_file_num = log_file_counter_;
 
@@ -784,19 +812,30 @@ void WriteAheadFrontendLogger::CreateNewLogFile(bool close_old_file) {
     LogFile *cur_log_file_object = log_files_[file_list_size - 1];
 
     if (file_list_size != 0) {
-      // TODO check return values of all these operations!
-      fseek(cur_file_handle.file, 0, SEEK_SET);
-
-      fwrite((void *)&(max_log_id_file), sizeof(max_log_id_file), 1,
-             cur_file_handle.file);
+      AppendStagedLogData();
+      cur_file_handle.size = log_writer->GetSize();
+      log_writer->Close();
+
+      // The header is written once the file is complete, through the page
+      // cache since it is smaller than a block
+      cid_t header[2] = {max_log_id_file, max_delimiter_file};
+      int header_fd =
+          open(cur_log_file_object->GetLogFileName().c_str(), O_WRONLY);
+      if (header_fd == -1 ||
+          pwrite(header_fd, header, sizeof(header), 0) != sizeof(header) ||
+          fdatasync(header_fd) != 0) {
+        LOG_ERROR("Could not write header of log file %s: %s",
+                  cur_log_file_object->GetLogFileName().c_str(),
+                  strerror(errno));
+      }
+      if (header_fd != -1) {
+        close(header_fd);
+      }
 
       cur_log_file_object->SetMaxLogId(max_log_id_file);
 
       LOG_TRACE("MaxLogID of the last closed file is %d", (int)max_log_id_file);
 
-      fwrite((void *)&(max_delimiter_file), sizeof(max_delimiter_file), 1,
-             cur_file_handle.file);
-
       cur_log_file_object->SetMaxDelimiter(max_delimiter_file);
 
       LOG_TRACE("MaxDelimiter of the last closed file is %d",
@@ -805,17 +844,11 @@ void WriteAheadFrontendLogger::CreateNewLogFile(bool close_old_file) {
       max_log_id_file = 0;     // reset
       max_delimiter_file = 0;  // reset
 
-      fstat(cur_file_handle.fd, &log_stats);
-
-      cur_file_handle.size = log_stats.st_size;
-
       LOG_TRACE("The log file to be closed has size %d",
                 (int)cur_file_handle.size);
 
       cur_log_file_object->SetLogFileSize(cur_file_handle.size);
 
-      fclose(cur_file_handle.file);
-
       cur_log_file_object->SetFilePtr(nullptr);  // invalidate
       cur_log_file_object->SetLogFileFD(-1);     // invalidate
     }
@@ -825,23 +858,20 @@ void WriteAheadFrontendLogger::CreateNewLogFile(bool close_old_file) {
 
   new_file_name = this->GetFileNameFromVersion(new_file_num);
 
-  FILE *new_log_file = fopen(new_file_name.c_str(), "wb");
-
-  if (new_log_file == NULL) {
+  if (log_segment_pool->AcquireSegment(new_file_name) == false ||
+      log_writer->Open(new_file_name) == false) {
     LOG_ERROR("new_log_file is NULL");
     return;
   }
 
   // now set the first 8 bytes to 0 - this is for the max_log id in this file
-  fwrite((void *)&default_commit_id, sizeof(default_commit_id), 1,
-         new_log_file);
+  log_writer->Append((char *)&default_commit_id, sizeof(default_commit_id));
 
   // now set the next 8 bytes to 0 - this is for the max delimiter in this file
-  fwrite((void *)&default_delimiter, sizeof(default_delimiter), 1,
-         new_log_file);
+  log_writer->Append((char *)&default_delimiter, sizeof(default_delimiter));
 
-  cur_file_handle.file = new_log_file;
-  cur_file_handle.fd = fileno(cur_file_handle.file);
+  cur_file_handle.file = nullptr;
+  cur_file_handle.fd = log_writer->GetFD();
   cur_file_handle.size = 0;
 
   if (cur_file_handle.fd == -1) {
@@ -861,11 +891,10 @@ void WriteAheadFrontendLogger::CreateNewLogFile(bool close_old_file) {
 }
 
 bool WriteAheadFrontendLogger::FileSwitchCondIsTrue() {
-  struct stat stat_buf;
   if (cur_file_handle.fd == -1) return false;
 
-  fstat(cur_file_handle.fd, &stat_buf);
-  cur_file_handle.size = stat_buf.st_size;
+  // Preallocated files are larger than the log data they hold
+  cur_file_handle.size = log_writer->GetSize() + staged_log_data.size();
 
   return cur_file_handle.size >
          LogManager::GetInstance().GetLogFileSizeLimit() * 1024;
@@ -874,90 +903,65 @@ bool WriteAheadFrontendLogger::FileSwitchCondIsTrue() {
 void WriteAheadFrontendLogger::OpenNextLogFile() {
   cid_t temp_max_log_id_file, temp_max_delimiter_file;
 
+  cur_mapped_file = nullptr;
+  cur_log_file = nullptr;
+
   if (log_files_.size() == 0) {  // no log files, fresh start
     LOG_TRACE("Size of log files list is 0.");
-    cur_file_handle = INVALID_FILE_HANDLE;
     return;
   }
 
   if (this->log_file_cursor_ >= (int)this->log_files_.size()) {
     LOG_TRACE("Cursor has reached the end. No more log files to read from.");
-    fclose(cur_file_handle.file);
-    cur_file_handle = INVALID_FILE_HANDLE;
     return;
   }
 
-  if (log_file_cursor_ != 0)  // close old file
-  {
-    LOG_TRACE("Closing last opened file");
-    fclose(cur_file_handle.file);
-  }
-
-  // open the next file
-  cur_file_handle.file =
-      fopen(GetFileNameFromVersion(log_files_[log_file_cursor_]->GetLogNumber())
-                .c_str(),
-            "rb");
-
-  if (cur_file_handle.file == NULL) {
+  // map the next file, it stays mapped until its records are replayed
+  std::string file_name =
+      GetFileNameFromVersion(log_files_[log_file_cursor_]->GetLogNumber());
+  std::unique_ptr<MappedLogFile> mapped_file(new MappedLogFile());
+  if (mapped_file->Open(file_name) == false) {
     LOG_ERROR("Couldn't open next log file");
-    cur_file_handle = INVALID_FILE_HANDLE;
     return;
   } else {
     LOG_TRACE("Opened new log file for recovery");
   }
 
-  cur_file_handle.fd = fileno(cur_file_handle.file);
-
-  LOG_TRACE("FD of opened file is %d", (int)cur_file_handle.fd);
-
-  // Skip first 8 bytes of max commit id
-  size_t read_size =
-      fread((void *)&temp_max_log_id_file, sizeof(temp_max_log_id_file), 1,
-            cur_file_handle.file);
-  if (read_size != 1) {
-    LOG_ERROR("Read failed after opening file %s",
-              GetFileNameFromVersion(
-                  log_files_[log_file_cursor_]->GetLogNumber()).c_str());
-  }
-
-  LOG_TRACE("On startup: MaxLogId of this file is %d",
-            (int)temp_max_log_id_file);
-
-  // Skip next 8 bytes of max delimiter
-  read_size = fread((void *)&temp_max_delimiter_file,
-                    sizeof(temp_max_delimiter_file), 1, cur_file_handle.file);
-
-  if (read_size != 1) {
-    LOG_ERROR("Read failed after opening file %s",
-              GetFileNameFromVersion(
-                  log_files_[log_file_cursor_]->GetLogNumber()).c_str());
+  // Skip first 8 bytes of max commit id and next 8 bytes of max delimiter
+  size_t header_size =
+      sizeof(temp_max_log_id_file) + sizeof(temp_max_delimiter_file);
+  if (mapped_file->GetSize() < header_size) {
+    LOG_ERROR("Read failed after opening file %s", file_name.c_str());
+    mapped_file->Seek(mapped_file->GetSize());
+  } else {
+    PL_MEMCPY(&temp_max_log_id_file, mapped_file->GetData(),
+              sizeof(temp_max_log_id_file));
+    PL_MEMCPY(&temp_max_delimiter_file,
+              mapped_file->GetData() + sizeof(temp_max_log_id_file),
+              sizeof(temp_max_delimiter_file));
+
+    LOG_TRACE("On startup: MaxLogId of this file is %d",
+              (int)temp_max_log_id_file);
+    LOG_TRACE("On startup: MaxDelimiter of this file is %d",
+              (int)temp_max_delimiter_file);
+
+    mapped_file->Seek(header_size);
   }
 
-  LOG_TRACE("On startup: MaxDelimiter of this file is %d",
-            (int)temp_max_delimiter_file);
-
-  struct stat stat_buf;
-
-  fstat(cur_file_handle.fd, &stat_buf);
-  cur_file_handle.size = stat_buf.st_size;
+  cur_mapped_file = mapped_file.get();
+  cur_log_file = mapped_file.get();
+  recovery_mapped_files.push_back(std::move(mapped_file));
 
   log_file_cursor_++;
   LOG_TRACE("Cursor is now %d", (int)log_file_cursor_);
 }
 
 void WriteAheadFrontendLogger::TruncateLog(cid_t truncate_log_id) {
-  int return_val;
-
   // delete stale log files except the one currently being used
   for (int i = 0; i < (int)log_files_.size() - 1; i++) {
     if (truncate_log_id >= log_files_[i]->GetMaxLogId()) {
-      // XXX Do we need directory prefix before log file name?
-      return_val = remove(log_files_[i]->GetLogFileName().c_str());
-      if (return_val != 0) {
-        LOG_ERROR("Couldn't delete log file: %s error: %s",
-                  log_files_[i]->GetLogFileName().c_str(), strerror(errno));
-      }
+      // Keep the file as a preallocated segment for the next log file
+      log_segment_pool->RecycleSegment(log_files_[i]->GetLogFileName());
       // remove entry from list anyway
       delete log_files_[i];
       log_files_.erase(log_files_.begin() + i);
@@ -970,7 +974,12 @@ void WriteAheadFrontendLogger::InitLogDirectory() {
   // Get log directory
   auto &log_manager = logging::LogManager::GetInstance();
   peloton_log_directory =
-      log_manager.GetLogDirectoryName() + wal_directory_path;
+      log_manager.GetLogStreamDirectoryName(logger_id) + wal_directory_path;
+
+  // every stream has its own log files, also when they share a directory
+  if (logger_id != 0) {
+    peloton_log_directory += "_" + std::to_string(logger_id);
+  }
 
   auto success =
       LoggingUtil::CreateDirectory(peloton_log_directory.c_str(), 0700);
@@ -988,37 +997,52 @@ std::string WriteAheadFrontendLogger::GetFileNameFromVersion(int version) {
 
 std::pair<cid_t, cid_t>
 WriteAheadFrontendLogger::ExtractMaxLogIdAndMaxDelimFromLogFileRecords(
-    FILE *log_file) {
-  bool reached_end_of_file = false;
-  struct stat log_stats;
+    const std::string &file_name) {
   cid_t max_log_id_so_far = 0, max_delim_so_far = 0;
-  FileHandle file_handle;
+  MappedLogFile mapped_file;
 
-  file_handle.file = log_file;
-  file_handle.fd = fileno(log_file);
+  if (mapped_file.Open(file_name) == false) {
+    return std::pair<cid_t, cid_t>(UINT64_MAX, UINT64_MAX);
+  }
+
+  // Skip the max commit id and max delimiter of the file header
+  mapped_file.Seek(std::min(mapped_file.GetSize(), 2 * sizeof(cid_t)));
+
+  if (ExtractMaxLogIdAndMaxDelimFromLogRecords(mapped_file, max_log_id_so_far,
+                                               max_delim_so_far) == false) {
+    return std::pair<cid_t, cid_t>(UINT64_MAX, UINT64_MAX);
+  }
+  return std::pair<cid_t, cid_t>(max_log_id_so_far, max_delim_so_far);
+}
 
-  fstat(file_handle.fd, &log_stats);
-  file_handle.size = log_stats.st_size;
+bool WriteAheadFrontendLogger::ExtractMaxLogIdAndMaxDelimFromLogRecords(
+    MappedLogFile &log_data, cid_t &max_log_id_so_far,
+    cid_t &max_delim_so_far) {
+  bool reached_end_of_file = false;
+  const char *frame;
+  size_t frame_size;
 
   while (reached_end_of_file == false) {
     // Read the first byte to identify log record type
     // If that is not possible, then wrap up recovery
-    auto record_type = LoggingUtil::GetNextLogRecordType(file_handle);
+    auto record_type = log_data.ReadRecordType();
+    size_t record_offset = log_data.GetOffset() - 1;
 
     cid_t commit_id = INVALID_CID;
 
-    TupleRecord *tuple_record;
-
     switch (record_type) {
       case LOGRECORD_TYPE_TRANSACTION_BEGIN:
       case LOGRECORD_TYPE_TRANSACTION_COMMIT:
       case LOGRECORD_TYPE_ITERATION_DELIMITER: {
         // Check for torn log write
-        TransactionRecord txn_rec(record_type);
-        if (LoggingUtil::ReadTransactionRecordHeader(txn_rec, file_handle) ==
-            false) {
-          return std::pair<cid_t, cid_t>(UINT64_MAX, UINT64_MAX);
+        if (log_data.ReadFrame(frame, frame_size) == false ||
+            log_data.ReadChecksum(record_offset) == false) {
+          return false;
         }
+        TransactionRecord txn_rec(record_type);
+        ReferenceSerializeInput txn_header(frame, frame_size);
+        txn_rec.Deserialize(txn_header);
+
         commit_id = txn_rec.GetTransactionId();
         if (commit_id > max_log_id_so_far) max_log_id_so_far = commit_id;
 
@@ -1028,48 +1052,45 @@ WriteAheadFrontendLogger::ExtractMaxLogIdAndMaxDelimFromLogFileRecords(
         break;
       }
       case LOGRECORD_TYPE_WAL_TUPLE_INSERT:
-      case LOGRECORD_TYPE_WAL_TUPLE_UPDATE: {
-        tuple_record = new TupleRecord(record_type);
-
-        if (LoggingUtil::ReadTupleRecordHeader(*tuple_record, file_handle) ==
-            false) {
+      case LOGRECORD_TYPE_WAL_TUPLE_UPDATE:
+      case LOGRECORD_TYPE_WAL_TUPLE_DELETE: {
+        if (log_data.ReadFrame(frame, frame_size) == false) {
           LOG_ERROR("Could not read tuple record header.");
-          delete tuple_record;
-          return std::pair<cid_t, cid_t>(UINT64_MAX, UINT64_MAX);
+          return false;
         }
 
-        auto cid = tuple_record->GetTransactionId();
-
-        if (cid > max_log_id_so_far) max_log_id_so_far = cid;
-
-        auto table = LoggingUtil::GetTable(*tuple_record);
-        if (!table) {
-          LoggingUtil::SkipTupleRecordBody(file_handle);
-          delete tuple_record;
-          continue;
+        // Step over the tuple record body
+        const char *body_frame;
+        size_t body_frame_size;
+        if (record_type != LOGRECORD_TYPE_WAL_TUPLE_DELETE &&
+            log_data.ReadFrame(body_frame, body_frame_size) == false) {
+          LOG_ERROR("Could not read tuple record body.");
+          return false;
+        }
+        if (log_data.ReadChecksum(record_offset) == false) {
+          LOG_ERROR("Checksum mismatch in tuple record.");
+          return false;
         }
 
-        // Read off the tuple record body from the log
-        auto record_body = LoggingUtil::ReadTupleRecordBody(
-            table->GetSchema(), recovery_pool, file_handle);
-        delete tuple_record;
-        delete record_body;
+        TupleRecord tuple_record(record_type);
+        ReferenceSerializeInput tuple_header(frame, frame_size);
+        tuple_record.DeserializeHeader(tuple_header);
 
+        auto cid = tuple_record.GetTransactionId();
+
+        if (cid > max_log_id_so_far) max_log_id_so_far = cid;
         break;
       }
-      case LOGRECORD_TYPE_WAL_TUPLE_DELETE: {
-        tuple_record = new TupleRecord(record_type);
-
-        if (LoggingUtil::ReadTupleRecordHeader(*tuple_record, file_handle) ==
-            false) {
-          delete tuple_record;
-          return std::pair<cid_t, cid_t>(UINT64_MAX, UINT64_MAX);
+      case LOGRECORD_TYPE_WAL_COMPRESSED_BLOCK: {
+        MappedLogFile block;
+        if (log_data.ReadCompressedBlock(block) == false) {
+          LOG_ERROR("Could not read compressed block.");
+          return false;
+        }
+        if (ExtractMaxLogIdAndMaxDelimFromLogRecords(
+                block, max_log_id_so_far, max_delim_so_far) == false) {
+          return false;
         }
-
-        auto cid = tuple_record->GetTransactionId();
-
-        if (cid > max_log_id_so_far) max_log_id_so_far = cid;
-        delete tuple_record;
         break;
       }
       default:
@@ -1077,13 +1098,10 @@ WriteAheadFrontendLogger::ExtractMaxLogIdAndMaxDelimFromLogFileRecords(
         break;
     }
   }
-  return std::pair<cid_t, cid_t>(max_log_id_so_far, max_delim_so_far);
+  return true;
 }
 
-void WriteAheadFrontendLogger::SetLoggerID(int id) {
-  logger_id = id;
-  peloton_log_directory += std::to_string(id);
-}
+void WriteAheadFrontendLogger::SetLoggerID(int id) { logger_id = id; }
 
 void WriteAheadFrontendLogger::UpdateMaxDelimiterForRecovery() {
   // this method must update the max delimiter id to be used for recovery
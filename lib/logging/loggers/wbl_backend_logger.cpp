@@ -25,7 +25,7 @@ namespace peloton {
 namespace logging {
 
 void WriteBehindBackendLogger::Log(LogRecord *record) {
-  // if we are committing, sync all data before taking the lock
+  // if we are committing, sync all data before publishing the commit
   if (record->GetType() == LOGRECORD_TYPE_TRANSACTION_COMMIT) {
     auto &log_manager = LogManager::GetInstance();
     auto no_write = log_manager.GetNoWrite();
@@ -34,7 +34,6 @@ void WriteBehindBackendLogger::Log(LogRecord *record) {
       SyncDataForCommit();
     }
   }
-  log_buffer_lock.Lock();
   switch (record->GetType()) {
     case LOGRECORD_TYPE_TRANSACTION_COMMIT:
       highest_logged_commit_message = record->GetTransactionId();
@@ -72,8 +71,6 @@ void WriteBehindBackendLogger::Log(LogRecord *record) {
       LOG_INFO("Invalid log record type");
       break;
   }
-
-  log_buffer_lock.Unlock();
 }
 
 void WriteBehindBackendLogger::SyncDataForCommit() {
@@ -16,6 +16,7 @@
 #include <cstring>
 
 #include "catalog/catalog.h"
+#include "common/crc32c.h"
 #include "storage/database.h"
 #include "type/types.h"
 
@@ -305,6 +306,33 @@ void LoggingUtil::SkipTupleRecordBody(FileHandle &file_handle) {
   CopySerializeInput tuple_body(body, body_size);
 }
 
+/**
+ * @brief Read the checksum closing a record and check it against the record
+ * @param file_handle positioned behind the frames of the record
+ * @param log_record_type type byte in front of the frames
+ * @param frames the frames of the record as read from the file
+ * @return false if the checksum is cut off or does not match
+ */
+bool LoggingUtil::ReadRecordChecksum(FileHandle &file_handle,
+                                     LogRecordType log_record_type,
+                                     const char *frames, size_t frames_size) {
+  uint32_t checksum;
+  if (IsFileTruncated(file_handle, sizeof(checksum))) {
+    return false;
+  }
+
+  if (fread(&checksum, 1, sizeof(checksum), file_handle.file) !=
+      sizeof(checksum)) {
+    LOG_ERROR("Error occured in fread ");
+    return false;
+  }
+
+  char record_type = static_cast<char>(log_record_type);
+  uint32_t record_checksum = Crc32c::Value(&record_type, sizeof(record_type));
+  record_checksum = Crc32c::Extend(record_checksum, frames, frames_size);
+  return checksum == record_checksum;
+}
+
 // Wrappers
 storage::DataTable *LoggingUtil::GetTable(TupleRecord &tuple_record) {
   // Get db, table, schema to insert tuple
@@ -0,0 +1,152 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// mapped_log_file.cpp
+//
+// Identification: src/logging/mapped_log_file.cpp
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "logging/mapped_log_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+#include "common/crc32c.h"
+#include "common/logger.h"
+#include "common/macros.h"
+#include "logging/log_compressor.h"
+
+namespace peloton {
+namespace logging {
+
+MappedLogFile::~MappedLogFile() { Close(); }
+
+bool MappedLogFile::Open(const std::string &file_name) {
+  Close();
+
+  int fd = open(file_name.c_str(), O_RDONLY);
+  if (fd == -1) {
+    LOG_ERROR("Could not open log file %s: %s", file_name.c_str(),
+              strerror(errno));
+    return false;
+  }
+
+  struct stat file_stats;
+  if (fstat(fd, &file_stats) != 0) {
+    LOG_ERROR("Could not stat log file %s: %s", file_name.c_str(),
+              strerror(errno));
+    close(fd);
+    return false;
+  }
+
+  // Nothing to map in an empty file
+  if (file_stats.st_size == 0) {
+    close(fd);
+    return true;
+  }
+
+  void *data = mmap(nullptr, file_stats.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    LOG_ERROR("Could not map log file %s: %s", file_name.c_str(),
+              strerror(errno));
+    return false;
+  }
+
+  // The file is parsed front to back exactly once
+  madvise(data, file_stats.st_size, MADV_SEQUENTIAL);
+  madvise(data, file_stats.st_size, MADV_WILLNEED);
+
+  data_ = reinterpret_cast<const char *>(data);
+  size_ = file_stats.st_size;
+  return true;
+}
+
+void MappedLogFile::Close() {
+  if (data_ != nullptr && block_data_.empty() == true) {
+    munmap(const_cast<char *>(data_), size_);
+  }
+  block_data_.clear();
+
+  data_ = nullptr;
+  size_ = 0;
+  offset_ = 0;
+}
+
+LogRecordType MappedLogFile::ReadRecordType() {
+  if (offset_ >= size_) {
+    return LOGRECORD_TYPE_INVALID;
+  }
+
+  // Preallocated log files are zero behind the log data
+  LogRecordType record_type = (LogRecordType)((int8_t)data_[offset_]);
+  if (record_type != LOGRECORD_TYPE_INVALID) {
+    offset_++;
+  }
+  return record_type;
+}
+
+bool MappedLogFile::ReadFrame(const char *&frame, size_t &frame_size) {
+  int32_t frame_length;
+  if (offset_ > size_ || size_ - offset_ < sizeof(frame_length)) {
+    return false;
+  }
+  PL_MEMCPY(&frame_length, data_ + offset_, sizeof(frame_length));
+
+  if (frame_length < 0 ||
+      size_ - offset_ - sizeof(frame_length) < (size_t)frame_length) {
+    return false;
+  }
+
+  frame = data_ + offset_;
+  frame_size = sizeof(frame_length) + frame_length;
+  offset_ += frame_size;
+  return true;
+}
+
+bool MappedLogFile::ReadChecksum(size_t record_offset) {
+  uint32_t checksum;
+  if (offset_ > size_ || size_ - offset_ < sizeof(checksum) ||
+      record_offset > offset_) {
+    return false;
+  }
+  PL_MEMCPY(&checksum, data_ + offset_, sizeof(checksum));
+
+  uint32_t record_checksum =
+      Crc32c::Value(data_ + record_offset, offset_ - record_offset);
+  offset_ += sizeof(checksum);
+  return checksum == record_checksum;
+}
+
+bool MappedLogFile::ReadCompressedBlock(MappedLogFile &block) {
+  size_t record_offset = offset_ - sizeof(char);
+  const char *frame;
+  size_t frame_size;
+  if (ReadFrame(frame, frame_size) == false ||
+      ReadChecksum(record_offset) == false) {
+    return false;
+  }
+
+  block.Close();
+  if (LogCompressor::DecompressFrame(frame, frame_size, block.block_data_) ==
+          false ||
+      block.block_data_.empty() == true) {
+    block.Close();
+    return false;
+  }
+
+  block.data_ = block.block_data_.data();
+  block.size_ = block.block_data_.size();
+  return true;
+}
+
+}  // namespace logging
+}  // namespace peloton
@@ -40,6 +40,8 @@ bool TransactionRecord::Serialize(CopySerializeOutput &output) {
       static_cast<int32_t>(output.Position() - start - sizeof(int32_t));
   output.WriteIntAt(start, header_length);
 
+  WriteChecksum(output);
+
   message_length = output.Size();
   message = new char[message_length];
   PL_MEMCPY(message, output.Data(), message_length);
@@ -51,7 +53,7 @@ bool TransactionRecord::Serialize(CopySerializeOutput &output) {
  * @brief Deserialize LogRecordHeader
  * @param input
  */
-void TransactionRecord::Deserialize(CopySerializeInput &input) {
+void TransactionRecord::Deserialize(SerializeInput &input) {
   // Get the message length
   input.ReadInt();
 
@@ -61,8 +63,8 @@ void TransactionRecord::Deserialize(CopySerializeInput &input) {
 
 // Used for peloton logging
 size_t TransactionRecord::GetTransactionRecordSize(void) {
-  // log_record_type + header_legnth + transaction_id
-  return sizeof(char) + sizeof(int) + sizeof(long);
+  // log_record_type + header_legnth + transaction_id + checksum
+  return sizeof(char) + sizeof(int) + sizeof(long) + sizeof(uint32_t);
 }
 
 const std::string TransactionRecord::GetInfo() const {
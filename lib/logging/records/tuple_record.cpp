@@ -56,6 +56,8 @@ bool TupleRecord::Serialize(CopySerializeOutput &output) {
     }
   }
 
+  WriteChecksum(output);
+
   message_length = output.Size();
   message = new char[message_length];
   PL_MEMCPY(message, output.Data(), message_length);
@@ -91,7 +93,7 @@ void TupleRecord::SerializeHeader(CopySerializeOutput &output) {
  * @brief Deserialize LogRecordHeader
  * @param input
  */
-void TupleRecord::DeserializeHeader(CopySerializeInput &input) {
+void TupleRecord::DeserializeHeader(SerializeInput &input) {
   input.ReadInt();
   db_oid = (oid_t)(input.ReadLong());
   table_oid = (oid_t)(input.ReadLong());
@@ -106,9 +108,9 @@ void TupleRecord::DeserializeHeader(CopySerializeInput &input) {
 // Used for write behind logging
 size_t TupleRecord::GetTupleRecordSize(void) {
   // log_record_type + header_legnth + db_oid + table_oid + txn_id +
-  // insert_location + delete_location
+  // insert_location + delete_location + checksum
   return sizeof(char) + sizeof(int) + sizeof(oid_t) + sizeof(oid_t) +
-         sizeof(txn_id_t) + sizeof(ItemPointer) * 2;
+         sizeof(txn_id_t) + sizeof(ItemPointer) * 2 + sizeof(uint32_t);
 }
 
 void TupleRecord::SetTuple(storage::Tuple *tuple) { this->tuple = tuple; }
@@ -65,7 +65,19 @@ column_map_type AbstractTable::GetTileGroupLayout(
 
 TileGroup *AbstractTable::GetTileGroupWithLayout(
     oid_t database_id, oid_t tile_group_id, const column_map_type &partitioning,
-    const size_t num_tuples) {
+    const size_t num_tuples, const int numa_node) {
+  std::vector<catalog::Schema> schemas = GetTileSchemas(partitioning);
+
+  TileGroup *tile_group =
+      TileGroupFactory::GetTileGroup(database_id, GetOid(), tile_group_id, this,
+                                     schemas, partitioning, num_tuples,
+                                     numa_node);
+
+  return tile_group;
+}
+
+std::vector<catalog::Schema> AbstractTable::GetTileSchemas(
+    const column_map_type &partitioning) const {
   std::vector<catalog::Schema> schemas;
 
   // Figure out the columns in each tile in new layout
@@ -84,11 +96,7 @@ TileGroup *AbstractTable::GetTileGroupWithLayout(
     schemas.push_back(tile_schema);
   }
 
-  TileGroup *tile_group =
-      TileGroupFactory::GetTileGroup(database_id, GetOid(), tile_group_id, this,
-                                     schemas, partitioning, num_tuples);
-
-  return tile_group;
+  return schemas;
 }
 
 const std::string AbstractTable::GetInfo() const {
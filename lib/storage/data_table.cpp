@@ -10,6 +10,8 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+#include <memory>
 #include <mutex>
 #include <utility>
 
@@ -18,12 +20,20 @@
 #include "common/exception.h"
 #include "common/exception.h"
 #include "common/logger.h"
+#include "common/init.h"
+#include "common/numa_util.h"
 #include "common/platform.h"
+#include "common/pmem_util.h"
+#include "common/thread_pool.h"
+#include "concurrency/epoch_manager.h"
 #include "storage/abstract_table.h"
 #include "storage/data_table.h"
 #include "storage/database.h"
+#include "storage/persistent_heap.h"
+#include "storage/storage_manager.h"
 #include "storage/tile.h"
 #include "storage/tile_group.h"
+#include "storage/tile_group_compactor.h"
 #include "storage/tile_group_factory.h"
 #include "storage/tile_group_header.h"
 #include "storage/tuple.h"
@@ -45,6 +55,7 @@ oid_t DataTable::invalid_tile_group_id = -1;
 
 size_t DataTable::default_active_tilegroup_count_ = 1;
 size_t DataTable::default_active_indirection_array_count_ = 1;
+double DataTable::spare_tile_group_threshold_ = 0.75;
 
 DataTable::DataTable(catalog::Schema *schema, const std::string &table_name,
                      const oid_t &database_oid, const oid_t &table_oid,
@@ -64,16 +75,25 @@ DataTable::DataTable(catalog::Schema *schema, const std::string &table_name,
   if (is_catalog == true) {
     active_tilegroup_count_ = 1;
     active_indirection_array_count_ = 1;
+    numa_node_count_ = 1;
   } else {
     active_tilegroup_count_ = default_active_tilegroup_count_;
     active_indirection_array_count_ = default_active_indirection_array_count_;
+    numa_node_count_ = NumaUtil::GetNodeCount();
   }
 
-  active_tile_groups_.resize(active_tilegroup_count_);
+  active_tile_groups_.resize(active_tilegroup_count_ * numa_node_count_);
+  spare_tile_groups_.resize(active_tile_groups_.size());
+  spare_tile_group_requests_.reset(
+      new std::atomic<oid_t>[active_tile_groups_.size()]);
+  for (size_t i = 0; i < active_tile_groups_.size(); ++i) {
+    spare_tile_group_requests_[i] = INVALID_OID;
+  }
+  spare_tile_group_tasks_.reset(new TaskGroup(thread_pool));
 
   active_indirection_arrays_.resize(active_indirection_array_count_);
-  // Create tile groups.
-  for (size_t i = 0; i < active_tilegroup_count_; ++i) {
+  // Create tile groups, each node gets its own set
+  for (size_t i = 0; i < active_tile_groups_.size(); ++i) {
     AddDefaultTileGroup(i);
   }
 
@@ -84,6 +104,12 @@ DataTable::DataTable(catalog::Schema *schema, const std::string &table_name,
 }
 
 DataTable::~DataTable() {
+  // no compaction round may reach the table anymore
+  TileGroupCompactor::GetInstance().RemoveTable(this);
+
+  // wait for spare tile groups still being built
+  spare_tile_group_tasks_.reset();
+
   // clean up tile groups by dropping the references in the catalog
   auto &catalog_manager = catalog::Manager::GetInstance();
   auto tile_groups_size = tile_groups_.GetSize();
@@ -157,21 +183,39 @@ bool DataTable::CheckConstraints(const storage::Tuple *tuple) const {
 // however, when performing insert, we have to copy data immediately,
 // and the argument cannot be set to nullptr.
 ItemPointer DataTable::GetEmptyTupleSlot(const storage::Tuple *tuple) {
- /* //=============== garbage collection==================
+  // Compaction waits for the epoch to pass before it looks at the slots of a
+  // sealed tile group. The slot is claimed before the guard goes away, so it
+  // never reads as an empty one.
+  concurrency::EpochGuard epoch_guard;
+
   // check if there are recycled tuple slots
-  auto free_item_pointer = gc_manager.ReturnFreeSlot(this->table_oid);
-  if (free_item_pointer.IsNull() == false) {
+  while (true) {
+    auto free_item_pointer = free_slot_manager_.GetFreeSlot();
+    if (free_item_pointer.IsNull() == true) {
+      break;
+    }
+
+    // tile groups dropped or sealed in the meantime take their slots with
+    // them
+    auto tile_group =
+        catalog::Manager::GetInstance().GetTileGroup(free_item_pointer.block);
+    if (tile_group == nullptr || tile_group->GetHeader()->IsSealed() == true) {
+      continue;
+    }
+
+    tile_group->GetHeader()->ReclaimTupleSlot(free_item_pointer.offset);
+
     // when inserting a tuple
     if (tuple != nullptr) {
-      auto tile_group =
-          catalog::Manager::GetInstance().GetTileGroup(free_item_pointer.block);
       tile_group->CopyTuple(tuple, free_item_pointer.offset);
     }
+
+    tile_group->GetHeader()->SetTransactionId(free_item_pointer.offset,
+                                              CLAIMED_TXN_ID);
     return free_item_pointer;
   }
-  //====================================================
-*/
-  size_t active_tile_group_id = number_of_tuples_ % active_tilegroup_count_;
+
+  size_t active_tile_group_id = GetActiveTileGroupId();
   std::shared_ptr<storage::TileGroup> tile_group;
   oid_t tuple_slot = INVALID_OID;
   oid_t tile_group_id = INVALID_OID;
@@ -179,7 +223,7 @@ ItemPointer DataTable::GetEmptyTupleSlot(const storage::Tuple *tuple) {
   // get valid tuple.
   while (true) {
     // get the last tile group.
-    tile_group = active_tile_groups_[active_tile_group_id];
+    tile_group = std::atomic_load(&active_tile_groups_[active_tile_group_id]);
 
     tuple_slot = tile_group->InsertTuple(tuple);
 
@@ -190,10 +234,23 @@ ItemPointer DataTable::GetEmptyTupleSlot(const storage::Tuple *tuple) {
     }
   }
 
+  tile_group->GetHeader()->SetTransactionId(tuple_slot, CLAIMED_TXN_ID);
+
+  oid_t last_tuple_slot = tile_group->GetAllocatedTupleCount() - 1;
+
+  // past the threshold, build the next tile group while this one still
+  // takes inserts. Slots are claimed in chunks, so the threshold slot itself
+  // may sit unused in the chunk of another thread.
+  oid_t spare_tuple_slot = static_cast<oid_t>(
+      tile_group->GetAllocatedTupleCount() * spare_tile_group_threshold_);
+  if (tuple_slot >= spare_tuple_slot && spare_tuple_slot < last_tuple_slot) {
+    ProvisionSpareTileGroup(active_tile_group_id, tile_group_id);
+  }
+
   // if this is the last tuple slot we can get
-  // then create a new tile group
-  if (tuple_slot == tile_group->GetAllocatedTupleCount() - 1) {
-    AddDefaultTileGroup(active_tile_group_id);
+  // then swap in the next tile group
+  if (tuple_slot == last_tuple_slot) {
+    ReplaceActiveTileGroup(active_tile_group_id, tile_group);
   }
 
   LOG_TRACE("tile group count: %lu, tile group id: %u, address: %p",
@@ -206,6 +263,17 @@ ItemPointer DataTable::GetEmptyTupleSlot(const storage::Tuple *tuple) {
   return location;
 }
 
+size_t DataTable::GetActiveTileGroupId() const {
+  // Threads stick to their own active tile group
+  size_t active_tile_group_id = GetThreadIndex() % active_tilegroup_count_;
+  if (numa_node_count_ == 1) {
+    return active_tile_group_id;
+  }
+
+  size_t numa_node = NumaUtil::GetCurrentNode() % numa_node_count_;
+  return numa_node * active_tilegroup_count_ + active_tile_group_id;
+}
+
 //===--------------------------------------------------------------------===//
 // INSERT
 //===--------------------------------------------------------------------===//
@@ -284,6 +352,16 @@ ItemPointer DataTable::InsertTuple(const storage::Tuple *tuple) {
   return location;
 }
 
+void DataTable::RetireTupleSlot(const ItemPointer &location) {
+  LOG_TRACE("Retired slot: %u, %u", location.block, location.offset);
+  free_slot_manager_.RetireSlot(location);
+}
+
+void DataTable::ReleaseTupleSlot(const ItemPointer &location) {
+  LOG_TRACE("Released slot: %u, %u", location.block, location.offset);
+  free_slot_manager_.ReleaseSlot(location);
+}
+
 //===--------------------------------------------------------------------===//
 // STATS
 //===--------------------------------------------------------------------===//
@@ -293,8 +371,8 @@ ItemPointer DataTable::InsertTuple(const storage::Tuple *tuple) {
  * @param amount amount to increase
  */
 void DataTable::IncreaseTupleCount(const size_t &amount) {
-  number_of_tuples_ += amount;
-  dirty_ = true;
+  number_of_tuples_.Add(amount);
+  SetDirty();
 }
 
 /**
@@ -302,8 +380,8 @@ void DataTable::IncreaseTupleCount(const size_t &amount) {
  * @param amount amount to decrease
  */
 void DataTable::DecreaseTupleCount(const size_t &amount) {
-  number_of_tuples_ -= amount;
-  dirty_ = true;
+  number_of_tuples_.Sub(amount);
+  SetDirty();
 }
 
 /**
@@ -311,36 +389,55 @@ void DataTable::DecreaseTupleCount(const size_t &amount) {
  * @param num_tuples number of tuples
  */
 void DataTable::SetTupleCount(const size_t &num_tuples) {
-  number_of_tuples_ = num_tuples;
-  dirty_ = true;
+  number_of_tuples_.Set(num_tuples);
+  SetDirty();
 }
 
 /**
  * @brief Get the number of tuples in this table
  * @return number of tuples
  */
-size_t DataTable::GetTupleCount() const { return number_of_tuples_; }
+size_t DataTable::GetTupleCount() const {
+  // Shards may be summed while a decrease is counted before its increase
+  int64_t num_tuples = number_of_tuples_.Get();
+  return (num_tuples > 0) ? num_tuples : 0;
+}
 
 /**
  * @brief return dirty flag
  * @return dirty flag
  */
-bool DataTable::IsDirty() const { return dirty_; }
+bool DataTable::IsDirty() const {
+  return dirty_.load(std::memory_order_relaxed);
+}
 
 /**
  * @brief Reset dirty flag
  */
-void DataTable::ResetDirty() { dirty_ = false; }
+void DataTable::ResetDirty() {
+  dirty_.store(false, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Set dirty flag, the cache line is only written once after a reset
+ */
+void DataTable::SetDirty() {
+  if (dirty_.load(std::memory_order_relaxed) == false) {
+    dirty_.store(true, std::memory_order_relaxed);
+  }
+}
 
 //===--------------------------------------------------------------------===//
 // TILE GROUP
 //===--------------------------------------------------------------------===//
 
 TileGroup *DataTable::GetTileGroupWithLayout(
-    const column_map_type &partitioning) {
+    const column_map_type &partitioning, const int numa_node) {
   oid_t tile_group_id = catalog::Manager::GetInstance().GetNextTileGroupId();
-  return (AbstractTable::GetTileGroupWithLayout(
-      database_oid, tile_group_id, partitioning, tuples_per_tilegroup_));
+  return (AbstractTable::GetTileGroupWithLayout(database_oid, tile_group_id,
+                                                partitioning,
+                                                tuples_per_tilegroup_,
+                                                numa_node));
 }
 
 oid_t DataTable::AddDefaultIndirectionArray(
@@ -360,21 +457,104 @@ oid_t DataTable::AddDefaultIndirectionArray(
 }
 
 oid_t DataTable::AddDefaultTileGroup() {
-  size_t active_tile_group_id = number_of_tuples_ % active_tilegroup_count_;
+  size_t active_tile_group_id = GetActiveTileGroupId();
   return AddDefaultTileGroup(active_tile_group_id);
 }
 
-oid_t DataTable::AddDefaultTileGroup(const size_t &active_tile_group_id) {
+std::shared_ptr<TileGroup> DataTable::CreateDefaultTileGroup(
+    const size_t &active_tile_group_id) {
   column_map_type column_map;
-  oid_t tile_group_id = INVALID_OID;
 
   // Figure out the partitioning for given tilegroup layout
   column_map = GetTileGroupLayout(LayoutType::LAYOUT_TYPE_ROW);
 
+  // Place the tile group on the node owning this active slot
+  int numa_node = INVALID_NUMA_NODE;
+  if (numa_node_count_ > 1) {
+    numa_node = active_tile_group_id / active_tilegroup_count_;
+  }
+
   // Create a tile group with that partitioning
-  std::shared_ptr<TileGroup> tile_group(GetTileGroupWithLayout(column_map));
+  std::shared_ptr<TileGroup> tile_group(
+      GetTileGroupWithLayout(column_map, numa_node));
   PL_ASSERT(tile_group.get());
 
+  return tile_group;
+}
+
+void DataTable::ProvisionSpareTileGroup(const size_t &active_tile_group_id,
+                                        const oid_t &full_tile_group_id) {
+  // Only the first inserter past the threshold requests the spare. Tile
+  // group ids grow, inserters still finishing an earlier tile group find a
+  // newer id and leave the request alone.
+  auto &request = spare_tile_group_requests_[active_tile_group_id];
+  oid_t requested_tile_group_id = request.load(std::memory_order_relaxed);
+  do {
+    if (requested_tile_group_id != INVALID_OID &&
+        requested_tile_group_id >= full_tile_group_id) {
+      return;
+    }
+  } while (request.compare_exchange_weak(requested_tile_group_id,
+                                         full_tile_group_id) == false);
+
+  if (std::atomic_load(&spare_tile_groups_[active_tile_group_id]) !=
+      nullptr) {
+    return;
+  }
+
+  spare_tile_group_tasks_->Run([this, active_tile_group_id]() {
+    auto spare_tile_group = CreateDefaultTileGroup(active_tile_group_id);
+
+    // A spare left over from an earlier round wins, this one is dropped
+    std::shared_ptr<TileGroup> no_tile_group;
+    std::atomic_compare_exchange_strong(
+        &spare_tile_groups_[active_tile_group_id], &no_tile_group,
+        spare_tile_group);
+  });
+}
+
+void DataTable::ReplaceActiveTileGroup(
+    const size_t &active_tile_group_id,
+    std::shared_ptr<TileGroup> full_tile_group) {
+  auto tile_group = std::atomic_exchange(
+      &spare_tile_groups_[active_tile_group_id], std::shared_ptr<TileGroup>());
+
+  // Not built yet, do it here
+  if (tile_group == nullptr) {
+    tile_group = CreateDefaultTileGroup(active_tile_group_id);
+  }
+
+  oid_t tile_group_id = tile_group->GetTileGroupId();
+
+  LOG_TRACE("Added a tile group ");
+  tile_groups_.Append(tile_group_id);
+
+  // add tile group metadata in locator
+  catalog::Manager::GetInstance().AddTileGroup(tile_group_id, tile_group);
+
+  // Only the thread that took the last slot of the full tile group gets
+  // here, inserters spinning on it move over once the swap lands
+  bool swapped = std::atomic_compare_exchange_strong(
+      &active_tile_groups_[active_tile_group_id], &full_tile_group,
+      tile_group);
+  PL_ASSERT(swapped == true);
+  (void)swapped;
+
+  // we must guarantee that the compiler always add tile group before adding
+  // tile_group_count_.
+  COMPILER_MEMORY_FENCE;
+
+  tile_group_count_++;
+
+  LOG_TRACE("Recording tile group : %u ", tile_group_id);
+}
+
+oid_t DataTable::AddDefaultTileGroup(const size_t &active_tile_group_id) {
+  oid_t tile_group_id = INVALID_OID;
+
+  std::shared_ptr<TileGroup> tile_group =
+      CreateDefaultTileGroup(active_tile_group_id);
+
   tile_group_id = tile_group->GetTileGroupId();
 
   LOG_TRACE("Added a tile group ");
@@ -385,7 +565,7 @@ oid_t DataTable::AddDefaultTileGroup(const size_t &active_tile_group_id) {
 
   COMPILER_MEMORY_FENCE;
 
-  active_tile_groups_[active_tile_group_id] = tile_group;
+  std::atomic_store(&active_tile_groups_[active_tile_group_id], tile_group);
 
   // we must guarantee that the compiler always add tile group before adding
   // tile_group_count_.
@@ -435,11 +615,116 @@ void DataTable::AddTileGroupWithOidForRecovery(const oid_t &tile_group_id) {
   }
 }
 
+size_t DataTable::RecoverTileGroups() {
+  auto &storage_manager = StorageManager::GetInstance();
+  PersistentHeap *persistent_heap = storage_manager.GetPersistentHeap();
+  if (persistent_heap == nullptr) {
+    return 0;
+  }
+
+  std::vector<std::shared_ptr<TileGroup>> recovered_tile_groups;
+  auto descriptor_ids =
+      persistent_heap->TakeRecoveredTileGroups(database_oid, table_oid);
+  for (auto descriptor_id : descriptor_ids) {
+    auto column_map = persistent_heap->GetColumnMap(descriptor_id);
+    if (column_map.size() != schema->GetColumnCount()) {
+      LOG_ERROR("Tile group %u does not match the schema of table %u",
+                persistent_heap->GetDescriptor(descriptor_id).tile_group_id,
+                table_oid);
+      continue;
+    }
+
+    std::shared_ptr<TileGroup> tile_group(
+        TileGroupFactory::GetPersistentTileGroup(
+            this, GetTileSchemas(column_map), descriptor_id));
+    oid_t tile_group_id = tile_group->GetTileGroupId();
+
+    tile_groups_.Append(tile_group_id);
+
+    // add tile group metadata in locator
+    catalog::Manager::GetInstance().AddTileGroup(tile_group_id, tile_group);
+
+    // we must guarantee that the compiler always add tile group before adding
+    // tile_group_count_.
+    COMPILER_MEMORY_FENCE;
+
+    tile_group_count_++;
+
+    IncreaseTupleCount(tile_group->GetHeader()->GetCurrentNextTupleSlot());
+    recovered_tile_groups.push_back(tile_group);
+
+    LOG_TRACE("Recovered tile group : %u ", tile_group_id);
+  }
+
+  // Version chains may cross tile groups, all of them are in place now
+  for (auto &tile_group : recovered_tile_groups) {
+    RecoverIndirections(tile_group.get());
+  }
+
+  return recovered_tile_groups.size();
+}
+
+void DataTable::RecoverIndirections(TileGroup *tile_group) {
+  auto &catalog_manager = catalog::Manager::GetInstance();
+  auto tile_group_header = tile_group->GetHeader();
+  oid_t tile_group_id = tile_group->GetTileGroupId();
+  oid_t tuple_slot_count = tile_group_header->GetCurrentNextTupleSlot();
+
+  // Every live version gets a fresh indirection, shared with the older
+  // versions of its chain, like an insert into the indexes would
+  for (oid_t tuple_slot_id = 0; tuple_slot_id < tuple_slot_count;
+       tuple_slot_id++) {
+    if (tile_group_header->GetTransactionId(tuple_slot_id) !=
+            INITIAL_TXN_ID ||
+        tile_group_header->GetEndCommitId(tuple_slot_id) != MAX_CID) {
+      continue;
+    }
+
+    ItemPointer *indirection = AllocateIndirection();
+    *indirection = ItemPointer(tile_group_id, tuple_slot_id);
+    tile_group_header->SetIndirection(tuple_slot_id, indirection);
+
+    ItemPointer next_location =
+        tile_group_header->GetNextItemPointer(tuple_slot_id);
+    while (next_location.IsNull() == false) {
+      auto next_tile_group = catalog_manager.GetTileGroup(next_location.block);
+      if (next_tile_group == nullptr) {
+        break;
+      }
+      auto next_header = next_tile_group->GetHeader();
+      next_header->SetIndirection(next_location.offset, indirection);
+      next_location = next_header->GetNextItemPointer(next_location.offset);
+    }
+  }
+}
+
+ItemPointer *DataTable::AllocateIndirection() {
+  size_t active_indirection_array_id =
+      GetTupleCount() % active_indirection_array_count_;
+
+  size_t indirection_offset = INVALID_INDIRECTION_OFFSET;
+  std::shared_ptr<IndirectionArray> active_indirection_array;
+  while (true) {
+    active_indirection_array =
+        active_indirection_arrays_[active_indirection_array_id];
+    indirection_offset = active_indirection_array->AllocateIndirection();
+    if (indirection_offset != INVALID_INDIRECTION_OFFSET) {
+      break;
+    }
+  }
+
+  if (indirection_offset == INDIRECTION_ARRAY_MAX_SIZE - 1) {
+    AddDefaultIndirectionArray(active_indirection_array_id);
+  }
+
+  return active_indirection_array->GetIndirectionByOffset(indirection_offset);
+}
+
 // NOTE: This function is only used in test cases.
 void DataTable::AddTileGroup(const std::shared_ptr<TileGroup> &tile_group) {
-  size_t active_tile_group_id = number_of_tuples_ % active_tilegroup_count_;
+  size_t active_tile_group_id = GetActiveTileGroupId();
 
-  active_tile_groups_[active_tile_group_id] = tile_group;
+  std::atomic_store(&active_tile_groups_[active_tile_group_id], tile_group);
 
   oid_t tile_group_id = tile_group->GetTileGroupId();
 
@@ -475,6 +760,22 @@ std::shared_ptr<storage::TileGroup> DataTable::GetTileGroupById(
   return manager.GetTileGroup(tile_group_id);
 }
 
+std::vector<oid_t> DataTable::GetTileGroupIds() const {
+  std::vector<oid_t> tile_group_ids;
+  auto tile_groups_size = tile_groups_.GetSize();
+  tile_group_ids.reserve(tile_groups_size);
+
+  for (std::size_t tile_groups_itr = 0; tile_groups_itr < tile_groups_size;
+       tile_groups_itr++) {
+    auto tile_group_id = tile_groups_.Find(tile_groups_itr);
+    if (tile_group_id != invalid_tile_group_id) {
+      tile_group_ids.push_back(tile_group_id);
+    }
+  }
+
+  return tile_group_ids;
+}
+
 void DataTable::DropTileGroups() {
   auto &catalog_manager = catalog::Manager::GetInstance();
   auto tile_groups_size = tile_groups_.GetSize();
@@ -492,10 +793,308 @@ void DataTable::DropTileGroups() {
 
   // Clear array
   tile_groups_.Clear(invalid_tile_group_id);
+  free_slot_manager_.Clear();
+
+  {
+    std::lock_guard<std::mutex> lock(compaction_mutex_);
+    sealed_tile_groups_.clear();
+    compacted_tile_groups_.clear();
+    compaction_tile_group_.reset();
+  }
 
   tile_group_count_ = 0;
 }
 
+//===--------------------------------------------------------------------===//
+// COMPACTION
+//===--------------------------------------------------------------------===//
+
+size_t DataTable::CompactTileGroups(const double &liveness_threshold,
+                                   const cid_t &commit_id) {
+  std::lock_guard<std::mutex> lock(compaction_mutex_);
+  auto &epoch_manager = concurrency::EpochManager::GetInstance();
+  uint64_t reclaimable_epoch = epoch_manager.GetReclaimableEpoch();
+
+  DropCompactedTileGroups(reclaimable_epoch);
+
+  // Move out the sealed tile groups that running inserts are done with
+  size_t compacted_count = 0;
+  std::vector<std::pair<uint64_t, oid_t>> sealed_tile_groups;
+  for (auto &sealed_tile_group : sealed_tile_groups_) {
+    if (sealed_tile_group.first < reclaimable_epoch &&
+        MoveLiveTuples(sealed_tile_group.second, commit_id) == true) {
+      compacted_count++;
+      continue;
+    }
+    sealed_tile_groups.push_back(sealed_tile_group);
+  }
+  sealed_tile_groups_.swap(sealed_tile_groups);
+
+  // Seal the full tile groups that are mostly dead
+  bool sealed = false;
+  for (auto tile_group_id : GetTileGroupIds()) {
+    auto tile_group = GetTileGroupById(tile_group_id);
+    if (tile_group == nullptr || tile_group == compaction_tile_group_ ||
+        IsActiveTileGroup(tile_group.get()) == true) {
+      continue;
+    }
+
+    auto tile_group_header = tile_group->GetHeader();
+    oid_t tuple_slot_count = tile_group->GetAllocatedTupleCount();
+    if (tile_group_header->IsSealed() == true ||
+        tile_group_header->GetCurrentNextTupleSlot() < tuple_slot_count) {
+      continue;
+    }
+
+    oid_t live_tuple_count = 0;
+    for (oid_t tuple_slot_id = 0; tuple_slot_id < tuple_slot_count;
+         tuple_slot_id++) {
+      if (tile_group_header->GetTransactionId(tuple_slot_id) !=
+              INVALID_TXN_ID &&
+          tile_group_header->GetEndCommitId(tuple_slot_id) == MAX_CID) {
+        live_tuple_count++;
+      }
+    }
+
+    if (live_tuple_count < liveness_threshold * tuple_slot_count) {
+      LOG_TRACE("Sealing tile group %u with %u live tuples", tile_group_id,
+                live_tuple_count);
+      tile_group_header->Seal();
+      sealed_tile_groups_.emplace_back(epoch_manager.GetCurrentEpoch(),
+                                       tile_group_id);
+      sealed = true;
+    }
+  }
+
+  // Inserts that pin the new epoch see the seals
+  if (sealed == true) {
+    epoch_manager.AdvanceEpoch();
+  }
+
+  return compacted_count;
+}
+
+bool DataTable::IsActiveTileGroup(const TileGroup *tile_group) const {
+  for (auto &active_tile_group : active_tile_groups_) {
+    if (std::atomic_load(&active_tile_group).get() == tile_group) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool DataTable::MoveLiveTuples(const oid_t &tile_group_id,
+                               const cid_t &commit_id) {
+  auto tile_group = GetTileGroupById(tile_group_id);
+  if (tile_group == nullptr) {
+    return true;
+  }
+
+  // Take over the live versions like an updating transaction would. Every
+  // slot handed out is claimed by now, an empty one was never handed out or
+  // its transaction aborted. Claimed and owned ones are busy.
+  auto tile_group_header = tile_group->GetHeader();
+  oid_t tuple_slot_count = tile_group_header->GetCurrentNextTupleSlot();
+  std::vector<oid_t> live_tuple_slots;
+  for (oid_t tuple_slot_id = 0; tuple_slot_id < tuple_slot_count;
+       tuple_slot_id++) {
+    txn_id_t txn_id = tile_group_header->GetTransactionId(tuple_slot_id);
+    if (txn_id == INVALID_TXN_ID ||
+        (txn_id == INITIAL_TXN_ID &&
+         tile_group_header->GetEndCommitId(tuple_slot_id) != MAX_CID)) {
+      continue;
+    }
+
+    if (tile_group_header->SetAtomicTransactionId(tuple_slot_id,
+                                                  COMPACTION_TXN_ID) == false) {
+      LOG_TRACE("Tile group %u is busy, compacting it later", tile_group_id);
+      for (auto live_tuple_slot : live_tuple_slots) {
+        tile_group_header->SetTransactionId(live_tuple_slot, INITIAL_TXN_ID);
+      }
+      return false;
+    }
+    live_tuple_slots.push_back(tuple_slot_id);
+  }
+
+  CompactedTileGroup compacted_tile_group;
+  compacted_tile_group.tile_group_id = tile_group_id;
+
+  for (auto tuple_slot_id : live_tuple_slots) {
+    ItemPointer old_location(tile_group_id, tuple_slot_id);
+    ItemPointer new_location =
+        CopyToCompactionTileGroup(tile_group.get(), tuple_slot_id);
+    auto new_tile_group_header =
+        GetTileGroupById(new_location.block)->GetHeader();
+    ItemPointer *indirection = tile_group_header->GetIndirection(tuple_slot_id);
+
+    // The moved version takes over at commit_id, older snapshots keep
+    // reading the old one. Linked like an update, the moved version is the
+    // newer one.
+    new_tile_group_header->SetBeginCommitId(new_location.offset, commit_id);
+    new_tile_group_header->SetEndCommitId(new_location.offset, MAX_CID);
+    new_tile_group_header->SetPrevItemPointer(new_location.offset,
+                                              INVALID_ITEMPOINTER);
+    new_tile_group_header->SetNextItemPointer(new_location.offset,
+                                              old_location);
+    new_tile_group_header->SetIndirection(new_location.offset, indirection);
+
+    tile_group_header->SetPrevItemPointer(tuple_slot_id, new_location);
+    tile_group_header->SetEndCommitId(tuple_slot_id, commit_id);
+
+    COMPILER_MEMORY_FENCE;
+
+    new_tile_group_header->SetTransactionId(new_location.offset,
+                                            INITIAL_TXN_ID);
+
+    // Indexes lead to the moved version from now on
+    if (indirection != nullptr) {
+      *indirection = new_location;
+    }
+
+    tile_group_header->SetTransactionId(tuple_slot_id, INITIAL_TXN_ID);
+
+  }
+
+  LOG_TRACE("Moved %lu tuples out of tile group %u", live_tuple_slots.size(),
+            tile_group_id);
+
+  // Snapshots taken from the next epoch on no longer see the old versions
+  auto &epoch_manager = concurrency::EpochManager::GetInstance();
+  compacted_tile_group.epoch = epoch_manager.AdvanceEpoch() - 1;
+  compacted_tile_groups_.push_back(std::move(compacted_tile_group));
+
+  return true;
+}
+
+ItemPointer DataTable::CopyToCompactionTileGroup(TileGroup *tile_group,
+                                                 const oid_t &tuple_slot_id) {
+  oid_t new_tuple_slot_id = INVALID_OID;
+  if (compaction_tile_group_ != nullptr) {
+    new_tuple_slot_id = compaction_tile_group_->InsertTuple(nullptr);
+  }
+
+  // Start the next compaction tile group. It takes no inserts and its slots
+  // stay invisible until the moved versions are installed.
+  if (new_tuple_slot_id == INVALID_OID) {
+    compaction_tile_group_ = CreateDefaultTileGroup(GetActiveTileGroupId());
+    oid_t compaction_tile_group_id = compaction_tile_group_->GetTileGroupId();
+
+    tile_groups_.Append(compaction_tile_group_id);
+    catalog::Manager::GetInstance().AddTileGroup(compaction_tile_group_id,
+                                                 compaction_tile_group_);
+
+    COMPILER_MEMORY_FENCE;
+
+    tile_group_count_++;
+
+    new_tuple_slot_id = compaction_tile_group_->InsertTuple(nullptr);
+    PL_ASSERT(new_tuple_slot_id != INVALID_OID);
+  }
+
+  oid_t column_count = schema->GetColumnCount();
+  for (oid_t column_itr = 0; column_itr < column_count; column_itr++) {
+    type::Value value = tile_group->GetValue(tuple_slot_id, column_itr);
+    compaction_tile_group_->SetValue(value, new_tuple_slot_id, column_itr);
+  }
+  compaction_tile_group_->GetHeader()->MarkDirty(new_tuple_slot_id);
+
+  return ItemPointer(compaction_tile_group_->GetTileGroupId(),
+                     new_tuple_slot_id);
+}
+
+void DataTable::UnlinkTileGroup(const oid_t &tile_group_id) {
+  auto &catalog_manager = catalog::Manager::GetInstance();
+  auto tile_group = catalog_manager.GetTileGroup(tile_group_id);
+  if (tile_group == nullptr) {
+    return;
+  }
+
+  auto tile_group_header = tile_group->GetHeader();
+  oid_t tuple_slot_count = tile_group_header->GetCurrentNextTupleSlot();
+  for (oid_t tuple_slot_id = 0; tuple_slot_id < tuple_slot_count;
+       tuple_slot_id++) {
+    // Newer version elsewhere, its next pointer leads here
+    ItemPointer prev_location =
+        tile_group_header->GetPrevItemPointer(tuple_slot_id);
+    if (prev_location.IsNull() == false &&
+        prev_location.block != tile_group_id) {
+      auto prev_tile_group = catalog_manager.GetTileGroup(prev_location.block);
+      if (prev_tile_group != nullptr) {
+        auto prev_header = prev_tile_group->GetHeader();
+        ItemPointer chain_location =
+            prev_header->GetNextItemPointer(prev_location.offset);
+        if (chain_location.block == tile_group_id &&
+            chain_location.offset == tuple_slot_id) {
+          prev_header->SetNextItemPointer(prev_location.offset,
+                                          INVALID_ITEMPOINTER);
+        }
+      }
+    }
+
+    // Older version elsewhere, its prev pointer leads here
+    ItemPointer next_location =
+        tile_group_header->GetNextItemPointer(tuple_slot_id);
+    if (next_location.IsNull() == false &&
+        next_location.block != tile_group_id) {
+      auto next_tile_group = catalog_manager.GetTileGroup(next_location.block);
+      if (next_tile_group != nullptr) {
+        auto next_header = next_tile_group->GetHeader();
+        ItemPointer chain_location =
+            next_header->GetPrevItemPointer(next_location.offset);
+        if (chain_location.block == tile_group_id &&
+            chain_location.offset == tuple_slot_id) {
+          next_header->SetPrevItemPointer(next_location.offset,
+                                          INVALID_ITEMPOINTER);
+        }
+      }
+    }
+  }
+}
+
+void DataTable::DropCompactedTileGroups(const uint64_t &reclaimable_epoch) {
+  auto &catalog_manager = catalog::Manager::GetInstance();
+  std::vector<CompactedTileGroup> compacted_tile_groups;
+
+  for (auto &compacted_tile_group : compacted_tile_groups_) {
+    if (compacted_tile_group.epoch >= reclaimable_epoch) {
+      compacted_tile_groups.push_back(std::move(compacted_tile_group));
+      continue;
+    }
+
+    oid_t tile_group_id = compacted_tile_group.tile_group_id;
+
+    // No snapshot needs the old versions anymore. Every chain pointer from
+    // another tile group into this one goes, not just the ones of the moved
+    // versions: newer versions elsewhere may still lead to versions that
+    // ended here before the move. Readers that followed a chain into the
+    // tile group before may still be there, it is dropped an epoch later.
+    if (compacted_tile_group.unlinked == false) {
+      UnlinkTileGroup(tile_group_id);
+
+      auto &epoch_manager = concurrency::EpochManager::GetInstance();
+      compacted_tile_group.unlinked = true;
+      compacted_tile_group.epoch = epoch_manager.AdvanceEpoch() - 1;
+      compacted_tile_groups.push_back(std::move(compacted_tile_group));
+      continue;
+    }
+
+    auto tile_groups_size = tile_groups_.GetSize();
+    for (std::size_t tile_groups_itr = 0; tile_groups_itr < tile_groups_size;
+         tile_groups_itr++) {
+      if (tile_groups_.Find(tile_groups_itr) == tile_group_id) {
+        tile_group_count_--;
+        tile_groups_.Erase(tile_groups_itr, invalid_tile_group_id);
+        break;
+      }
+    }
+
+    LOG_TRACE("Dropping compacted tile group %u", tile_group_id);
+    catalog_manager.DropTileGroup(tile_group_id);
+  }
+
+  compacted_tile_groups_.swap(compacted_tile_groups);
+}
+
 
 // Get the schema for the new transformed tile group
 std::vector<catalog::Schema> TransformTileGroupSchema(
@@ -534,7 +1133,10 @@ std::vector<catalog::Schema> TransformTileGroupSchema(
   return new_schema;
 }
 
-// Set the transformed tile group column-at-a-time
+// Tuples assembled per streaming copy into an inlined tile
+#define TRANSFORM_STAGING_SIZE (64 * 1024)
+
+// Set the transformed tile group tile-at-a-time
 void SetTransformedTileGroup(storage::TileGroup *orig_tile_group,
                              storage::TileGroup *new_tile_group) {
   // Check the schema of the two tile groups
@@ -547,26 +1149,85 @@ void SetTransformedTileGroup(storage::TileGroup *orig_tile_group,
 
   auto column_count = new_column_map.size();
   auto tuple_count = orig_tile_group->GetAllocatedTupleCount();
-  // Go over each column copying onto the new tile group
-  for (oid_t column_itr = 0; column_itr < column_count; column_itr++) {
-    // Locate the original base tile and tile column offset
-    orig_tile_group->LocateTileAndColumn(column_itr, orig_tile_offset,
-                                         orig_tile_column_offset);
 
+  // Group the columns by the new tile they go to
+  std::map<oid_t, std::vector<oid_t>> new_tile_columns;
+  for (oid_t column_itr = 0; column_itr < column_count; column_itr++) {
     new_tile_group->LocateTileAndColumn(column_itr, new_tile_offset,
                                         new_tile_column_offset);
+    new_tile_columns[new_tile_offset].push_back(column_itr);
+  }
 
-    auto orig_tile = orig_tile_group->GetTile(orig_tile_offset);
-    auto new_tile = new_tile_group->GetTile(new_tile_offset);
+  for (auto &new_tile_entry : new_tile_columns) {
+    auto new_tile = new_tile_group->GetTile(new_tile_entry.first);
+    auto new_tile_schema = new_tile->GetSchema();
+
+    // Inlined tiles are assembled a batch of tuples at a time from the
+    // original tiles and streamed into the new tile
+    if (new_tile_schema->IsInlined()) {
+      size_t tuple_length = new_tile_schema->GetLength();
+      oid_t batch_tuple_count =
+          std::max<size_t>(TRANSFORM_STAGING_SIZE / tuple_length, 1);
+      std::unique_ptr<char[]> staging(
+          new char[batch_tuple_count * tuple_length]);
+
+      for (oid_t batch_begin = 0; batch_begin < tuple_count;
+           batch_begin += batch_tuple_count) {
+        oid_t batch_end =
+            std::min<oid_t>(batch_begin + batch_tuple_count, tuple_count);
+
+        for (auto column_itr : new_tile_entry.second) {
+          orig_tile_group->LocateTileAndColumn(column_itr, orig_tile_offset,
+                                               orig_tile_column_offset);
+          new_tile_group->LocateTileAndColumn(column_itr, new_tile_offset,
+                                              new_tile_column_offset);
+
+          auto orig_tile = orig_tile_group->GetTile(orig_tile_offset);
+          size_t orig_position =
+              orig_tile->GetSchema()->GetOffset(orig_tile_column_offset);
+          size_t new_position =
+              new_tile_schema->GetOffset(new_tile_column_offset);
+          size_t column_length =
+              new_tile_schema->GetLength(new_tile_column_offset);
+
+          char *staged_location = staging.get() + new_position;
+          for (oid_t tuple_itr = batch_begin; tuple_itr < batch_end;
+               tuple_itr++) {
+            PL_MEMCPY(staged_location,
+                      orig_tile->GetTupleLocation(tuple_itr) + orig_position,
+                      column_length);
+            staged_location += tuple_length;
+          }
+        }
+
+        PmemUtil::MemcpyNontemporal(new_tile->GetTupleLocation(batch_begin),
+                                    staging.get(),
+                                    (batch_end - batch_begin) * tuple_length);
+      }
+      continue;
+    }
 
-    // Copy the column over to the new tile group
-    for (oid_t tuple_itr = 0; tuple_itr < tuple_count; tuple_itr++) {
-      type::Value val =
-          (orig_tile->GetValue(tuple_itr, orig_tile_column_offset));
-      new_tile->SetValue(val, tuple_itr, new_tile_column_offset);
+    // Otherwise copy value-at-a-time, so that uninlined values are copied
+    // into the new tile's pool
+    for (auto column_itr : new_tile_entry.second) {
+      orig_tile_group->LocateTileAndColumn(column_itr, orig_tile_offset,
+                                           orig_tile_column_offset);
+      new_tile_group->LocateTileAndColumn(column_itr, new_tile_offset,
+                                          new_tile_column_offset);
+
+      auto orig_tile = orig_tile_group->GetTile(orig_tile_offset);
+
+      for (oid_t tuple_itr = 0; tuple_itr < tuple_count; tuple_itr++) {
+        type::Value val =
+            (orig_tile->GetValue(tuple_itr, orig_tile_column_offset));
+        new_tile->SetValue(val, tuple_itr, new_tile_column_offset);
+      }
     }
   }
 
+  // Streamed tuples are visible before the tile group is
+  PmemUtil::Fence();
+
   // Finally, copy over the tile header
   auto header = orig_tile_group->GetHeader();
   auto new_header = new_tile_group->GetHeader();
@@ -606,11 +1267,15 @@ storage::TileGroup *DataTable::TransformTileGroup(
           tile_group->GetDatabaseId(), tile_group->GetTableId(),
           tile_group->GetTileGroupId(), tile_group->GetAbstractTable(),
           new_schema, default_partition_,
-          tile_group->GetAllocatedTupleCount()));
+          tile_group->GetAllocatedTupleCount(), tile_group->GetNumaNode(),
+          false));
 
   // Set the transformed tile group column-at-a-time
   SetTransformedTileGroup(tile_group.get(), new_tile_group.get());
 
+  // It replaces the original tile group in the persistent heap once complete
+  TileGroupFactory::PublishTileGroup(new_tile_group.get());
+
   // Set the location of the new tile group
   // and clean up the orig tile group
   catalog_manager.AddTileGroup(tile_group_id, new_tile_group);
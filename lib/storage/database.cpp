@@ -36,6 +36,14 @@ Database::~Database() {
 //===--------------------------------------------------------------------===//
 
 void Database::AddTable(storage::DataTable *table, bool is_catalog) {
+  // Tables join their database at startup, the tile groups they left in the
+  // persistent heap come back with them
+  size_t recovered_tile_group_count = table->RecoverTileGroups();
+  if (recovered_tile_group_count > 0) {
+    LOG_INFO("Recovered %lu tile groups of table %s",
+             recovered_tile_group_count, table->GetName().c_str());
+  }
+
   {
     std::lock_guard<std::mutex> lock(database_mutex);
     tables.push_back(table);
@@ -0,0 +1,220 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// extent_allocator.cpp
+//
+// Identification: src/storage/extent_allocator.cpp
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/extent_allocator.h"
+
+#include "common/logger.h"
+#include "common/macros.h"
+
+namespace peloton {
+namespace storage {
+
+// Classes cover 1 page, 2-3 pages, 4-7 pages, ...
+#define EXTENT_SIZE_CLASS_COUNT 48
+
+const size_t ExtentAllocator::INVALID_EXTENT_OFFSET;
+
+const size_t ExtentAllocator::default_alignment_;
+
+ExtentAllocator::ExtentAllocator(const size_t &capacity,
+                                 const size_t &alignment)
+    : capacity_(0),
+      alignment_(alignment),
+      free_bytes_(0),
+      size_classes_(EXTENT_SIZE_CLASS_COUNT) {
+  PL_ASSERT(alignment_ > 0 && (alignment_ & (alignment_ - 1)) == 0);
+  Grow(capacity);
+}
+
+size_t ExtentAllocator::GetSizeClass(const size_t &length) const {
+  size_t pages = length / alignment_;
+  PL_ASSERT(pages > 0);
+
+  size_t size_class = 63 - __builtin_clzll(pages);
+  if (size_class >= EXTENT_SIZE_CLASS_COUNT) {
+    size_class = EXTENT_SIZE_CLASS_COUNT - 1;
+  }
+  return size_class;
+}
+
+void ExtentAllocator::AddFreeExtent(const size_t &offset,
+                                    const size_t &length) {
+  free_extents_[offset] = length;
+  size_classes_[GetSizeClass(length)].insert(std::make_pair(length, offset));
+}
+
+void ExtentAllocator::RemoveFreeExtent(const size_t &offset,
+                                       const size_t &length) {
+  free_extents_.erase(offset);
+  size_classes_[GetSizeClass(length)].erase(std::make_pair(length, offset));
+}
+
+size_t ExtentAllocator::Allocate(const size_t &size) {
+  if (size == 0) {
+    return INVALID_EXTENT_OFFSET;
+  }
+
+  size_t length = (size + alignment_ - 1) & ~(alignment_ - 1);
+
+  // Best fit within the request's own class, any extent of a larger class
+  // is large enough
+  size_t offset = INVALID_EXTENT_OFFSET;
+  size_t extent_length = 0;
+  for (size_t size_class = GetSizeClass(length);
+       size_class < EXTENT_SIZE_CLASS_COUNT; size_class++) {
+    auto &extents = size_classes_[size_class];
+    auto extent_itr = extents.lower_bound(std::make_pair(length, size_t(0)));
+    if (extent_itr != extents.end()) {
+      extent_length = extent_itr->first;
+      offset = extent_itr->second;
+      break;
+    }
+  }
+
+  if (offset == INVALID_EXTENT_OFFSET) {
+    return INVALID_EXTENT_OFFSET;
+  }
+
+  // Carve the allocation from the front, the tail stays free
+  RemoveFreeExtent(offset, extent_length);
+  if (extent_length > length) {
+    AddFreeExtent(offset + length, extent_length - length);
+  }
+
+  allocated_extents_[offset] = length;
+  free_bytes_ -= length;
+
+  return offset;
+}
+
+bool ExtentAllocator::Reserve(const size_t &offset, const size_t &size) {
+  size_t length = (size + alignment_ - 1) & ~(alignment_ - 1);
+  if (length == 0 || (offset & (alignment_ - 1)) != 0) {
+    return false;
+  }
+
+  // Find the free extent containing the range
+  auto extent_itr = free_extents_.upper_bound(offset);
+  if (extent_itr == free_extents_.begin()) {
+    return false;
+  }
+  --extent_itr;
+
+  size_t extent_offset = extent_itr->first;
+  size_t extent_length = extent_itr->second;
+  if (offset + length > extent_offset + extent_length) {
+    return false;
+  }
+
+  // Keep the free space on both sides
+  RemoveFreeExtent(extent_offset, extent_length);
+  if (offset > extent_offset) {
+    AddFreeExtent(extent_offset, offset - extent_offset);
+  }
+  if (extent_offset + extent_length > offset + length) {
+    AddFreeExtent(offset + length,
+                  extent_offset + extent_length - (offset + length));
+  }
+
+  allocated_extents_[offset] = length;
+  free_bytes_ -= length;
+
+  return true;
+}
+
+size_t ExtentAllocator::Release(const size_t &offset) {
+  auto allocated_itr = allocated_extents_.find(offset);
+  if (allocated_itr == allocated_extents_.end()) {
+    LOG_TRACE("No extent at offset %lu", offset);
+    return 0;
+  }
+
+  size_t length = allocated_itr->second;
+  allocated_extents_.erase(allocated_itr);
+  free_bytes_ += length;
+
+  size_t free_offset = offset;
+  size_t free_length = length;
+
+  // Coalesce with the following extent
+  auto next_itr = free_extents_.find(offset + length);
+  if (next_itr != free_extents_.end()) {
+    size_t next_length = next_itr->second;
+    RemoveFreeExtent(next_itr->first, next_length);
+    free_length += next_length;
+  }
+
+  // Coalesce with the preceding extent
+  auto prev_itr = free_extents_.lower_bound(offset);
+  if (prev_itr != free_extents_.begin()) {
+    --prev_itr;
+    if (prev_itr->first + prev_itr->second == offset) {
+      size_t prev_offset = prev_itr->first;
+      size_t prev_length = prev_itr->second;
+      RemoveFreeExtent(prev_offset, prev_length);
+      free_offset = prev_offset;
+      free_length += prev_length;
+    }
+  }
+
+  AddFreeExtent(free_offset, free_length);
+
+  return length;
+}
+
+void ExtentAllocator::Grow(const size_t &new_capacity) {
+  size_t aligned_capacity = new_capacity & ~(alignment_ - 1);
+  if (aligned_capacity <= capacity_) {
+    return;
+  }
+
+  size_t old_capacity = capacity_;
+  capacity_ = aligned_capacity;
+  free_bytes_ += aligned_capacity - old_capacity;
+
+  // New space joins a free extent at the old end of the range
+  size_t free_offset = old_capacity;
+  size_t free_length = aligned_capacity - old_capacity;
+  auto last_itr = free_extents_.rbegin();
+  if (last_itr != free_extents_.rend() &&
+      last_itr->first + last_itr->second == old_capacity) {
+    size_t last_offset = last_itr->first;
+    size_t last_length = last_itr->second;
+    RemoveFreeExtent(last_offset, last_length);
+    free_offset = last_offset;
+    free_length += last_length;
+  }
+
+  AddFreeExtent(free_offset, free_length);
+}
+
+size_t ExtentAllocator::GetExtentSize(const size_t &offset) const {
+  auto allocated_itr = allocated_extents_.find(offset);
+  if (allocated_itr == allocated_extents_.end()) {
+    return 0;
+  }
+  return allocated_itr->second;
+}
+
+size_t ExtentAllocator::GetLargestFreeExtent() const {
+  for (size_t size_class = EXTENT_SIZE_CLASS_COUNT; size_class > 0;
+       size_class--) {
+    auto &extents = size_classes_[size_class - 1];
+    if (extents.empty() == false) {
+      return extents.rbegin()->first;
+    }
+  }
+  return 0;
+}
+
+}  // End storage namespace
+}  // End peloton namespace
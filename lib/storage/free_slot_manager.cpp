@@ -0,0 +1,131 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// free_slot_manager.cpp
+//
+// Identification: src/storage/free_slot_manager.cpp
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/free_slot_manager.h"
+
+#include "common/logger.h"
+#include "concurrency/epoch_manager.h"
+
+namespace peloton {
+namespace storage {
+
+const size_t FreeSlotManager::shard_count_;
+
+const size_t FreeSlotManager::epoch_advance_interval_;
+
+namespace {
+
+// Reclaims of the thread, it starts a new epoch every so often
+thread_local size_t reclaim_count = 0;
+
+}  // namespace
+
+FreeSlotManager::FreeSlotManager() : retired_slot_count_(0) {}
+
+void FreeSlotManager::RetireSlot(const ItemPointer &location) {
+  auto epoch = concurrency::EpochManager::GetInstance().GetCurrentEpoch();
+  auto &shard = shards_[GetThreadIndex() % shard_count_];
+
+  shard.shard_lock.Lock();
+  shard.retired_slots.emplace_back(epoch, location);
+  shard.shard_lock.Unlock();
+
+  retired_slot_count_.fetch_add(1, std::memory_order_release);
+}
+
+void FreeSlotManager::ReleaseSlot(const ItemPointer &location) {
+  auto &shard = shards_[GetThreadIndex() % shard_count_];
+
+  shard.shard_lock.Lock();
+  shard.free_slots.push_back(location);
+  shard.shard_lock.Unlock();
+
+  retired_slot_count_.fetch_add(1, std::memory_order_release);
+}
+
+void FreeSlotManager::ReclaimSlots(Shard &shard, uint64_t &reclaimable_epoch) {
+  // Determined once per lookup. New epochs are mostly started by the garbage
+  // collector, the inserts only start one now and then so that the epoch the
+  // slots were retired in ends without it as well.
+  if (reclaimable_epoch == 0) {
+    auto &epoch_manager = concurrency::EpochManager::GetInstance();
+    if (++reclaim_count % epoch_advance_interval_ == 0) {
+      epoch_manager.AdvanceEpoch();
+    }
+    reclaimable_epoch = epoch_manager.GetReclaimableEpoch();
+  }
+
+  auto &retired_slots = shard.retired_slots;
+  while (retired_slots.empty() == false &&
+         retired_slots.front().first < reclaimable_epoch) {
+    shard.free_slots.push_back(retired_slots.front().second);
+    retired_slots.pop_front();
+  }
+}
+
+ItemPointer FreeSlotManager::GetFreeSlot() {
+  // Tables without retired slots pay only for this check
+  if (retired_slot_count_.load(std::memory_order_acquire) == 0) {
+    return INVALID_ITEMPOINTER;
+  }
+
+  uint64_t reclaimable_epoch = 0;
+  size_t home_shard = GetThreadIndex() % shard_count_;
+
+  for (size_t shard_itr = 0; shard_itr < shard_count_; shard_itr++) {
+    auto &shard = shards_[(home_shard + shard_itr) % shard_count_];
+
+    // Do not wait for the shards of other threads
+    if (shard_itr == 0) {
+      shard.shard_lock.Lock();
+    } else if (shard.shard_lock.TryLock() == false) {
+      continue;
+    }
+
+    if (shard.free_slots.empty() == true &&
+        shard.retired_slots.empty() == false) {
+      ReclaimSlots(shard, reclaimable_epoch);
+    }
+
+    if (shard.free_slots.empty() == false) {
+      ItemPointer location = shard.free_slots.back();
+      shard.free_slots.pop_back();
+      shard.shard_lock.Unlock();
+
+      retired_slot_count_.fetch_sub(1, std::memory_order_relaxed);
+      return location;
+    }
+
+    shard.shard_lock.Unlock();
+  }
+
+  return INVALID_ITEMPOINTER;
+}
+
+void FreeSlotManager::Clear() {
+  for (size_t shard_itr = 0; shard_itr < shard_count_; shard_itr++) {
+    auto &shard = shards_[shard_itr];
+
+    shard.shard_lock.Lock();
+    retired_slot_count_.fetch_sub(
+        shard.retired_slots.size() + shard.free_slots.size(),
+        std::memory_order_relaxed);
+    shard.retired_slots.clear();
+    shard.free_slots.clear();
+    shard.shard_lock.Unlock();
+  }
+
+  LOG_TRACE("Cleared free slots");
+}
+
+}  // End storage namespace
+}  // End peloton namespace
@@ -0,0 +1,195 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// huge_page_pool.cpp
+//
+// Identification: src/storage/huge_page_pool.cpp
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <sys/mman.h>
+
+#include <cerrno>
+#include <cstring>
+#include <string>
+
+#include "storage/huge_page_pool.h"
+
+#include "common/exception.h"
+#include "common/logger.h"
+#include "common/numa_util.h"
+
+namespace peloton {
+namespace storage {
+
+const size_t HugePagePool::default_max_cached_bytes_;
+
+const size_t HugePagePool::hugetlb_retry_interval_;
+
+HugePagePool::HugePagePool(const size_t &max_cached_bytes)
+    : max_cached_bytes_(max_cached_bytes),
+      hugetlb_available_(true),
+      hugetlb_retry_countdown_(0),
+      hugetlb_region_count_(0),
+      transparent_region_count_(0),
+      recycled_region_count_(0),
+      live_bytes_(0),
+      cached_bytes_(0) {}
+
+HugePagePool::~HugePagePool() {
+  Trim();
+
+  // Regions still in use go away with the process
+  if (live_regions_.empty() == false) {
+    LOG_TRACE("%lu huge page regions still in use", live_regions_.size());
+  }
+}
+
+void *HugePagePool::MapRegion(const size_t &size, bool &hugetlb) {
+  // Reserved huge pages first, unless the kernel ran out of them recently
+  bool try_hugetlb = hugetlb_available_;
+  size_t countdown = hugetlb_retry_countdown_;
+  while (try_hugetlb == true && countdown > 0) {
+    if (hugetlb_retry_countdown_.compare_exchange_weak(countdown,
+                                                       countdown - 1)) {
+      try_hugetlb = false;
+    }
+  }
+
+  if (try_hugetlb == true) {
+    void *address = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (address != MAP_FAILED) {
+      hugetlb = true;
+      hugetlb_region_count_++;
+      return address;
+    }
+
+    // Reserved huge pages may be added or freed later, unlike support for
+    // them
+    LOG_TRACE("MAP_HUGETLB failed : %s", strerror(errno));
+    if (errno == EINVAL || errno == ENOSYS) {
+      hugetlb_available_ = false;
+    } else {
+      hugetlb_retry_countdown_ = hugetlb_retry_interval_;
+    }
+  }
+
+  // Fall back to transparent huge pages. Over-map so that the region can be
+  // aligned to a huge page boundary, then trim the excess.
+  size_t mapped_size = size + HUGE_PAGE_SIZE;
+  void *mapping = mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (mapping == MAP_FAILED) {
+    throw Exception("could not map " + std::to_string(size) +
+                    " bytes : " + strerror(errno));
+  }
+
+  uintptr_t mapping_begin = reinterpret_cast<uintptr_t>(mapping);
+  uintptr_t region_begin =
+      (mapping_begin + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+  uintptr_t region_end = region_begin + size;
+  uintptr_t mapping_end = mapping_begin + mapped_size;
+
+  if (region_begin > mapping_begin) {
+    munmap(mapping, region_begin - mapping_begin);
+  }
+  if (mapping_end > region_end) {
+    munmap(reinterpret_cast<void *>(region_end), mapping_end - region_end);
+  }
+
+  void *address = reinterpret_cast<void *>(region_begin);
+  if (madvise(address, size, MADV_HUGEPAGE) != 0) {
+    LOG_TRACE("MADV_HUGEPAGE failed : %s", strerror(errno));
+  }
+
+  hugetlb = false;
+  transparent_region_count_++;
+  return address;
+}
+
+void HugePagePool::UnmapRegion(void *address, const Region &region) {
+  if (munmap(address, region.size) != 0) {
+    LOG_ERROR("munmap of huge page region failed : %s", strerror(errno));
+  }
+}
+
+void *HugePagePool::Allocate(const size_t &size, const int &numa_node) {
+  size_t region_size = (size + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+
+  {
+    std::lock_guard<std::mutex> lock(pool_mutex_);
+
+    // Reuse a cached region of the same shape
+    auto cached_itr = cached_regions_.find(std::make_pair(region_size, numa_node));
+    if (cached_itr != cached_regions_.end() &&
+        cached_itr->second.empty() == false) {
+      auto cached_region = cached_itr->second.back();
+      cached_itr->second.pop_back();
+      cached_bytes_ -= region_size;
+
+      live_regions_[cached_region.first] = cached_region.second;
+      live_bytes_ += region_size;
+      recycled_region_count_++;
+      return cached_region.first;
+    }
+  }
+
+  Region region;
+  region.size = region_size;
+  region.numa_node = numa_node;
+  void *address = MapRegion(region_size, region.hugetlb);
+
+  // Bind before anybody touches the pages
+  if (numa_node != INVALID_NUMA_NODE) {
+    NumaUtil::BindToNode(address, region_size, numa_node);
+  }
+
+  std::lock_guard<std::mutex> lock(pool_mutex_);
+  live_regions_[address] = region;
+  live_bytes_ += region_size;
+  return address;
+}
+
+bool HugePagePool::Release(void *address) {
+  std::lock_guard<std::mutex> lock(pool_mutex_);
+
+  auto live_itr = live_regions_.find(address);
+  if (live_itr == live_regions_.end()) {
+    return false;
+  }
+
+  Region region = live_itr->second;
+  live_regions_.erase(live_itr);
+  live_bytes_ -= region.size;
+
+  // Keep it around for the next tile group unless the pool is full
+  if (cached_bytes_ + region.size <= max_cached_bytes_) {
+    cached_regions_[std::make_pair(region.size, region.numa_node)].push_back(
+        std::make_pair(address, region));
+    cached_bytes_ += region.size;
+  } else {
+    UnmapRegion(address, region);
+  }
+
+  return true;
+}
+
+void HugePagePool::Trim() {
+  std::lock_guard<std::mutex> lock(pool_mutex_);
+
+  for (auto &cached_entry : cached_regions_) {
+    for (auto &cached_region : cached_entry.second) {
+      UnmapRegion(cached_region.first, cached_region.second);
+    }
+  }
+
+  cached_regions_.clear();
+  cached_bytes_ = 0;
+}
+
+}  // End storage namespace
+}  // End peloton namespace
@@ -0,0 +1,262 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// parallel_table_scanner.cpp
+//
+// Identification: src/storage/parallel_table_scanner.cpp
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <thread>
+#include <unordered_set>
+
+#include "storage/parallel_table_scanner.h"
+
+#include "catalog/schema.h"
+#include "common/init.h"
+#include "common/logger.h"
+#include "common/macros.h"
+#include "common/numa_util.h"
+#include "common/thread_pool.h"
+#include "concurrency/epoch_manager.h"
+#include "executor/logical_tile.h"
+#include "executor/logical_tile_factory.h"
+#include "storage/data_table.h"
+#include "storage/tile_group.h"
+#include "storage/tile_group_header.h"
+
+namespace peloton {
+namespace storage {
+
+//===--------------------------------------------------------------------===//
+// Morsel Queue
+//===--------------------------------------------------------------------===//
+
+MorselQueue::MorselQueue(const std::vector<Morsel> &morsels,
+                         const size_t node_count) {
+  PL_ASSERT(node_count > 0);
+
+  for (size_t node_itr = 0; node_itr < node_count; node_itr++) {
+    node_queues_.emplace_back(new NodeQueue());
+  }
+
+  for (auto &morsel : morsels) {
+    size_t node = (morsel.numa_node == INVALID_NUMA_NODE)
+                      ? 0
+                      : morsel.numa_node % node_count;
+    node_queues_[node]->morsels.push_back(morsel);
+  }
+}
+
+bool MorselQueue::PopFront(NodeQueue &queue, Morsel &morsel) {
+  queue.lock.Lock();
+  bool found = !queue.morsels.empty();
+  if (found) {
+    morsel = queue.morsels.front();
+    queue.morsels.pop_front();
+  }
+  queue.lock.Unlock();
+  return found;
+}
+
+bool MorselQueue::PopBack(NodeQueue &queue, Morsel &morsel) {
+  queue.lock.Lock();
+  bool found = !queue.morsels.empty();
+  if (found) {
+    morsel = queue.morsels.back();
+    queue.morsels.pop_back();
+  }
+  queue.lock.Unlock();
+  return found;
+}
+
+bool MorselQueue::Next(const int numa_node, Morsel &morsel) {
+  auto node_count = node_queues_.size();
+  size_t local_node = (numa_node < 0) ? 0 : numa_node % node_count;
+
+  // Node-local morsels first
+  if (PopFront(*node_queues_[local_node], morsel) == true) {
+    return true;
+  }
+
+  // Steal from the other nodes, starting with the next one over
+  for (size_t victim_itr = 1; victim_itr < node_count; victim_itr++) {
+    auto victim_node = (local_node + victim_itr) % node_count;
+    if (PopBack(*node_queues_[victim_node], morsel) == true) {
+      LOG_TRACE("Node %lu stole morsel [%u, %u) from node %lu", local_node,
+                morsel.begin_offset, morsel.end_offset, victim_node);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+//===--------------------------------------------------------------------===//
+// Parallel Table Scanner
+//===--------------------------------------------------------------------===//
+
+ParallelTableScanner::ParallelTableScanner(const DataTable *table,
+                                           const cid_t snapshot_cid,
+                                           const std::vector<oid_t> &column_ids,
+                                           const size_t worker_count,
+                                           const size_t tile_groups_per_morsel)
+    : table_(table),
+      snapshot_cid_(snapshot_cid),
+      column_ids_(column_ids),
+      worker_count_(worker_count),
+      tile_groups_per_morsel_(tile_groups_per_morsel) {
+  PL_ASSERT(table_ != nullptr);
+  PL_ASSERT(tile_groups_per_morsel > 0);
+
+  // Scan all columns if no projection was given
+  if (column_ids_.empty() == true) {
+    auto column_count = table_->GetSchema()->GetColumnCount();
+    for (oid_t column_itr = 0; column_itr < column_count; column_itr++) {
+      column_ids_.push_back(column_itr);
+    }
+  }
+
+  if (worker_count_ == 0) {
+    worker_count_ = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  numa_node_count_ = NumaUtil::GetNodeCount();
+  AddTileGroups(table_->GetTileGroupIds());
+}
+
+void ParallelTableScanner::AddTileGroups(
+    const std::vector<oid_t> &tile_group_ids) {
+  std::unordered_set<oid_t> covered_tile_group_ids(tile_group_ids_.begin(),
+                                                   tile_group_ids_.end());
+
+  // Bucket the tile groups by the node holding their memory
+  std::vector<std::vector<oid_t>> node_tile_group_ids(numa_node_count_);
+  for (auto tile_group_id : tile_group_ids) {
+    if (covered_tile_group_ids.count(tile_group_id) > 0) {
+      continue;
+    }
+    auto tile_group = table_->GetTileGroupById(tile_group_id);
+    if (tile_group == nullptr) {
+      continue;
+    }
+    int numa_node = tile_group->GetNumaNode();
+    size_t node = (numa_node == INVALID_NUMA_NODE)
+                      ? 0
+                      : numa_node % numa_node_count_;
+    node_tile_group_ids[node].push_back(tile_group_id);
+  }
+
+  for (size_t node = 0; node < numa_node_count_; node++) {
+    AddMorsels(node_tile_group_ids[node], node);
+  }
+
+  // No point in starting more workers than there are morsels
+  worker_count_ = std::max<size_t>(1, std::min(worker_count_, morsels_.size()));
+}
+
+void ParallelTableScanner::AddMorsels(const std::vector<oid_t> &tile_group_ids,
+                                      const int numa_node) {
+  oid_t begin_offset = tile_group_ids_.size();
+  tile_group_ids_.insert(tile_group_ids_.end(), tile_group_ids.begin(),
+                         tile_group_ids.end());
+  oid_t end_offset = tile_group_ids_.size();
+
+  for (oid_t offset = begin_offset; offset < end_offset;
+       offset += tile_groups_per_morsel_) {
+    Morsel morsel;
+    morsel.begin_offset = offset;
+    morsel.end_offset =
+        std::min<oid_t>(offset + tile_groups_per_morsel_, end_offset);
+    morsel.numa_node = numa_node;
+    morsels_.push_back(morsel);
+  }
+}
+
+executor::LogicalTile *ParallelTableScanner::ScanTileGroup(
+    const std::shared_ptr<TileGroup> &tile_group, const cid_t snapshot_cid,
+    const std::vector<oid_t> &column_ids) {
+  auto tile_group_header = tile_group->GetHeader();
+  oid_t active_tuple_count = tile_group_header->GetCurrentNextTupleSlot();
+
+  // A version is visible if it was committed at or before the snapshot and
+  // has not been superseded as of the snapshot
+  std::vector<oid_t> position_list;
+  position_list.reserve(active_tuple_count);
+  for (oid_t tuple_id = 0; tuple_id < active_tuple_count; tuple_id++) {
+    if (tile_group_header->GetTransactionId(tuple_id) == INVALID_TXN_ID) {
+      continue;
+    }
+    if (tile_group_header->GetBeginCommitId(tuple_id) <= snapshot_cid &&
+        tile_group_header->GetEndCommitId(tuple_id) > snapshot_cid) {
+      position_list.push_back(tuple_id);
+    }
+  }
+
+  if (position_list.empty() == true) {
+    return nullptr;
+  }
+
+  std::unique_ptr<executor::LogicalTile> logical_tile(
+      executor::LogicalTileFactory::GetTile());
+  logical_tile->AddPositionList(std::move(position_list));
+  logical_tile->AddColumns(tile_group, column_ids);
+
+  return logical_tile.release();
+}
+
+void ParallelTableScanner::ScanMorsels(const size_t worker_id,
+                                       MorselQueue &queue,
+                                       const ConsumerType &consumer) {
+  Morsel morsel;
+  while (queue.Next(NumaUtil::GetCurrentNode(), morsel) == true) {
+    for (oid_t offset = morsel.begin_offset; offset < morsel.end_offset;
+         offset++) {
+      auto tile_group = table_->GetTileGroupById(tile_group_ids_[offset]);
+      if (tile_group == nullptr) {
+        continue;
+      }
+
+      std::unique_ptr<executor::LogicalTile> logical_tile(
+          ScanTileGroup(tile_group, snapshot_cid_, column_ids_));
+      if (logical_tile != nullptr) {
+        consumer(worker_id, std::move(logical_tile));
+      }
+    }
+  }
+}
+
+void ParallelTableScanner::Execute(const ConsumerType &consumer) {
+  // Tile groups and varlen data the workers read stay allocated until the
+  // scan is done, the workers run within the pin of the calling thread
+  concurrency::EpochGuard epoch_guard;
+
+  // Compaction may have moved live versions into new tile groups since the
+  // scanner was set up. Their commit ids decide whether the snapshot sees
+  // them or the versions they were copied from.
+  AddTileGroups(table_->GetTileGroupIds());
+
+  if (morsels_.empty() == true) {
+    return;
+  }
+
+  MorselQueue queue(morsels_, numa_node_count_);
+
+  // The calling thread doubles as worker zero
+  TaskGroup scan_group(thread_pool);
+  for (size_t worker_id = 1; worker_id < worker_count_; worker_id++) {
+    scan_group.Run([this, worker_id, &queue, &consumer]() {
+      ScanMorsels(worker_id, queue, consumer);
+    });
+  }
+  ScanMorsels(0, queue, consumer);
+
+  scan_group.Wait();
+}
+
+}  // End storage namespace
+}  // End peloton namespace
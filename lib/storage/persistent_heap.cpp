@@ -0,0 +1,405 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// persistent_heap.cpp
+//
+// Identification: src/storage/persistent_heap.cpp
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include "storage/persistent_heap.h"
+
+#include "common/exception.h"
+#include "common/logger.h"
+#include "common/macros.h"
+#include "storage/storage_manager.h"
+
+namespace peloton {
+namespace storage {
+
+#define PERSISTENT_HEAP_MAGIC UINT64_C(0x50454c4f544f4e48)  // "PELOTONH"
+#define PERSISTENT_HEAP_VERSION 1
+#define PERSISTENT_HEAP_FILE_NAME "peloton.heap"
+
+// Enough for 64 K tile groups
+#define PERSISTENT_HEAP_DESCRIPTOR_COUNT (64 * 1024)
+
+// Extents are cache line aligned so that flushes never share lines
+#define PERSISTENT_HEAP_ALIGNMENT 64
+
+static_assert(sizeof(PersistentTileGroupDescriptor) == 64,
+              "descriptors must fill a cache line");
+
+PersistentHeap::PersistentHeap(const std::string &file_name,
+                               const size_t &heap_size)
+    : file_name(file_name),
+      heap_fd(-1),
+      heap_address(nullptr),
+      heap_size(heap_size),
+      superblock(nullptr),
+      descriptors(nullptr),
+      max_recovered_tile_group_id(INVALID_OID),
+      recovered_tile_group_count(0),
+      next_sequence(1),
+      detached(false) {
+  if ((heap_fd = open(file_name.c_str(), O_CREAT | O_RDWR,
+                      S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP)) < 0) {
+    throw Exception("could not open persistent heap " + file_name + " : " +
+                    strerror(errno));
+  }
+
+  // An existing heap decides its own size
+  PersistentHeapSuperblock existing_superblock;
+  PL_MEMSET(&existing_superblock, 0, sizeof(existing_superblock));
+  bool existing_heap =
+      pread(heap_fd, &existing_superblock, sizeof(existing_superblock), 0) ==
+          sizeof(existing_superblock) &&
+      existing_superblock.magic == PERSISTENT_HEAP_MAGIC &&
+      existing_superblock.version == PERSISTENT_HEAP_VERSION;
+
+  if (existing_heap == true) {
+    this->heap_size = existing_superblock.heap_size;
+  } else if ((errno = posix_fallocate(heap_fd, 0, this->heap_size)) != 0) {
+    throw Exception("could not allocate persistent heap " + file_name +
+                    " : " + strerror(errno));
+  }
+
+  void *address = mmap(nullptr, this->heap_size, PROT_READ | PROT_WRITE,
+                       MAP_SHARED, heap_fd, 0);
+  if (address == MAP_FAILED) {
+    throw Exception("could not map persistent heap " + file_name + " : " +
+                    strerror(errno));
+  }
+
+  heap_address = reinterpret_cast<char *>(address);
+  superblock = reinterpret_cast<PersistentHeapSuperblock *>(heap_address);
+
+  if (existing_heap == true) {
+    Recover();
+  } else {
+    Format();
+  }
+}
+
+PersistentHeap::~PersistentHeap() {
+  if (heap_address != nullptr) {
+    munmap(heap_address, heap_size);
+  }
+  if (heap_fd >= 0) {
+    close(heap_fd);
+  }
+}
+
+std::string PersistentHeap::GetDefaultFileName() {
+  struct stat dir_stat;
+  if (stat(NVM_DIR, &dir_stat) == 0 && S_ISDIR(dir_stat.st_mode)) {
+    return std::string(NVM_DIR) + PERSISTENT_HEAP_FILE_NAME;
+  }
+  return std::string(TMP_DIR) + PERSISTENT_HEAP_FILE_NAME;
+}
+
+void PersistentHeap::Persist(const void *address, const size_t &length) {
+  auto &storage_manager = StorageManager::GetInstance();
+  storage_manager.Sync(BackendType::NVM, const_cast<void *>(address), length);
+}
+
+void PersistentHeap::Format() {
+  size_t page_size = sysconf(_SC_PAGESIZE);
+  size_t descriptor_offset = page_size;
+  size_t descriptor_table_size =
+      PERSISTENT_HEAP_DESCRIPTOR_COUNT * sizeof(PersistentTileGroupDescriptor);
+  size_t data_offset = (descriptor_offset + descriptor_table_size +
+                        page_size - 1) & ~(page_size - 1);
+
+  if (data_offset >= heap_size) {
+    throw Exception("persistent heap of " + std::to_string(heap_size) +
+                    " bytes is too small");
+  }
+
+  // Lay out everything but the magic, which makes the heap valid
+  superblock->magic = 0;
+  superblock->version = PERSISTENT_HEAP_VERSION;
+  superblock->heap_size = heap_size;
+  superblock->descriptor_count = PERSISTENT_HEAP_DESCRIPTOR_COUNT;
+  superblock->descriptor_offset = descriptor_offset;
+  superblock->data_offset = data_offset;
+
+  descriptors = reinterpret_cast<PersistentTileGroupDescriptor *>(
+      GetAddress(descriptor_offset));
+  PL_MEMSET(descriptors, 0, descriptor_table_size);
+
+  Persist(superblock, sizeof(PersistentHeapSuperblock));
+  Persist(descriptors, descriptor_table_size);
+
+  superblock->magic = PERSISTENT_HEAP_MAGIC;
+  Persist(&superblock->magic, sizeof(superblock->magic));
+
+  data_allocator.reset(
+      new ExtentAllocator(heap_size - data_offset, PERSISTENT_HEAP_ALIGNMENT));
+
+  for (oid_t descriptor_id = PERSISTENT_HEAP_DESCRIPTOR_COUNT;
+       descriptor_id > 0; descriptor_id--) {
+    free_descriptors.push_back(descriptor_id - 1);
+  }
+}
+
+void PersistentHeap::Recover() {
+  descriptors = reinterpret_cast<PersistentTileGroupDescriptor *>(
+      GetAddress(superblock->descriptor_offset));
+  data_allocator.reset(new ExtentAllocator(
+      heap_size - superblock->data_offset, PERSISTENT_HEAP_ALIGNMENT));
+
+  // Only the latest descriptor of a tile group counts
+  std::map<oid_t, oid_t> latest_descriptors;
+  for (oid_t descriptor_id = superblock->descriptor_count; descriptor_id > 0;
+       descriptor_id--) {
+    auto &descriptor = descriptors[descriptor_id - 1];
+
+    if (descriptor.state != PERSISTENT_DESCRIPTOR_VALID) {
+      free_descriptors.push_back(descriptor_id - 1);
+      continue;
+    }
+
+    if (descriptor.sequence >= next_sequence) {
+      next_sequence = descriptor.sequence + 1;
+    }
+
+    auto latest_itr = latest_descriptors.find(descriptor.tile_group_id);
+    if (latest_itr == latest_descriptors.end()) {
+      latest_descriptors[descriptor.tile_group_id] = descriptor_id - 1;
+      continue;
+    }
+
+    // Retire the replaced one
+    oid_t replaced_descriptor_id = descriptor_id - 1;
+    if (descriptors[latest_itr->second].sequence < descriptor.sequence) {
+      replaced_descriptor_id = latest_itr->second;
+      latest_itr->second = descriptor_id - 1;
+    }
+    descriptors[replaced_descriptor_id].state = PERSISTENT_DESCRIPTOR_FREE;
+    Persist(&descriptors[replaced_descriptor_id].state,
+            sizeof(descriptors[replaced_descriptor_id].state));
+    free_descriptors.push_back(replaced_descriptor_id);
+  }
+
+  uint64_t data_offset = superblock->data_offset;
+  for (auto &latest_entry : latest_descriptors) {
+    oid_t descriptor_id = latest_entry.second;
+    auto &descriptor = descriptors[descriptor_id];
+
+    // Whatever a valid descriptor refers to is in use
+    bool reserved = data_allocator->Reserve(
+        descriptor.header_offset - data_offset, descriptor.header_size);
+
+    size_t layout_size =
+        descriptor.tile_count * sizeof(PersistentTileExtent) +
+        descriptor.column_count * sizeof(PersistentColumnMapEntry);
+    reserved &= data_allocator->Reserve(descriptor.layout_offset - data_offset,
+                                        layout_size);
+
+    auto tile_extents = reinterpret_cast<PersistentTileExtent *>(
+        GetAddress(descriptor.layout_offset));
+    for (oid_t tile_itr = 0; tile_itr < descriptor.tile_count; tile_itr++) {
+      reserved &= data_allocator->Reserve(
+          tile_extents[tile_itr].offset - data_offset,
+          tile_extents[tile_itr].size);
+    }
+
+    if (reserved == false) {
+      throw Exception("persistent heap " + file_name +
+                      " has overlapping tile groups");
+    }
+
+    recovered_tile_groups[std::make_pair(descriptor.database_id,
+                                         descriptor.table_id)]
+        .push_back(descriptor_id);
+    recovered_tile_group_count++;
+
+    if (max_recovered_tile_group_id == INVALID_OID ||
+        descriptor.tile_group_id > max_recovered_tile_group_id) {
+      max_recovered_tile_group_id = descriptor.tile_group_id;
+    }
+  }
+
+  // Tile groups in creation order
+  for (auto &recovered_entry : recovered_tile_groups) {
+    std::sort(recovered_entry.second.begin(), recovered_entry.second.end(),
+              [this](const oid_t &lhs, const oid_t &rhs) {
+                return descriptors[lhs].tile_group_id <
+                       descriptors[rhs].tile_group_id;
+              });
+  }
+
+  LOG_TRACE("Recovered %lu tile groups from %s", recovered_tile_group_count,
+            file_name.c_str());
+}
+
+void *PersistentHeap::Allocate(const size_t &size) {
+  std::lock_guard<std::mutex> lock(heap_mutex);
+
+  size_t extent_offset = data_allocator->Allocate(size);
+  if (extent_offset == ExtentAllocator::INVALID_EXTENT_OFFSET) {
+    throw Exception("no more memory available in persistent heap : " +
+                    std::to_string(size) + " bytes");
+  }
+
+  return GetAddress(superblock->data_offset + extent_offset);
+}
+
+void PersistentHeap::Free(void *address) {
+  if (detached == true) return;
+
+  std::lock_guard<std::mutex> lock(heap_mutex);
+
+  data_allocator->Release(GetOffset(address) - superblock->data_offset);
+}
+
+size_t PersistentHeap::GetFreeBytes() {
+  std::lock_guard<std::mutex> lock(heap_mutex);
+  return data_allocator->GetFreeBytes();
+}
+
+oid_t PersistentHeap::RegisterTileGroup(
+    const oid_t &database_id, const oid_t &table_id,
+    const oid_t &tile_group_id, const oid_t &tuple_count,
+    const void *header_data, const size_t &header_size,
+    const std::vector<std::pair<const void *, size_t>> &tile_data,
+    const std::map<oid_t, std::pair<oid_t, oid_t>> &column_map) {
+  oid_t descriptor_id = INVALID_OID;
+  uint64_t sequence = 0;
+  {
+    std::lock_guard<std::mutex> lock(heap_mutex);
+    if (free_descriptors.empty() == true) {
+      LOG_ERROR("Persistent heap descriptor table is full");
+      return INVALID_OID;
+    }
+    descriptor_id = free_descriptors.back();
+    free_descriptors.pop_back();
+    sequence = next_sequence++;
+  }
+
+  oid_t tile_count = tile_data.size();
+  oid_t column_count = column_map.size();
+  size_t layout_size = tile_count * sizeof(PersistentTileExtent) +
+                       column_count * sizeof(PersistentColumnMapEntry);
+  char *layout = reinterpret_cast<char *>(Allocate(layout_size));
+
+  auto tile_extents = reinterpret_cast<PersistentTileExtent *>(layout);
+  for (oid_t tile_itr = 0; tile_itr < tile_count; tile_itr++) {
+    tile_extents[tile_itr].offset = GetOffset(tile_data[tile_itr].first);
+    tile_extents[tile_itr].size = tile_data[tile_itr].second;
+  }
+
+  auto column_entries = reinterpret_cast<PersistentColumnMapEntry *>(
+      layout + tile_count * sizeof(PersistentTileExtent));
+  for (auto &column_entry : column_map) {
+    PL_ASSERT(column_entry.first < column_count);
+    column_entries[column_entry.first].tile_offset = column_entry.second.first;
+    column_entries[column_entry.first].tile_column_offset =
+        column_entry.second.second;
+  }
+
+  // The tile group must be complete before the descriptor points to it
+  Persist(header_data, header_size);
+  for (auto &tile_entry : tile_data) {
+    Persist(tile_entry.first, tile_entry.second);
+  }
+  Persist(layout, layout_size);
+
+  auto &descriptor = descriptors[descriptor_id];
+  descriptor.database_id = database_id;
+  descriptor.table_id = table_id;
+  descriptor.tile_group_id = tile_group_id;
+  descriptor.tuple_count = tuple_count;
+  descriptor.tile_count = tile_count;
+  descriptor.column_count = column_count;
+  descriptor.header_offset = GetOffset(header_data);
+  descriptor.header_size = header_size;
+  descriptor.layout_offset = GetOffset(layout);
+  descriptor.sequence = sequence;
+  Persist(&descriptor, sizeof(descriptor));
+
+  descriptor.state = PERSISTENT_DESCRIPTOR_VALID;
+  Persist(&descriptor.state, sizeof(descriptor.state));
+
+  return descriptor_id;
+}
+
+void PersistentHeap::UnregisterTileGroup(const oid_t &descriptor_id) {
+  if (detached == true) return;
+
+  auto &descriptor = descriptors[descriptor_id];
+
+  // Retire the descriptor before any of its extents can be reused
+  descriptor.state = PERSISTENT_DESCRIPTOR_FREE;
+  Persist(&descriptor.state, sizeof(descriptor.state));
+
+  Free(GetAddress(descriptor.layout_offset));
+
+  std::lock_guard<std::mutex> lock(heap_mutex);
+  free_descriptors.push_back(descriptor_id);
+}
+
+std::vector<oid_t> PersistentHeap::TakeRecoveredTileGroups(
+    const oid_t &database_id, const oid_t &table_id) {
+  std::lock_guard<std::mutex> lock(heap_mutex);
+
+  std::vector<oid_t> descriptor_ids;
+  auto recovered_itr =
+      recovered_tile_groups.find(std::make_pair(database_id, table_id));
+  if (recovered_itr != recovered_tile_groups.end()) {
+    descriptor_ids.swap(recovered_itr->second);
+    recovered_tile_groups.erase(recovered_itr);
+  }
+
+  return descriptor_ids;
+}
+
+char *PersistentHeap::GetHeaderData(const oid_t &descriptor_id) const {
+  return GetAddress(descriptors[descriptor_id].header_offset);
+}
+
+std::vector<char *> PersistentHeap::GetTileData(
+    const oid_t &descriptor_id) const {
+  auto &descriptor = descriptors[descriptor_id];
+  auto tile_extents = reinterpret_cast<PersistentTileExtent *>(
+      GetAddress(descriptor.layout_offset));
+
+  std::vector<char *> tile_data;
+  for (oid_t tile_itr = 0; tile_itr < descriptor.tile_count; tile_itr++) {
+    tile_data.push_back(GetAddress(tile_extents[tile_itr].offset));
+  }
+  return tile_data;
+}
+
+std::map<oid_t, std::pair<oid_t, oid_t>> PersistentHeap::GetColumnMap(
+    const oid_t &descriptor_id) const {
+  auto &descriptor = descriptors[descriptor_id];
+  auto column_entries = reinterpret_cast<PersistentColumnMapEntry *>(
+      GetAddress(descriptor.layout_offset) +
+      descriptor.tile_count * sizeof(PersistentTileExtent));
+
+  std::map<oid_t, std::pair<oid_t, oid_t>> column_map;
+  for (oid_t column_itr = 0; column_itr < descriptor.column_count;
+       column_itr++) {
+    column_map[column_itr] =
+        std::make_pair(column_entries[column_itr].tile_offset,
+                       column_entries[column_itr].tile_column_offset);
+  }
+  return column_map;
+}
+
+}  // End storage namespace
+}  // End peloton namespace
@@ -10,7 +10,6 @@
 //
 //===----------------------------------------------------------------------===//
 
-#include <cpuid.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <stdio.h>
@@ -21,14 +20,20 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <string>
 
 #include "common/exception.h"
 #include "common/logger.h"
 #include "common/macros.h"
+#include "common/numa_util.h"
+#include "common/pmem_util.h"
 #include "type/types.h"
 #include "logging/logging_util.h"
+#include "catalog/manager.h"
+#include "storage/persistent_heap.h"
 #include "storage/storage_manager.h"
 
 //===--------------------------------------------------------------------===//
@@ -39,209 +44,24 @@
 // PMEM file size
 size_t peloton_data_file_size = 0;
 
+// Persistent heap size (MB), NVM tiles stay volatile without a heap
+size_t peloton_persistent_heap_size = 0;
+
 namespace peloton {
 namespace storage {
 
 //===--------------------------------------------------------------------===//
-// INSTRUCTIONS
-//===--------------------------------------------------------------------===//
-
-// Source : https://github.com/pmem/nvml/blob/master/src/libpmem/pmem.c
-
-// 64B cache line size
-#define FLUSH_ALIGN ((uintptr_t)64)
-
-#define EAX_IDX 0
-#define EBX_IDX 1
-#define ECX_IDX 2
-#define EDX_IDX 3
-
-#ifndef bit_CLFLUSH
-#define bit_CLFLUSH (1 << 23)
-#endif
-
-#ifndef bit_PCOMMIT
-#define bit_PCOMMIT (1 << 22)
-#endif
-
-#ifndef bit_CLFLUSHOPT
-#define bit_CLFLUSHOPT (1 << 23)
-#endif
-
-#ifndef bit_CLWB
-#define bit_CLWB (1 << 24)
-#endif
-
-/*
- * The x86 memory instructions are new enough that the compiler
- * intrinsic functions are not always available.  The intrinsic
- * functions are defined here in terms of asm statements for now.
- */
-#define _mm_clflushopt(addr) \
-  asm volatile(".byte 0x66; clflush %0" : "+m"(*(volatile char *)addr));
-#define _mm_clwb(addr) \
-  asm volatile(".byte 0x66; xsaveopt %0" : "+m"(*(volatile char *)addr));
-#define _mm_pcommit() asm volatile(".byte 0x66, 0x0f, 0xae, 0xf8");
-
-//===--------------------------------------------------------------------===//
-// CPU CHECK
-//===--------------------------------------------------------------------===//
-
-static inline void cpuid(unsigned func, unsigned subfunc, unsigned cpuinfo[4]) {
-  __cpuid_count(func, subfunc, cpuinfo[EAX_IDX], cpuinfo[EBX_IDX],
-                cpuinfo[ECX_IDX], cpuinfo[EDX_IDX]);
-}
-
-/*
- * is_cpu_genuine_intel -- checks for genuine Intel CPU
- */
-int is_cpu_genuine_intel(void) {
-  unsigned cpuinfo[4] = {0};
-
-  union {
-    char name[0x20];
-    unsigned cpuinfo[3];
-  } vendor;
-
-  PL_MEMSET(&vendor, 0, sizeof(vendor));
-
-  cpuid(0x0, 0x0, cpuinfo);
-
-  vendor.cpuinfo[0] = cpuinfo[EBX_IDX];
-  vendor.cpuinfo[1] = cpuinfo[EDX_IDX];
-  vendor.cpuinfo[2] = cpuinfo[ECX_IDX];
-
-  return (strncmp(vendor.name, "GenuineIntel", sizeof(vendor.name))) == 0;
-}
-
-//===--------------------------------------------------------------------===//
-// INSTRUCTION CHECKS
-//===--------------------------------------------------------------------===//
-
-/*
- * is_cpu_clflush_present -- checks if CLFLUSH instruction is supported
- */
-int is_cpu_clflush_present(void) {
-  unsigned cpuinfo[4] = {0};
-
-  cpuid(0x1, 0x0, cpuinfo);
-
-  int ret = (cpuinfo[EDX_IDX] & bit_CLFLUSH) != 0;
-
-  return ret;
-}
-
-/*
- * is_cpu_clwb_present -- checks if CLWB instruction is supported
- */
-int is_cpu_clwb_present(void) {
-  unsigned cpuinfo[4] = {0};
-
-  if (!is_cpu_genuine_intel()) return 0;
-
-  cpuid(0x7, 0x0, cpuinfo);
-
-  int ret = (cpuinfo[EBX_IDX] & bit_CLWB) != 0;
-
-  return ret;
-}
-
-/*
- * is_cpu_pcommit_present -- checks if PCOMMIT instruction is supported
- */
-int is_cpu_pcommit_present(void) {
-  unsigned cpuinfo[4] = {0};
-
-  if (!is_cpu_genuine_intel()) return 0;
-
-  cpuid(0x7, 0x0, cpuinfo);
-
-  int ret = (cpuinfo[EBX_IDX] & bit_PCOMMIT) != 0;
-
-  return ret;
-}
-
-//===--------------------------------------------------------------------===//
-// FLUSH FUNCTIONS
-//===--------------------------------------------------------------------===//
-
-/*
- * flush_clflush -- (internal) flush the CPU cache, using clflush
- */
-static inline void flush_clflush(const void *addr, size_t len) {
-  uintptr_t uptr;
-
-  // Loop through cache-line-size (typically 64B) aligned chunks
-  // covering the given range.
-  for (uptr = (uintptr_t)addr & ~(FLUSH_ALIGN - 1);
-       uptr < (uintptr_t)addr + len; uptr += FLUSH_ALIGN)
-    _mm_clflush((char *)uptr);
-}
-
-// flush_clwb -- (internal) flush the CPU cache, using clwb
-static inline void flush_clwb(const void *addr, size_t len) {
-  uintptr_t uptr;
-
-  // Loop through cache-line-size (typically 64B) aligned chunks
-  // covering the given range.
-  for (uptr = (uintptr_t)addr & ~(FLUSH_ALIGN - 1);
-       uptr < (uintptr_t)addr + len; uptr += FLUSH_ALIGN) {
-    _mm_clwb((char *)uptr);
-  }
-}
-
-/*
- * pmem_flush() calls through Func_flush to do the work.  Although
- * initialized to flush_clflush(), once the existence of the clflushopt
- * feature is confirmed by pmem_init() at library initialization time,
- * Func_flush is set to flush_clflushopt().  That's the most common case
- * on modern hardware that supports persistent memory.
- */
-static void (*Func_flush)(const void *, size_t) = flush_clflush;
-
-//===--------------------------------------------------------------------===//
-// PREDRAIN FUNCTIONS
+// NVM LATENCY
 //===--------------------------------------------------------------------===//
 
-/*
- * predrain_fence_empty -- (internal) issue the pre-drain fence instruction
- */
-static void predrain_fence_empty(void) {
-  /* nothing to do (because CLFLUSH did it for us) */
-}
+// How long the TSC frequency is measured for
+#define TSC_CALIBRATION_NS 1000000
 
-/*
- * predrain_fence_sfence -- (internal) issue the pre-drain fence instruction
- */
-static void predrain_fence_sfence(void) {
-  _mm_sfence(); /* ensure CLWB or CLFLUSHOPT completes before PCOMMIT */
-}
+// Granularity of the emulated reads of new NVM space
+#define NVM_EMULATION_PAGE_SIZE 4096
 
-/*
- * pmem_drain() calls through Func_predrain_fence to do the fence.  Although
- * initialized to predrain_fence_empty(), once the existence of the CLWB or
- * CLFLUSHOPT feature is confirmed by pmem_init() at library initialization
- * time, Func_predrain_fence is set to predrain_fence_sfence().  That's the
- * most common case on modern hardware that supports persistent memory.
- */
-static void (*Func_predrain_fence)(void) = predrain_fence_empty;
-
-//===--------------------------------------------------------------------===//
-// DRAIN FUNCTIONS
-//===--------------------------------------------------------------------===//
-
-/*
- * drain_no_pcommit -- (internal) wait for PM stores to drain, empty version
- */
-static void drain_no_pcommit(void) {
-  Func_predrain_fence();
-
-  /* caller assumed responsibility for the rest */
-}
-
-// PCOMMIT helpers
-
-#define CPU_FREQ_MHZ (2593)
+// Granularity of the emulated flushes
+#define NVM_EMULATION_LINE_SIZE 64
 
 static inline unsigned long read_tsc(void) {
   unsigned long var;
@@ -255,35 +75,36 @@ static inline unsigned long read_tsc(void) {
 
 static inline void cpu_pause() { __asm__ volatile("pause" ::: "memory"); }
 
-static inline void pcommit(unsigned long lat) {
+// TSC ticks per microsecond. Both clocks run through the same interval, so
+// being descheduled meanwhile does not skew the ratio.
+static double calibrate_tsc_frequency() {
+  auto begin_time = std::chrono::steady_clock::now();
+  unsigned long begin_tsc = read_tsc();
+
+  std::chrono::steady_clock::time_point end_time;
+  do {
+    cpu_pause();
+    end_time = std::chrono::steady_clock::now();
+  } while (end_time - begin_time <
+           std::chrono::nanoseconds(TSC_CALIBRATION_NS));
+  unsigned long end_tsc = read_tsc();
+
+  auto elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        end_time - begin_time).count();
+  return (end_tsc - begin_tsc) * 1000.0 / elapsed_ns;
+}
+
+// Busy-wait for lat nanoseconds
+static inline void emulate_latency(unsigned long lat, double tsc_frequency) {
   // Special case
   if (lat == 0) return;
 
-  unsigned long etsc = read_tsc() + (unsigned long)(lat * CPU_FREQ_MHZ / 1000);
+  unsigned long etsc = read_tsc() + (unsigned long)(lat * tsc_frequency / 1000);
   while (read_tsc() < etsc) {
     cpu_pause();
   }
 }
 
-/*
- * drain_pcommit -- (internal) wait for PM stores to drain, pcommit version
- */
-static void drain_pcommit(void) {
-  Func_predrain_fence();
-
-  // pause if needed
-
-}
-
-/*
- * pmem_drain() calls through Func_drain to do the work.  Although
- * initialized to drain_no_pcommit(), once the existence of the pcommit
- * feature is confirmed by pmem_init() at library initialization time,
- * Func_drain is set to drain_pcommit().  That's the most common case
- * on modern hardware that supports persistent memory.
- */
-static void (*Func_drain)(void) = drain_no_pcommit;
-
 //===--------------------------------------------------------------------===//
 // STORAGE MANAGER
 //===--------------------------------------------------------------------===//
@@ -291,6 +112,12 @@ static void (*Func_drain)(void) = drain_no_pcommit;
 #define DATA_FILE_LEN 1024 * 1024 * UINT64_C(512)  // 512 MB
 #define DATA_FILE_NAME "peloton.pmem"
 
+// Address space reserved up front so that the data file can grow in place
+#define DATA_FILE_MAX_LEN 1024 * 1024 * 1024 * UINT64_C(64)  // 64 GB
+
+// Smaller allocations would waste most of a huge page
+#define HUGE_PAGE_MIN_ALLOCATION_SIZE (HUGE_PAGE_SIZE / 2)
+
 // global singleton
 StorageManager &StorageManager::GetInstance(void) {
   static StorageManager storage_manager;
@@ -298,7 +125,10 @@ StorageManager &StorageManager::GetInstance(void) {
 }
 
 StorageManager::StorageManager()
-    : data_file_address(nullptr), data_file_len(0), data_file_offset(0) {
+    : data_file_address(nullptr),
+      data_file_fd(-1),
+      data_file_len(0),
+      data_file_reserved_len(0) {
   // Check if we need a data pool
 
 
@@ -311,7 +141,6 @@ StorageManager::StorageManager()
 
   // Check for relevant file system
   bool found_file_system = false;
-  int data_fd;
   std::string data_file_name;
   struct stat data_stat;
 
@@ -329,7 +158,7 @@ StorageManager::StorageManager()
   LOG_TRACE("DATA DIR :: %s ", data_file_name.c_str());
 
   // Create a data file
-  if ((data_fd = open(
+  if ((data_file_fd = open(
            data_file_name.c_str(), O_CREAT | O_TRUNC | O_RDWR,
            S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH | S_IWOTH)) < 0) {
     perror(data_file_name.c_str());
@@ -337,23 +166,50 @@ StorageManager::StorageManager()
   }
 
   // Allocate the data file
-  if ((errno = posix_fallocate(data_fd, 0, data_file_len)) != 0) {
+  if ((errno = posix_fallocate(data_file_fd, 0, data_file_len)) != 0) {
     perror("posix_fallocate");
     exit(EXIT_FAILURE);
   }
 
-  // map the data file in memory
-  if ((data_file_address = mmap(NULL, data_file_len, PROT_READ | PROT_WRITE,
-                                MAP_SHARED, data_fd, 0)) == MAP_FAILED) {
+  // reserve address space for the data file and its growth
+  data_file_reserved_len = std::max<size_t>(DATA_FILE_MAX_LEN, data_file_len);
+  if ((data_file_address =
+           mmap(NULL, data_file_reserved_len, PROT_NONE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0)) ==
+      MAP_FAILED) {
+    perror("mmap");
+    exit(EXIT_FAILURE);
+  }
+
+  // map the data file in memory at the start of the reservation
+  if (mmap(data_file_address, data_file_len, PROT_READ | PROT_WRITE,
+           MAP_SHARED | MAP_FIXED, data_file_fd, 0) == MAP_FAILED) {
     perror("mmap");
     exit(EXIT_FAILURE);
   }
 
-  // close the pmem file -- it will remain mapped
-  close(data_fd);
+  data_file_allocator.reset(new ExtentAllocator(data_file_len));
+
+  // Open the persistent heap at startup, tables re-attach the tile groups
+  // found in it as they join their databases
+  if (peloton_persistent_heap_size != 0) {
+    size_t recovered_tile_group_count =
+        OpenPersistentHeap(PersistentHeap::GetDefaultFileName(),
+                           peloton_persistent_heap_size * 1024 * 1024);
+    LOG_INFO("Opened persistent heap with %lu tile groups",
+             recovered_tile_group_count);
+  }
 }
 
 StorageManager::~StorageManager() {
+  // finish queued syncs
+  StopSyncFlusher();
+
+  // pooled buffers go back to their backends while these are still up
+  zeroed_buffer_pool.Shutdown();
+
+  // tiles released during static destruction must stay in the heap
+  ClosePersistentHeap();
 
   // sync and unmap the data file
   if (data_file_address != nullptr) {
@@ -364,53 +220,151 @@ StorageManager::~StorageManager() {
       exit(EXIT_FAILURE);
     }
 
-    if (munmap(data_file_address, data_file_len)) {
+    if (munmap(data_file_address, data_file_reserved_len)) {
       perror("munmap");
       exit(EXIT_FAILURE);
     }
   }
+
+  if (data_file_fd >= 0) {
+    close(data_file_fd);
+  }
+}
+
+size_t StorageManager::AllocateDataFileExtent(size_t size) {
+  data_file_spinlock.Lock();
+  size_t extent_offset = data_file_allocator->Allocate(size);
+  data_file_spinlock.Unlock();
+  return extent_offset;
+}
+
+void StorageManager::GrowDataFile(size_t size) {
+  // At least double the file to amortize growth
+  size_t old_data_file_len = data_file_len;
+  size_t page_size = sysconf(_SC_PAGESIZE);
+  size_t aligned_size = (size + page_size - 1) & ~(page_size - 1);
+  size_t new_data_file_len =
+      old_data_file_len + std::max<size_t>(old_data_file_len, aligned_size);
+  if (new_data_file_len > data_file_reserved_len) {
+    new_data_file_len = data_file_reserved_len;
+  }
+
+  if (new_data_file_len < old_data_file_len + aligned_size) {
+    throw Exception("data file can not grow beyond " +
+                    std::to_string(data_file_reserved_len) + " bytes");
+  }
+
+  size_t delta = new_data_file_len - old_data_file_len;
+  if ((errno = posix_fallocate(data_file_fd, old_data_file_len, delta)) !=
+      0) {
+    throw Exception("could not extend data file to " +
+                    std::to_string(new_data_file_len) + " bytes : " +
+                    strerror(errno));
+  }
+
+  // Map the new tail over the reservation, existing extents stay in place
+  char *tail_address = reinterpret_cast<char *>(data_file_address) +
+                       old_data_file_len;
+  if (mmap(tail_address, delta, PROT_READ | PROT_WRITE,
+           MAP_SHARED | MAP_FIXED, data_file_fd, old_data_file_len) ==
+      MAP_FAILED) {
+    throw Exception("could not map data file tail : " +
+                    std::string(strerror(errno)));
+  }
+
+  LOG_TRACE("Data file grew from %lu to %lu bytes", old_data_file_len,
+            new_data_file_len);
+
+  // Only publishing the new tail needs the data file lock
+  data_file_spinlock.Lock();
+  data_file_len = new_data_file_len;
+  data_file_allocator->Grow(new_data_file_len);
+  data_file_growth_count++;
+  data_file_spinlock.Unlock();
 }
 
-void *StorageManager::Allocate(BackendType type, size_t size) {
+size_t StorageManager::GetDataFileFreeBytes() {
+  data_file_spinlock.Lock();
+  size_t free_bytes = data_file_allocator->GetFreeBytes();
+  data_file_spinlock.Unlock();
+  return free_bytes;
+}
+
+void *StorageManager::Allocate(BackendType type, size_t size,
+                               int numa_node) {
   // Update allocation count
-  allocation_count++;
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
 
   switch (type) {
     case BackendType::MM:
     case BackendType::NVM: {
-      return ::operator new(size);
-    } break;
-
-    case BackendType::SSD:
-    case BackendType::HDD: {
-      {
-        size_t cache_data_file_offset = 0;
+      // first touch of the new space reads it from the device
+      if (type == BackendType::NVM && nvm_latency_emulation == true) {
+        size_t page_count = (size + NVM_EMULATION_PAGE_SIZE - 1) /
+                            NVM_EMULATION_PAGE_SIZE;
+        EmulateNvmLatency(
+            nvm_read_latency.load(std::memory_order_relaxed) * page_count);
+      }
 
-        // Lock the file
-        data_file_spinlock.Lock();
+      if (type == BackendType::NVM && persistent_heap != nullptr) {
+        return persistent_heap->Allocate(size);
+      }
 
-        // Check if within bounds
-        if (data_file_offset < data_file_len) {
-          cache_data_file_offset = data_file_offset;
+      if (huge_page_mode == true && size >= HUGE_PAGE_MIN_ALLOCATION_SIZE) {
+        huge_page_allocation_count.fetch_add(1, std::memory_order_relaxed);
+        return huge_page_pool.Allocate(size, numa_node);
+      }
 
-          // Offset by the requested size
-          data_file_offset += size;
+      if (numa_node == INVALID_NUMA_NODE || NumaUtil::GetNodeCount() == 1) {
+        void *address = malloc(size);
+        if (address == nullptr) {
+          throw Exception("could not allocate " + std::to_string(size) +
+                          " bytes");
+        }
+        return address;
+      }
 
-          // Unlock the file
-          data_file_spinlock.Unlock();
+      // mbind works at page granularity, so give the allocation its own
+      // pages. If binding fails the pages are placed on first touch, which
+      // happens when the caller zeroes them.
+      size_t page_size = sysconf(_SC_PAGESIZE);
+      size_t aligned_size = (size + page_size - 1) & ~(page_size - 1);
+      void *address = nullptr;
+      if (posix_memalign(&address, page_size, aligned_size) != 0) {
+        throw Exception("could not allocate " + std::to_string(size) +
+                        " bytes on node " + std::to_string(numa_node));
+      }
+      if (NumaUtil::BindToNode(address, aligned_size, numa_node) == true) {
+        numa_allocation_count.fetch_add(1, std::memory_order_relaxed);
+      }
+      return address;
+    } break;
 
-          void *address = reinterpret_cast<char *>(data_file_address) +
-                          cache_data_file_offset;
-          return address;
+    case BackendType::SSD:
+    case BackendType::HDD: {
+      size_t extent_offset = AllocateDataFileExtent(size);
+
+      // Growing the file takes syscalls, other allocators keep taking
+      // extents from the data file lock meanwhile
+      if (extent_offset == ExtentAllocator::INVALID_EXTENT_OFFSET) {
+        std::lock_guard<std::mutex> growth_lock(data_file_growth_mutex);
+
+        // Another thread may have grown the file while this one waited
+        extent_offset = AllocateDataFileExtent(size);
+        if (extent_offset == ExtentAllocator::INVALID_EXTENT_OFFSET) {
+          GrowDataFile(size);
+          extent_offset = AllocateDataFileExtent(size);
         }
+      }
 
-        data_file_spinlock.Unlock();
-        throw Exception("no more memory available: offset : " +
-                        std::to_string(data_file_offset) + " length : " +
+      if (extent_offset == ExtentAllocator::INVALID_EXTENT_OFFSET) {
+        throw Exception("no more memory available: length : " +
                         std::to_string(data_file_len));
-
-        return nullptr;
       }
+
+      void *address =
+          reinterpret_cast<char *>(data_file_address) + extent_offset;
+      return address;
     } break;
 
     case BackendType::INVALID:
@@ -425,12 +379,33 @@ void StorageManager::Release(BackendType type, void *address) {
   switch (type) {
     case BackendType::MM:
     case BackendType::NVM: {
-      ::operator delete(address);
+      if (persistent_heap != nullptr && persistent_heap->Contains(address)) {
+        persistent_heap->Free(address);
+        break;
+      }
+
+      // Huge page regions go back to their pool
+      if (huge_page_pool.GetLiveBytes() > 0 &&
+          huge_page_pool.Release(address) == true) {
+        break;
+      }
+      free(address);
     } break;
 
     case BackendType::SSD:
     case BackendType::HDD: {
-      // Nothing to do here
+      size_t extent_offset = reinterpret_cast<char *>(address) -
+                             reinterpret_cast<char *>(data_file_address);
+
+      // Return the extent to the free lists
+      data_file_spinlock.Lock();
+      size_t extent_length = data_file_allocator->Release(extent_offset);
+      data_file_spinlock.Unlock();
+
+      if (extent_length == 0) {
+        LOG_ERROR("Releasing unknown data file extent at offset %lu",
+                  extent_offset);
+      }
     } break;
 
     case BackendType::INVALID:
@@ -441,6 +416,27 @@ void StorageManager::Release(BackendType type, void *address) {
   }
 }
 
+void *StorageManager::AllocateZeroed(BackendType type, size_t size,
+                                     int numa_node) {
+  if (buffer_pool_mode == true) {
+    return zeroed_buffer_pool.Allocate(type, size, numa_node);
+  }
+
+  void *address = Allocate(type, size, numa_node);
+  PL_MEMSET(address, 0, size);
+  return address;
+}
+
+void StorageManager::ReleaseZeroed(BackendType type, void *address,
+                                   size_t size, int numa_node) {
+  if (buffer_pool_mode == true) {
+    zeroed_buffer_pool.Release(type, address, size, numa_node);
+    return;
+  }
+
+  Release(type, address);
+}
+
 void StorageManager::Sync(BackendType type, void *address, size_t length) {
   switch (type) {
     case BackendType::MM: {
@@ -449,21 +445,38 @@ void StorageManager::Sync(BackendType type, void *address, size_t length) {
 
     case BackendType::NVM: {
       // flush writes to NVM
-      Func_flush(address, length);
-      Func_drain();
-      clflush_count++;
+      PmemUtil::Persist(address, length);
+      clflush_count.fetch_add(1, std::memory_order_relaxed);
+
+      // every line flushed, then wait for the writes to drain
+      if (nvm_latency_emulation == true) {
+        uintptr_t begin = reinterpret_cast<uintptr_t>(address);
+        size_t line_count =
+            (begin + length + NVM_EMULATION_LINE_SIZE - 1) /
+                NVM_EMULATION_LINE_SIZE -
+            begin / NVM_EMULATION_LINE_SIZE;
+        EmulateNvmLatency(
+            nvm_flush_latency.load(std::memory_order_relaxed) * line_count +
+            nvm_write_latency.load(std::memory_order_relaxed));
+      }
     } break;
 
     case BackendType::SSD:
     case BackendType::HDD: {
-      // sync the mmap'ed file to SSD or HDD
-      int status = msync(data_file_address, data_file_len, MS_SYNC);
-      if (status != 0) {
-        perror("msync");
-        exit(EXIT_FAILURE);
+      if (length == 0) break;
+
+      size_t offset = reinterpret_cast<char *>(address) -
+                      reinterpret_cast<char *>(data_file_address);
+
+      // sync the mmap'ed range to SSD or HDD, or leave it to the flusher
+      if (async_sync_mode == true) {
+        std::lock_guard<std::mutex> lock(sync_mutex);
+        queued_sync_ranges.emplace_back(offset, length);
+        queued_sync_count++;
+        sync_queued_cv.notify_one();
+      } else {
+        SyncDataFile(offset, length);
       }
-
-      msync_count++;
     } break;
 
     case BackendType::INVALID:
@@ -473,5 +486,199 @@ void StorageManager::Sync(BackendType type, void *address, size_t length) {
   }
 }
 
+void StorageManager::SetNvmLatencyEmulation(size_t read_latency,
+                                            size_t write_latency,
+                                            size_t flush_latency) {
+  bool latency_emulation =
+      (read_latency != 0 || write_latency != 0 || flush_latency != 0);
+
+  // The calibration busy-waits, only pay for it when emulating
+  if (latency_emulation == true) {
+    std::call_once(tsc_calibration_flag,
+                   [this] { tsc_frequency = calibrate_tsc_frequency(); });
+  }
+
+  nvm_read_latency.store(read_latency, std::memory_order_relaxed);
+  nvm_write_latency.store(write_latency, std::memory_order_relaxed);
+  nvm_flush_latency.store(flush_latency, std::memory_order_relaxed);
+  nvm_latency_emulation = latency_emulation;
+}
+
+void StorageManager::EmulateNvmLatency(size_t latency) {
+  if (latency == 0) return;
+
+  emulate_latency(latency, tsc_frequency);
+  emulated_latency += latency;
+}
+
+size_t StorageManager::OpenPersistentHeap(const std::string &file_name,
+                                          size_t heap_size) {
+  if (persistent_heap != nullptr) {
+    throw Exception("persistent heap is already open : " +
+                    persistent_heap->GetFileName());
+  }
+  persistent_heap = new PersistentHeap(file_name, heap_size);
+
+  // New tile groups must not reuse the ids of recovered ones
+  auto &manager = catalog::Manager::GetInstance();
+  oid_t max_tile_group_id = persistent_heap->GetMaxRecoveredTileGroupId();
+  if (max_tile_group_id != INVALID_OID &&
+      manager.GetCurrentTileGroupId() < max_tile_group_id) {
+    manager.SetNextTileGroupId(max_tile_group_id);
+  }
+
+  return persistent_heap->GetRecoveredTileGroupCount();
+}
+
+void StorageManager::ClosePersistentHeap() {
+  if (persistent_heap != nullptr) {
+    persistent_heap->Detach();
+  }
+}
+
+bool StorageManager::NeedsSync(BackendType type) const {
+  switch (type) {
+    case BackendType::SSD:
+    case BackendType::HDD:
+      return true;
+
+    case BackendType::NVM:
+      return persistent_heap != nullptr;
+
+    case BackendType::MM:
+    case BackendType::INVALID:
+    default:
+      return false;
+  }
+}
+
+void StorageManager::SyncDataFile(size_t offset, size_t length) {
+  // msync works on whole pages
+  size_t page_size = sysconf(_SC_PAGESIZE);
+  size_t begin_offset = offset & ~(page_size - 1);
+  size_t end_offset = (offset + length + page_size - 1) & ~(page_size - 1);
+
+  int status = msync(reinterpret_cast<char *>(data_file_address) + begin_offset,
+                     end_offset - begin_offset, MS_SYNC);
+  if (status != 0) {
+    perror("msync");
+    exit(EXIT_FAILURE);
+  }
+
+  msync_count++;
+  synced_byte_count += end_offset - begin_offset;
+}
+
+void StorageManager::SetAsyncSyncMode(const bool enabled) {
+  {
+    std::lock_guard<std::mutex> lock(sync_mutex);
+    if (enabled == true && sync_flusher.joinable() == false) {
+      sync_flusher_shutdown = false;
+      sync_flusher = std::thread(&StorageManager::FlushSyncRanges, this);
+    }
+    async_sync_mode = enabled;
+  }
+
+  // Ranges queued so far are still expected to become durable
+  if (enabled == false) {
+    WaitForSync();
+  }
+}
+
+void StorageManager::WaitForSync() {
+  std::unique_lock<std::mutex> lock(sync_mutex);
+  size_t wait_sync_count = queued_sync_count;
+  sync_done_cv.wait(lock, [this, wait_sync_count] {
+    return durable_sync_count >= wait_sync_count;
+  });
+}
+
+void StorageManager::StopSyncFlusher() {
+  {
+    std::lock_guard<std::mutex> lock(sync_mutex);
+    sync_flusher_shutdown = true;
+    sync_queued_cv.notify_one();
+  }
+
+  if (sync_flusher.joinable()) {
+    sync_flusher.join();
+  }
+}
+
+void StorageManager::FlushSyncRanges() {
+  size_t page_size = sysconf(_SC_PAGESIZE);
+  std::vector<std::pair<size_t, size_t>> sync_ranges;
+
+  std::unique_lock<std::mutex> lock(sync_mutex);
+  while (true) {
+    sync_queued_cv.wait(lock, [this] {
+      return queued_sync_ranges.empty() == false || sync_flusher_shutdown;
+    });
+
+    // Shut down once drained
+    if (queued_sync_ranges.empty() == true) break;
+
+    sync_ranges.clear();
+    sync_ranges.swap(queued_sync_ranges);
+    size_t batch_sync_count = queued_sync_count;
+    lock.unlock();
+
+    // Page align, then merge overlapping and adjacent ranges
+    for (auto &sync_range : sync_ranges) {
+      size_t end_offset = (sync_range.first + sync_range.second +
+                           page_size - 1) & ~(page_size - 1);
+      sync_range.first &= ~(page_size - 1);
+      sync_range.second = end_offset;
+    }
+    std::sort(sync_ranges.begin(), sync_ranges.end());
+
+    size_t merged_count = 0;
+    for (auto &sync_range : sync_ranges) {
+      if (merged_count > 0 &&
+          sync_range.first <= sync_ranges[merged_count - 1].second) {
+        sync_ranges[merged_count - 1].second = std::max(
+            sync_ranges[merged_count - 1].second, sync_range.second);
+      } else {
+        sync_ranges[merged_count++] = sync_range;
+      }
+    }
+    sync_ranges.resize(merged_count);
+
+    // Start writeback of every range before waiting on any of them
+    for (auto &sync_range : sync_ranges) {
+      sync_file_range(data_file_fd, sync_range.first,
+                      sync_range.second - sync_range.first,
+                      SYNC_FILE_RANGE_WRITE);
+    }
+
+    size_t batch_byte_count = 0;
+    for (auto &sync_range : sync_ranges) {
+      if (sync_file_range(data_file_fd, sync_range.first,
+                          sync_range.second - sync_range.first,
+                          SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE |
+                              SYNC_FILE_RANGE_WAIT_AFTER) != 0) {
+        perror("sync_file_range");
+        exit(EXIT_FAILURE);
+      }
+      batch_byte_count += sync_range.second - sync_range.first;
+    }
+
+    // sync_file_range neither flushes the device cache nor the metadata of
+    // a grown file
+    if (fdatasync(data_file_fd) != 0) {
+      perror("fdatasync");
+      exit(EXIT_FAILURE);
+    }
+
+    msync_count += sync_ranges.size();
+    synced_byte_count += batch_byte_count;
+
+    lock.lock();
+    durable_sync_count = batch_sync_count;
+    sync_batch_count++;
+    sync_done_cv.notify_all();
+  }
+}
+
 }  // End storage namespace
 }  // End peloton namespace
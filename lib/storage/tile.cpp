@@ -16,6 +16,7 @@
 #include "catalog/schema.h"
 #include "common/exception.h"
 #include "common/macros.h"
+#include "common/pmem_util.h"
 #include "type/serializer.h"
 #include "type/types.h"
 #include "type/ephemeral_pool.h"
@@ -30,12 +31,13 @@ namespace storage {
 
 Tile::Tile(BackendType backend_type, TileGroupHeader *tile_header,
            const catalog::Schema &tuple_schema, TileGroup *tile_group,
-           int tuple_count)
+           int tuple_count, int numa_node)
     : database_id(INVALID_OID),
       table_id(INVALID_OID),
       tile_group_id(INVALID_OID),
       tile_id(INVALID_OID),
       backend_type(backend_type),
+      numa_node(numa_node),
       schema(tuple_schema),
       data(NULL),
       tile_group(tile_group),
@@ -51,25 +53,50 @@ Tile::Tile(BackendType backend_type, TileGroupHeader *tile_header,
 
   tile_size = tuple_count * tuple_length;
 
-  // allocate tuple storage space for inlined data
+  // allocate zeroed tuple storage space for inlined data
   auto &storage_manager = storage::StorageManager::GetInstance();
   data = reinterpret_cast<char *>(
-      storage_manager.Allocate(backend_type, tile_size));
+      storage_manager.AllocateZeroed(backend_type, tile_size, numa_node));
   PL_ASSERT(data != NULL);
 
-  // zero out the data
-  PL_MEMSET(data, 0, tile_size);
-
   // allocate pool for blob storage if schema not inlined
   // if (schema.IsInlined() == false) {
   pool = new type::EphemeralPool();
   //}
 }
 
+Tile::Tile(BackendType backend_type, TileGroupHeader *tile_header,
+           const catalog::Schema &tuple_schema, TileGroup *tile_group,
+           int tuple_count, char *persistent_data)
+    : database_id(INVALID_OID),
+      table_id(INVALID_OID),
+      tile_group_id(INVALID_OID),
+      tile_id(INVALID_OID),
+      backend_type(backend_type),
+      numa_node(INVALID_NUMA_NODE),
+      schema(tuple_schema),
+      data(persistent_data),
+      tile_group(tile_group),
+      pool(NULL),
+      num_tuple_slots(tuple_count),
+      column_count(tuple_schema.GetColumnCount()),
+      tuple_length(tuple_schema.GetLength()),
+      uninlined_data_size(0),
+      column_header(NULL),
+      column_header_size(INVALID_OID),
+      tile_group_header(tile_header) {
+  PL_ASSERT(tuple_count > 0);
+  PL_ASSERT(data != NULL);
+
+  tile_size = tuple_count * tuple_length;
+
+  pool = new type::EphemeralPool();
+}
+
 Tile::~Tile() {
   // reclaim the tile memory (INLINED data)
   auto &storage_manager = storage::StorageManager::GetInstance();
-  storage_manager.Release(backend_type, data);
+  storage_manager.ReleaseZeroed(backend_type, data, tile_size, numa_node);
   data = NULL;
 
   // reclaim the tile memory (UNINLINED data)
@@ -99,6 +126,10 @@ void Tile::InsertTuple(const oid_t tuple_offset, Tuple *tuple) {
 
   // Copy over the tuple data into the tuple slot in the tile
   PL_MEMCPY(location, tuple->tuple_data_, tuple_length);
+
+  if (tile_group_header != nullptr) {
+    tile_group_header->MarkDirty(tuple_offset);
+  }
 }
 
 /**
@@ -155,6 +186,10 @@ void Tile::SetValue(const type::Value &value, const oid_t tuple_offset,
   // const bool is_in_bytes = false;
   PL_ASSERT(pool != nullptr);
   value.SerializeTo(field_location, is_inlined, pool);
+
+  if (tile_group_header != nullptr) {
+    tile_group_header->MarkDirty(tuple_offset);
+  }
 }
 
 
@@ -175,6 +210,37 @@ void Tile::SetValueFast(const type::Value &value, const oid_t tuple_offset,
   // const bool is_in_bytes = false;
   PL_ASSERT(pool != nullptr);
   value.SerializeTo(field_location, is_inlined, pool);
+
+  if (tile_group_header != nullptr) {
+    tile_group_header->MarkDirty(tuple_offset);
+  }
+}
+
+void Tile::FreeUninlinedData(const oid_t tuple_offset) {
+  PL_ASSERT(tuple_offset < num_tuple_slots);
+
+  if (schema.IsInlined() == true) {
+    return;
+  }
+
+  char *tuple_location = GetTupleLocation(tuple_offset);
+  for (oid_t column_itr = 0; column_itr < column_count; column_itr++) {
+    if (schema.IsInlined(column_itr) == true) {
+      continue;
+    }
+
+    // Uninlined fields hold a pointer to the value in the pool
+    char **field_location =
+        reinterpret_cast<char **>(tuple_location + schema.GetOffset(column_itr));
+    if (*field_location != nullptr) {
+      pool->Free(*field_location);
+      *field_location = nullptr;
+    }
+  }
+
+  if (tile_group_header != nullptr) {
+    tile_group_header->MarkDirty(tuple_offset);
+  }
 }
 
 Tile *Tile::CopyTile(BackendType backend_type) {
@@ -188,8 +254,9 @@ Tile *Tile::CopyTile(BackendType backend_type) {
       backend_type, INVALID_OID, INVALID_OID, INVALID_OID, INVALID_OID,
       new_header, *schema, tile_group, allocated_tuple_count);
 
-  PL_MEMCPY(static_cast<void *>(new_tile->data), static_cast<void *>(data),
-            tile_size);
+  PmemUtil::MemcpyNontemporal(static_cast<void *>(new_tile->data),
+                              static_cast<void *>(data), tile_size);
+  PmemUtil::Fence();
 
   // Do a deep copy if some column is uninlined, so that
   // the values in that column point to the new pool
@@ -475,6 +542,14 @@ void Tile::Sync() {
   storage_manager.Sync(backend_type, data, tile_size);
 }
 
+void Tile::Sync(const oid_t &begin_slot, const oid_t &end_slot) {
+  PL_ASSERT(begin_slot <= end_slot && end_slot <= num_tuple_slots);
+
+  auto &storage_manager = storage::StorageManager::GetInstance();
+  storage_manager.Sync(backend_type, data + begin_slot * tuple_length,
+                       (end_slot - begin_slot) * tuple_length);
+}
+
 //===--------------------------------------------------------------------===//
 // Utilities
 //===--------------------------------------------------------------------===//
@@ -20,6 +20,8 @@
 #include "common/platform.h"
 #include "type/types.h"
 #include "storage/abstract_table.h"
+#include "storage/persistent_heap.h"
+#include "storage/storage_manager.h"
 #include "storage/tile.h"
 #include "storage/tile_group_header.h"
 #include "storage/tuple.h"
@@ -30,7 +32,8 @@ namespace storage {
 TileGroup::TileGroup(BackendType backend_type,
                      TileGroupHeader *tile_group_header, AbstractTable *table,
                      const std::vector<catalog::Schema> &schemas,
-                     const column_map_type &column_map, int tuple_count)
+                     const column_map_type &column_map, int tuple_count,
+                     int numa_node)
     : database_id(INVALID_OID),
       table_id(INVALID_OID),
       tile_group_id(INVALID_OID),
@@ -39,7 +42,9 @@ TileGroup::TileGroup(BackendType backend_type,
       tile_group_header(tile_group_header),
       table(table),
       num_tuple_slots(tuple_count),
-      column_map(column_map) {
+      numa_node(numa_node),
+      column_map(column_map),
+      persistent_descriptor_id(INVALID_OID) {
   tile_count = tile_schemas.size();
 
   for (oid_t tile_itr = 0; tile_itr < tile_count; tile_itr++) {
@@ -48,7 +53,41 @@ TileGroup::TileGroup(BackendType backend_type,
 
     std::shared_ptr<Tile> tile(storage::TileFactory::GetTile(
         backend_type, database_id, table_id, tile_group_id, tile_id,
-        tile_group_header, tile_schemas[tile_itr], this, tuple_count));
+        tile_group_header, tile_schemas[tile_itr], this, tuple_count,
+        numa_node));
+
+    // Add a reference to the tile in the tile group
+    tiles.push_back(tile);
+  }
+}
+
+TileGroup::TileGroup(BackendType backend_type,
+                     TileGroupHeader *tile_group_header, AbstractTable *table,
+                     const std::vector<catalog::Schema> &schemas,
+                     const column_map_type &column_map, int tuple_count,
+                     const std::vector<char *> &persistent_tile_data)
+    : database_id(INVALID_OID),
+      table_id(INVALID_OID),
+      tile_group_id(INVALID_OID),
+      backend_type(backend_type),
+      tile_schemas(schemas),
+      tile_group_header(tile_group_header),
+      table(table),
+      num_tuple_slots(tuple_count),
+      numa_node(INVALID_NUMA_NODE),
+      column_map(column_map),
+      persistent_descriptor_id(INVALID_OID) {
+  tile_count = tile_schemas.size();
+  PL_ASSERT(persistent_tile_data.size() == tile_count);
+
+  for (oid_t tile_itr = 0; tile_itr < tile_count; tile_itr++) {
+    auto &manager = catalog::Manager::GetInstance();
+    oid_t tile_id = manager.GetNextTileId();
+
+    std::shared_ptr<Tile> tile(storage::TileFactory::GetTile(
+        backend_type, database_id, table_id, tile_group_id, tile_id,
+        tile_group_header, tile_schemas[tile_itr], this, tuple_count,
+        persistent_tile_data[tile_itr]));
 
     // Add a reference to the tile in the tile group
     tiles.push_back(tile);
@@ -56,6 +95,13 @@ TileGroup::TileGroup(BackendType backend_type,
 }
 
 TileGroup::~TileGroup() {
+  // Retire the tile group from the persistent heap before its tiles go
+  if (persistent_descriptor_id != INVALID_OID) {
+    auto &storage_manager = StorageManager::GetInstance();
+    storage_manager.GetPersistentHeap()->UnregisterTileGroup(
+        persistent_descriptor_id);
+  }
+
   // Drop references on all tiles
 
   // clean up tile group header
@@ -121,6 +167,8 @@ void TileGroup::CopyTuple(const Tuple *tuple, const oid_t &tuple_slot_id) {
       column_itr++;
     }
   }
+
+  tile_group_header->MarkDirty(tuple_slot_id);
 }
 
 /**
@@ -159,13 +207,19 @@ oid_t TileGroup::InsertTuple(const Tuple *tuple) {
   return tuple_slot_id;
 }
 
+void TileGroup::FreeUninlinedData(const oid_t &tuple_slot_id) {
+  for (oid_t tile_itr = 0; tile_itr < tile_count; tile_itr++) {
+    GetTile(tile_itr)->FreeUninlinedData(tuple_slot_id);
+  }
+}
+
 /**
- * Grab specific slot and fill in the tuple
+ * Grab specific slot and fill in the tuple serialized in the log
  * Used by recovery
  * Returns slot where inserted (INVALID_ID if not inserted)
  */
 oid_t TileGroup::InsertTupleFromRecovery(cid_t commit_id, oid_t tuple_slot_id,
-                                         const Tuple *tuple) {
+                                         SerializeInput &tuple_body) {
   auto status = tile_group_header->GetEmptyTupleSlot(tuple_slot_id);
 
   // No more slots
@@ -182,28 +236,7 @@ oid_t TileGroup::InsertTupleFromRecovery(cid_t commit_id, oid_t tuple_slot_id,
   LOG_TRACE("Tile Group Id :: %u status :: %u out of %u slots ", tile_group_id,
             tuple_slot_id, num_tuple_slots);
 
-  oid_t tile_column_count;
-  oid_t column_itr = 0;
-
-  for (oid_t tile_itr = 0; tile_itr < tile_count; tile_itr++) {
-    const catalog::Schema &schema = tile_schemas[tile_itr];
-    tile_column_count = schema.GetColumnCount();
-
-    storage::Tile *tile = GetTile(tile_itr);
-    PL_ASSERT(tile);
-    char *tile_tuple_location = tile->GetTupleLocation(tuple_slot_id);
-    PL_ASSERT(tile_tuple_location);
-
-    // NOTE:: Only a tuple wrapper
-    storage::Tuple tile_tuple(&schema, tile_tuple_location);
-
-    for (oid_t tile_column_itr = 0; tile_column_itr < tile_column_count;
-         tile_column_itr++) {
-      type::Value val = (tuple->GetValue(column_itr));
-      tile_tuple.SetValue(tile_column_itr, val, tile->GetPool());
-      column_itr++;
-    }
-  }
+  CopySerializedTuple(tuple_slot_id, tuple_body);
 
   // Set MVCC info
   tile_group_header->SetTransactionId(tuple_slot_id, INITIAL_TXN_ID);
@@ -272,7 +305,7 @@ oid_t TileGroup::UpdateTupleFromRecovery(cid_t commit_id, oid_t tuple_slot_id,
  * Returns slot where inserted (INVALID_ID if not inserted)
  */
 oid_t TileGroup::InsertTupleFromCheckpoint(oid_t tuple_slot_id,
-                                           const Tuple *tuple,
+                                           SerializeInput &tuple_body,
                                            cid_t commit_id) {
   auto status = tile_group_header->GetEmptyTupleSlot(tuple_slot_id);
 
@@ -282,36 +315,77 @@ oid_t TileGroup::InsertTupleFromCheckpoint(oid_t tuple_slot_id,
   LOG_TRACE("Tile Group Id :: %u status :: %u out of %u slots ", tile_group_id,
             tuple_slot_id, num_tuple_slots);
 
-  oid_t tile_column_count;
-  oid_t column_itr = 0;
+  CopySerializedTuple(tuple_slot_id, tuple_body);
 
-  for (oid_t tile_itr = 0; tile_itr < tile_count; tile_itr++) {
+  // Set MVCC info
+  tile_group_header->SetTransactionId(tuple_slot_id, INITIAL_TXN_ID);
+  tile_group_header->SetBeginCommitId(tuple_slot_id, commit_id);
+  tile_group_header->SetEndCommitId(tuple_slot_id, MAX_CID);
+  tile_group_header->SetNextItemPointer(tuple_slot_id, INVALID_ITEMPOINTER);
+
+  return tuple_slot_id;
+}
+
+/**
+ * Decode a tuple serialized by Tuple::SerializeTo straight into the tiles of
+ * the slot. Fixed length values are stored in the serialized layout and are
+ * copied as they are. The pool copy of a variable length value is its length
+ * followed by the data, also the serialized layout, so it is copied in one go.
+ * Values are serialized in table column order, which the column map follows
+ * whatever tiles the columns were split into.
+ */
+void TileGroup::CopySerializedTuple(oid_t tuple_slot_id,
+                                    SerializeInput &tuple_body) {
+  // Skip the tuple size, the values follow in column order
+  tuple_body.ReadInt();
+
+  for (auto &column_entry : column_map) {
+    oid_t tile_itr = column_entry.second.first;
+    oid_t tile_column_itr = column_entry.second.second;
     const catalog::Schema &schema = tile_schemas[tile_itr];
-    tile_column_count = schema.GetColumnCount();
 
     storage::Tile *tile = GetTile(tile_itr);
     PL_ASSERT(tile);
     char *tile_tuple_location = tile->GetTupleLocation(tuple_slot_id);
     PL_ASSERT(tile_tuple_location);
 
-    // NOTE:: Only a tuple wrapper
-    storage::Tuple tile_tuple(&schema, tile_tuple_location);
-
-    for (oid_t tile_column_itr = 0; tile_column_itr < tile_column_count;
-         tile_column_itr++) {
-      type::Value val = (tuple->GetValue(column_itr));
-      tile_tuple.SetValue(tile_column_itr, val, tile->GetPool());
-      column_itr++;
+    char *value_location =
+        tile_tuple_location + schema.GetOffset(tile_column_itr);
+    auto column_type = schema.GetType(tile_column_itr);
+
+    switch (column_type) {
+      case type::Type::BOOLEAN:
+      case type::Type::TINYINT:
+      case type::Type::SMALLINT:
+      case type::Type::INTEGER:
+      case type::Type::BIGINT:
+      case type::Type::DECIMAL:
+      case type::Type::TIMESTAMP:
+        tuple_body.ReadBytes(value_location,
+                             type::Type::GetTypeSize(column_type));
+        break;
+
+      case type::Type::VARCHAR:
+      case type::Type::VARBINARY: {
+        uint32_t value_length = tuple_body.ReadInt();
+        char *value_data = nullptr;
+        if (value_length != type::PELOTON_VALUE_NULL) {
+          value_data = reinterpret_cast<char *>(
+              tile->GetPool()->Allocate(sizeof(uint32_t) + value_length));
+          PL_MEMCPY(value_data, &value_length, sizeof(uint32_t));
+          tuple_body.ReadBytes(value_data + sizeof(uint32_t), value_length);
+        }
+        PL_MEMCPY(value_location, &value_data, sizeof(value_data));
+      } break;
+
+      default: {
+        // NOTE:: Only a tuple wrapper
+        storage::Tuple tile_tuple(&schema, tile_tuple_location);
+        type::Value val = type::Value::DeserializeFrom(tuple_body, column_type);
+        tile_tuple.SetValue(tile_column_itr, val, tile->GetPool());
+      } break;
     }
   }
-
-  // Set MVCC info
-  tile_group_header->SetTransactionId(tuple_slot_id, INITIAL_TXN_ID);
-  tile_group_header->SetBeginCommitId(tuple_slot_id, commit_id);
-  tile_group_header->SetEndCommitId(tuple_slot_id, MAX_CID);
-  tile_group_header->SetNextItemPointer(tuple_slot_id, INVALID_ITEMPOINTER);
-
-  return tuple_slot_id;
 }
 
 oid_t TileGroup::GetTileIdFromColumnId(oid_t column_id) {
@@ -369,9 +443,15 @@ double TileGroup::GetSchemaDifference(
 }
 
 void TileGroup::Sync() {
-  // Sync the tile group data by syncing all the underlying tiles
-  for (auto tile : tiles) {
-    tile->Sync();
+  // Sync the slot ranges modified since the last sync, both the header
+  // entries and the tuples in all the underlying tiles
+  auto dirty_ranges = tile_group_header->TakeDirtyRanges();
+
+  for (auto &dirty_range : dirty_ranges) {
+    tile_group_header->Sync(dirty_range.first, dirty_range.second);
+    for (auto tile : tiles) {
+      tile->Sync(dirty_range.first, dirty_range.second);
+    }
   }
 }
 
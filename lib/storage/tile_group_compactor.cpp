@@ -0,0 +1,91 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// tile_group_compactor.cpp
+//
+// Identification: src/storage/tile_group_compactor.cpp
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/tile_group_compactor.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "common/logger.h"
+#include "storage/data_table.h"
+
+namespace peloton {
+namespace storage {
+
+TileGroupCompactor &TileGroupCompactor::GetInstance() {
+  static TileGroupCompactor tile_group_compactor;
+  return tile_group_compactor;
+}
+
+TileGroupCompactor::TileGroupCompactor()
+    : compaction_stop(false), liveness_threshold(0.3) {}
+
+TileGroupCompactor::~TileGroupCompactor() { Stop(); }
+
+void TileGroupCompactor::Start(const CommitIdProvider &commit_id_provider) {
+  Stop();
+
+  this->commit_id_provider = commit_id_provider;
+  compaction_stop = false;
+  compactor_thread = std::thread(&TileGroupCompactor::CompactTables, this);
+
+  LOG_INFO("Started tile group compactor");
+}
+
+void TileGroupCompactor::Stop() {
+  compaction_stop = true;
+
+  if (compactor_thread.joinable() == true) {
+    compactor_thread.join();
+    LOG_INFO("Stopped tile group compactor");
+  }
+}
+
+void TileGroupCompactor::CompactTables() {
+  while (compaction_stop == false) {
+    Compact(commit_id_provider());
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(sleep_duration));
+  }
+}
+
+size_t TileGroupCompactor::Compact(const cid_t &commit_id) {
+  std::lock_guard<std::mutex> lock(compactor_mutex);
+  size_t compacted_count = 0;
+
+  for (auto table : tables) {
+    compacted_count += table->CompactTileGroups(liveness_threshold, commit_id);
+  }
+
+  if (compacted_count > 0) {
+    LOG_TRACE("Compacted %lu tile groups", compacted_count);
+  }
+  return compacted_count;
+}
+
+void TileGroupCompactor::AddTable(DataTable *table) {
+  std::lock_guard<std::mutex> lock(compactor_mutex);
+  tables.push_back(table);
+}
+
+void TileGroupCompactor::RemoveTable(DataTable *table) {
+  std::lock_guard<std::mutex> lock(compactor_mutex);
+  tables.erase(std::remove(tables.begin(), tables.end(), table), tables.end());
+}
+
+void TileGroupCompactor::ClearTables() {
+  std::lock_guard<std::mutex> lock(compactor_mutex);
+  tables.clear();
+}
+
+}  // End storage namespace
+}  // End peloton namespace
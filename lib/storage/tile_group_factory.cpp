@@ -12,6 +12,9 @@
 
 #include "storage/tile_group_factory.h"
 #include "logging/logging_util.h"
+#include "storage/persistent_heap.h"
+#include "storage/storage_manager.h"
+#include "storage/tile.h"
 #include "storage/tile_group_header.h"
 
 //===--------------------------------------------------------------------===//
@@ -25,13 +28,16 @@ namespace storage {
 TileGroup *TileGroupFactory::GetTileGroup(
     oid_t database_id, oid_t table_id, oid_t tile_group_id,
     AbstractTable *table, const std::vector<catalog::Schema> &schemas,
-    const column_map_type &column_map, int tuple_count) {
+    const column_map_type &column_map, int tuple_count, int numa_node,
+    bool publish) {
   // Allocate the data on appropriate backend
   BackendType backend_type = BackendType::NVM;
 
-  TileGroupHeader *tile_header = new TileGroupHeader(backend_type, tuple_count);
-  TileGroup *tile_group = new TileGroup(backend_type, tile_header, table,
-                                        schemas, column_map, tuple_count);
+  TileGroupHeader *tile_header =
+      new TileGroupHeader(backend_type, tuple_count, numa_node);
+  TileGroup *tile_group =
+      new TileGroup(backend_type, tile_header, table, schemas, column_map,
+                    tuple_count, numa_node);
 
   tile_header->SetTileGroup(tile_group);
 
@@ -39,6 +45,67 @@ TileGroup *TileGroupFactory::GetTileGroup(
   tile_group->tile_group_id = tile_group_id;
   tile_group->table_id = table_id;
 
+  if (publish == true) {
+    PublishTileGroup(tile_group);
+  }
+
+  return tile_group;
+}
+
+void TileGroupFactory::PublishTileGroup(TileGroup *tile_group) {
+  auto &storage_manager = StorageManager::GetInstance();
+  PersistentHeap *persistent_heap = storage_manager.GetPersistentHeap();
+  if (persistent_heap == nullptr ||
+      tile_group->backend_type != BackendType::NVM) {
+    return;
+  }
+
+  // Uninlined values live in volatile pools and would not survive
+  for (auto &tile_schema : tile_group->tile_schemas) {
+    if (tile_schema.IsInlined() == false) {
+      return;
+    }
+  }
+
+  std::vector<std::pair<const void *, size_t>> tile_data;
+  for (auto &tile : tile_group->tiles) {
+    tile_data.push_back(
+        std::make_pair(tile->GetTupleLocation(0), tile->GetInlinedSize()));
+  }
+
+  auto tile_group_header = tile_group->GetHeader();
+  tile_group->persistent_descriptor_id = persistent_heap->RegisterTileGroup(
+      tile_group->database_id, tile_group->table_id,
+      tile_group->tile_group_id, tile_group->num_tuple_slots,
+      tile_group_header->GetData(), tile_group_header->GetHeaderSize(),
+      tile_data, tile_group->column_map);
+}
+
+TileGroup *TileGroupFactory::GetPersistentTileGroup(
+    AbstractTable *table, const std::vector<catalog::Schema> &schemas,
+    const oid_t &descriptor_id) {
+  auto &storage_manager = StorageManager::GetInstance();
+  PersistentHeap *persistent_heap = storage_manager.GetPersistentHeap();
+  PL_ASSERT(persistent_heap != nullptr);
+
+  auto &descriptor = persistent_heap->GetDescriptor(descriptor_id);
+  BackendType backend_type = BackendType::NVM;
+
+  TileGroupHeader *tile_header =
+      new TileGroupHeader(backend_type, descriptor.tuple_count,
+                          persistent_heap->GetHeaderData(descriptor_id));
+  TileGroup *tile_group = new TileGroup(
+      backend_type, tile_header, table, schemas,
+      persistent_heap->GetColumnMap(descriptor_id), descriptor.tuple_count,
+      persistent_heap->GetTileData(descriptor_id));
+
+  tile_header->SetTileGroup(tile_group);
+
+  tile_group->database_id = descriptor.database_id;
+  tile_group->tile_group_id = descriptor.tile_group_id;
+  tile_group->table_id = descriptor.table_id;
+  tile_group->persistent_descriptor_id = descriptor_id;
+
   return tile_group;
 }
 
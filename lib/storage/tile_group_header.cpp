@@ -10,60 +10,220 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <iomanip>
 #include <iostream>
 #include <sstream>
 
+#include "catalog/manager.h"
 #include "common/container_tuple.h"
 #include "common/logger.h"
 #include "common/macros.h"
 #include "common/platform.h"
 #include "common/printable.h"
 #include "logging/log_manager.h"
+#include "storage/data_table.h"
 #include "storage/storage_manager.h"
+#include "storage/tile_group.h"
 #include "storage/tile_group_header.h"
 
 namespace peloton {
 namespace storage {
 
+// Tile group headers a thread remembers claimed slots of
+#define INSERT_CHUNK_CACHE_SIZE 8
+
+namespace {
+
+// Slots claimed by the thread in a tile group header and not handed out yet
+struct InsertChunk {
+  uint64_t insert_serial = 0;
+  oid_t tile_group_id = INVALID_OID;
+  oid_t next_slot = 0;
+  oid_t end_slot = 0;
+};
+
+// Give the slots the thread did not hand out to the free slots of the table,
+// inserts take them from there like any other free slot
+void ReturnInsertChunk(InsertChunk &chunk) {
+  // Headers without a tile group have no table to return slots to
+  if (chunk.next_slot >= chunk.end_slot ||
+      chunk.tile_group_id == INVALID_OID) {
+    chunk.next_slot = chunk.end_slot;
+    return;
+  }
+
+  // The tile group may be gone, or its header replaced by a transformation
+  // that dropped the claims
+  auto tile_group =
+      catalog::Manager::GetInstance().GetTileGroup(chunk.tile_group_id);
+  if (tile_group != nullptr &&
+      tile_group->GetHeader()->GetInsertSerial() == chunk.insert_serial) {
+    auto table = dynamic_cast<DataTable *>(tile_group->GetAbstractTable());
+    if (table != nullptr) {
+      LOG_TRACE("Returning slots [%u, %u) of tile group %u", chunk.next_slot,
+                chunk.end_slot, chunk.tile_group_id);
+      for (oid_t tuple_slot_id = chunk.next_slot;
+           tuple_slot_id < chunk.end_slot; tuple_slot_id++) {
+        table->ReleaseTupleSlot(
+            ItemPointer(chunk.tile_group_id, tuple_slot_id));
+      }
+    }
+  }
+
+  chunk.next_slot = chunk.end_slot;
+}
+
+// Returns the remaining slots of its chunks when the thread exits
+struct InsertChunkCache {
+  ~InsertChunkCache() {
+    for (auto &chunk : chunks) {
+      ReturnInsertChunk(chunk);
+    }
+  }
+
+  InsertChunk chunks[INSERT_CHUNK_CACHE_SIZE];
+};
+
+thread_local InsertChunkCache insert_chunk_cache;
+
+}  // namespace
+
+const oid_t TileGroupHeader::insert_chunk_slot_count;
+
+std::atomic<uint64_t> TileGroupHeader::next_insert_serial(1);
+
 TileGroupHeader::TileGroupHeader(const BackendType &backend_type,
-                                 const int &tuple_count)
+                                 const int &tuple_count, const int &numa_node)
     : backend_type(backend_type),
+      numa_node(numa_node),
       tile_group(nullptr),
       data(nullptr),
       num_tuple_slots(tuple_count),
       next_tuple_slot(0),
-      tile_header_lock() {
+      insert_serial(next_insert_serial++),
+      sealed(false),
+      tile_header_lock(),
+      dirty_word_count(0) {
   header_size = num_tuple_slots * header_entry_size;
 
-  // allocate storage space for header
+  // allocate zeroed storage space for header. Slots get their MVCC initial
+  // values when they are handed out, see InitTupleSlot().
   auto &storage_manager = storage::StorageManager::GetInstance();
   data = reinterpret_cast<char *>(
-      storage_manager.Allocate(backend_type, header_size));
+      storage_manager.AllocateZeroed(backend_type, header_size, numa_node));
   PL_ASSERT(data != nullptr);
 
-  // zero out the data
-  PL_MEMSET(data, 0, header_size);
+  // Track modifications on backends that need to be synced. The
+  // initialized header has not been synced yet.
+  if (storage_manager.NeedsSync(backend_type) == true) {
+    oid_t chunk_count = (num_tuple_slots + dirty_chunk_slot_count - 1) /
+                        dirty_chunk_slot_count;
+    dirty_word_count = (chunk_count + 63) / 64;
+    dirty_chunks.reset(new std::atomic<uint64_t>[dirty_word_count]);
+    MarkAllDirty();
+  }
+}
 
-  // Set MVCC Initial Value
+TileGroupHeader::TileGroupHeader(const BackendType &backend_type,
+                                 const int &tuple_count, char *persistent_data)
+    : backend_type(backend_type),
+      numa_node(INVALID_NUMA_NODE),
+      tile_group(nullptr),
+      data(persistent_data),
+      num_tuple_slots(tuple_count),
+      next_tuple_slot(0),
+      insert_serial(next_insert_serial++),
+      sealed(false),
+      tile_header_lock(),
+      dirty_word_count(0) {
+  header_size = num_tuple_slots * header_entry_size;
+  PL_ASSERT(data != nullptr);
+
+  // Transactions that were running at the crash are gone, roll back their
+  // versions and release their write locks. Slots past the last used one
+  // are still free, either initialized or never handed out and zero.
+  oid_t used_tuple_slot_count = 0;
   for (oid_t tuple_slot_id = START_OID; tuple_slot_id < num_tuple_slots;
        tuple_slot_id++) {
-    SetTransactionId(tuple_slot_id, INVALID_TXN_ID);
-    SetBeginCommitId(tuple_slot_id, MAX_CID);
-    SetEndCommitId(tuple_slot_id, MAX_CID);
-    SetNextItemPointer(tuple_slot_id, INVALID_ITEMPOINTER);
-    SetPrevItemPointer(tuple_slot_id, INVALID_ITEMPOINTER);
+    txn_id_t txn_id = GetTransactionId(tuple_slot_id);
+    cid_t begin_cid = GetBeginCommitId(tuple_slot_id);
+
+    if (txn_id != INVALID_TXN_ID && txn_id != INITIAL_TXN_ID) {
+      if (begin_cid == MAX_CID) {
+        SetTransactionId(tuple_slot_id, INVALID_TXN_ID);
+      } else {
+        SetTransactionId(tuple_slot_id, INITIAL_TXN_ID);
+      }
+    }
+
+    // Indexes refer to versions through volatile pointers
+    SetIndirection(tuple_slot_id, nullptr);
+
+    if (txn_id != INVALID_TXN_ID ||
+        (begin_cid != MAX_CID && begin_cid != INVALID_CID)) {
+      used_tuple_slot_count = tuple_slot_id + 1;
+    }
   }
+  next_tuple_slot = used_tuple_slot_count;
+
+  oid_t chunk_count = (num_tuple_slots + dirty_chunk_slot_count - 1) /
+                      dirty_chunk_slot_count;
+  dirty_word_count = (chunk_count + 63) / 64;
+  dirty_chunks.reset(new std::atomic<uint64_t>[dirty_word_count]);
+  MarkAllDirty();
 }
 
 TileGroupHeader::~TileGroupHeader() {
   // reclaim the space
   auto &storage_manager = storage::StorageManager::GetInstance();
-  storage_manager.Release(backend_type, data);
+  storage_manager.ReleaseZeroed(backend_type, data, header_size, numa_node);
 
   data = nullptr;
 }
 
+oid_t TileGroupHeader::GetNextEmptyTupleSlot() {
+  if (IsSealed() == true) {
+    return INVALID_OID;
+  }
+
+  auto &chunk =
+      insert_chunk_cache.chunks[insert_serial % INSERT_CHUNK_CACHE_SIZE];
+
+  if (chunk.insert_serial != insert_serial ||
+      chunk.next_slot >= chunk.end_slot) {
+    // The chunk of another tile group is evicted, its slots are not lost
+    if (chunk.insert_serial != insert_serial) {
+      ReturnInsertChunk(chunk);
+    }
+
+    // Claim the next chunk
+    oid_t begin_slot = next_tuple_slot.load(std::memory_order_relaxed);
+    oid_t end_slot;
+    do {
+      if (begin_slot >= num_tuple_slots) {
+        return INVALID_OID;
+      }
+      end_slot = std::min(begin_slot + insert_chunk_slot_count,
+                          num_tuple_slots - 1);
+      if (end_slot <= begin_slot) {
+        end_slot = begin_slot + 1;
+      }
+    } while (next_tuple_slot.compare_exchange_weak(
+                 begin_slot, end_slot, std::memory_order_relaxed) == false);
+
+    chunk.insert_serial = insert_serial;
+    chunk.tile_group_id =
+        (tile_group != nullptr) ? tile_group->GetTileGroupId() : INVALID_OID;
+    chunk.next_slot = begin_slot;
+    chunk.end_slot = end_slot;
+  }
+
+  oid_t tuple_slot_id = chunk.next_slot++;
+  InitTupleSlot(tuple_slot_id);
+  return tuple_slot_id;
+}
+
 //===--------------------------------------------------------------------===//
 // Tile Group Header
 //===--------------------------------------------------------------------===//
@@ -163,6 +323,49 @@ void TileGroupHeader::Sync() {
   storage_manager.Sync(backend_type, data, header_size);
 }
 
+void TileGroupHeader::Sync(const oid_t &begin_slot, const oid_t &end_slot) {
+  PL_ASSERT(begin_slot <= end_slot && end_slot <= num_tuple_slots);
+
+  auto &storage_manager = storage::StorageManager::GetInstance();
+  storage_manager.Sync(backend_type, data + begin_slot * header_entry_size,
+                       (end_slot - begin_slot) * header_entry_size);
+}
+
+void TileGroupHeader::MarkAllDirty() {
+  for (size_t word_itr = 0; word_itr < dirty_word_count; word_itr++) {
+    dirty_chunks[word_itr].store(~UINT64_C(0), std::memory_order_release);
+  }
+}
+
+std::vector<std::pair<oid_t, oid_t>> TileGroupHeader::TakeDirtyRanges() {
+  std::vector<std::pair<oid_t, oid_t>> dirty_ranges;
+
+  for (size_t word_itr = 0; word_itr < dirty_word_count; word_itr++) {
+    uint64_t word =
+        dirty_chunks[word_itr].exchange(0, std::memory_order_acquire);
+
+    while (word != 0) {
+      oid_t chunk_id = word_itr * 64 + __builtin_ctzll(word);
+      word &= word - 1;
+
+      oid_t begin_slot = chunk_id * dirty_chunk_slot_count;
+      if (begin_slot >= num_tuple_slots) break;
+      oid_t end_slot =
+          std::min(begin_slot + dirty_chunk_slot_count, num_tuple_slots);
+
+      // Adjacent chunks become one range
+      if (dirty_ranges.empty() == false &&
+          dirty_ranges.back().second == begin_slot) {
+        dirty_ranges.back().second = end_slot;
+      } else {
+        dirty_ranges.emplace_back(begin_slot, end_slot);
+      }
+    }
+  }
+
+  return dirty_ranges;
+}
+
 void TileGroupHeader::PrintVisibility(txn_id_t txn_id, cid_t at_cid) {
   oid_t active_tuple_slots = GetCurrentNextTupleSlot();
   std::stringstream os;
@@ -229,7 +432,7 @@ oid_t TileGroupHeader::GetActiveTupleCount() const {
   for (oid_t tuple_slot_id = START_OID; tuple_slot_id < num_tuple_slots;
        tuple_slot_id++) {
     txn_id_t tuple_txn_id = GetTransactionId(tuple_slot_id);
-    if (tuple_txn_id != INVALID_TXN_ID) {
+    if (tuple_txn_id != INVALID_TXN_ID && tuple_txn_id != CLAIMED_TXN_ID) {
       PL_ASSERT(tuple_txn_id == INITIAL_TXN_ID);
       active_tuple_slots++;
     }
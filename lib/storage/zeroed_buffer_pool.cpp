@@ -0,0 +1,189 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// zeroed_buffer_pool.cpp
+//
+// Identification: src/storage/zeroed_buffer_pool.cpp
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/zeroed_buffer_pool.h"
+
+#include "common/logger.h"
+#include "common/macros.h"
+#include "storage/storage_manager.h"
+
+namespace peloton {
+namespace storage {
+
+const size_t ZeroedBufferPool::default_max_cached_bytes_;
+
+const size_t ZeroedBufferPool::max_ready_count_;
+
+ZeroedBufferPool::ZeroedBufferPool(StorageManager &storage_manager,
+                                   const size_t &max_cached_bytes)
+    : storage_manager_(storage_manager),
+      max_cached_bytes_(max_cached_bytes),
+      shutdown_(false),
+      hit_count_(0),
+      miss_count_(0),
+      cached_bytes_(0) {}
+
+ZeroedBufferPool::~ZeroedBufferPool() { Shutdown(); }
+
+void ZeroedBufferPool::StartRefiller() {
+  // Caller holds the pool lock
+  if (refiller_.joinable() == false) {
+    refiller_ = std::thread(&ZeroedBufferPool::RefillBuffers, this);
+  }
+}
+
+void *ZeroedBufferPool::Allocate(const BackendType &backend_type,
+                                 const size_t &size, const int &numa_node) {
+  Shape shape(backend_type, size, numa_node);
+  void *address = nullptr;
+
+  {
+    std::lock_guard<std::mutex> lock(pool_mutex_);
+    if (shutdown_ == false) {
+      StartRefiller();
+
+      auto &buffers = shapes_[shape];
+      if (buffers.ready.empty() == false) {
+        address = buffers.ready.back();
+        buffers.ready.pop_back();
+        cached_bytes_ -= size;
+        hit_count_++;
+
+        if (buffers.ready.size() < buffers.ready_target) {
+          refill_cv_.notify_one();
+        }
+        return address;
+      }
+
+      // Ran dry, keep more of this shape ready from now on
+      if (buffers.ready_target < max_ready_count_) {
+        buffers.ready_target++;
+      }
+      refill_cv_.notify_one();
+
+      // Rather clear a released buffer here than allocate another one
+      if (buffers.dirty.empty() == false) {
+        address = buffers.dirty.back();
+        buffers.dirty.pop_back();
+        cached_bytes_ -= size;
+      }
+    }
+  }
+
+  miss_count_++;
+  if (address == nullptr) {
+    address = storage_manager_.Allocate(backend_type, size, numa_node);
+  }
+  PL_MEMSET(address, 0, size);
+
+  return address;
+}
+
+void ZeroedBufferPool::Release(const BackendType &backend_type, void *address,
+                               const size_t &size, const int &numa_node) {
+  {
+    std::lock_guard<std::mutex> lock(pool_mutex_);
+    if (shutdown_ == false && cached_bytes_ + size <= max_cached_bytes_) {
+      StartRefiller();
+
+      shapes_[Shape(backend_type, size, numa_node)].dirty.push_back(address);
+      cached_bytes_ += size;
+      refill_cv_.notify_one();
+      return;
+    }
+  }
+
+  // Pool is full
+  storage_manager_.Release(backend_type, address);
+}
+
+void ZeroedBufferPool::RefillBuffers() {
+  std::unique_lock<std::mutex> lock(pool_mutex_);
+
+  while (shutdown_ == false) {
+    // Find a shape with a buffer to clear or a buffer missing
+    bool found = false;
+    Shape shape;
+    void *address = nullptr;
+    for (auto &shape_entry : shapes_) {
+      auto &buffers = shape_entry.second;
+      size_t size = std::get<1>(shape_entry.first);
+
+      if (buffers.dirty.empty() == false) {
+        address = buffers.dirty.back();
+        buffers.dirty.pop_back();
+      } else if (buffers.ready.size() < buffers.ready_target &&
+                 cached_bytes_ + size <= max_cached_bytes_) {
+        cached_bytes_ += size;
+      } else {
+        continue;
+      }
+
+      shape = shape_entry.first;
+      found = true;
+      break;
+    }
+
+    if (found == false) {
+      refill_cv_.wait(lock);
+      continue;
+    }
+
+    // Allocate and clear without holding the lock. Clearing also faults
+    // the pages in.
+    lock.unlock();
+    size_t size = std::get<1>(shape);
+    if (address == nullptr) {
+      address = storage_manager_.Allocate(std::get<0>(shape), size,
+                                          std::get<2>(shape));
+    }
+    PL_MEMSET(address, 0, size);
+    lock.lock();
+
+    shapes_[shape].ready.push_back(address);
+  }
+}
+
+void ZeroedBufferPool::Shutdown() {
+  {
+    std::lock_guard<std::mutex> lock(pool_mutex_);
+    shutdown_ = true;
+  }
+  refill_cv_.notify_all();
+
+  if (refiller_.joinable() == true) {
+    refiller_.join();
+  }
+
+  std::map<Shape, ShapeBuffers> shapes;
+  {
+    std::lock_guard<std::mutex> lock(pool_mutex_);
+    shapes.swap(shapes_);
+    cached_bytes_ = 0;
+  }
+
+  for (auto &shape_entry : shapes) {
+    auto backend_type = std::get<0>(shape_entry.first);
+    for (auto address : shape_entry.second.ready) {
+      storage_manager_.Release(backend_type, address);
+    }
+    for (auto address : shape_entry.second.dirty) {
+      storage_manager_.Release(backend_type, address);
+    }
+  }
+
+  LOG_TRACE("Zeroed buffer pool : %lu hits, %lu misses", hit_count_.load(),
+            miss_count_.load());
+}
+
+}  // End storage namespace
+}  // End peloton namespace
@@ -2045,6 +2045,9 @@ std::string LogRecordTypeToString(LogRecordType type) {
     case LOGRECORD_TYPE_WAL_TUPLE_UPDATE: {
       return "WAL_TUPLE_UPDATE";
     }
+    case LOGRECORD_TYPE_WAL_COMPRESSED_BLOCK: {
+      return "WAL_COMPRESSED_BLOCK";
+    }
     case LOGRECORD_TYPE_WBL_TUPLE_INSERT: {
       return "WBL_TUPLE_INSERT";
     }
@@ -2092,6 +2095,8 @@ LogRecordType StringToLogRecordType(const std::string& str) {
     return LOGRECORD_TYPE_WAL_TUPLE_DELETE;
   } else if (upper_str == "WAL_TUPLE_UPDATE") {
     return LOGRECORD_TYPE_WAL_TUPLE_UPDATE;
+  } else if (upper_str == "WAL_COMPRESSED_BLOCK") {
+    return LOGRECORD_TYPE_WAL_COMPRESSED_BLOCK;
   } else if (upper_str == "WBL_TUPLE_INSERT") {
     return LOGRECORD_TYPE_WBL_TUPLE_INSERT;
   } else if (upper_str == "WBL_TUPLE_DELETE") {
@@ -0,0 +1,123 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// crc32c_test.cpp
+//
+// Identification: test/common/crc32c_test.cpp
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "common/crc32c.h"
+#include "common/logger.h"
+
+namespace peloton {
+namespace test {
+
+//===--------------------------------------------------------------------===//
+// CRC32C Tests
+//===--------------------------------------------------------------------===//
+
+class Crc32cTests : public ::testing::Test {};
+
+namespace {
+
+struct KnownAnswer {
+  std::vector<char> data;
+  uint32_t crc;
+};
+
+// Check values of RFC 3720, B.4, and the common "123456789" check
+std::vector<KnownAnswer> GetKnownAnswers() {
+  std::vector<KnownAnswer> known_answers;
+
+  const char *check = "123456789";
+  known_answers.push_back(
+      {std::vector<char>(check, check + strlen(check)), 0xE3069283u});
+
+  known_answers.push_back({std::vector<char>(32, 0x00), 0x8A9136AAu});
+
+  known_answers.push_back({std::vector<char>(32, (char)0xFF), 0x62A8AB43u});
+
+  std::vector<char> ascending(32), descending(32);
+  for (int byte_itr = 0; byte_itr < 32; byte_itr++) {
+    ascending[byte_itr] = (char)byte_itr;
+    descending[byte_itr] = (char)(31 - byte_itr);
+  }
+  known_answers.push_back({ascending, 0x46DD794Eu});
+  known_answers.push_back({descending, 0x113FDB5Cu});
+
+  known_answers.push_back({std::vector<char>(), 0x00000000u});
+
+  return known_answers;
+}
+
+// Bit by bit, the definition the table and the instruction must agree with
+uint32_t ReferenceCrc32c(const char *data, size_t length) {
+  uint32_t crc = ~0u;
+  for (size_t byte_itr = 0; byte_itr < length; byte_itr++) {
+    crc ^= static_cast<uint8_t>(data[byte_itr]);
+    for (int bit_itr = 0; bit_itr < 8; bit_itr++) {
+      crc = (crc & 1) ? (crc >> 1) ^ 0x82F63B78u : (crc >> 1);
+    }
+  }
+  return ~crc;
+}
+
+}  // namespace
+
+TEST_F(Crc32cTests, SoftwareKnownAnswerTest) {
+  for (auto &known_answer : GetKnownAnswers()) {
+    EXPECT_EQ(known_answer.crc,
+              Crc32c::ExtendSoftware(0, known_answer.data.data(),
+                                     known_answer.data.size()));
+  }
+}
+
+TEST_F(Crc32cTests, HardwareKnownAnswerTest) {
+  if (Crc32c::IsHardwareAccelerated() == false) {
+    LOG_INFO("No crc32 instruction, Value() uses the software path");
+  }
+
+  for (auto &known_answer : GetKnownAnswers()) {
+    EXPECT_EQ(known_answer.crc, Crc32c::Value(known_answer.data.data(),
+                                              known_answer.data.size()));
+  }
+}
+
+TEST_F(Crc32cTests, UnalignedExtendTest) {
+  // Every offset and length around the eight byte steps of both paths
+  std::vector<char> data(4096);
+  srand(42);
+  for (auto &byte : data) {
+    byte = static_cast<char>(rand());
+  }
+
+  for (size_t offset = 0; offset < 16; offset++) {
+    for (size_t length = 0; length < 600; length += 7) {
+      const char *begin = data.data() + offset;
+      uint32_t reference = ReferenceCrc32c(begin, length);
+      EXPECT_EQ(reference, Crc32c::Value(begin, length));
+      EXPECT_EQ(reference, Crc32c::ExtendSoftware(0, begin, length));
+
+      // Checksums continue across pieces
+      size_t split = length / 3;
+      EXPECT_EQ(reference, Crc32c::Extend(Crc32c::Value(begin, split),
+                                          begin + split, length - split));
+      EXPECT_EQ(reference,
+                Crc32c::ExtendSoftware(Crc32c::ExtendSoftware(0, begin, split),
+                                       begin + split, length - split));
+    }
+  }
+}
+
+}  // End test namespace
+}  // End peloton namespace
@@ -0,0 +1,119 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// epoch_manager_test.cpp
+//
+// Identification: test/concurrency/epoch_manager_test.cpp
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <thread>
+
+#include "gtest/gtest.h"
+
+#include "concurrency/epoch_manager.h"
+#include "concurrency/timestamp_ordering_transaction_manager.h"
+#include "concurrency/transaction.h"
+
+namespace peloton {
+namespace test {
+
+//===--------------------------------------------------------------------===//
+// Epoch Manager Tests
+//===--------------------------------------------------------------------===//
+
+class EpochManagerTests : public ::testing::Test {};
+
+TEST_F(EpochManagerTests, NestedPinTest) {
+  auto &epoch_manager = concurrency::EpochManager::GetInstance();
+
+  uint64_t outer_epoch = epoch_manager.EnterEpoch();
+  epoch_manager.AdvanceEpoch();
+
+  // The inner pin keeps the outer epoch
+  EXPECT_EQ(outer_epoch, epoch_manager.EnterEpoch());
+  epoch_manager.AdvanceEpoch();
+  EXPECT_EQ(outer_epoch, epoch_manager.GetReclaimableEpoch());
+
+  epoch_manager.ExitEpoch();
+  EXPECT_EQ(outer_epoch, epoch_manager.GetReclaimableEpoch());
+
+  epoch_manager.ExitEpoch();
+  EXPECT_EQ(epoch_manager.GetCurrentEpoch(),
+            epoch_manager.GetReclaimableEpoch());
+}
+
+TEST_F(EpochManagerTests, GuardTest) {
+  auto &epoch_manager = concurrency::EpochManager::GetInstance();
+
+  uint64_t pinned_epoch;
+  {
+    concurrency::EpochGuard epoch_guard;
+    pinned_epoch = epoch_manager.GetCurrentEpoch();
+    epoch_manager.AdvanceEpoch();
+    EXPECT_EQ(pinned_epoch, epoch_manager.GetReclaimableEpoch());
+  }
+
+  EXPECT_LT(pinned_epoch, epoch_manager.GetReclaimableEpoch());
+}
+
+TEST_F(EpochManagerTests, ExitOnAnotherThreadTest) {
+  auto &epoch_manager = concurrency::EpochManager::GetInstance();
+
+  // The pin outlives the thread that took it
+  size_t slot;
+  uint64_t pinned_epoch;
+  std::thread pinning_thread(
+      [&]() { pinned_epoch = epoch_manager.EnterEpoch(slot); });
+  pinning_thread.join();
+
+  epoch_manager.AdvanceEpoch();
+  EXPECT_EQ(pinned_epoch, epoch_manager.GetReclaimableEpoch());
+
+  // Pins of a thread that takes over the slot add to it
+  std::thread reusing_thread([&]() {
+    size_t reused_slot;
+    epoch_manager.EnterEpoch(reused_slot);
+    epoch_manager.AdvanceEpoch();
+    EXPECT_EQ(pinned_epoch, epoch_manager.GetReclaimableEpoch());
+    epoch_manager.ExitEpoch(reused_slot);
+  });
+  reusing_thread.join();
+  EXPECT_EQ(pinned_epoch, epoch_manager.GetReclaimableEpoch());
+
+  epoch_manager.ExitEpoch(slot);
+  EXPECT_EQ(epoch_manager.GetCurrentEpoch(),
+            epoch_manager.GetReclaimableEpoch());
+}
+
+TEST_F(EpochManagerTests, TransactionEpochTest) {
+  auto &epoch_manager = concurrency::EpochManager::GetInstance();
+  auto &txn_manager =
+      concurrency::TimestampOrderingTransactionManager::GetInstance();
+
+  // A transaction begun on one thread and committed on another releases the
+  // epoch it pinned
+  concurrency::Transaction *txn = nullptr;
+  std::thread begin_thread([&]() { txn = txn_manager.BeginTransaction(); });
+  begin_thread.join();
+
+  uint64_t txn_epoch = txn->GetEpochId();
+  epoch_manager.AdvanceEpoch();
+  EXPECT_EQ(txn_epoch, epoch_manager.GetReclaimableEpoch());
+
+  uint64_t local_epoch = epoch_manager.EnterEpoch();
+  EXPECT_LT(txn_epoch, local_epoch);
+
+  EXPECT_EQ(ResultType::SUCCESS, txn_manager.CommitTransaction(txn));
+  EXPECT_EQ(local_epoch, epoch_manager.GetReclaimableEpoch());
+
+  epoch_manager.ExitEpoch();
+  EXPECT_EQ(epoch_manager.GetCurrentEpoch(),
+            epoch_manager.GetReclaimableEpoch());
+}
+
+}  // End test namespace
+}  // End peloton namespace
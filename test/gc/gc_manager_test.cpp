@@ -0,0 +1,202 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// gc_manager_test.cpp
+//
+// Identification: test/gc/gc_manager_test.cpp
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <memory>
+#include <string>
+
+#include "gtest/gtest.h"
+
+#include "catalog/manager.h"
+#include "catalog/schema.h"
+#include "concurrency/timestamp_ordering_transaction_manager.h"
+#include "concurrency/transaction.h"
+#include "gc/gc_manager.h"
+#include "storage/data_table.h"
+#include "storage/table_factory.h"
+#include "storage/tile.h"
+#include "storage/tile_group.h"
+#include "storage/tile_group_header.h"
+#include "storage/tuple.h"
+#include "type/ephemeral_pool.h"
+#include "type/value_factory.h"
+
+namespace peloton {
+namespace test {
+
+//===--------------------------------------------------------------------===//
+// GC Manager Tests
+//===--------------------------------------------------------------------===//
+
+class GCManagerTests : public ::testing::Test {};
+
+namespace {
+
+const size_t tuples_per_tile_group = 100;
+
+const size_t update_count = 10000;
+
+catalog::Schema *GetSchema() {
+  catalog::Column key_column(type::Type::INTEGER,
+                             type::Type::GetTypeSize(type::Type::INTEGER),
+                             "key", true);
+  catalog::Column value_column(type::Type::VARCHAR, 64, "value", false);
+  return new catalog::Schema({key_column, value_column});
+}
+
+std::string GetValue(const size_t &version) {
+  return "value of version " + std::to_string(version);
+}
+
+// Slots handed out so far and uninlined values held by the table
+void GetUsage(storage::DataTable *table, size_t &slot_count,
+              size_t &varlen_count) {
+  slot_count = 0;
+  varlen_count = 0;
+  for (auto tile_group_id : table->GetTileGroupIds()) {
+    auto tile_group = table->GetTileGroupById(tile_group_id);
+    slot_count += tile_group->GetHeader()->GetCurrentNextTupleSlot();
+    for (oid_t tile_itr = 0; tile_itr < tile_group->NumTiles(); tile_itr++) {
+      auto pool = static_cast<type::EphemeralPool *>(
+          tile_group->GetTile(tile_itr)->GetPool());
+      varlen_count += pool->locations_.size();
+    }
+  }
+}
+
+}  // namespace
+
+TEST_F(GCManagerTests, UpdateTest) {
+  auto &txn_manager =
+      concurrency::TimestampOrderingTransactionManager::GetInstance();
+  auto &gc_manager = gc::GCManager::GetInstance();
+  auto &manager = catalog::Manager::GetInstance();
+
+  auto schema = GetSchema();
+  std::unique_ptr<storage::DataTable> table(storage::TableFactory::GetDataTable(
+      INVALID_OID, INVALID_OID, schema, "gc_table", tuples_per_tile_group,
+      true, false));
+  storage::Tuple tuple(schema, true);
+  tuple.SetValue(0, type::ValueFactory::GetIntegerValue(1));
+  tuple.SetValue(1, type::ValueFactory::GetVarcharValue(GetValue(0)));
+
+  // The indirection leads to the newest version, like a primary index would
+  ItemPointer head_location;
+  auto txn = txn_manager.BeginTransaction();
+  ItemPointer location = table->InsertTuple(&tuple);
+  ASSERT_FALSE(location.IsNull());
+  head_location = location;
+  txn_manager.PerformInsert(txn, location, &head_location);
+  EXPECT_EQ(ResultType::SUCCESS, txn_manager.CommitTransaction(txn));
+
+  // Update the tuple over and over, without a GC thread
+  size_t max_slot_count = 0, max_varlen_count = 0;
+  for (size_t version = 1; version <= update_count; version++) {
+    txn = txn_manager.BeginTransaction();
+    ItemPointer old_location = head_location;
+    ASSERT_TRUE(txn_manager.PerformRead(txn, old_location, true));
+
+    ItemPointer new_location = table->AcquireVersion();
+    ASSERT_FALSE(new_location.IsNull());
+    tuple.SetValue(1, type::ValueFactory::GetVarcharValue(GetValue(version)));
+    manager.GetTileGroup(new_location.block)
+        ->CopyTuple(&tuple, new_location.offset);
+
+    txn_manager.PerformUpdate(txn, old_location, new_location);
+    EXPECT_EQ(ResultType::SUCCESS, txn_manager.CommitTransaction(txn));
+    EXPECT_EQ(new_location.block, head_location.block);
+    EXPECT_EQ(new_location.offset, head_location.offset);
+
+    size_t slot_count, varlen_count;
+    GetUsage(table.get(), slot_count, varlen_count);
+    max_slot_count = std::max(max_slot_count, slot_count);
+    max_varlen_count = std::max(max_varlen_count, varlen_count);
+  }
+
+  // Old versions are collected by the committing threads once their queue
+  // grows long, their slots and values are reused
+  size_t usage_bound = 4 * gc::GCManager::cooperative_collection_threshold_;
+  EXPECT_GT(usage_bound, max_slot_count);
+  EXPECT_GT(usage_bound, max_varlen_count);
+  EXPECT_GT(update_count / 2, max_slot_count);
+
+  // Without pinned epochs everything but the newest version goes
+  gc_manager.Collect();
+  EXPECT_EQ(0, gc_manager.GetPendingVersionCount());
+  EXPECT_EQ(update_count, gc_manager.GetCollectedVersionCount());
+
+  size_t slot_count, varlen_count;
+  GetUsage(table.get(), slot_count, varlen_count);
+  EXPECT_EQ(1, varlen_count);
+
+  auto head_tile_group = manager.GetTileGroup(head_location.block);
+  auto head_header = head_tile_group->GetHeader();
+  EXPECT_TRUE(head_header->GetNextItemPointer(head_location.offset).IsNull());
+  EXPECT_EQ(GetValue(update_count),
+            head_tile_group->GetValue(head_location.offset, 1).ToString());
+}
+
+TEST_F(GCManagerTests, PinnedSnapshotTest) {
+  auto &txn_manager =
+      concurrency::TimestampOrderingTransactionManager::GetInstance();
+  auto &gc_manager = gc::GCManager::GetInstance();
+  auto &manager = catalog::Manager::GetInstance();
+
+  auto schema = GetSchema();
+  std::unique_ptr<storage::DataTable> table(storage::TableFactory::GetDataTable(
+      INVALID_OID, INVALID_OID, schema, "pinned_table", tuples_per_tile_group,
+      true, false));
+  storage::Tuple tuple(schema, true);
+  tuple.SetValue(0, type::ValueFactory::GetIntegerValue(1));
+  tuple.SetValue(1, type::ValueFactory::GetVarcharValue(GetValue(0)));
+
+  ItemPointer head_location;
+  auto txn = txn_manager.BeginTransaction();
+  ItemPointer first_location = table->InsertTuple(&tuple);
+  head_location = first_location;
+  txn_manager.PerformInsert(txn, first_location, &head_location);
+  txn_manager.CommitTransaction(txn);
+
+  // A reader that started before the update keeps the old version alive
+  auto reader_txn = txn_manager.BeginReadonlyTransaction();
+
+  txn = txn_manager.BeginTransaction();
+  ASSERT_TRUE(txn_manager.PerformRead(txn, head_location, true));
+  ItemPointer new_location = table->AcquireVersion();
+  tuple.SetValue(1, type::ValueFactory::GetVarcharValue(GetValue(1)));
+  manager.GetTileGroup(new_location.block)
+      ->CopyTuple(&tuple, new_location.offset);
+  txn_manager.PerformUpdate(txn, first_location, new_location);
+  txn_manager.CommitTransaction(txn);
+
+  size_t collected_count = gc_manager.GetCollectedVersionCount();
+  gc_manager.Collect();
+  EXPECT_EQ(collected_count, gc_manager.GetCollectedVersionCount());
+
+  auto first_tile_group = manager.GetTileGroup(first_location.block);
+  EXPECT_EQ(VisibilityType::OK,
+            txn_manager.IsVisible(reader_txn, first_tile_group->GetHeader(),
+                                  first_location.offset));
+  EXPECT_EQ(GetValue(0),
+            first_tile_group->GetValue(first_location.offset, 1).ToString());
+
+  // Once the reader is done, the old version goes
+  txn_manager.CommitTransaction(reader_txn);
+  gc_manager.Collect();
+  EXPECT_EQ(collected_count + 1, gc_manager.GetCollectedVersionCount());
+
+  auto new_header = manager.GetTileGroup(new_location.block)->GetHeader();
+  EXPECT_TRUE(new_header->GetNextItemPointer(new_location.offset).IsNull());
+}
+
+}  // End test namespace
+}  // End peloton namespace
@@ -0,0 +1,381 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// backend_logger_test.cpp
+//
+// Identification: test/logging/backend_logger_test.cpp
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <atomic>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "common/crc32c.h"
+#include "logging/lock_free_buffer_pool.h"
+#include "logging/log_buffer.h"
+#include "logging/log_manager.h"
+#include "logging/loggers/wal_backend_logger.h"
+#include "logging/records/transaction_record.h"
+#include "logging/records/tuple_record.h"
+#include "type/serializeio.h"
+
+namespace peloton {
+namespace test {
+
+//===--------------------------------------------------------------------===//
+// Backend Logger Tests
+//===--------------------------------------------------------------------===//
+
+class BackendLoggerTests : public ::testing::Test {};
+
+namespace {
+
+const size_t backend_logger_count = 4;
+
+const size_t transaction_count = 2000;
+
+// Small buffers, so transactions often span several of them
+const unsigned int log_buffer_capacity = 1024;
+
+const oid_t database_oid = 45678;
+
+const oid_t table_oid = 45679;
+
+// Commit ids of the backend loggers interleave, but grow for each of them
+cid_t GetCommitId(size_t backend_itr, size_t transaction_itr) {
+  return 1 + transaction_itr * backend_logger_count + backend_itr;
+}
+
+// Every few transactions write more records than a buffer holds
+size_t GetTupleRecordCount(size_t transaction_itr) {
+  return (transaction_itr % 10 == 0) ? 40 : transaction_itr % 3;
+}
+
+// Begin and tuple records of a transaction, like a worker thread logs them
+// before its commit
+void LogTransactionRecords(logging::BackendLogger *backend_logger,
+                           size_t backend_itr, size_t transaction_itr) {
+  cid_t commit_id = GetCommitId(backend_itr, transaction_itr);
+  backend_logger->SetLoggingCidLowerBound(commit_id);
+
+  logging::TransactionRecord begin_record(LOGRECORD_TYPE_TRANSACTION_BEGIN,
+                                          commit_id);
+  backend_logger->Log(&begin_record);
+
+  for (size_t record_itr = 0; record_itr < GetTupleRecordCount(transaction_itr);
+       record_itr++) {
+    std::unique_ptr<logging::LogRecord> tuple_record(
+        backend_logger->GetTupleRecord(
+            LOGRECORD_TYPE_TUPLE_DELETE, commit_id, table_oid, database_oid,
+            INVALID_ITEMPOINTER, ItemPointer(1, record_itr)));
+    backend_logger->Log(tuple_record.get());
+  }
+}
+
+void LogCommit(logging::BackendLogger *backend_logger, cid_t commit_id) {
+  logging::TransactionRecord commit_record(LOGRECORD_TYPE_TRANSACTION_COMMIT,
+                                           commit_id);
+  backend_logger->Log(&commit_record);
+}
+
+void LogTransactions(logging::BackendLogger *backend_logger,
+                     size_t backend_itr) {
+  for (size_t transaction_itr = 0; transaction_itr < transaction_count;
+       transaction_itr++) {
+    LogTransactionRecords(backend_logger, backend_itr, transaction_itr);
+    LogCommit(backend_logger, GetCommitId(backend_itr, transaction_itr));
+  }
+}
+
+// Grant the buffers of a backend logger like its frontend logger does
+void GrantBuffers(logging::BackendLogger *backend_logger) {
+  for (int buffer_itr = 0; buffer_itr < BUFFER_POOL_SIZE; buffer_itr++) {
+    std::unique_ptr<logging::LogBuffer> log_buffer(
+        new logging::LogBuffer(backend_logger));
+    backend_logger->GrantEmptyBuffer(std::move(log_buffer));
+  }
+}
+
+// What the frontend has collected from a backend logger so far
+struct CollectedRecords {
+  size_t transaction_itr = 0;
+
+  LogRecordType next_record_type = LOGRECORD_TYPE_TRANSACTION_BEGIN;
+
+  size_t tuple_record_count = 0;
+
+  // highest commit whose records were all collected
+  cid_t collected_commit_id = INVALID_CID;
+
+  // highest commit the backend logger reported
+  cid_t reported_commit_id = INVALID_CID;
+};
+
+// Walks the records of a collected buffer, they have to arrive whole and in
+// the order they were logged
+void CollectRecords(logging::LogBuffer *log_buffer, size_t backend_itr,
+                    CollectedRecords &collected_records) {
+  const char *data = log_buffer->GetData();
+  size_t size = log_buffer->GetSize();
+  size_t offset = 0;
+  while (offset < size) {
+    size_t record_offset = offset;
+    auto record_type = (LogRecordType)((int8_t)data[offset]);
+    offset += sizeof(char);
+
+    int32_t frame_length;
+    ASSERT_GE(size, offset + sizeof(frame_length));
+    memcpy(&frame_length, data + offset, sizeof(frame_length));
+    ReferenceSerializeInput frame(data + offset,
+                                  sizeof(frame_length) + frame_length);
+    offset += sizeof(frame_length) + frame_length;
+
+    uint32_t checksum;
+    ASSERT_GE(size, offset + sizeof(checksum));
+    memcpy(&checksum, data + offset, sizeof(checksum));
+    EXPECT_EQ(Crc32c::Value(data + record_offset, offset - record_offset),
+              checksum);
+    offset += sizeof(checksum);
+
+    cid_t commit_id;
+    if (record_type == LOGRECORD_TYPE_WAL_TUPLE_DELETE) {
+      logging::TupleRecord record(record_type);
+      record.DeserializeHeader(frame);
+      commit_id = record.GetTransactionId();
+    } else {
+      logging::TransactionRecord record(record_type);
+      record.Deserialize(frame);
+      commit_id = record.GetTransactionId();
+    }
+
+    size_t transaction_itr = collected_records.transaction_itr;
+    ASSERT_GT(transaction_count, transaction_itr);
+    ASSERT_EQ(GetCommitId(backend_itr, transaction_itr), commit_id);
+    ASSERT_EQ(collected_records.next_record_type, record_type);
+
+    switch (record_type) {
+      case LOGRECORD_TYPE_TRANSACTION_BEGIN:
+        collected_records.tuple_record_count = 0;
+        break;
+      case LOGRECORD_TYPE_WAL_TUPLE_DELETE:
+        collected_records.tuple_record_count++;
+        break;
+      default:
+        collected_records.collected_commit_id = commit_id;
+        collected_records.transaction_itr++;
+        collected_records.next_record_type = LOGRECORD_TYPE_TRANSACTION_BEGIN;
+        continue;
+    }
+
+    if (collected_records.tuple_record_count ==
+        GetTupleRecordCount(transaction_itr)) {
+      collected_records.next_record_type = LOGRECORD_TYPE_TRANSACTION_COMMIT;
+    } else {
+      collected_records.next_record_type = LOGRECORD_TYPE_WAL_TUPLE_DELETE;
+    }
+  }
+}
+
+// One collection round of the frontend logger over a backend logger
+void CollectLogBuffers(logging::BackendLogger *backend_logger,
+                       size_t backend_itr,
+                       CollectedRecords &collected_records) {
+  auto cid_pair = backend_logger->PrepareLogBuffers();
+  auto &log_buffers = backend_logger->GetLogBuffers();
+  for (auto &log_buffer : log_buffers) {
+    CollectRecords(log_buffer.get(), backend_itr, collected_records);
+    log_buffer->ResetData();
+    backend_logger->GrantEmptyBuffer(std::move(log_buffer));
+  }
+  log_buffers.clear();
+
+  // A commit is never reported before its records are collected, and every
+  // commit below the lower bound is collected
+  cid_t backend_lower_bound = cid_pair.first;
+  cid_t backend_committed = cid_pair.second;
+  if (backend_committed != INVALID_CID) {
+    EXPECT_GE(collected_records.collected_commit_id, backend_committed);
+    EXPECT_LE(collected_records.reported_commit_id, backend_committed);
+    collected_records.reported_commit_id = backend_committed;
+  }
+  if (backend_lower_bound != INVALID_CID) {
+    EXPECT_GE(GetCommitId(backend_itr, collected_records.transaction_itr),
+              backend_lower_bound);
+  }
+}
+
+/**
+ * Persist pool that lets the frontend step in at the points where a backend
+ * hands a buffer over, or where a collection found no more buffers.
+ */
+class InterleavingBufferPool : public logging::BufferPool {
+ public:
+  bool Put(std::unique_ptr<logging::LogBuffer> log_buffer) {
+    bool status = buffer_pool_.Put(std::move(log_buffer));
+    if (after_put_) {
+      after_put_();
+    }
+    return status;
+  }
+
+  std::unique_ptr<logging::LogBuffer> Get() { return buffer_pool_.Get(); }
+
+  bool TryGet(std::unique_ptr<logging::LogBuffer> &log_buffer) {
+    if (buffer_pool_.TryGet(log_buffer) == true) {
+      return true;
+    }
+    if (after_drain_) {
+      auto after_drain = std::move(after_drain_);
+      after_drain_ = nullptr;
+      after_drain();
+    }
+    return false;
+  }
+
+  unsigned int GetSize() { return buffer_pool_.GetSize(); }
+
+  // runs after every buffer handed over
+  std::function<void()> after_put_;
+
+  // runs once, when a collection finds the pool empty
+  std::function<void()> after_drain_;
+
+ private:
+  logging::LockFreeBufferPool buffer_pool_;
+};
+
+class InterleavingBackendLogger : public logging::WriteAheadBackendLogger {
+ public:
+  InterleavingBackendLogger() : buffer_pool_(new InterleavingBufferPool()) {
+    persist_buffer_pool_.reset(buffer_pool_);
+  }
+
+  InterleavingBufferPool *GetPersistBufferPool() { return buffer_pool_; }
+
+  cid_t GetPublishedCommitId() { return highest_logged_commit_message; }
+
+ private:
+  InterleavingBufferPool *buffer_pool_;
+};
+
+}  // namespace
+
+TEST_F(BackendLoggerTests, PublicationOrderTest) {
+  auto &log_manager = logging::LogManager::GetInstance();
+  unsigned int old_log_buffer_capacity = log_manager.GetLogBufferCapacity();
+  log_manager.SetLogBufferCapacity(log_buffer_capacity);
+
+  InterleavingBackendLogger backend_logger;
+  GrantBuffers(&backend_logger);
+  auto buffer_pool = backend_logger.GetPersistBufferPool();
+  CollectedRecords collected_records;
+
+  // The frontend collects each buffer as soon as it is handed over, before
+  // the commit in it is published. The commit is reported by the next
+  // collection, though its buffer is gone by then.
+  const size_t stepped_transaction_count = 12;
+  cid_t commit_id = INVALID_CID;
+  buffer_pool->after_put_ = [&] {
+    EXPECT_GT(commit_id, backend_logger.GetPublishedCommitId());
+    CollectLogBuffers(&backend_logger, 0, collected_records);
+  };
+  for (size_t transaction_itr = 0; transaction_itr < stepped_transaction_count;
+       transaction_itr++) {
+    commit_id = GetCommitId(0, transaction_itr);
+    LogTransactionRecords(&backend_logger, 0, transaction_itr);
+    LogCommit(&backend_logger, commit_id);
+    EXPECT_EQ(commit_id, collected_records.collected_commit_id);
+    EXPECT_GT(commit_id, collected_records.reported_commit_id);
+
+    CollectLogBuffers(&backend_logger, 0, collected_records);
+    EXPECT_EQ(commit_id, collected_records.reported_commit_id);
+  }
+  buffer_pool->after_put_ = nullptr;
+
+  // A transaction commits right after a collection took the buffers, its
+  // commit is left for the next collection to report along with its buffer
+  cid_t last_commit_id = commit_id;
+  commit_id = GetCommitId(0, stepped_transaction_count);
+  ASSERT_EQ(0, GetTupleRecordCount(stepped_transaction_count));
+  LogTransactionRecords(&backend_logger, 0, stepped_transaction_count);
+  buffer_pool->after_drain_ = [&] { LogCommit(&backend_logger, commit_id); };
+  CollectLogBuffers(&backend_logger, 0, collected_records);
+  EXPECT_EQ(commit_id, backend_logger.GetPublishedCommitId());
+  EXPECT_EQ(last_commit_id, collected_records.collected_commit_id);
+  EXPECT_EQ(last_commit_id, collected_records.reported_commit_id);
+
+  CollectLogBuffers(&backend_logger, 0, collected_records);
+  EXPECT_EQ(commit_id, collected_records.collected_commit_id);
+  EXPECT_EQ(commit_id, collected_records.reported_commit_id);
+
+  log_manager.SetLogBufferCapacity(old_log_buffer_capacity);
+}
+
+TEST_F(BackendLoggerTests, CollectWhileLoggingTest) {
+  auto &log_manager = logging::LogManager::GetInstance();
+  unsigned int old_log_buffer_capacity = log_manager.GetLogBufferCapacity();
+  log_manager.SetLogBufferCapacity(log_buffer_capacity);
+
+  std::vector<std::unique_ptr<logging::BackendLogger>> backend_loggers;
+  for (size_t backend_itr = 0; backend_itr < backend_logger_count;
+       backend_itr++) {
+    backend_loggers.emplace_back(new logging::WriteAheadBackendLogger());
+    GrantBuffers(backend_loggers.back().get());
+  }
+
+  std::atomic<size_t> finished_count(0);
+  std::vector<std::thread> backend_threads;
+  for (size_t backend_itr = 0; backend_itr < backend_logger_count;
+       backend_itr++) {
+    backend_threads.emplace_back([&, backend_itr] {
+      LogTransactions(backend_loggers[backend_itr].get(), backend_itr);
+      finished_count++;
+    });
+  }
+
+  // Collect as fast as possible while the backends log and commit
+  std::vector<CollectedRecords> collected_records(backend_logger_count);
+  while (finished_count != backend_logger_count) {
+    for (size_t backend_itr = 0; backend_itr < backend_logger_count;
+         backend_itr++) {
+      CollectLogBuffers(backend_loggers[backend_itr].get(), backend_itr,
+                        collected_records[backend_itr]);
+    }
+  }
+  for (auto &backend_thread : backend_threads) {
+    backend_thread.join();
+  }
+
+  // The last commit is reported once all is collected, even if its buffer
+  // went out with an earlier round
+  for (size_t backend_itr = 0; backend_itr < backend_logger_count;
+       backend_itr++) {
+    CollectLogBuffers(backend_loggers[backend_itr].get(), backend_itr,
+                      collected_records[backend_itr]);
+    auto &backend_records = collected_records[backend_itr];
+    cid_t last_commit_id = GetCommitId(backend_itr, transaction_count - 1);
+    EXPECT_EQ(transaction_count, backend_records.transaction_itr);
+    EXPECT_EQ(last_commit_id, backend_records.collected_commit_id);
+    EXPECT_EQ(last_commit_id, backend_records.reported_commit_id);
+
+    // Nothing new to report afterwards
+    auto cid_pair = backend_loggers[backend_itr]->PrepareLogBuffers();
+    EXPECT_EQ(INVALID_CID, cid_pair.first);
+    EXPECT_EQ(INVALID_CID, cid_pair.second);
+    EXPECT_TRUE(backend_loggers[backend_itr]->GetLogBuffers().empty());
+  }
+
+  log_manager.SetLogBufferCapacity(old_log_buffer_capacity);
+}
+
+}  // End test namespace
+}  // End peloton namespace
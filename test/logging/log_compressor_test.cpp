@@ -0,0 +1,144 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// log_compressor_test.cpp
+//
+// Identification: test/logging/log_compressor_test.cpp
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "common/crc32c.h"
+#include "logging/log_compressor.h"
+
+namespace peloton {
+namespace test {
+
+//===--------------------------------------------------------------------===//
+// Log Compressor Tests
+//===--------------------------------------------------------------------===//
+
+class LogCompressorTests : public ::testing::Test {};
+
+namespace {
+
+// Tuple images of one table that repeat most of their columns
+std::vector<char> GetLogData(size_t size) {
+  const std::string row = "db12345|tbl777|value_of_row_";
+  std::vector<char> data(size);
+  srand(7);
+  for (size_t byte_itr = 0; byte_itr < size; byte_itr++) {
+    data[byte_itr] = row[byte_itr % row.size()];
+    if (byte_itr % 97 == 0) {
+      data[byte_itr] ^= static_cast<char>(rand() & 7);
+    }
+  }
+  return data;
+}
+
+// The frame of a block record, without its type and checksum
+std::vector<char> GetFrame(const logging::LogCompressor &log_compressor) {
+  const char *block = log_compressor.GetBlock();
+  size_t block_size = log_compressor.GetBlockSize();
+  return std::vector<char>(block + sizeof(char),
+                           block + block_size - sizeof(uint32_t));
+}
+
+}  // namespace
+
+TEST_F(LogCompressorTests, RoundTripTest) {
+  logging::LogCompressor log_compressor;
+  std::vector<char> data = GetLogData(256 * 1024);
+
+  for (int level = logging::LogCompressor::min_level_ + 1;
+       level <= logging::LogCompressor::max_level_; level++) {
+    ASSERT_TRUE(log_compressor.CompressBlock(data.data(), data.size(), level));
+    EXPECT_GT(data.size(), log_compressor.GetBlockSize());
+
+    // The checksum closes the block like any other log record
+    size_t block_size = log_compressor.GetBlockSize();
+    uint32_t checksum;
+    memcpy(&checksum,
+           log_compressor.GetBlock() + block_size - sizeof(checksum),
+           sizeof(checksum));
+    EXPECT_EQ(Crc32c::Value(log_compressor.GetBlock(),
+                            block_size - sizeof(checksum)),
+              checksum);
+
+    std::vector<char> frame = GetFrame(log_compressor);
+    std::vector<char> decompressed;
+    ASSERT_TRUE(logging::LogCompressor::DecompressFrame(
+        frame.data(), frame.size(), decompressed));
+    EXPECT_TRUE(decompressed == data);
+  }
+}
+
+TEST_F(LogCompressorTests, IncompressibleDataTest) {
+  logging::LogCompressor log_compressor;
+  std::vector<char> data(64 * 1024);
+  srand(11);
+  for (auto &byte : data) {
+    byte = static_cast<char>(rand());
+  }
+
+  EXPECT_FALSE(log_compressor.CompressBlock(
+      data.data(), data.size(), logging::LogCompressor::max_level_));
+  EXPECT_FALSE(log_compressor.CompressBlock(
+      data.data(), data.size(), logging::LogCompressor::min_level_));
+}
+
+TEST_F(LogCompressorTests, CorruptFrameTest) {
+  logging::LogCompressor log_compressor;
+  std::vector<char> data = GetLogData(64 * 1024);
+  ASSERT_TRUE(log_compressor.CompressBlock(data.data(), data.size(), 1));
+  std::vector<char> frame = GetFrame(log_compressor);
+  std::vector<char> decompressed;
+
+  // Too short for its own header
+  EXPECT_FALSE(logging::LogCompressor::DecompressFrame(frame.data(), 6,
+                                                       decompressed));
+
+  // Cut off in the middle of the compressed data
+  EXPECT_FALSE(logging::LogCompressor::DecompressFrame(
+      frame.data(), frame.size() / 2, decompressed));
+
+  // Claims more log data than the sequences produce
+  std::vector<char> oversized_frame = frame;
+  uint32_t data_size = static_cast<uint32_t>(data.size() + 1);
+  memcpy(oversized_frame.data() + sizeof(int32_t), &data_size,
+         sizeof(data_size));
+  EXPECT_FALSE(logging::LogCompressor::DecompressFrame(
+      oversized_frame.data(), oversized_frame.size(), decompressed));
+
+  // A match reaching back before the beginning of the log data
+  std::vector<char> bad_offset_frame(frame.begin(),
+                                     frame.begin() + 2 * sizeof(int32_t));
+  const char sequence[] = {0x10, 'x', 0x05, 0x00};
+  bad_offset_frame.insert(bad_offset_frame.end(), sequence,
+                          sequence + sizeof(sequence));
+  EXPECT_FALSE(logging::LogCompressor::DecompressFrame(
+      bad_offset_frame.data(), bad_offset_frame.size(), decompressed));
+
+  // Random damage must never read or write out of bounds
+  srand(13);
+  for (int damage_itr = 0; damage_itr < 1000; damage_itr++) {
+    std::vector<char> damaged_frame = frame;
+    size_t byte_offset =
+        2 * sizeof(int32_t) + rand() % (frame.size() - 2 * sizeof(int32_t));
+    damaged_frame[byte_offset] ^= static_cast<char>(1 << (rand() % 8));
+    logging::LogCompressor::DecompressFrame(
+        damaged_frame.data(), damaged_frame.size(), decompressed);
+  }
+}
+
+}  // End test namespace
+}  // End peloton namespace
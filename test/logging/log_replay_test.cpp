@@ -0,0 +1,462 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// log_replay_test.cpp
+//
+// Identification: test/logging/log_replay_test.cpp
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "catalog/catalog.h"
+#include "catalog/manager.h"
+#include "catalog/schema.h"
+#include "logging/log_manager.h"
+#include "logging/log_replayer.h"
+#include "logging/loggers/wal_frontend_logger.h"
+#include "logging/logging_util.h"
+#include "logging/records/transaction_record.h"
+#include "logging/records/tuple_record.h"
+#include "storage/data_table.h"
+#include "storage/database.h"
+#include "storage/table_factory.h"
+#include "storage/tile_group.h"
+#include "storage/tile_group_header.h"
+#include "storage/tuple.h"
+#include "type/serializeio.h"
+#include "type/value_factory.h"
+
+namespace peloton {
+namespace test {
+
+//===--------------------------------------------------------------------===//
+// Log Replay Tests
+//===--------------------------------------------------------------------===//
+
+class LogReplayTests : public ::testing::Test {
+ protected:
+  virtual void SetUp() {
+    char directory[] = "/tmp/log_replay_test_XXXXXX";
+    ASSERT_TRUE(mkdtemp(directory) != nullptr);
+    directory_ = directory;
+  }
+
+  virtual void TearDown() {
+    logging::LoggingUtil::RemoveDirectory(directory_.c_str(), false);
+  }
+
+  std::string directory_;
+};
+
+namespace {
+
+const oid_t database_oid = 23456;
+
+const oid_t table_oid = 23457;
+
+// Far behind the tile groups created by the catalog
+const oid_t tile_group_id = 5000;
+
+const size_t tuples_per_tile_group = 100;
+
+// The first transaction inserts a tuple, every later one updates it
+const cid_t first_commit_id = 10;
+
+const cid_t last_commit_id = 19;
+
+// Transactions of a stream between two of its delimiters
+const size_t delimiter_interval = 2;
+
+const size_t stream_count = 2;
+
+catalog::Schema *GetSchema() {
+  catalog::Column key_column(type::Type::INTEGER,
+                             type::Type::GetTypeSize(type::Type::INTEGER),
+                             "key", true);
+  catalog::Column value_column(type::Type::INTEGER,
+                               type::Type::GetTypeSize(type::Type::INTEGER),
+                               "value", true);
+  return new catalog::Schema({key_column, value_column});
+}
+
+// Every version of the tuple gets its own slot
+ItemPointer GetLocation(const cid_t &commit_id) {
+  return ItemPointer(tile_group_id, commit_id - first_commit_id);
+}
+
+void AppendRecord(std::vector<char> &log_data, const char *message,
+                  size_t message_length) {
+  log_data.insert(log_data.end(), message, message + message_length);
+}
+
+void AppendTransactionRecord(std::vector<char> &log_data,
+                             LogRecordType record_type, const cid_t &cid) {
+  logging::TransactionRecord record(record_type, cid);
+  CopySerializeOutput output;
+  record.Serialize(output);
+  AppendRecord(log_data, record.GetMessage(), record.GetMessageLength());
+}
+
+// Writes the tuple version of the commit id, an update of the previous
+// version unless it is the first one
+void AppendTransaction(std::vector<char> &log_data, catalog::Schema *schema,
+                       const cid_t &commit_id, bool committed) {
+  AppendTransactionRecord(log_data, LOGRECORD_TYPE_TRANSACTION_BEGIN,
+                          commit_id);
+
+  storage::Tuple tuple(schema, true);
+  tuple.SetValue(0, type::ValueFactory::GetIntegerValue(1));
+  tuple.SetValue(1, type::ValueFactory::GetIntegerValue(commit_id));
+
+  LogRecordType record_type = LOGRECORD_TYPE_WAL_TUPLE_UPDATE;
+  ItemPointer delete_location = GetLocation(commit_id - 1);
+  if (commit_id == first_commit_id) {
+    record_type = LOGRECORD_TYPE_WAL_TUPLE_INSERT;
+    delete_location = INVALID_ITEMPOINTER;
+  }
+  logging::TupleRecord record(record_type, commit_id, table_oid,
+                              GetLocation(commit_id), delete_location, &tuple,
+                              database_oid);
+  CopySerializeOutput output;
+  record.Serialize(output);
+  AppendRecord(log_data, record.GetMessage(), record.GetMessageLength());
+
+  if (committed == true) {
+    AppendTransactionRecord(log_data, LOGRECORD_TYPE_TRANSACTION_COMMIT,
+                            commit_id);
+  }
+}
+
+// Log file of a stream, with the header the frontend logger writes
+void WriteLogFile(const std::string &directory,
+                  const std::vector<char> &log_data, cid_t max_log_id,
+                  cid_t max_delimiter) {
+  ASSERT_TRUE(logging::LoggingUtil::CreateDirectory(directory.c_str(), 0700));
+  std::string file_name = directory + "/peloton_log_0.log";
+  FILE *file = fopen(file_name.c_str(), "wb");
+  ASSERT_TRUE(file != nullptr);
+  EXPECT_EQ(1, fwrite(&max_log_id, sizeof(max_log_id), 1, file));
+  EXPECT_EQ(1, fwrite(&max_delimiter, sizeof(max_delimiter), 1, file));
+  EXPECT_EQ(log_data.size(),
+            fwrite(log_data.data(), 1, log_data.size(), file));
+  EXPECT_EQ(0, fclose(file));
+}
+
+// Tables written by the replayer on its own, far from the tile groups of
+// the streams
+const oid_t replayer_database_oid = 23458;
+
+const oid_t replayer_table_oid = 23459;
+
+const oid_t replayer_tile_group_id = 6000;
+
+const oid_t replayer_tile_group_count = 4;
+
+const size_t replayer_worker_count = 3;
+
+const int32_t replayer_tuple_count = 200;
+
+catalog::Schema *GetReplayerSchema() {
+  catalog::Column key_column(type::Type::INTEGER,
+                             type::Type::GetTypeSize(type::Type::INTEGER),
+                             "key", true);
+  catalog::Column name_column(type::Type::VARCHAR, 64, "name", false);
+  catalog::Column balance_column(type::Type::DECIMAL,
+                                 type::Type::GetTypeSize(type::Type::DECIMAL),
+                                 "balance", true);
+  catalog::Column note_column(type::Type::VARCHAR, 64, "note", false);
+  return new catalog::Schema(
+      {key_column, name_column, balance_column, note_column});
+}
+
+// Tuple body of a record, as the frontend logger hands it out of the mapped
+// log
+std::vector<char> GetTupleBody(catalog::Schema *schema, int32_t key,
+                               const std::string &name) {
+  storage::Tuple tuple(schema, true);
+  tuple.SetValue(0, type::ValueFactory::GetIntegerValue(key));
+  tuple.SetValue(1, type::ValueFactory::GetVarcharValue(name));
+  tuple.SetValue(2, type::ValueFactory::GetDecimalValue(key * 1.5));
+  if (key % 2 == 0) {
+    tuple.SetValue(3, type::ValueFactory::GetNullValueByType(
+                          type::Type::VARCHAR));
+  } else {
+    tuple.SetValue(3, type::ValueFactory::GetVarcharValue(
+                          std::string(key, 'n')));
+  }
+  CopySerializeOutput output;
+  tuple.SerializeTo(output);
+  return std::vector<char>(output.Data(), output.Data() + output.Size());
+}
+
+// The values of a tuple body, deserialized one by one like recovery did
+// before decoding the bodies straight into the tiles
+std::vector<type::Value> GetTupleValues(catalog::Schema *schema,
+                                        const std::vector<char> &tuple_body) {
+  std::vector<type::Value> values;
+  ReferenceSerializeInput input(tuple_body.data(), tuple_body.size());
+  input.ReadInt();
+  for (oid_t column_itr = 0; column_itr < schema->GetColumnCount();
+       column_itr++) {
+    values.push_back(
+        type::Value::DeserializeFrom(input, schema->GetType(column_itr)));
+  }
+  return values;
+}
+
+void CheckTupleValues(storage::TileGroup *tile_group, oid_t tuple_slot_id,
+                      const std::vector<type::Value> &values) {
+  for (oid_t column_itr = 0; column_itr < values.size(); column_itr++) {
+    auto value = tile_group->GetValue(tuple_slot_id, column_itr);
+    if (values[column_itr].IsNull() == true) {
+      EXPECT_TRUE(value.IsNull()) << "column " << column_itr;
+    } else {
+      EXPECT_EQ(type::CMP_TRUE, values[column_itr].CompareEquals(value))
+          << "column " << column_itr;
+    }
+  }
+}
+
+// Tuples are spread over the tile groups, and so over the workers
+ItemPointer GetReplayerLocation(int32_t key) {
+  return ItemPointer(replayer_tile_group_id + key % replayer_tile_group_count,
+                     key / replayer_tile_group_count);
+}
+
+// Updated versions go to the tile group of another worker
+ItemPointer GetUpdatedLocation(int32_t key) {
+  return ItemPointer(
+      replayer_tile_group_id + (key + 1) % replayer_tile_group_count,
+      replayer_tuple_count / replayer_tile_group_count +
+          key / replayer_tile_group_count);
+}
+
+bool IsUpdated(int32_t key) { return key % 5 == 0; }
+
+bool IsDeleted(int32_t key) { return key % 7 == 3 && IsUpdated(key) == false; }
+
+}  // namespace
+
+TEST_F(LogReplayTests, InterleavedStreamsTest) {
+  auto &log_manager = logging::LogManager::GetInstance();
+  auto catalog = catalog::Catalog::GetInstance();
+  auto &manager = catalog::Manager::GetInstance();
+
+  // Each version is written by the other stream than the one before it,
+  // the streams hold back their delimiters differently
+  std::unique_ptr<catalog::Schema> tuple_schema(GetSchema());
+  std::vector<std::vector<char>> log_data(stream_count);
+  std::vector<size_t> transaction_counts(stream_count, 0);
+  std::vector<cid_t> max_delimiters(stream_count, INVALID_CID);
+  for (cid_t commit_id = first_commit_id; commit_id <= last_commit_id;
+       commit_id++) {
+    size_t stream_id = commit_id % stream_count;
+    AppendTransaction(log_data[stream_id], tuple_schema.get(), commit_id,
+                      true);
+    if (++transaction_counts[stream_id] % delimiter_interval == 0) {
+      AppendTransactionRecord(log_data[stream_id],
+                              LOGRECORD_TYPE_ITERATION_DELIMITER, commit_id);
+      max_delimiters[stream_id] = commit_id;
+    }
+  }
+
+  // Never committed
+  AppendTransaction(log_data[0], tuple_schema.get(), last_commit_id + 1,
+                    false);
+
+  // Streams other than the first one add their id to the directory name
+  std::string stream_directory =
+      directory_ + "/" + logging::WriteAheadFrontendLogger::wal_directory_path;
+  for (size_t stream_id = 0; stream_id < stream_count; stream_id++) {
+    log_manager.SetLogStreamDirectoryName(stream_id, directory_ + "/");
+    std::string directory = stream_directory;
+    if (stream_id != 0) {
+      directory += "_" + std::to_string(stream_id);
+    }
+    WriteLogFile(directory, log_data[stream_id], last_commit_id + 1,
+                 max_delimiters[stream_id]);
+  }
+
+  // The table the records belong to
+  storage::Database *database = new storage::Database(database_oid);
+  storage::DataTable *table = storage::TableFactory::GetDataTable(
+      database_oid, table_oid, GetSchema(), "replay_table",
+      tuples_per_tile_group, true, false);
+  database->AddTable(table);
+  catalog->AddDatabase(database);
+
+  log_manager.SetLogFileSizeLimit(1024);
+  log_manager.Configure(LoggingType::NVM_WAL, false, stream_count);
+  log_manager.InitFrontendLoggers();
+  log_manager.SetGlobalMaxFlushedIdForRecovery(MAX_CID);
+  for (size_t stream_id = 0; stream_id < stream_count; stream_id++) {
+    log_manager.GetFrontendLogger(stream_id)->DoRecovery();
+  }
+  log_manager.ReplayRecoveredTransactions();
+
+  // A version applied before the transaction that wrote it would be ended
+  // without ever getting its value
+  auto tile_group = manager.GetTileGroup(tile_group_id);
+  ASSERT_TRUE(tile_group != nullptr);
+  auto tile_group_header = tile_group->GetHeader();
+  for (cid_t commit_id = first_commit_id; commit_id <= last_commit_id;
+       commit_id++) {
+    oid_t tuple_slot_id = GetLocation(commit_id).offset;
+    EXPECT_EQ(commit_id,
+              tile_group->GetValue(tuple_slot_id, 1).GetAs<int32_t>());
+
+    if (commit_id == last_commit_id) {
+      EXPECT_EQ(INITIAL_TXN_ID,
+                tile_group_header->GetTransactionId(tuple_slot_id));
+      EXPECT_EQ(commit_id, tile_group_header->GetBeginCommitId(tuple_slot_id));
+      EXPECT_EQ(MAX_CID, tile_group_header->GetEndCommitId(tuple_slot_id));
+    } else {
+      EXPECT_EQ(commit_id + 1,
+                tile_group_header->GetEndCommitId(tuple_slot_id));
+      ItemPointer new_location =
+          tile_group_header->GetNextItemPointer(tuple_slot_id);
+      EXPECT_EQ(GetLocation(commit_id + 1).offset, new_location.offset);
+    }
+  }
+
+  // The transaction left running is not replayed
+  EXPECT_EQ(GetLocation(last_commit_id + 1).offset,
+            tile_group_header->GetCurrentNextTupleSlot());
+  EXPECT_EQ(1, table->GetTupleCount());
+}
+
+TEST_F(LogReplayTests, ReplayerTest) {
+  auto catalog = catalog::Catalog::GetInstance();
+  auto &manager = catalog::Manager::GetInstance();
+
+  std::unique_ptr<catalog::Schema> tuple_schema(GetReplayerSchema());
+  storage::Database *database = new storage::Database(replayer_database_oid);
+  storage::DataTable *table = storage::TableFactory::GetDataTable(
+      replayer_database_oid, replayer_table_oid, GetReplayerSchema(),
+      "replayer_table", tuples_per_tile_group, true, false);
+  database->AddTable(table);
+  catalog->AddDatabase(database);
+
+  // Bodies of the inserts and of the updates, the values they hold are
+  // deserialized by the old path. Values deserialized that way point into
+  // the bodies, so these stay as they are.
+  std::vector<std::vector<char>> tuple_bodies;
+  for (int32_t key = 0; key < replayer_tuple_count; key++) {
+    tuple_bodies.push_back(GetTupleBody(tuple_schema.get(), key,
+                                        "inserted " + std::to_string(key)));
+    tuple_bodies.push_back(GetTupleBody(tuple_schema.get(), key,
+                                        "updated " + std::to_string(key)));
+  }
+  std::vector<std::vector<type::Value>> tuple_values;
+  for (auto &tuple_body : tuple_bodies) {
+    tuple_values.push_back(GetTupleValues(tuple_schema.get(), tuple_body));
+  }
+
+  // The replayed bodies stay in place until the replay is done, like the
+  // mapped log
+  std::vector<std::vector<char>> log_bodies(tuple_bodies);
+
+  // Inserts, then updates, then deletes, one transaction each
+  logging::LogReplayer log_replayer(replayer_worker_count);
+  std::vector<logging::TupleRecord *> tuple_records;
+  for (int32_t key = 0; key < replayer_tuple_count; key++) {
+    cid_t commit_id = 100 + key;
+    auto &tuple_body = log_bodies[2 * key];
+    auto tuple_record = new logging::TupleRecord(
+        LOGRECORD_TYPE_WAL_TUPLE_INSERT, commit_id, replayer_table_oid,
+        GetReplayerLocation(key), INVALID_ITEMPOINTER, nullptr,
+        replayer_database_oid);
+    tuple_record->SetTupleBody(tuple_body.data(), tuple_body.size());
+    tuple_records.push_back(tuple_record);
+    log_replayer.ReplayTransaction(commit_id, tuple_records);
+    EXPECT_TRUE(tuple_records.empty());
+  }
+  for (int32_t key = 0; key < replayer_tuple_count; key++) {
+    if (IsUpdated(key) == false) {
+      continue;
+    }
+    cid_t commit_id = 1000 + key;
+    auto &tuple_body = log_bodies[2 * key + 1];
+    auto tuple_record = new logging::TupleRecord(
+        LOGRECORD_TYPE_WAL_TUPLE_UPDATE, commit_id, replayer_table_oid,
+        GetUpdatedLocation(key), GetReplayerLocation(key), nullptr,
+        replayer_database_oid);
+    tuple_record->SetTupleBody(tuple_body.data(), tuple_body.size());
+    tuple_records.push_back(tuple_record);
+    log_replayer.ReplayTransaction(commit_id, tuple_records);
+  }
+  size_t deleted_count = 0;
+  for (int32_t key = 0; key < replayer_tuple_count; key++) {
+    if (IsDeleted(key) == false) {
+      continue;
+    }
+    cid_t commit_id = 2000 + key;
+    tuple_records.push_back(new logging::TupleRecord(
+        LOGRECORD_TYPE_WAL_TUPLE_DELETE, commit_id, replayer_table_oid,
+        INVALID_ITEMPOINTER, GetReplayerLocation(key), nullptr,
+        replayer_database_oid));
+    log_replayer.ReplayTransaction(commit_id, tuple_records);
+    deleted_count++;
+  }
+
+  // Every tile group was created by the replay
+  EXPECT_EQ(replayer_tile_group_id + replayer_tile_group_count - 1,
+            log_replayer.Finish());
+
+  // The values live in the tiles, not in the log data
+  for (auto &log_body : log_bodies) {
+    memset(log_body.data(), 0, log_body.size());
+  }
+
+  for (int32_t key = 0; key < replayer_tuple_count; key++) {
+    ItemPointer location = GetReplayerLocation(key);
+    auto tile_group = manager.GetTileGroup(location.block);
+    ASSERT_TRUE(tile_group != nullptr);
+    auto tile_group_header = tile_group->GetHeader();
+    CheckTupleValues(tile_group.get(), location.offset, tuple_values[2 * key]);
+
+    if (IsUpdated(key) == true) {
+      ItemPointer new_location = GetUpdatedLocation(key);
+      EXPECT_EQ(1000 + key, tile_group_header->GetEndCommitId(location.offset));
+      ItemPointer next_location =
+          tile_group_header->GetNextItemPointer(location.offset);
+      EXPECT_EQ(new_location.block, next_location.block);
+      EXPECT_EQ(new_location.offset, next_location.offset);
+
+      auto new_tile_group = manager.GetTileGroup(new_location.block);
+      CheckTupleValues(new_tile_group.get(), new_location.offset,
+                       tuple_values[2 * key + 1]);
+      auto new_tile_group_header = new_tile_group->GetHeader();
+      EXPECT_EQ(1000 + key,
+                new_tile_group_header->GetBeginCommitId(new_location.offset));
+      EXPECT_EQ(MAX_CID,
+                new_tile_group_header->GetEndCommitId(new_location.offset));
+    } else if (IsDeleted(key) == true) {
+      EXPECT_EQ(INVALID_TXN_ID,
+                tile_group_header->GetTransactionId(location.offset));
+      EXPECT_EQ(2000 + key, tile_group_header->GetEndCommitId(location.offset));
+    } else {
+      EXPECT_EQ(INITIAL_TXN_ID,
+                tile_group_header->GetTransactionId(location.offset));
+      EXPECT_EQ(100 + key,
+                tile_group_header->GetBeginCommitId(location.offset));
+      EXPECT_EQ(MAX_CID, tile_group_header->GetEndCommitId(location.offset));
+    }
+  }
+
+  // Versions of updates are not new tuples
+  EXPECT_EQ(replayer_tuple_count - deleted_count, table->GetTupleCount());
+}
+
+}  // End test namespace
+}  // End peloton namespace
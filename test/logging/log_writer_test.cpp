@@ -0,0 +1,129 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// log_writer_test.cpp
+//
+// Identification: test/logging/log_writer_test.cpp
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <sys/stat.h>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+#include "gtest/gtest.h"
+
+#include "logging/log_segment_pool.h"
+#include "logging/log_writer.h"
+#include "logging/logging_util.h"
+#include "logging/mapped_log_file.h"
+#include "logging/records/transaction_record.h"
+#include "type/serializeio.h"
+
+namespace peloton {
+namespace test {
+
+//===--------------------------------------------------------------------===//
+// Log Writer Tests
+//===--------------------------------------------------------------------===//
+
+class LogWriterTests : public ::testing::Test {
+ protected:
+  virtual void SetUp() {
+    char directory[] = "/tmp/log_writer_test_XXXXXX";
+    ASSERT_TRUE(mkdtemp(directory) != nullptr);
+    directory_ = directory;
+  }
+
+  virtual void TearDown() {
+    logging::LoggingUtil::RemoveDirectory(directory_.c_str(), false);
+  }
+
+  std::string directory_;
+};
+
+namespace {
+
+// More than all staging buffers of the writer hold, so they are reused
+const size_t record_count = 100000;
+
+const size_t segment_size = 4 * 1024 * 1024;
+
+void AppendCommitRecord(logging::LogWriter &log_writer, const cid_t &cid) {
+  logging::TransactionRecord record(LOGRECORD_TYPE_TRANSACTION_COMMIT, cid);
+  CopySerializeOutput output;
+  record.Serialize(output);
+  log_writer.Append(record.GetMessage(), record.GetMessageLength());
+}
+
+}  // namespace
+
+TEST_F(LogWriterTests, WriteThenRecoverTest) {
+  std::string file_name = directory_ + "/peloton_log_0.log";
+
+  // Write into a preallocated, zeroed segment
+  {
+    logging::LogSegmentPool log_segment_pool(directory_, segment_size);
+    for (int wait_itr = 0; wait_itr < 1000; wait_itr++) {
+      if (log_segment_pool.GetSpareSegmentCount() > 0) {
+        break;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_LT(0, log_segment_pool.GetSpareSegmentCount());
+    ASSERT_TRUE(log_segment_pool.AcquireSegment(file_name));
+  }
+
+  struct stat file_stat;
+  ASSERT_EQ(0, stat(file_name.c_str(), &file_stat));
+  EXPECT_EQ(segment_size, static_cast<size_t>(file_stat.st_size));
+
+  // Sync now and then, so that partial blocks are written again
+  logging::LogWriter log_writer;
+  ASSERT_TRUE(log_writer.Open(file_name));
+  for (size_t record_itr = 1; record_itr <= record_count; record_itr++) {
+    AppendCommitRecord(log_writer, record_itr);
+    if (record_itr % 997 == 0) {
+      EXPECT_TRUE(log_writer.Sync());
+    }
+  }
+  EXPECT_TRUE(log_writer.Sync());
+  size_t log_size = log_writer.GetSize();
+  log_writer.Close();
+
+  // Recovery reads every record back and stops at the zeros behind them
+  logging::MappedLogFile log_file;
+  ASSERT_TRUE(log_file.Open(file_name));
+  cid_t expected_cid = 1;
+  while (true) {
+    size_t record_offset = log_file.GetOffset();
+    LogRecordType record_type = log_file.ReadRecordType();
+    if (record_type == LOGRECORD_TYPE_INVALID) {
+      break;
+    }
+    ASSERT_EQ(LOGRECORD_TYPE_TRANSACTION_COMMIT, record_type);
+
+    const char *frame;
+    size_t frame_size;
+    ASSERT_TRUE(log_file.ReadFrame(frame, frame_size));
+    ASSERT_TRUE(log_file.ReadChecksum(record_offset));
+
+    logging::TransactionRecord record(record_type);
+    ReferenceSerializeInput input(frame, frame_size);
+    record.Deserialize(input);
+    ASSERT_EQ(expected_cid, record.GetTransactionId());
+    expected_cid++;
+  }
+
+  EXPECT_EQ(record_count + 1, expected_cid);
+  EXPECT_EQ(log_size, log_file.GetOffset());
+  log_file.Close();
+}
+
+}  // End test namespace
+}  // End peloton namespace
@@ -0,0 +1,364 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// mapped_log_file_test.cpp
+//
+// Identification: test/logging/mapped_log_file_test.cpp
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "catalog/schema.h"
+#include "logging/log_compressor.h"
+#include "logging/logging_util.h"
+#include "logging/mapped_log_file.h"
+#include "logging/records/transaction_record.h"
+#include "logging/records/tuple_record.h"
+#include "storage/tuple.h"
+#include "type/serializeio.h"
+#include "type/value_factory.h"
+
+namespace peloton {
+namespace test {
+
+//===--------------------------------------------------------------------===//
+// Mapped Log File Tests
+//===--------------------------------------------------------------------===//
+
+class MappedLogFileTests : public ::testing::Test {
+ protected:
+  virtual void SetUp() {
+    char directory[] = "/tmp/mapped_log_file_test_XXXXXX";
+    ASSERT_TRUE(mkdtemp(directory) != nullptr);
+    directory_ = directory;
+  }
+
+  virtual void TearDown() {
+    logging::LoggingUtil::RemoveDirectory(directory_.c_str(), false);
+  }
+
+  std::string directory_;
+};
+
+namespace {
+
+const oid_t database_oid = 34567;
+
+const oid_t table_oid = 34568;
+
+const size_t transaction_count = 20;
+
+catalog::Schema *GetSchema() {
+  catalog::Column key_column(type::Type::INTEGER,
+                             type::Type::GetTypeSize(type::Type::INTEGER),
+                             "key", true);
+  catalog::Column value_column(type::Type::VARCHAR, 64, "value", false);
+  return new catalog::Schema({key_column, value_column});
+}
+
+std::string GetValue(const cid_t &commit_id) {
+  return "value of transaction " + std::to_string(commit_id);
+}
+
+void AppendRecord(std::vector<char> &log_data, const char *message,
+                  size_t message_length) {
+  log_data.insert(log_data.end(), message, message + message_length);
+}
+
+void AppendTransactionRecord(std::vector<char> &log_data,
+                             LogRecordType record_type, const cid_t &cid) {
+  logging::TransactionRecord record(record_type, cid);
+  CopySerializeOutput output;
+  record.Serialize(output);
+  AppendRecord(log_data, record.GetMessage(), record.GetMessageLength());
+}
+
+// Begin, insert and commit of a transaction, returns the offsets the records
+// start at
+std::vector<size_t> AppendTransaction(std::vector<char> &log_data,
+                                      catalog::Schema *schema,
+                                      const cid_t &commit_id) {
+  std::vector<size_t> record_offsets;
+  record_offsets.push_back(log_data.size());
+  AppendTransactionRecord(log_data, LOGRECORD_TYPE_TRANSACTION_BEGIN,
+                          commit_id);
+
+  storage::Tuple tuple(schema, true);
+  tuple.SetValue(0, type::ValueFactory::GetIntegerValue(commit_id));
+  tuple.SetValue(1, type::ValueFactory::GetVarcharValue(GetValue(commit_id)));
+  logging::TupleRecord record(LOGRECORD_TYPE_WAL_TUPLE_INSERT, commit_id,
+                              table_oid, ItemPointer(1, commit_id),
+                              INVALID_ITEMPOINTER, &tuple, database_oid);
+  CopySerializeOutput output;
+  record.Serialize(output);
+  record_offsets.push_back(log_data.size());
+  AppendRecord(log_data, record.GetMessage(), record.GetMessageLength());
+
+  record_offsets.push_back(log_data.size());
+  AppendTransactionRecord(log_data, LOGRECORD_TYPE_TRANSACTION_COMMIT,
+                          commit_id);
+  return record_offsets;
+}
+
+void WriteFile(const std::string &file_name, const char *data, size_t size) {
+  FILE *file = fopen(file_name.c_str(), "wb");
+  ASSERT_TRUE(file != nullptr);
+  EXPECT_EQ(size, fwrite(data, 1, size, file));
+  EXPECT_EQ(0, fclose(file));
+}
+
+// Reads the next record the way recovery does, false if it is torn or does
+// not match its checksum
+bool ReadRecord(logging::MappedLogFile &log_file, LogRecordType &record_type,
+                cid_t &commit_id, const char *&body_frame,
+                size_t &body_frame_size) {
+  size_t record_offset = log_file.GetOffset();
+  record_type = log_file.ReadRecordType();
+  body_frame = nullptr;
+  body_frame_size = 0;
+
+  const char *frame;
+  size_t frame_size;
+  switch (record_type) {
+    case LOGRECORD_TYPE_TRANSACTION_BEGIN:
+    case LOGRECORD_TYPE_TRANSACTION_COMMIT: {
+      if (log_file.ReadFrame(frame, frame_size) == false ||
+          log_file.ReadChecksum(record_offset) == false) {
+        return false;
+      }
+      logging::TransactionRecord record(record_type);
+      ReferenceSerializeInput input(frame, frame_size);
+      record.Deserialize(input);
+      commit_id = record.GetTransactionId();
+      return true;
+    }
+    case LOGRECORD_TYPE_WAL_TUPLE_INSERT: {
+      if (log_file.ReadFrame(frame, frame_size) == false ||
+          log_file.ReadFrame(body_frame, body_frame_size) == false ||
+          log_file.ReadChecksum(record_offset) == false) {
+        return false;
+      }
+      logging::TupleRecord record(record_type);
+      ReferenceSerializeInput input(frame, frame_size);
+      record.DeserializeHeader(input);
+      commit_id = record.GetTransactionId();
+      return true;
+    }
+    default:
+      return false;
+  }
+}
+
+// Reads the records of a transaction appended by AppendTransaction, and
+// checks that the tuple body is the one written
+void CheckTransaction(logging::MappedLogFile &log_file,
+                      catalog::Schema *schema, const cid_t &commit_id) {
+  LogRecordType record_type;
+  cid_t record_commit_id;
+  const char *body_frame;
+  size_t body_frame_size;
+
+  ASSERT_TRUE(ReadRecord(log_file, record_type, record_commit_id, body_frame,
+                         body_frame_size));
+  EXPECT_EQ(LOGRECORD_TYPE_TRANSACTION_BEGIN, record_type);
+  EXPECT_EQ(commit_id, record_commit_id);
+
+  ASSERT_TRUE(ReadRecord(log_file, record_type, record_commit_id, body_frame,
+                         body_frame_size));
+  EXPECT_EQ(LOGRECORD_TYPE_WAL_TUPLE_INSERT, record_type);
+  EXPECT_EQ(commit_id, record_commit_id);
+
+  // The body is handed out in place
+  ASSERT_TRUE(body_frame != nullptr);
+  EXPECT_LE(log_file.GetData(), body_frame);
+  EXPECT_GE(log_file.GetData() + log_file.GetSize(),
+            body_frame + body_frame_size);
+  ReferenceSerializeInput body(body_frame, body_frame_size);
+  body.ReadInt();
+  EXPECT_EQ(commit_id,
+            type::Value::DeserializeFrom(body, schema->GetType(0))
+                .GetAs<int32_t>());
+  EXPECT_EQ(GetValue(commit_id),
+            type::Value::DeserializeFrom(body, schema->GetType(1)).ToString());
+
+  ASSERT_TRUE(ReadRecord(log_file, record_type, record_commit_id, body_frame,
+                         body_frame_size));
+  EXPECT_EQ(LOGRECORD_TYPE_TRANSACTION_COMMIT, record_type);
+  EXPECT_EQ(commit_id, record_commit_id);
+}
+
+}  // namespace
+
+TEST_F(MappedLogFileTests, ReadTest) {
+  std::unique_ptr<catalog::Schema> schema(GetSchema());
+  std::vector<char> log_data;
+  for (cid_t commit_id = 1; commit_id <= transaction_count; commit_id++) {
+    AppendTransaction(log_data, schema.get(), commit_id);
+  }
+  size_t log_data_size = log_data.size();
+
+  // Preallocated log files are zero behind the log data
+  log_data.resize(log_data_size + 4096, 0);
+  std::string file_name = directory_ + "/peloton_log_0.log";
+  WriteFile(file_name, log_data.data(), log_data.size());
+
+  logging::MappedLogFile log_file;
+  ASSERT_TRUE(log_file.Open(file_name));
+  EXPECT_EQ(log_data.size(), log_file.GetSize());
+  for (cid_t commit_id = 1; commit_id <= transaction_count; commit_id++) {
+    CheckTransaction(log_file, schema.get(), commit_id);
+  }
+
+  // The zeros end the log data, without moving past them
+  EXPECT_EQ(log_data_size, log_file.GetOffset());
+  EXPECT_EQ(LOGRECORD_TYPE_INVALID, log_file.ReadRecordType());
+  EXPECT_EQ(LOGRECORD_TYPE_INVALID, log_file.ReadRecordType());
+  EXPECT_EQ(log_data_size, log_file.GetOffset());
+
+  // The log data can be read again
+  log_file.Seek(0);
+  CheckTransaction(log_file, schema.get(), 1);
+
+  log_file.Close();
+  EXPECT_TRUE(log_file.GetData() == nullptr);
+  EXPECT_EQ(0, log_file.GetSize());
+  EXPECT_EQ(0, log_file.GetOffset());
+}
+
+TEST_F(MappedLogFileTests, TornTailTest) {
+  std::unique_ptr<catalog::Schema> schema(GetSchema());
+  std::vector<char> log_data;
+  AppendTransaction(log_data, schema.get(), 1);
+  auto record_offsets = AppendTransaction(log_data, schema.get(), 2);
+
+  // The write of the log data stopped anywhere in the second transaction
+  std::string file_name = directory_ + "/peloton_log_0.log";
+  for (size_t cut_offset = record_offsets.front();
+       cut_offset < log_data.size(); cut_offset++) {
+    WriteFile(file_name, log_data.data(), cut_offset);
+
+    logging::MappedLogFile log_file;
+    ASSERT_TRUE(log_file.Open(file_name));
+    ASSERT_EQ(cut_offset, log_file.GetSize());
+    CheckTransaction(log_file, schema.get(), 1);
+
+    // Every whole record is read, the torn one is not
+    LogRecordType record_type;
+    cid_t commit_id;
+    const char *body_frame;
+    size_t body_frame_size;
+    for (size_t record_itr = 0; record_itr < record_offsets.size();
+         record_itr++) {
+      if (record_offsets[record_itr] >= cut_offset) {
+        EXPECT_EQ(LOGRECORD_TYPE_INVALID, log_file.ReadRecordType())
+            << "cut at " << cut_offset;
+        break;
+      }
+
+      bool whole_record = record_itr + 1 < record_offsets.size() &&
+                          record_offsets[record_itr + 1] <= cut_offset;
+      EXPECT_EQ(whole_record, ReadRecord(log_file, record_type, commit_id,
+                                         body_frame, body_frame_size))
+          << "cut at " << cut_offset;
+      if (whole_record == false) {
+        break;
+      }
+      EXPECT_EQ(2, commit_id);
+    }
+    EXPECT_GE(cut_offset, log_file.GetOffset());
+  }
+}
+
+TEST_F(MappedLogFileTests, ChecksumTest) {
+  std::unique_ptr<catalog::Schema> schema(GetSchema());
+  std::vector<char> log_data;
+  AppendTransaction(log_data, schema.get(), 1);
+  auto record_offsets = AppendTransaction(log_data, schema.get(), 2);
+
+  // A byte of the tuple body of the second insert went bad
+  log_data[record_offsets[2] - sizeof(uint32_t) - 1] ^= 0x10;
+  std::string file_name = directory_ + "/peloton_log_0.log";
+  WriteFile(file_name, log_data.data(), log_data.size());
+
+  logging::MappedLogFile log_file;
+  ASSERT_TRUE(log_file.Open(file_name));
+  CheckTransaction(log_file, schema.get(), 1);
+
+  LogRecordType record_type;
+  cid_t commit_id;
+  const char *body_frame;
+  size_t body_frame_size;
+  EXPECT_TRUE(ReadRecord(log_file, record_type, commit_id, body_frame,
+                         body_frame_size));
+  EXPECT_FALSE(ReadRecord(log_file, record_type, commit_id, body_frame,
+                          body_frame_size));
+  EXPECT_EQ(LOGRECORD_TYPE_WAL_TUPLE_INSERT, record_type);
+}
+
+TEST_F(MappedLogFileTests, EmptyFileTest) {
+  // Nothing is mapped for a log file that was never written to
+  std::string file_name = directory_ + "/peloton_log_0.log";
+  WriteFile(file_name, nullptr, 0);
+
+  logging::MappedLogFile log_file;
+  ASSERT_TRUE(log_file.Open(file_name));
+  EXPECT_TRUE(log_file.GetData() == nullptr);
+  EXPECT_EQ(0, log_file.GetSize());
+  EXPECT_EQ(LOGRECORD_TYPE_INVALID, log_file.ReadRecordType());
+
+  EXPECT_FALSE(log_file.Open(directory_ + "/peloton_log_1.log"));
+}
+
+TEST_F(MappedLogFileTests, CompressedBlockTest) {
+  std::unique_ptr<catalog::Schema> schema(GetSchema());
+  std::vector<char> block_data;
+  for (cid_t commit_id = 1; commit_id <= transaction_count; commit_id++) {
+    AppendTransaction(block_data, schema.get(), commit_id);
+  }
+
+  logging::LogCompressor log_compressor;
+  ASSERT_TRUE(log_compressor.CompressBlock(
+      block_data.data(), block_data.size(), logging::LogCompressor::max_level_));
+  std::vector<char> log_data(
+      log_compressor.GetBlock(),
+      log_compressor.GetBlock() + log_compressor.GetBlockSize());
+  AppendTransaction(log_data, schema.get(), transaction_count + 1);
+
+  std::string file_name = directory_ + "/peloton_log_0.log";
+  WriteFile(file_name, log_data.data(), log_data.size());
+
+  // The records of the block are read from its decompressed log data, the
+  // file goes on behind the block
+  logging::MappedLogFile log_file;
+  logging::MappedLogFile block;
+  ASSERT_TRUE(log_file.Open(file_name));
+  ASSERT_EQ(LOGRECORD_TYPE_WAL_COMPRESSED_BLOCK, log_file.ReadRecordType());
+  ASSERT_TRUE(log_file.ReadCompressedBlock(block));
+  EXPECT_EQ(block_data.size(), block.GetSize());
+  for (cid_t commit_id = 1; commit_id <= transaction_count; commit_id++) {
+    CheckTransaction(block, schema.get(), commit_id);
+  }
+  EXPECT_EQ(LOGRECORD_TYPE_INVALID, block.ReadRecordType());
+  CheckTransaction(log_file, schema.get(), transaction_count + 1);
+
+  // A torn block is not decompressed
+  WriteFile(file_name, log_data.data(), log_compressor.GetBlockSize() - 1);
+  ASSERT_TRUE(log_file.Open(file_name));
+  ASSERT_EQ(LOGRECORD_TYPE_WAL_COMPRESSED_BLOCK, log_file.ReadRecordType());
+  logging::MappedLogFile torn_block;
+  EXPECT_FALSE(log_file.ReadCompressedBlock(torn_block));
+  EXPECT_EQ(0, torn_block.GetSize());
+}
+
+}  // End test namespace
+}  // End peloton namespace
@@ -0,0 +1,304 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// compaction_test.cpp
+//
+// Identification: test/storage/compaction_test.cpp
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <memory>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "catalog/manager.h"
+#include "catalog/schema.h"
+#include "storage/data_table.h"
+#include "storage/table_factory.h"
+#include "storage/tile_group_compactor.h"
+#include "storage/tile_group.h"
+#include "storage/tile_group_header.h"
+#include "storage/tuple.h"
+#include "type/value_factory.h"
+
+namespace peloton {
+namespace test {
+
+//===--------------------------------------------------------------------===//
+// Compaction Tests
+//===--------------------------------------------------------------------===//
+
+class CompactionTests : public ::testing::Test {};
+
+namespace {
+
+const size_t tuples_per_tile_group = 100;
+
+const size_t tuple_count = 1000;
+
+// Versions committed at this commit id, the dead ones end right after
+const cid_t load_commit_id = 5;
+
+catalog::Column GetColumn(const std::string &name) {
+  return catalog::Column(type::Type::INTEGER,
+                         type::Type::GetTypeSize(type::Type::INTEGER), name,
+                         true);
+}
+
+std::shared_ptr<storage::TileGroupHeader> GetHeader(
+    const ItemPointer &location) {
+  auto tile_group =
+      catalog::Manager::GetInstance().GetTileGroup(location.block);
+  EXPECT_TRUE(tile_group != nullptr);
+  return std::shared_ptr<storage::TileGroupHeader>(tile_group,
+                                                   tile_group->GetHeader());
+}
+
+int32_t GetKey(const ItemPointer &location) {
+  auto tile_group =
+      catalog::Manager::GetInstance().GetTileGroup(location.block);
+  return tile_group->GetValue(location.offset, 0).GetAs<int32_t>();
+}
+
+// Sum of the keys of the versions visible at the snapshot
+int64_t SumVisibleKeys(storage::DataTable *table, const cid_t &snapshot_cid,
+                       size_t &visible_count) {
+  int64_t key_sum = 0;
+  visible_count = 0;
+  for (auto tile_group_id : table->GetTileGroupIds()) {
+    auto tile_group = table->GetTileGroupById(tile_group_id);
+    auto tile_group_header = tile_group->GetHeader();
+    oid_t tuple_slot_count = tile_group_header->GetCurrentNextTupleSlot();
+    for (oid_t tuple_slot_id = 0; tuple_slot_id < tuple_slot_count;
+         tuple_slot_id++) {
+      if (tile_group_header->GetTransactionId(tuple_slot_id) ==
+              INITIAL_TXN_ID &&
+          tile_group_header->GetBeginCommitId(tuple_slot_id) <=
+              snapshot_cid &&
+          tile_group_header->GetEndCommitId(tuple_slot_id) > snapshot_cid) {
+        key_sum += GetKey(ItemPointer(tile_group_id, tuple_slot_id));
+        visible_count++;
+      }
+    }
+  }
+  return key_sum;
+}
+
+}  // namespace
+
+TEST_F(CompactionTests, MoveLiveTuplesTest) {
+  auto schema = new catalog::Schema({GetColumn("a"), GetColumn("b")});
+  std::unique_ptr<storage::DataTable> table(storage::TableFactory::GetDataTable(
+      INVALID_OID, INVALID_OID, schema, "compaction_table",
+      tuples_per_tile_group, true, false));
+
+  // Every tenth tuple stays live and is reached through an indirection
+  storage::Tuple tuple(schema, true);
+  std::vector<std::unique_ptr<ItemPointer>> indirections;
+  std::vector<ItemPointer> live_locations;
+  int64_t live_key_sum = 0;
+  for (size_t tuple_itr = 0; tuple_itr < tuple_count; tuple_itr++) {
+    tuple.SetValue(0, type::ValueFactory::GetIntegerValue(tuple_itr));
+    tuple.SetValue(1, type::ValueFactory::GetIntegerValue(1));
+    ItemPointer location = table->InsertTuple(&tuple);
+    ASSERT_FALSE(location.IsNull());
+
+    auto tile_group_header = GetHeader(location);
+    tile_group_header->SetBeginCommitId(location.offset, load_commit_id);
+    if (tuple_itr % 10 == 0) {
+      indirections.emplace_back(new ItemPointer(location));
+      tile_group_header->SetIndirection(location.offset,
+                                        indirections.back().get());
+      live_locations.push_back(location);
+      live_key_sum += tuple_itr;
+    } else {
+      tile_group_header->SetEndCommitId(location.offset, load_commit_id + 1);
+    }
+    tile_group_header->SetTransactionId(location.offset, INITIAL_TXN_ID);
+  }
+
+  size_t visible_count;
+  EXPECT_EQ(live_key_sum,
+            SumVisibleKeys(table.get(), load_commit_id + 1, visible_count));
+  EXPECT_EQ(live_locations.size(), visible_count);
+  size_t loaded_tile_group_count = table->GetTileGroupCount();
+
+  // The first round seals the mostly dead tile groups, the second one moves
+  // their live tuples out
+  cid_t compaction_cid = load_commit_id + 10;
+  EXPECT_EQ(0, table->CompactTileGroups(0.5, compaction_cid));
+  size_t compacted_count = table->CompactTileGroups(0.5, compaction_cid);
+  EXPECT_LT(0, compacted_count);
+
+  // The moved versions are linked in front of the old ones like updates
+  size_t moved_count = 0;
+  for (size_t live_itr = 0; live_itr < live_locations.size(); live_itr++) {
+    ItemPointer old_location = live_locations[live_itr];
+    ItemPointer new_location = *indirections[live_itr];
+    if (new_location.block == old_location.block &&
+        new_location.offset == old_location.offset) {
+      continue;
+    }
+    moved_count++;
+
+    auto new_header = GetHeader(new_location);
+    auto old_header = GetHeader(old_location);
+    EXPECT_EQ(GetKey(old_location), GetKey(new_location));
+    EXPECT_EQ(compaction_cid,
+              new_header->GetBeginCommitId(new_location.offset));
+    EXPECT_EQ(MAX_CID, new_header->GetEndCommitId(new_location.offset));
+    EXPECT_EQ(compaction_cid, old_header->GetEndCommitId(old_location.offset));
+    EXPECT_EQ(INITIAL_TXN_ID,
+              old_header->GetTransactionId(old_location.offset));
+
+    ItemPointer next = new_header->GetNextItemPointer(new_location.offset);
+    EXPECT_EQ(old_location.block, next.block);
+    EXPECT_EQ(old_location.offset, next.offset);
+    EXPECT_TRUE(new_header->GetPrevItemPointer(new_location.offset).IsNull());
+
+    ItemPointer prev = old_header->GetPrevItemPointer(old_location.offset);
+    EXPECT_EQ(new_location.block, prev.block);
+    EXPECT_EQ(new_location.offset, prev.offset);
+  }
+  EXPECT_LT(0, moved_count);
+
+  // Old snapshots read the old versions, new ones the moved versions
+  EXPECT_EQ(live_key_sum,
+            SumVisibleKeys(table.get(), load_commit_id + 1, visible_count));
+  EXPECT_EQ(live_locations.size(), visible_count);
+  EXPECT_EQ(live_key_sum,
+            SumVisibleKeys(table.get(), compaction_cid, visible_count));
+  EXPECT_EQ(live_locations.size(), visible_count);
+
+  // Without pinned epochs the moved-out tile groups are unlinked, then
+  // dropped
+  table->CompactTileGroups(0.5, compaction_cid + 1);
+  table->CompactTileGroups(0.5, compaction_cid + 2);
+  EXPECT_GT(loaded_tile_group_count, table->GetTileGroupCount());
+
+  for (size_t live_itr = 0; live_itr < live_locations.size(); live_itr++) {
+    ItemPointer location = *indirections[live_itr];
+    auto tile_group_header = GetHeader(location);
+    EXPECT_EQ(static_cast<int32_t>(live_itr * 10), GetKey(location));
+    EXPECT_TRUE(
+        tile_group_header->GetNextItemPointer(location.offset).IsNull());
+  }
+
+  EXPECT_EQ(live_key_sum,
+            SumVisibleKeys(table.get(), compaction_cid + 2, visible_count));
+  EXPECT_EQ(live_locations.size(), visible_count);
+}
+
+TEST_F(CompactionTests, ClaimedSlotTest) {
+  auto schema = new catalog::Schema({GetColumn("a"), GetColumn("b")});
+  std::unique_ptr<storage::DataTable> table(storage::TableFactory::GetDataTable(
+      INVALID_OID, INVALID_OID, schema, "claimed_table",
+      tuples_per_tile_group, true, false));
+
+  // A full tile group of dead versions, except for one slot that was handed
+  // out but not taken over by its transaction yet
+  storage::Tuple tuple(schema, true);
+  tuple.SetValue(0, type::ValueFactory::GetIntegerValue(0));
+  tuple.SetValue(1, type::ValueFactory::GetIntegerValue(0));
+  ItemPointer claimed_location = INVALID_ITEMPOINTER;
+  for (size_t tuple_itr = 0; tuple_itr < 3 * tuples_per_tile_group;
+       tuple_itr++) {
+    ItemPointer location = table->InsertTuple(&tuple);
+    ASSERT_FALSE(location.IsNull());
+
+    auto tile_group_header = GetHeader(location);
+    EXPECT_EQ(CLAIMED_TXN_ID,
+              tile_group_header->GetTransactionId(location.offset));
+    if (claimed_location.IsNull() == true) {
+      claimed_location = location;
+      continue;
+    }
+    tile_group_header->SetBeginCommitId(location.offset, load_commit_id);
+    tile_group_header->SetEndCommitId(location.offset, load_commit_id + 1);
+    tile_group_header->SetTransactionId(location.offset, INITIAL_TXN_ID);
+  }
+
+  // The claimed slot keeps its tile group from being moved out, the other
+  // full ones go
+  size_t loaded_tile_group_count = table->GetTileGroupCount();
+  for (cid_t round_itr = 0; round_itr < 4; round_itr++) {
+    table->CompactTileGroups(0.5, load_commit_id + 10 + round_itr);
+  }
+  EXPECT_GT(loaded_tile_group_count, table->GetTileGroupCount());
+  auto tile_group =
+      catalog::Manager::GetInstance().GetTileGroup(claimed_location.block);
+  ASSERT_TRUE(tile_group != nullptr);
+  EXPECT_EQ(CLAIMED_TXN_ID,
+            tile_group->GetHeader()->GetTransactionId(claimed_location.offset));
+}
+
+TEST_F(CompactionTests, EndedVersionChainTest) {
+  auto schema = new catalog::Schema({GetColumn("a"), GetColumn("b")});
+  std::unique_ptr<storage::DataTable> table(storage::TableFactory::GetDataTable(
+      INVALID_OID, INVALID_OID, schema, "chain_table", tuples_per_tile_group,
+      true, false));
+
+  // A full tile group of dead versions, the first one was updated and its
+  // newer version lives in the next tile group
+  storage::Tuple tuple(schema, true);
+  tuple.SetValue(0, type::ValueFactory::GetIntegerValue(0));
+  tuple.SetValue(1, type::ValueFactory::GetIntegerValue(0));
+  std::vector<ItemPointer> dead_locations;
+  for (size_t tuple_itr = 0; tuple_itr < tuples_per_tile_group; tuple_itr++) {
+    ItemPointer location = table->InsertTuple(&tuple);
+    ASSERT_FALSE(location.IsNull());
+
+    auto tile_group_header = GetHeader(location);
+    tile_group_header->SetBeginCommitId(location.offset, load_commit_id);
+    tile_group_header->SetEndCommitId(location.offset, load_commit_id + 1);
+    tile_group_header->SetTransactionId(location.offset, INITIAL_TXN_ID);
+    dead_locations.push_back(location);
+  }
+
+  ItemPointer old_location = dead_locations.front();
+  ItemPointer new_location = table->InsertTuple(&tuple);
+  ASSERT_FALSE(new_location.IsNull());
+  ASSERT_NE(old_location.block, new_location.block);
+
+  auto new_header = GetHeader(new_location);
+  new_header->SetBeginCommitId(new_location.offset, load_commit_id + 1);
+  new_header->SetEndCommitId(new_location.offset, MAX_CID);
+  new_header->SetNextItemPointer(new_location.offset, old_location);
+  new_header->SetTransactionId(new_location.offset, INITIAL_TXN_ID);
+  GetHeader(old_location)
+      ->SetPrevItemPointer(old_location.offset, new_location);
+
+  // Nothing is moved out of the tile group, it is sealed, unlinked and
+  // dropped all the same
+  for (cid_t round_itr = 0; round_itr < 4; round_itr++) {
+    table->CompactTileGroups(0.5, load_commit_id + 10 + round_itr);
+  }
+  EXPECT_TRUE(catalog::Manager::GetInstance().GetTileGroup(
+                  old_location.block) == nullptr);
+
+  // The newer version no longer leads into the dropped tile group
+  EXPECT_TRUE(new_header->GetNextItemPointer(new_location.offset).IsNull());
+  EXPECT_EQ(MAX_CID, new_header->GetEndCommitId(new_location.offset));
+}
+
+TEST_F(CompactionTests, DropTableTest) {
+  auto &tile_group_compactor = storage::TileGroupCompactor::GetInstance();
+
+  // A dropped table leaves the compactor
+  auto schema = new catalog::Schema({GetColumn("a"), GetColumn("b")});
+  std::unique_ptr<storage::DataTable> table(storage::TableFactory::GetDataTable(
+      INVALID_OID, INVALID_OID, schema, "dropped_table", tuples_per_tile_group,
+      true, false));
+  tile_group_compactor.AddTable(table.get());
+  table.reset();
+
+  EXPECT_EQ(0, tile_group_compactor.Compact(load_commit_id + 10));
+  tile_group_compactor.ClearTables();
+}
+
+}  // End test namespace
+}  // End peloton namespace
@@ -0,0 +1,148 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// extent_allocator_test.cpp
+//
+// Identification: test/storage/extent_allocator_test.cpp
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "storage/extent_allocator.h"
+
+namespace peloton {
+namespace test {
+
+//===--------------------------------------------------------------------===//
+// Extent Allocator Tests
+//===--------------------------------------------------------------------===//
+
+class ExtentAllocatorTests : public ::testing::Test {};
+
+namespace {
+
+const size_t page_size = storage::ExtentAllocator::default_alignment_;
+
+const size_t page_count = 64;
+
+}  // namespace
+
+TEST_F(ExtentAllocatorTests, SplitMergeTest) {
+  storage::ExtentAllocator extent_allocator(page_count * page_size);
+  EXPECT_EQ(1, extent_allocator.GetFreeExtentCount());
+
+  // Allocations are carved from the front, rounded up to pages
+  size_t first_offset = extent_allocator.Allocate(page_size + 1);
+  size_t second_offset = extent_allocator.Allocate(page_size);
+  size_t third_offset = extent_allocator.Allocate(4 * page_size);
+  EXPECT_EQ(0, first_offset);
+  EXPECT_EQ(2 * page_size, second_offset);
+  EXPECT_EQ(3 * page_size, third_offset);
+  EXPECT_EQ(2 * page_size, extent_allocator.GetExtentSize(first_offset));
+  EXPECT_EQ(7 * page_size, extent_allocator.GetAllocatedBytes());
+  EXPECT_EQ(1, extent_allocator.GetFreeExtentCount());
+
+  // Free extents that do not touch stay apart
+  EXPECT_EQ(2 * page_size, extent_allocator.Release(first_offset));
+  EXPECT_EQ(2, extent_allocator.GetFreeExtentCount());
+  EXPECT_EQ(4 * page_size, extent_allocator.Release(third_offset));
+  EXPECT_EQ(2, extent_allocator.GetFreeExtentCount());
+
+  // The extent between them joins both neighbours
+  EXPECT_EQ(page_size, extent_allocator.Release(second_offset));
+  EXPECT_EQ(1, extent_allocator.GetFreeExtentCount());
+  EXPECT_EQ(page_count * page_size, extent_allocator.GetLargestFreeExtent());
+  EXPECT_EQ(0, extent_allocator.GetAllocatedBytes());
+
+  // Only allocated extents can be released
+  EXPECT_EQ(0, extent_allocator.Release(second_offset));
+  EXPECT_EQ(0, extent_allocator.GetExtentSize(second_offset));
+}
+
+TEST_F(ExtentAllocatorTests, ExhaustionTest) {
+  storage::ExtentAllocator extent_allocator(page_count * page_size);
+
+  std::vector<size_t> offsets;
+  for (size_t page_itr = 0; page_itr < page_count; page_itr++) {
+    size_t offset = extent_allocator.Allocate(page_size);
+    ASSERT_NE(storage::ExtentAllocator::INVALID_EXTENT_OFFSET, offset);
+    offsets.push_back(offset);
+  }
+  EXPECT_EQ(0, extent_allocator.GetFreeBytes());
+  EXPECT_EQ(0, extent_allocator.GetLargestFreeExtent());
+  EXPECT_EQ(storage::ExtentAllocator::INVALID_EXTENT_OFFSET,
+            extent_allocator.Allocate(page_size));
+  EXPECT_EQ(storage::ExtentAllocator::INVALID_EXTENT_OFFSET,
+            extent_allocator.Allocate(0));
+
+  // Every other page freed, enough bytes but no extent of two pages
+  for (size_t page_itr = 0; page_itr < page_count; page_itr += 2) {
+    extent_allocator.Release(offsets[page_itr]);
+  }
+  EXPECT_EQ(page_count / 2 * page_size, extent_allocator.GetFreeBytes());
+  EXPECT_EQ(page_size, extent_allocator.GetLargestFreeExtent());
+  EXPECT_EQ(storage::ExtentAllocator::INVALID_EXTENT_OFFSET,
+            extent_allocator.Allocate(2 * page_size));
+
+  // Growing the range makes room at its end
+  extent_allocator.Grow((page_count + 2) * page_size);
+  EXPECT_EQ(page_count * page_size, extent_allocator.Allocate(2 * page_size));
+}
+
+TEST_F(ExtentAllocatorTests, ReuseTest) {
+  storage::ExtentAllocator extent_allocator(page_count * page_size);
+
+  size_t small_offset = extent_allocator.Allocate(2 * page_size);
+  extent_allocator.Allocate(page_size);
+  size_t large_offset = extent_allocator.Allocate(8 * page_size);
+  size_t last_offset = extent_allocator.Allocate(page_size);
+  extent_allocator.Release(small_offset);
+  extent_allocator.Release(large_offset);
+  EXPECT_EQ(3, extent_allocator.GetFreeExtentCount());
+
+  // The smallest extent that fits is reused, not the tail of the range
+  EXPECT_EQ(small_offset, extent_allocator.Allocate(2 * page_size));
+  EXPECT_EQ(large_offset, extent_allocator.Allocate(5 * page_size));
+
+  // The rest of the split extent is handed out next
+  EXPECT_EQ(large_offset + 5 * page_size,
+            extent_allocator.Allocate(3 * page_size));
+  EXPECT_EQ(1, extent_allocator.GetFreeExtentCount());
+
+  // Released space is reused over and over without fragmenting the range
+  for (size_t round_itr = 0; round_itr < 100; round_itr++) {
+    size_t offset = extent_allocator.Allocate(page_size);
+    EXPECT_EQ(last_offset + page_size, offset);
+    extent_allocator.Release(offset);
+  }
+  EXPECT_EQ(1, extent_allocator.GetFreeExtentCount());
+}
+
+TEST_F(ExtentAllocatorTests, ReserveTest) {
+  storage::ExtentAllocator extent_allocator(page_count * page_size);
+
+  // Extents of a persistent range are taken back where they were
+  EXPECT_TRUE(extent_allocator.Reserve(4 * page_size, 2 * page_size));
+  EXPECT_EQ(2, extent_allocator.GetFreeExtentCount());
+  EXPECT_EQ(2 * page_size, extent_allocator.GetExtentSize(4 * page_size));
+
+  EXPECT_FALSE(extent_allocator.Reserve(5 * page_size, page_size));
+  EXPECT_FALSE(extent_allocator.Reserve(page_size + 1, page_size));
+  EXPECT_FALSE(extent_allocator.Reserve(page_count * page_size, page_size));
+
+  // Allocations go around the reserved extent
+  EXPECT_EQ(0, extent_allocator.Allocate(4 * page_size));
+  EXPECT_EQ(6 * page_size, extent_allocator.Allocate(page_size));
+
+  extent_allocator.Release(4 * page_size);
+  EXPECT_EQ(4 * page_size, extent_allocator.Allocate(2 * page_size));
+}
+
+}  // End test namespace
+}  // End peloton namespace
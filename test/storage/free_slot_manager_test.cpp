@@ -0,0 +1,106 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// free_slot_manager_test.cpp
+//
+// Identification: test/storage/free_slot_manager_test.cpp
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <set>
+#include <thread>
+#include <utility>
+
+#include "gtest/gtest.h"
+
+#include "concurrency/epoch_manager.h"
+#include "storage/free_slot_manager.h"
+
+namespace peloton {
+namespace test {
+
+//===--------------------------------------------------------------------===//
+// Free Slot Manager Tests
+//===--------------------------------------------------------------------===//
+
+class FreeSlotManagerTests : public ::testing::Test {};
+
+TEST_F(FreeSlotManagerTests, ReleaseSlotTest) {
+  storage::FreeSlotManager free_slot_manager;
+  EXPECT_TRUE(free_slot_manager.GetFreeSlot().IsNull());
+
+  free_slot_manager.ReleaseSlot(ItemPointer(1, 2));
+  EXPECT_EQ(1, free_slot_manager.GetRetiredSlotCount());
+
+  ItemPointer location = free_slot_manager.GetFreeSlot();
+  EXPECT_EQ(1, location.block);
+  EXPECT_EQ(2, location.offset);
+  EXPECT_EQ(0, free_slot_manager.GetRetiredSlotCount());
+  EXPECT_TRUE(free_slot_manager.GetFreeSlot().IsNull());
+}
+
+TEST_F(FreeSlotManagerTests, PinnedEpochTest) {
+  auto &epoch_manager = concurrency::EpochManager::GetInstance();
+  storage::FreeSlotManager free_slot_manager;
+
+  // A reader pinned before the slot was retired may still look at it
+  epoch_manager.EnterEpoch();
+  free_slot_manager.RetireSlot(ItemPointer(3, 4));
+  epoch_manager.AdvanceEpoch();
+  EXPECT_TRUE(free_slot_manager.GetFreeSlot().IsNull());
+  EXPECT_EQ(1, free_slot_manager.GetRetiredSlotCount());
+
+  epoch_manager.ExitEpoch();
+
+  // The epoch it was retired in has to end as well
+  epoch_manager.AdvanceEpoch();
+  ItemPointer location = free_slot_manager.GetFreeSlot();
+  EXPECT_EQ(3, location.block);
+  EXPECT_EQ(4, location.offset);
+  EXPECT_EQ(0, free_slot_manager.GetRetiredSlotCount());
+}
+
+TEST_F(FreeSlotManagerTests, OtherShardTest) {
+  auto &epoch_manager = concurrency::EpochManager::GetInstance();
+  storage::FreeSlotManager free_slot_manager;
+
+  // Slots retired by other threads are found once the home shard is empty
+  const oid_t slot_count = 100;
+  std::thread retiring_thread([&]() {
+    for (oid_t slot_itr = 0; slot_itr < slot_count; slot_itr++) {
+      free_slot_manager.RetireSlot(ItemPointer(5, slot_itr));
+    }
+  });
+  retiring_thread.join();
+  epoch_manager.AdvanceEpoch();
+
+  std::set<oid_t> offsets;
+  while (true) {
+    ItemPointer location = free_slot_manager.GetFreeSlot();
+    if (location.IsNull() == true) {
+      break;
+    }
+    EXPECT_EQ(5, location.block);
+    offsets.insert(location.offset);
+  }
+  EXPECT_EQ(slot_count, offsets.size());
+  EXPECT_EQ(0, free_slot_manager.GetRetiredSlotCount());
+}
+
+TEST_F(FreeSlotManagerTests, ClearTest) {
+  storage::FreeSlotManager free_slot_manager;
+
+  free_slot_manager.RetireSlot(ItemPointer(6, 0));
+  free_slot_manager.ReleaseSlot(ItemPointer(6, 1));
+  EXPECT_EQ(2, free_slot_manager.GetRetiredSlotCount());
+
+  free_slot_manager.Clear();
+  EXPECT_EQ(0, free_slot_manager.GetRetiredSlotCount());
+  EXPECT_TRUE(free_slot_manager.GetFreeSlot().IsNull());
+}
+
+}  // End test namespace
+}  // End peloton namespace
@@ -0,0 +1,220 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// persistent_heap_test.cpp
+//
+// Identification: test/storage/persistent_heap_test.cpp
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "gtest/gtest.h"
+
+#include "catalog/manager.h"
+#include "catalog/schema.h"
+#include "concurrency/timestamp_ordering_transaction_manager.h"
+#include "concurrency/transaction.h"
+#include "storage/data_table.h"
+#include "storage/database.h"
+#include "storage/storage_manager.h"
+#include "storage/table_factory.h"
+#include "storage/tile_group.h"
+#include "storage/tile_group_header.h"
+#include "storage/tuple.h"
+#include "type/value_factory.h"
+
+namespace peloton {
+namespace test {
+
+//===--------------------------------------------------------------------===//
+// Persistent Heap Tests
+//===--------------------------------------------------------------------===//
+
+class PersistentHeapTests : public ::testing::Test {};
+
+namespace {
+
+const size_t heap_size = 64 * 1024 * 1024;
+
+const oid_t database_oid = 12345;
+
+const oid_t table_oid = 12346;
+
+const size_t tuples_per_tile_group = 100;
+
+const int32_t tuple_count = 10;
+
+// Key of the tuple updated before the restart, and of the deleted one
+const int32_t updated_key = 3;
+
+const int32_t deleted_key = 7;
+
+catalog::Schema *GetSchema() {
+  catalog::Column key_column(type::Type::INTEGER,
+                             type::Type::GetTypeSize(type::Type::INTEGER),
+                             "key", true);
+  catalog::Column value_column(type::Type::INTEGER,
+                               type::Type::GetTypeSize(type::Type::INTEGER),
+                               "value", true);
+  return new catalog::Schema({key_column, value_column});
+}
+
+storage::DataTable *GetTable() {
+  return storage::TableFactory::GetDataTable(database_oid, table_oid,
+                                             GetSchema(), "persistent_table",
+                                             tuples_per_tile_group, true,
+                                             false);
+}
+
+// Load the table, update and delete a tuple, and leave a transaction
+// running. Runs in a child process that goes away without any cleanup,
+// like a crashed server.
+void LoadAndCrash(const std::string &file_name) {
+  auto &storage_manager = storage::StorageManager::GetInstance();
+  auto &txn_manager =
+      concurrency::TimestampOrderingTransactionManager::GetInstance();
+  auto &manager = catalog::Manager::GetInstance();
+
+  storage_manager.OpenPersistentHeap(file_name, heap_size);
+  storage::DataTable *table = GetTable();
+  storage::Tuple tuple(table->GetSchema(), true);
+
+  std::map<int32_t, ItemPointer> locations;
+  auto txn = txn_manager.BeginTransaction();
+  for (int32_t key = 0; key < tuple_count; key++) {
+    tuple.SetValue(0, type::ValueFactory::GetIntegerValue(key));
+    tuple.SetValue(1, type::ValueFactory::GetIntegerValue(key));
+    ItemPointer location = table->InsertTuple(&tuple);
+    txn_manager.PerformInsert(txn, location, nullptr);
+    locations[key] = location;
+  }
+  txn_manager.CommitTransaction(txn);
+
+  txn = txn_manager.BeginTransaction();
+  txn_manager.PerformRead(txn, locations[updated_key], true);
+  ItemPointer new_location = table->AcquireVersion();
+  tuple.SetValue(0, type::ValueFactory::GetIntegerValue(updated_key));
+  tuple.SetValue(1, type::ValueFactory::GetIntegerValue(-updated_key));
+  manager.GetTileGroup(new_location.block)
+      ->CopyTuple(&tuple, new_location.offset);
+  txn_manager.PerformUpdate(txn, locations[updated_key], new_location);
+  txn_manager.CommitTransaction(txn);
+
+  txn = txn_manager.BeginTransaction();
+  txn_manager.PerformRead(txn, locations[deleted_key], true);
+  ItemPointer empty_location = table->AcquireVersion();
+  txn_manager.PerformDelete(txn, locations[deleted_key], empty_location);
+  txn_manager.CommitTransaction(txn);
+
+  // Never committed
+  txn = txn_manager.BeginTransaction();
+  tuple.SetValue(0, type::ValueFactory::GetIntegerValue(tuple_count));
+  tuple.SetValue(1, type::ValueFactory::GetIntegerValue(tuple_count));
+  txn_manager.PerformInsert(txn, table->InsertTuple(&tuple), nullptr);
+
+  _exit(EXIT_SUCCESS);
+}
+
+}  // namespace
+
+TEST_F(PersistentHeapTests, RestartTest) {
+  std::string file_name =
+      "/tmp/persistent_heap_test_" + std::to_string(getpid()) + ".heap";
+  unlink(file_name.c_str());
+
+  pid_t child_pid = fork();
+  ASSERT_LE(0, child_pid);
+  if (child_pid == 0) {
+    LoadAndCrash(file_name);
+  }
+
+  int status;
+  ASSERT_EQ(child_pid, waitpid(child_pid, &status, 0));
+  ASSERT_TRUE(WIFEXITED(status));
+  ASSERT_EQ(EXIT_SUCCESS, WEXITSTATUS(status));
+
+  // Start over from the heap the child left behind
+  auto &storage_manager = storage::StorageManager::GetInstance();
+  auto &manager = catalog::Manager::GetInstance();
+  EXPECT_LT(0, storage_manager.OpenPersistentHeap(file_name, heap_size));
+
+  storage::Database database(database_oid);
+  storage::DataTable *table = GetTable();
+  auto new_tile_group_ids = table->GetTileGroupIds();
+  database.AddTable(table);
+
+  // The committed state is back, every live version is reached through an
+  // indirection, like the indexes would reach it
+  std::map<int32_t, int32_t> values;
+  oid_t max_tile_group_id = 0;
+  for (auto tile_group_id : table->GetTileGroupIds()) {
+    auto tile_group = table->GetTileGroupById(tile_group_id);
+    auto tile_group_header = tile_group->GetHeader();
+    if (std::find(new_tile_group_ids.begin(), new_tile_group_ids.end(),
+                  tile_group_id) == new_tile_group_ids.end()) {
+      max_tile_group_id = std::max(max_tile_group_id, tile_group_id);
+    }
+
+    oid_t tuple_slot_count = tile_group_header->GetCurrentNextTupleSlot();
+    for (oid_t tuple_slot_id = 0; tuple_slot_id < tuple_slot_count;
+         tuple_slot_id++) {
+      if (tile_group_header->GetTransactionId(tuple_slot_id) !=
+              INITIAL_TXN_ID ||
+          tile_group_header->GetEndCommitId(tuple_slot_id) != MAX_CID) {
+        continue;
+      }
+
+      int32_t key = tile_group->GetValue(tuple_slot_id, 0).GetAs<int32_t>();
+      values[key] = tile_group->GetValue(tuple_slot_id, 1).GetAs<int32_t>();
+
+      ItemPointer *indirection =
+          tile_group_header->GetIndirection(tuple_slot_id);
+      ASSERT_TRUE(indirection != nullptr);
+      EXPECT_EQ(tile_group_id, indirection->block);
+      EXPECT_EQ(tuple_slot_id, indirection->offset);
+
+      // Older versions share the indirection
+      ItemPointer next_location =
+          tile_group_header->GetNextItemPointer(tuple_slot_id);
+      if (next_location.IsNull() == false) {
+        EXPECT_EQ(updated_key, key);
+        EXPECT_EQ(indirection, manager.GetTileGroup(next_location.block)
+                                   ->GetHeader()
+                                   ->GetIndirection(next_location.offset));
+      }
+    }
+  }
+
+  EXPECT_EQ(tuple_count - 1, values.size());
+  for (int32_t key = 0; key < tuple_count; key++) {
+    if (key == deleted_key) {
+      EXPECT_EQ(0, values.count(key));
+    } else if (key == updated_key) {
+      EXPECT_EQ(-updated_key, values[key]);
+    } else {
+      EXPECT_EQ(key, values[key]);
+    }
+  }
+
+  // Tile groups created after the heap was opened do not reuse the
+  // recovered ids
+  EXPECT_LT(0, max_tile_group_id);
+  for (auto tile_group_id : new_tile_group_ids) {
+    EXPECT_LT(max_tile_group_id, tile_group_id);
+  }
+
+  unlink(file_name.c_str());
+}
+
+}  // End test namespace
+}  // End peloton namespace
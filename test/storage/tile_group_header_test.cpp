@@ -0,0 +1,128 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// tile_group_header_test.cpp
+//
+// Identification: test/storage/tile_group_header_test.cpp
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstring>
+#include <memory>
+
+#include "gtest/gtest.h"
+
+#include "common/item_pointer.h"
+#include "storage/tile_group_header.h"
+
+namespace peloton {
+namespace test {
+
+//===--------------------------------------------------------------------===//
+// Tile Group Header Tests
+//===--------------------------------------------------------------------===//
+
+class TileGroupHeaderTests : public ::testing::Test {};
+
+namespace {
+
+const int tuple_count = 100;
+
+// The values a slot starts out with
+void ExpectInitialized(storage::TileGroupHeader *tile_group_header,
+                       const oid_t &tuple_slot_id) {
+  EXPECT_EQ(INVALID_TXN_ID, tile_group_header->GetTransactionId(tuple_slot_id));
+  EXPECT_EQ(MAX_CID, tile_group_header->GetBeginCommitId(tuple_slot_id));
+  EXPECT_EQ(MAX_CID, tile_group_header->GetEndCommitId(tuple_slot_id));
+  EXPECT_TRUE(tile_group_header->GetNextItemPointer(tuple_slot_id).IsNull());
+  EXPECT_TRUE(tile_group_header->GetPrevItemPointer(tuple_slot_id).IsNull());
+  EXPECT_TRUE(tile_group_header->GetIndirection(tuple_slot_id) == nullptr);
+}
+
+const char *GetEntry(storage::TileGroupHeader *tile_group_header,
+                     const oid_t &tuple_slot_id) {
+  return tile_group_header->GetData() +
+         tuple_slot_id * storage::TileGroupHeader::header_entry_size;
+}
+
+}  // namespace
+
+TEST_F(TileGroupHeaderTests, LazyInitTest) {
+  // Slots initialized as inserts claim them, and all at once like recovery
+  // claims them
+  std::unique_ptr<storage::TileGroupHeader> lazy_header(
+      new storage::TileGroupHeader(BackendType::MM, tuple_count));
+  std::unique_ptr<storage::TileGroupHeader> eager_header(
+      new storage::TileGroupHeader(BackendType::MM, tuple_count));
+
+  oid_t claimed_count = 0;
+  while (lazy_header->GetNextEmptyTupleSlot() != INVALID_OID) {
+    claimed_count++;
+  }
+  ASSERT_LT(0, claimed_count);
+  ASSERT_TRUE(eager_header->GetEmptyTupleSlot(claimed_count - 1));
+
+  for (oid_t tuple_slot_id = 0; tuple_slot_id < claimed_count;
+       tuple_slot_id++) {
+    ExpectInitialized(lazy_header.get(), tuple_slot_id);
+    EXPECT_EQ(0, memcmp(GetEntry(lazy_header.get(), tuple_slot_id),
+                        GetEntry(eager_header.get(), tuple_slot_id),
+                        storage::TileGroupHeader::header_entry_size));
+  }
+
+  // Slots never handed out are zero, which reads as empty
+  for (oid_t tuple_slot_id = claimed_count; tuple_slot_id < tuple_count;
+       tuple_slot_id++) {
+    EXPECT_EQ(INVALID_TXN_ID,
+              eager_header->GetTransactionId(tuple_slot_id));
+  }
+  EXPECT_EQ(0, eager_header->GetActiveTupleCount());
+}
+
+TEST_F(TileGroupHeaderTests, ReclaimTest) {
+  std::unique_ptr<storage::TileGroupHeader> tile_group_header(
+      new storage::TileGroupHeader(BackendType::MM, tuple_count));
+  std::unique_ptr<storage::TileGroupHeader> fresh_header(
+      new storage::TileGroupHeader(BackendType::MM, tuple_count));
+  ASSERT_TRUE(fresh_header->GetEmptyTupleSlot(0));
+
+  // A reclaimed slot looks like it was never used
+  oid_t tuple_slot_id = tile_group_header->GetNextEmptyTupleSlot();
+  ASSERT_NE(INVALID_OID, tuple_slot_id);
+  ItemPointer indirection(1, 2);
+  tile_group_header->SetTransactionId(tuple_slot_id, INITIAL_TXN_ID);
+  tile_group_header->SetBeginCommitId(tuple_slot_id, 10);
+  tile_group_header->SetEndCommitId(tuple_slot_id, 20);
+  tile_group_header->SetNextItemPointer(tuple_slot_id, ItemPointer(3, 4));
+  tile_group_header->SetPrevItemPointer(tuple_slot_id, ItemPointer(5, 6));
+  tile_group_header->SetIndirection(tuple_slot_id, &indirection);
+
+  tile_group_header->ReclaimTupleSlot(tuple_slot_id);
+  ExpectInitialized(tile_group_header.get(), tuple_slot_id);
+  EXPECT_EQ(0, memcmp(GetEntry(tile_group_header.get(), tuple_slot_id),
+                      GetEntry(fresh_header.get(), 0),
+                      storage::TileGroupHeader::header_entry_size));
+}
+
+TEST_F(TileGroupHeaderTests, RecycledHeaderTest) {
+  // Headers are allocated from recycled buffers, written all over by the
+  // header that had them before
+  for (int round_itr = 0; round_itr < 10; round_itr++) {
+    std::unique_ptr<storage::TileGroupHeader> tile_group_header(
+        new storage::TileGroupHeader(BackendType::MM, tuple_count));
+    const char *data = tile_group_header->GetData();
+    for (size_t byte_itr = 0;
+         byte_itr < tuple_count * storage::TileGroupHeader::header_entry_size;
+         byte_itr++) {
+      ASSERT_EQ(0, data[byte_itr]);
+    }
+    memset(tile_group_header->GetData(), 0xab,
+           tuple_count * storage::TileGroupHeader::header_entry_size);
+  }
+}
+
+}  // End test namespace
+}  // End peloton namespace
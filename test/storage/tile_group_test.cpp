@@ -0,0 +1,154 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// tile_group_test.cpp
+//
+// Identification: test/storage/tile_group_test.cpp
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "catalog/manager.h"
+#include "catalog/schema.h"
+#include "storage/tile_group.h"
+#include "storage/tile_group_factory.h"
+#include "storage/tile_group_header.h"
+#include "storage/tuple.h"
+#include "type/serializeio.h"
+#include "type/value_factory.h"
+
+namespace peloton {
+namespace test {
+
+//===--------------------------------------------------------------------===//
+// Tile Group Tests
+//===--------------------------------------------------------------------===//
+
+class TileGroupTests : public ::testing::Test {};
+
+namespace {
+
+const int tuple_count = 10;
+
+catalog::Column GetColumn(type::Type::TypeId type_id, const std::string &name) {
+  if (type_id == type::Type::VARCHAR) {
+    return catalog::Column(type_id, 64, name, false);
+  }
+  return catalog::Column(type_id, type::Type::GetTypeSize(type_id), name,
+                         true);
+}
+
+// Every type the tile group decodes itself, spread over three tiles
+std::vector<catalog::Column> GetColumns() {
+  return {GetColumn(type::Type::INTEGER, "integer"),
+          GetColumn(type::Type::VARCHAR, "varchar"),
+          GetColumn(type::Type::BIGINT, "bigint"),
+          GetColumn(type::Type::DECIMAL, "decimal"),
+          GetColumn(type::Type::VARCHAR, "null_varchar"),
+          GetColumn(type::Type::TIMESTAMP, "timestamp"),
+          GetColumn(type::Type::BOOLEAN, "boolean"),
+          GetColumn(type::Type::TINYINT, "tinyint"),
+          GetColumn(type::Type::SMALLINT, "smallint"),
+          GetColumn(type::Type::VARCHAR, "empty_varchar")};
+}
+
+std::vector<type::Value> GetValues() {
+  return {type::ValueFactory::GetIntegerValue(-12345),
+          type::ValueFactory::GetVarcharValue(std::string(100, 'a') + "end"),
+          type::ValueFactory::GetBigIntValue(INT64_C(987654321)),
+          type::ValueFactory::GetDecimalValue(3.25),
+          type::ValueFactory::GetNullValueByType(type::Type::VARCHAR),
+          type::ValueFactory::GetTimestampValue(INT64_C(1234567890123)),
+          type::ValueFactory::GetBooleanValue(true),
+          type::ValueFactory::GetTinyIntValue(-7),
+          type::ValueFactory::GetSmallIntValue(4321),
+          type::ValueFactory::GetVarcharValue("")};
+}
+
+bool ValueEquals(const type::Value &expected, const type::Value &value) {
+  if (expected.IsNull() == true || value.IsNull() == true) {
+    return expected.IsNull() == value.IsNull();
+  }
+  return expected.CompareEquals(value) == type::CMP_TRUE;
+}
+
+}  // namespace
+
+TEST_F(TileGroupTests, CopySerializedTupleTest) {
+  auto columns = GetColumns();
+  catalog::Schema schema(columns);
+
+  // Columns are split over the tiles out of order
+  std::vector<std::vector<catalog::Column>> tile_columns(3);
+  column_map_type column_map;
+  for (oid_t column_itr = 0; column_itr < columns.size(); column_itr++) {
+    oid_t tile_itr = column_itr % tile_columns.size();
+    column_map[column_itr] =
+        std::make_pair(tile_itr, (oid_t)tile_columns[tile_itr].size());
+    tile_columns[tile_itr].push_back(columns[column_itr]);
+  }
+  std::vector<catalog::Schema> schemas;
+  for (auto &tile_column : tile_columns) {
+    schemas.emplace_back(tile_column);
+  }
+
+  std::unique_ptr<storage::TileGroup> tile_group(
+      storage::TileGroupFactory::GetTileGroup(
+          INVALID_OID, INVALID_OID,
+          catalog::Manager::GetInstance().GetNextTileGroupId(), nullptr,
+          schemas, column_map, tuple_count));
+
+  auto values = GetValues();
+  storage::Tuple tuple(&schema, true);
+  for (oid_t column_itr = 0; column_itr < values.size(); column_itr++) {
+    tuple.SetValue(column_itr, values[column_itr]);
+  }
+  CopySerializeOutput output;
+  tuple.SerializeTo(output);
+  std::vector<char> tuple_body(output.Data(), output.Data() + output.Size());
+
+  // Decoded straight into the slot, like recovery replays it
+  ReferenceSerializeInput direct_input(tuple_body.data(), tuple_body.size());
+  ASSERT_EQ(0, tile_group->InsertTupleFromRecovery(10, 0, direct_input));
+
+  // Deserialized value by value and set column by column, like recovery
+  // used to replay it
+  ReferenceSerializeInput value_input(tuple_body.data(), tuple_body.size());
+  value_input.ReadInt();
+  ASSERT_TRUE(tile_group->GetHeader()->GetEmptyTupleSlot(1));
+  for (oid_t column_itr = 0; column_itr < schema.GetColumnCount();
+       column_itr++) {
+    auto value = type::Value::DeserializeFrom(value_input,
+                                              schema.GetType(column_itr));
+    tile_group->SetValue(value, 1, column_itr);
+  }
+
+  // Values live in the tile pools, not in the log data
+  memset(tuple_body.data(), 0, tuple_body.size());
+
+  for (oid_t column_itr = 0; column_itr < values.size(); column_itr++) {
+    auto direct_value = tile_group->GetValue(0, column_itr);
+    auto copied_value = tile_group->GetValue(1, column_itr);
+    EXPECT_TRUE(ValueEquals(values[column_itr], direct_value))
+        << "column " << column_itr;
+    EXPECT_TRUE(ValueEquals(copied_value, direct_value))
+        << "column " << column_itr;
+  }
+
+  auto tile_group_header = tile_group->GetHeader();
+  EXPECT_EQ(INITIAL_TXN_ID, tile_group_header->GetTransactionId(0));
+  EXPECT_EQ(10, tile_group_header->GetBeginCommitId(0));
+  EXPECT_EQ(MAX_CID, tile_group_header->GetEndCommitId(0));
+}
+
+}  // End test namespace
+}  // End peloton namespace
@@ -0,0 +1,112 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// zeroed_buffer_pool_test.cpp
+//
+// Identification: test/storage/zeroed_buffer_pool_test.cpp
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <chrono>
+#include <cstring>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "storage/storage_manager.h"
+#include "storage/zeroed_buffer_pool.h"
+
+namespace peloton {
+namespace test {
+
+//===--------------------------------------------------------------------===//
+// Zeroed Buffer Pool Tests
+//===--------------------------------------------------------------------===//
+
+class ZeroedBufferPoolTests : public ::testing::Test {};
+
+namespace {
+
+const size_t buffer_size = 64 * 1024;
+
+const size_t round_count = 100;
+
+bool IsZeroed(const char *buffer, const size_t &size) {
+  for (size_t byte_itr = 0; byte_itr < size; byte_itr++) {
+    if (buffer[byte_itr] != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+TEST_F(ZeroedBufferPoolTests, RecycledBufferTest) {
+  storage::ZeroedBufferPool zeroed_buffer_pool(
+      storage::StorageManager::GetInstance());
+
+  // Buffers come back written all over, the refill thread clears them
+  // before they are handed out again
+  std::set<void *> buffers;
+  for (size_t round_itr = 0; round_itr < round_count; round_itr++) {
+    char *buffer = reinterpret_cast<char *>(zeroed_buffer_pool.Allocate(
+        BackendType::MM, buffer_size, INVALID_NUMA_NODE));
+    ASSERT_TRUE(buffer != nullptr);
+    EXPECT_TRUE(IsZeroed(buffer, buffer_size));
+    buffers.insert(buffer);
+
+    memset(buffer, 0xab, buffer_size);
+    zeroed_buffer_pool.Release(BackendType::MM, buffer, buffer_size,
+                               INVALID_NUMA_NODE);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  EXPECT_EQ(round_count, zeroed_buffer_pool.GetHitCount() +
+                             zeroed_buffer_pool.GetMissCount());
+  EXPECT_LT(0, zeroed_buffer_pool.GetHitCount());
+  EXPECT_GE(storage::ZeroedBufferPool::max_ready_count_ + 1, buffers.size());
+
+  zeroed_buffer_pool.Shutdown();
+  EXPECT_EQ(0, zeroed_buffer_pool.GetCachedBytes());
+}
+
+TEST_F(ZeroedBufferPoolTests, RunDryTest) {
+  storage::ZeroedBufferPool zeroed_buffer_pool(
+      storage::StorageManager::GetInstance());
+
+  // More buffers than are kept ready, a released one that was not cleared
+  // yet is cleared on the spot
+  char *buffer = reinterpret_cast<char *>(zeroed_buffer_pool.Allocate(
+      BackendType::MM, buffer_size, INVALID_NUMA_NODE));
+  memset(buffer, 0xcd, buffer_size);
+  zeroed_buffer_pool.Release(BackendType::MM, buffer, buffer_size,
+                             INVALID_NUMA_NODE);
+
+  std::vector<char *> buffers;
+  for (size_t buffer_itr = 0;
+       buffer_itr < 2 * storage::ZeroedBufferPool::max_ready_count_;
+       buffer_itr++) {
+    buffer = reinterpret_cast<char *>(zeroed_buffer_pool.Allocate(
+        BackendType::MM, buffer_size, INVALID_NUMA_NODE));
+    EXPECT_TRUE(IsZeroed(buffer, buffer_size));
+    memset(buffer, 0xcd, buffer_size);
+    buffers.push_back(buffer);
+  }
+  EXPECT_LT(0, zeroed_buffer_pool.GetMissCount());
+
+  for (auto buffer : buffers) {
+    zeroed_buffer_pool.Release(BackendType::MM, buffer, buffer_size,
+                               INVALID_NUMA_NODE);
+  }
+  zeroed_buffer_pool.Shutdown();
+  EXPECT_EQ(0, zeroed_buffer_pool.GetCachedBytes());
+}
+
+}  // End test namespace
+}  // End peloton namespace